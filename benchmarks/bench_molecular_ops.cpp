@@ -0,0 +1,190 @@
+// Native benchmarks for the per-molecule hot paths shared by the Python
+// batch functions: parsing, reasoning traces, Morgan rows and descriptor
+// plans, each driven over the worker pool exactly as molecular_ops does.
+
+#include "smiles_sets.hpp"
+#include "bit_packing.hpp"
+#include "descriptor_registry.hpp"
+#include "ecfp_trace.hpp"
+#include "mol_batch.hpp"
+#include "thread_pool.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using rdktools::bench::SmilesSet;
+
+// Every benchmark runs once per (set, threads) pair
+void set_and_thread_args(benchmark::internal::Benchmark* b) {
+    std::vector<int> threads = {1, 2, 4, 8};
+    const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    if (hardware > threads.back()) {
+        threads.push_back(hardware);
+    }
+    for (int set = 0; set < rdktools::bench::kNumSmilesSets; ++set) {
+        for (int t : threads) {
+            b->Args({set, t});
+        }
+    }
+    b->ArgNames({"set", "threads"});
+    b->UseRealTime();
+    b->Unit(benchmark::kMillisecond);
+}
+
+SmilesSet smiles_set(const benchmark::State& state) {
+    return static_cast<SmilesSet>(state.range(0));
+}
+
+int num_threads(const benchmark::State& state) {
+    return static_cast<int>(state.range(1));
+}
+
+// Label the run with its set and report molecules/s plus the fraction of
+// rows that produced a result
+void finish(benchmark::State& state, std::size_t rows, std::size_t valid) {
+    state.SetLabel(rdktools::bench::smiles_set_name(smiles_set(state)));
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * rows));
+    state.counters["valid_fraction"] =
+        rows == 0 ? 0.0 : static_cast<double>(valid) / static_cast<double>(rows);
+}
+
+void BM_ParseSmiles(benchmark::State& state) {
+    const std::vector<std::string>& batch = rdktools::bench::smiles_batch(smiles_set(state));
+    std::atomic<std::size_t> valid{0};
+    for (auto _ : state) {
+        valid.store(0, std::memory_order_relaxed);
+        rdktools::parallel_for(batch.size(), num_threads(state),
+                               [&](std::size_t begin, std::size_t end) {
+            std::size_t local = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                auto mol = rdktools::smiles_to_mol(batch[i]);
+                local += mol != nullptr;
+                benchmark::DoNotOptimize(mol.get());
+            }
+            valid.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+    finish(state, batch.size(), valid.load());
+}
+BENCHMARK(BM_ParseSmiles)->Apply(set_and_thread_args);
+
+void run_traces(benchmark::State& state) {
+    const std::vector<std::string>& batch = rdktools::bench::smiles_batch(smiles_set(state));
+    std::atomic<std::size_t> valid{0};
+    for (auto _ : state) {
+        valid.store(0, std::memory_order_relaxed);
+        rdktools::parallel_for(batch.size(), num_threads(state),
+                               [&](std::size_t begin, std::size_t end) {
+            std::size_t local = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                auto result = rdktools::ecfp_reasoning_trace_from_smiles(
+                    batch[i], 2, true, false, true);
+                local += !std::get<0>(result).empty();
+                benchmark::DoNotOptimize(result);
+            }
+            valid.fetch_add(local, std::memory_order_relaxed);
+        });
+    }
+    finish(state, batch.size(), valid.load());
+}
+
+// Trace caches stay warm across iterations, as in a long-running pipeline
+void BM_EcfpReasoningTrace(benchmark::State& state) {
+    run_traces(state);
+}
+BENCHMARK(BM_EcfpReasoningTrace)->Apply(set_and_thread_args);
+
+// With the SMARTS and fragment-metric caches disabled every environment is
+// written and measured again, isolating SMARTS generation and the token
+// metric lookups from cache hits
+void BM_EcfpReasoningTraceUncached(benchmark::State& state) {
+    const std::size_t capacity = rdktools::trace_cache_capacity();
+    rdktools::set_trace_cache_capacity(0);
+    run_traces(state);
+    rdktools::set_trace_cache_capacity(capacity);
+}
+BENCHMARK(BM_EcfpReasoningTraceUncached)->Apply(set_and_thread_args);
+
+void BM_MorganFingerprintRow(benchmark::State& state) {
+    const std::vector<std::string>& batch = rdktools::bench::smiles_batch(smiles_set(state));
+    const std::size_t row_bytes =
+        rdktools::fingerprint_row_bytes(2048, rdktools::FingerprintLayout::PackedBytes);
+    std::vector<std::uint8_t> rows(batch.size() * row_bytes);
+    std::atomic<std::size_t> valid{0};
+    for (auto _ : state) {
+        valid.store(0, std::memory_order_relaxed);
+        rdktools::parallel_for(batch.size(), num_threads(state),
+                               [&](std::size_t begin, std::size_t end) {
+            std::size_t local = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                std::uint8_t* row = rows.data() + i * row_bytes;
+                auto mol = rdktools::smiles_to_mol(batch[i]);
+                if (!mol) {
+                    std::fill_n(row, row_bytes, 0);
+                    continue;
+                }
+                rdktools::morgan_fingerprint_row(*mol, 2, false, 2048,
+                                                 rdktools::FingerprintLayout::PackedBytes,
+                                                 row);
+                ++local;
+            }
+            valid.fetch_add(local, std::memory_order_relaxed);
+        });
+        benchmark::ClobberMemory();
+    }
+    finish(state, batch.size(), valid.load());
+}
+BENCHMARK(BM_MorganFingerprintRow)->Apply(set_and_thread_args);
+
+void run_descriptor_plan(benchmark::State& state, const std::vector<std::string>& names) {
+    const std::vector<std::string>& batch = rdktools::bench::smiles_batch(smiles_set(state));
+    const rdktools::DescriptorPlan plan(names);
+    std::vector<double> values(batch.size() * plan.size());
+    std::atomic<std::size_t> valid{0};
+    for (auto _ : state) {
+        valid.store(0, std::memory_order_relaxed);
+        rdktools::parallel_for(batch.size(), num_threads(state),
+                               [&](std::size_t begin, std::size_t end) {
+            std::size_t local = 0;
+            for (std::size_t i = begin; i < end; ++i) {
+                double* row = values.data() + i * plan.size();
+                auto mol = rdktools::smiles_to_mol(batch[i]);
+                if (!mol) {
+                    plan.fill_invalid(row);
+                    continue;
+                }
+                plan.compute(*mol, row);
+                ++local;
+            }
+            valid.fetch_add(local, std::memory_order_relaxed);
+        });
+        benchmark::ClobberMemory();
+    }
+    finish(state, batch.size(), valid.load());
+    state.counters["descriptors"] = static_cast<double>(plan.size());
+}
+
+// calculate_descriptors() with the molecular_weight / logp / tpsa columns
+// that multiple_descriptors returns
+void BM_DescriptorPlanBasic(benchmark::State& state) {
+    run_descriptor_plan(state, {"molecular_weight", "logp", "tpsa"});
+}
+BENCHMARK(BM_DescriptorPlanBasic)->Apply(set_and_thread_args);
+
+// Every registered descriptor, as calculate_descriptors() with no names
+void BM_DescriptorPlanAll(benchmark::State& state) {
+    run_descriptor_plan(state, {});
+}
+BENCHMARK(BM_DescriptorPlanAll)->Apply(set_and_thread_args);
+
+} // namespace
+
+BENCHMARK_MAIN();
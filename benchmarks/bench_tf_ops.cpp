@@ -0,0 +1,160 @@
+// Native benchmarks for the TensorFlow kernels. Each kernel is instantiated
+// from a NodeDef exactly as the executor would and Compute() is called on a
+// minimal CPU device whose intra-op pool size is the benchmark's thread
+// count, so Shard() splits work the same way it does inside a tf.function.
+
+#include "smiles_sets.hpp"
+#include "absl/container/inlined_vector.h"
+#include "tensorflow/core/framework/allocator.h"
+#include "tensorflow/core/framework/device_attributes.pb.h"
+#include "tensorflow/core/framework/device_base.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/threadpool.h"
+#include "tensorflow/core/public/version.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tensorflow {
+
+namespace {
+
+using rdktools::bench::SmilesSet;
+
+// CPU device exposing only what the rdktools kernels use: the allocator and
+// the intra-op worker threads
+class BenchDevice : public DeviceBase {
+ public:
+  explicit BenchDevice(int num_threads)
+      : DeviceBase(Env::Default()),
+        pool_(Env::Default(), "rdktools_bench", num_threads) {
+    workers_.num_threads = num_threads;
+    workers_.workers = &pool_;
+    set_tensorflow_cpu_worker_threads(&workers_);
+    attributes_.set_name("/job:localhost/replica:0/task:0/device:CPU:0");
+    attributes_.set_device_type(DEVICE_CPU);
+  }
+
+  Allocator* GetAllocator(AllocatorAttributes) override {
+    return cpu_allocator();
+  }
+
+  const DeviceAttributes& attributes() const override { return attributes_; }
+
+ private:
+  thread::ThreadPool pool_;
+  CpuWorkerThreads workers_;
+  DeviceAttributes attributes_;
+};
+
+std::unique_ptr<OpKernel> make_kernel(DeviceBase* device,
+                                      NodeDefBuilder builder) {
+  NodeDef def;
+  Status status =
+      builder.Input(NodeDefBuilder::NodeOut("smiles", 0, DT_STRING))
+          .Finalize(&def);
+  std::unique_ptr<OpKernel> kernel;
+  if (status.ok()) {
+    kernel = CreateOpKernel(DEVICE_CPU, device, cpu_allocator(), def,
+                            TF_GRAPH_DEF_VERSION, &status);
+  }
+  if (!status.ok()) {
+    throw std::runtime_error(status.ToString());
+  }
+  return kernel;
+}
+
+Tensor smiles_tensor(const std::vector<std::string>& batch) {
+  Tensor tensor(DT_STRING, TensorShape({static_cast<int64_t>(batch.size())}));
+  auto flat = tensor.flat<tstring>();
+  for (std::size_t i = 0; i < batch.size(); ++i) {
+    flat(i) = batch[i];
+  }
+  return tensor;
+}
+
+// One Compute() call; outputs are released with the context
+void compute(OpKernel* kernel, DeviceBase* device, Tensor* input,
+             benchmark::State& state) {
+  const absl::InlinedVector<TensorValue, 4> inputs = {TensorValue(input)};
+  std::vector<AllocatorAttributes> output_attrs(kernel->num_outputs());
+  OpKernelContext::Params params;
+  params.device = device;
+  params.op_kernel = kernel;
+  params.inputs = inputs;
+  params.output_attr_array = output_attrs.data();
+  OpKernelContext context(&params, kernel->num_outputs());
+  kernel->Compute(&context);
+  if (!context.status().ok()) {
+    state.SkipWithError(context.status().ToString().c_str());
+  }
+}
+
+void set_and_thread_args(benchmark::internal::Benchmark* b) {
+  std::vector<int> threads = {1, 2, 4, 8};
+  const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+  if (hardware > threads.back()) {
+    threads.push_back(hardware);
+  }
+  for (int set = 0; set < rdktools::bench::kNumSmilesSets; ++set) {
+    for (int t : threads) {
+      b->Args({set, t});
+    }
+  }
+  b->ArgNames({"set", "threads"});
+  b->UseRealTime();
+  b->Unit(benchmark::kMillisecond);
+}
+
+void run_kernel(benchmark::State& state, NodeDefBuilder builder) {
+  const SmilesSet set = static_cast<SmilesSet>(state.range(0));
+  BenchDevice device(static_cast<int>(state.range(1)));
+  std::unique_ptr<OpKernel> kernel = make_kernel(&device, std::move(builder));
+  Tensor input = smiles_tensor(rdktools::bench::smiles_batch(set));
+  for (auto _ : state) {
+    compute(kernel.get(), &device, &input, state);
+  }
+  state.SetLabel(rdktools::bench::smiles_set_name(set));
+  state.SetItemsProcessed(state.iterations() * input.NumElements());
+}
+
+void BM_StringProcessOp(benchmark::State& state) {
+  run_kernel(state, NodeDefBuilder("bench", "StringProcess"));
+}
+BENCHMARK(BM_StringProcessOp)->Apply(set_and_thread_args);
+
+void BM_StringProcessOpPacked(benchmark::State& state) {
+  run_kernel(state,
+             NodeDefBuilder("bench", "StringProcess").Attr("packed", true));
+}
+BENCHMARK(BM_StringProcessOpPacked)->Apply(set_and_thread_args);
+
+void BM_MorganFingerprintOp(benchmark::State& state) {
+  run_kernel(state,
+             NodeDefBuilder("bench", "MorganFingerprint").Attr("packed", true));
+}
+BENCHMARK(BM_MorganFingerprintOp)->Apply(set_and_thread_args);
+
+void BM_DescriptorProcessOp(benchmark::State& state) {
+  run_kernel(state, NodeDefBuilder("bench", "DescriptorProcess"));
+}
+BENCHMARK(BM_DescriptorProcessOp)->Apply(set_and_thread_args);
+
+void BM_FormulaProcessOp(benchmark::State& state) {
+  run_kernel(state, NodeDefBuilder("bench", "FormulaProcess"));
+}
+BENCHMARK(BM_FormulaProcessOp)->Apply(set_and_thread_args);
+
+}  // namespace
+
+}  // namespace tensorflow
+
+BENCHMARK_MAIN();
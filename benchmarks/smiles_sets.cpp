@@ -0,0 +1,192 @@
+#include "smiles_sets.hpp"
+#include <array>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace rdktools::bench {
+
+namespace {
+
+const std::vector<std::string>& drug_like_base() {
+    static const std::vector<std::string> base = {
+        "CC(=O)Oc1ccccc1C(=O)O",                                      // aspirin
+        "CC(C)Cc1ccc(cc1)C(C)C(=O)O",                                 // ibuprofen
+        "CC(=O)Nc1ccc(O)cc1",                                         // paracetamol
+        "Cn1cnc2c1c(=O)n(C)c(=O)n2C",                                 // caffeine
+        "COc1ccc2cc(ccc2c1)[C@H](C)C(=O)O",                           // naproxen
+        "OC(=O)Cc1ccccc1Nc1c(Cl)cccc1Cl",                             // diclofenac
+        "Cc1ccc(NC(=O)c2ccc(CN3CCN(C)CC3)cc2)cc1Nc1nccc(n1)-c1cccnc1",  // imatinib
+        "CC(C)c1n(CC[C@@H](O)C[C@@H](O)CC(=O)O)c(-c2ccc(F)cc2)"
+        "c(-c2ccccc2)c1C(=O)Nc1ccccc1",                               // atorvastatin
+        "Cc1ccc(cc1)-c1cc(nn1-c1ccc(cc1)S(N)(=O)=O)C(F)(F)F",         // celecoxib
+        "CCCc1nn(C)c2c1nc([nH]c2=O)-c1cc(ccc1OCC)S(=O)(=O)N1CCN(C)CC1",  // sildenafil
+        "CN(C)C(=N)NC(=N)N",                                          // metformin
+        "COc1ccc2[nH]c(nc2c1)S(=O)Cc1ncc(C)c(OC)c1C",                 // omeprazole
+        "CNCCC(Oc1ccc(cc1)C(F)(F)F)c1ccccc1",                         // fluoxetine
+        "CN1C(=O)CN=C(c2ccccc2)c2cc(Cl)ccc12",                        // diazepam
+        "CCOC(=O)N1CCC(=C2c3ccc(Cl)cc3CCc3cccnc23)CC1",               // loratadine
+        "CC(C)NCC(O)COc1cccc2ccccc12",                                // propranolol
+        "CC(=O)CC(c1ccccc1)c1c(O)c2ccccc2oc1=O",                      // warfarin
+        "OC(=O)c1cn(C2CC2)c2cc(N3CCNCC3)c(F)cc2c1=O",                 // ciprofloxacin
+        "CC1(C)S[C@@H]2[C@H](NC(=O)Cc3ccccc3)C(=O)N2[C@H]1C(=O)O",    // penicillin G
+        "CN1CCC[C@H]1c1cccnc1",                                       // nicotine
+        "NCCCC[C@H](N[C@@H](CCc1ccccc1)C(=O)O)C(=O)N1CCC[C@H]1C(=O)O",  // lisinopril
+        "CCC(=C(c1ccccc1)c1ccc(OCCN(C)C)cc1)c1ccccc1",                // tamoxifen
+        "COc1cc2ncnc(Nc3ccc(F)c(Cl)c3)c2cc1OCCCN1CCOCC1",             // gefitinib
+        "CN[C@H]1CC[C@@H](c2ccc(Cl)c(Cl)c2)c2ccccc12",                // sertraline
+        "COC(=O)[C@@H](c1ccccc1Cl)N1CCc2sccc2C1",                     // clopidogrel
+        "CCCCc1nc(Cl)c(CO)n1Cc1ccc(cc1)-c1ccccc1-c1nnn[nH]1",         // losartan
+        "C[C@]12CC[C@H]3[C@@H](CCC4=CC(=O)CC[C@]34C)[C@@H]1CC[C@@H]2O",  // testosterone
+        "C[N+](C)(C)CCO",                                             // choline
+        "[Na+].[O-]C(=O)c1ccccc1",                                    // sodium benzoate
+        "OC[C@H]1O[C@@H](O)[C@H](O)[C@@H](O)[C@@H]1O",                // glucose
+    };
+    return base;
+}
+
+// Cyclic peptide of residues side chains (an empty entry is glycine); every
+// third amide nitrogen is methylated, as in cyclosporin-like macrocycles
+std::string cyclic_peptide(const std::vector<std::string>& residues) {
+    std::string smiles;
+    for (std::size_t i = 0; i < residues.size(); ++i) {
+        const bool first = i == 0;
+        const bool last = i + 1 == residues.size();
+        smiles += first ? "N1" : (i % 3 == 0 ? "N(C)" : "N");
+        smiles += residues[i].empty() ? "C" : "C(" + residues[i] + ")";
+        smiles += last ? "C1=O" : "C(=O)";
+    }
+    return smiles;
+}
+
+const std::vector<std::string>& macrocycle_base() {
+    static const std::vector<std::string> base = [] {
+        std::vector<std::string> smiles = {
+            // erythromycin
+            "CC[C@@H]1[C@@]([C@@H]([C@H](C(=O)[C@@H](C[C@@]([C@@H]([C@H]([C@@H]"
+            "([C@H](C(=O)O1)C)O[C@H]2C[C@@]([C@H]([C@@H](O2)C)O)(C)OC)C)O[C@H]3"
+            "[C@@H]([C@H](C[C@H](O3)C)N(C)C)O)(C)O)C)C)O)(C)O",
+            // porphine
+            "C1=CC2=NC1=CC3=CC=C(N3)C=C4C=CC(=N4)C=C5C=CC(=C2)N5",
+            "C1COCCOCCOCCOCCOCCO1",  // 18-crown-6
+        };
+        const std::array<const char*, 8> side_chains = {
+            "",                // Gly
+            "C",               // Ala
+            "CC(C)C",          // Leu
+            "Cc2ccccc2",       // Phe
+            "CO",              // Ser
+            "CCC(=O)O",        // Glu
+            "CCCCN",           // Lys
+            "Cc2c[nH]c3ccccc23",  // Trp
+        };
+        for (std::size_t n = 6; n <= 16; ++n) {
+            std::vector<std::string> residues;
+            for (std::size_t i = 0; i < n; ++i) {
+                residues.emplace_back(side_chains[(i * 5 + n) % side_chains.size()]);
+            }
+            smiles.push_back(cyclic_peptide(residues));
+        }
+        for (std::size_t n = 12; n <= 36; n += 6) {
+            smiles.push_back("C1" + std::string(n - 2, 'C') + "C1");
+        }
+        return smiles;
+    }();
+    return base;
+}
+
+const std::vector<std::string>& invalid_heavy_base() {
+    static const std::vector<std::string> base = [] {
+        const std::vector<std::string>& valid = drug_like_base();
+        std::vector<std::string> smiles;
+        for (std::size_t i = 0; i < valid.size(); ++i) {
+            const std::string& s = valid[i];
+            switch (i % 5) {
+                case 0:
+                case 1:
+                    smiles.push_back(s);  // valid rows
+                    break;
+                case 2:
+                    smiles.push_back(s.substr(0, s.size() / 2));  // truncated
+                    break;
+                case 3:
+                    smiles.push_back(s + "C(C)(C)(C)(C)C");  // pentavalent carbon
+                    break;
+                default:
+                    smiles.push_back("c1cccc1" + s);  // kekulization failure
+                    break;
+            }
+        }
+        smiles.insert(smiles.end(), {
+            "",
+            "not a smiles",
+            "[Na+",
+            "C1CC",
+            "c1ccccc1)",
+            "CC(=O)O[",
+            "N(=O)(=O)(=O)C",
+            "Xx1ccccc1",
+        });
+        return smiles;
+    }();
+    return base;
+}
+
+std::size_t initial_batch_size() {
+    if (const char* env = std::getenv("RDKTOOLS_BENCH_MOLECULES")) {
+        char* end = nullptr;
+        const unsigned long long value = std::strtoull(env, &end, 10);
+        if (end != env && value > 0) {
+            return static_cast<std::size_t>(value);
+        }
+    }
+    return 1024;
+}
+
+std::vector<std::string> cycle(const std::vector<std::string>& base, std::size_t size) {
+    std::vector<std::string> batch;
+    batch.reserve(size);
+    for (std::size_t i = 0; i < size; ++i) {
+        batch.push_back(base[i % base.size()]);
+    }
+    return batch;
+}
+
+} // namespace
+
+const char* smiles_set_name(SmilesSet set) {
+    switch (set) {
+        case SmilesSet::DrugLike:
+            return "drug_like";
+        case SmilesSet::Macrocycle:
+            return "macrocycle";
+        case SmilesSet::InvalidHeavy:
+            return "invalid_heavy";
+    }
+    return "unknown";
+}
+
+std::size_t smiles_batch_size() {
+    static const std::size_t size = initial_batch_size();
+    return size;
+}
+
+const std::vector<std::string>& smiles_batch(SmilesSet set) {
+    static const std::vector<std::string> drug_like =
+        cycle(drug_like_base(), smiles_batch_size());
+    static const std::vector<std::string> macrocycle =
+        cycle(macrocycle_base(), smiles_batch_size());
+    static const std::vector<std::string> invalid_heavy =
+        cycle(invalid_heavy_base(), smiles_batch_size());
+    switch (set) {
+        case SmilesSet::Macrocycle:
+            return macrocycle;
+        case SmilesSet::InvalidHeavy:
+            return invalid_heavy;
+        case SmilesSet::DrugLike:
+        default:
+            return drug_like;
+    }
+}
+
+} // namespace rdktools::bench
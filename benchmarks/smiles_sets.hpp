@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace rdktools::bench {
+
+/**
+ * @brief Input corpora the native benchmarks are run against
+ */
+enum class SmilesSet {
+    DrugLike,      // marketed small molecules, salts and charged species
+    Macrocycle,    // cyclic peptides, macrolides and large carbocycles
+    InvalidHeavy,  // drug-like rows where about two thirds fail to parse or sanitize
+};
+
+inline constexpr int kNumSmilesSets = 3;
+
+/**
+ * @brief Short name of a set, used as the benchmark label
+ */
+const char* smiles_set_name(SmilesSet set);
+
+/**
+ * @brief Batch of smiles_batch_size() rows drawn from set in a fixed order
+ *
+ * Rows cycle through the set's base molecules, so the same molecule recurs
+ * every few dozen rows as it does in real screening decks.
+ */
+const std::vector<std::string>& smiles_batch(SmilesSet set);
+
+/**
+ * @brief Number of rows in every batch returned by smiles_batch():
+ *        RDKTOOLS_BENCH_MOLECULES when set, otherwise 1024
+ */
+std::size_t smiles_batch_size();
+
+} // namespace rdktools::bench
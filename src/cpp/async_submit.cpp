@@ -0,0 +1,150 @@
+#include "async_submit.hpp"
+#include "thread_pool.hpp"
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+
+namespace nb = nanobind;
+
+namespace rdktools {
+
+namespace {
+
+// Two jobs in flight let one batch featurize while the next is prepared
+constexpr std::size_t kDefaultMaxInFlight = 2;
+
+struct Limiter {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t in_flight = 0;
+    std::size_t limit = kDefaultMaxInFlight;
+};
+
+Limiter& limiter() {
+    // Leaked like the worker pool, so jobs finishing during interpreter
+    // shutdown never touch a destroyed mutex
+    static Limiter* instance = new Limiter();
+    return *instance;
+}
+
+void release_slot() {
+    Limiter& l = limiter();
+    {
+        std::lock_guard<std::mutex> guard(l.mutex);
+        --l.in_flight;
+    }
+    l.cv.notify_all();
+}
+
+// Python objects of one job. They are only touched, and dropped, with the
+// GIL held.
+struct Job {
+    nb::object future;
+    nb::object fn;
+    nb::tuple args;
+    nb::dict kwargs;
+};
+
+void run_job(Job& job) {
+    nb::gil_scoped_acquire acquire;
+    bool run = false;
+    try {
+        run = nb::cast<bool>(job.future.attr("set_running_or_notify_cancel")());
+    } catch (const nb::python_error&) {
+        // Already resolved by the caller; nothing to publish
+    }
+
+    nb::object result;
+    nb::object error;
+    if (run) {
+        try {
+            result = job.fn(*job.args, **job.kwargs);
+        } catch (nb::python_error& e) {
+            error = nb::borrow(e.value());
+        } catch (const std::exception& e) {
+            error = nb::module_::import_("builtins").attr("RuntimeError")(e.what());
+        }
+    }
+
+    release_slot();
+    if (run) {
+        try {
+            if (error.is_valid()) {
+                job.future.attr("set_exception")(error);
+            } else {
+                job.future.attr("set_result")(result);
+            }
+        } catch (nb::python_error& e) {
+            // A failing done-callback must not take the worker down
+            e.discard_as_unraisable("rdktools.submit");
+        }
+    }
+    job = Job();
+}
+
+} // namespace
+
+bool submit_call(const nb::object& future,
+                 const nb::object& fn,
+                 const nb::tuple& args,
+                 const nb::dict& kwargs,
+                 bool block) {
+    Limiter& l = limiter();
+    {
+        nb::gil_scoped_release release;
+        std::unique_lock<std::mutex> lock(l.mutex);
+        if (!block && l.in_flight >= l.limit) {
+            return false;
+        }
+        l.cv.wait(lock, [&] { return l.in_flight < l.limit; });
+        ++l.in_flight;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->future = future;
+    job->fn = fn;
+    job->args = args;
+    job->kwargs = kwargs;
+    try {
+        ThreadPool::instance().enqueue([job] { run_job(*job); });
+    } catch (...) {
+        *job = Job();
+        release_slot();
+        throw;
+    }
+    return true;
+}
+
+void set_max_in_flight(std::size_t limit) {
+    if (limit == 0) {
+        throw std::invalid_argument("max_in_flight must be positive");
+    }
+    Limiter& l = limiter();
+    {
+        std::lock_guard<std::mutex> guard(l.mutex);
+        l.limit = limit;
+    }
+    l.cv.notify_all();
+}
+
+std::size_t max_in_flight() {
+    Limiter& l = limiter();
+    std::lock_guard<std::mutex> guard(l.mutex);
+    return l.limit;
+}
+
+std::size_t in_flight() {
+    Limiter& l = limiter();
+    std::lock_guard<std::mutex> guard(l.mutex);
+    return l.in_flight;
+}
+
+void wait_for_submitted() {
+    Limiter& l = limiter();
+    nb::gil_scoped_release release;
+    std::unique_lock<std::mutex> lock(l.mutex);
+    l.cv.wait(lock, [&] { return l.in_flight == 0; });
+}
+
+} // namespace rdktools
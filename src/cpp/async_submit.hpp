@@ -0,0 +1,45 @@
+#pragma once
+
+#include <nanobind/nanobind.h>
+#include <cstddef>
+
+namespace rdktools {
+
+/**
+ * @brief Run fn(*args, **kwargs) on the shared worker pool and resolve future
+ *
+ * future is a concurrent.futures.Future owned by the caller. The job takes
+ * the GIL only to start fn and to publish its result or exception; the
+ * rdktools batch functions release it while they featurize, so the caller
+ * keeps running Python in the meantime. A job's slot is freed before its
+ * future resolves, so done-callbacks may submit again without waiting.
+ *
+ * @param block wait (with the GIL released) for a free slot when
+ *        max_in_flight() jobs are already pending; otherwise return false
+ * @return true once the job is queued
+ */
+bool submit_call(const nanobind::object& future,
+                 const nanobind::object& fn,
+                 const nanobind::tuple& args,
+                 const nanobind::dict& kwargs,
+                 bool block);
+
+/**
+ * @brief Bound the number of submitted jobs queued or running at once
+ * @throws std::invalid_argument if limit is 0
+ */
+void set_max_in_flight(std::size_t limit);
+
+std::size_t max_in_flight();
+
+/**
+ * @brief Jobs submitted and not yet finished
+ */
+std::size_t in_flight();
+
+/**
+ * @brief Block, with the GIL released, until every submitted job finished
+ */
+void wait_for_submitted();
+
+} // namespace rdktools
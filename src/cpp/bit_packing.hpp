@@ -0,0 +1,191 @@
+#pragma once
+
+#include <DataStructs/ExplicitBitVect.h>
+#include <boost/dynamic_bitset.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief Memory layout of a fingerprint row
+ *
+ * Dense stores one uint8 (0/1) per bit. PackedBytes stores eight bits per
+ * byte in np.packbits order (bit 0 in the most significant bit of byte 0).
+ * PackedWords stores 64 bits per uint64 word, bit i at position i % 64 of
+ * word i / 64, which is the native ExplicitBitVect block layout.
+ */
+enum class FingerprintLayout {
+    Dense,
+    PackedBytes,
+    PackedWords,
+};
+
+/**
+ * @brief Parse a user-facing layout name ("dense", "bytes" or "uint64")
+ * @throws std::invalid_argument for unknown names
+ */
+inline FingerprintLayout parse_fingerprint_layout(const std::string& name) {
+    if (name.empty() || name == "dense" || name == "none") {
+        return FingerprintLayout::Dense;
+    }
+    if (name == "bytes" || name == "packbits") {
+        return FingerprintLayout::PackedBytes;
+    }
+    if (name == "uint64" || name == "words") {
+        return FingerprintLayout::PackedWords;
+    }
+    throw std::invalid_argument(
+        "unknown fingerprint layout '" + name +
+        "' (expected 'dense', 'bytes' or 'uint64')");
+}
+
+inline std::size_t packed_num_bytes(std::size_t nbits) {
+    return (nbits + 7) / 8;
+}
+
+inline std::size_t packed_num_words(std::size_t nbits) {
+    return (nbits + 63) / 64;
+}
+
+/**
+ * @brief Number of row elements (not bytes) for a layout: bits, bytes or words
+ */
+inline std::size_t fingerprint_row_elements(std::size_t nbits,
+                                            FingerprintLayout layout) {
+    switch (layout) {
+    case FingerprintLayout::PackedBytes:
+        return packed_num_bytes(nbits);
+    case FingerprintLayout::PackedWords:
+        return packed_num_words(nbits);
+    case FingerprintLayout::Dense:
+    default:
+        return nbits;
+    }
+}
+
+/**
+ * @brief Size of one row in bytes for a layout
+ */
+inline std::size_t fingerprint_row_bytes(std::size_t nbits,
+                                         FingerprintLayout layout) {
+    return layout == FingerprintLayout::PackedWords
+               ? packed_num_words(nbits) * sizeof(std::uint64_t)
+               : fingerprint_row_elements(nbits, layout);
+}
+
+namespace detail {
+
+using BitsetBlock = boost::dynamic_bitset<>::block_type;
+static_assert(sizeof(BitsetBlock) == sizeof(std::uint64_t),
+              "fingerprint packing assumes 64-bit dynamic_bitset blocks");
+
+constexpr std::array<std::uint8_t, 256> make_bit_reverse_table() {
+    std::array<std::uint8_t, 256> table{};
+    for (unsigned int value = 0; value < 256; ++value) {
+        unsigned int reversed = 0;
+        for (unsigned int bit = 0; bit < 8; ++bit) {
+            if (value & (1U << bit)) {
+                reversed |= 0x80U >> bit;
+            }
+        }
+        table[value] = static_cast<std::uint8_t>(reversed);
+    }
+    return table;
+}
+
+inline constexpr std::array<std::uint8_t, 256> kBitReverse =
+    make_bit_reverse_table();
+
+} // namespace detail
+
+/**
+ * @brief Copy the ExplicitBitVect storage blocks into 64-bit words
+ * @param fp source fingerprint
+ * @param out destination with room for packed_num_words(fp.getNumBits()) words
+ */
+inline void copy_fingerprint_words(const ExplicitBitVect& fp,
+                                   std::uint64_t* out) {
+    boost::to_block_range(*fp.dp_bits, out);
+}
+
+/**
+ * @brief Write one row of 64-bit fingerprint words in the requested layout
+ * @param words packed_num_words(nbits) words, bit i at position i % 64 of
+ *        word i / 64, with no bits set past nbits
+ * @param nbits number of bits to emit (the row width)
+ * @param layout destination layout
+ * @param out destination buffer of fingerprint_row_bytes(nbits, layout) bytes
+ */
+inline void write_fingerprint_words(const std::uint64_t* words,
+                                    std::size_t nbits,
+                                    FingerprintLayout layout,
+                                    std::uint8_t* out) {
+    const std::size_t num_words = packed_num_words(nbits);
+    switch (layout) {
+    case FingerprintLayout::PackedWords:
+        std::memcpy(out, words, num_words * sizeof(std::uint64_t));
+        break;
+    case FingerprintLayout::PackedBytes: {
+        const std::size_t num_bytes = packed_num_bytes(nbits);
+        for (std::size_t byte = 0; byte < num_bytes; ++byte) {
+            const auto value = static_cast<std::uint8_t>(
+                words[byte / 8] >> (8 * (byte % 8)));
+            out[byte] = detail::kBitReverse[value];
+        }
+        break;
+    }
+    case FingerprintLayout::Dense:
+    default:
+        std::memset(out, 0, nbits);
+        for (std::size_t w = 0; w < num_words; ++w) {
+            std::uint64_t word = words[w];
+            while (word != 0) {
+                const auto bit = static_cast<std::size_t>(__builtin_ctzll(word));
+                out[w * 64 + bit] = 1;
+                word &= word - 1;
+            }
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Write one fingerprint row in the requested layout
+ * @param fp source fingerprint with nbits bits
+ * @param nbits number of bits to emit (the row width)
+ * @param layout destination layout
+ * @param out destination buffer of fingerprint_row_bytes(nbits, layout) bytes
+ *
+ * Works from whole storage words: dense rows only touch the set bits and
+ * packed rows are a block copy, never a per-bit getBit() loop.
+ */
+inline void write_fingerprint_row(const ExplicitBitVect& fp,
+                                  std::size_t nbits,
+                                  FingerprintLayout layout,
+                                  std::uint8_t* out) {
+    const std::size_t num_words = packed_num_words(nbits);
+    thread_local std::vector<std::uint64_t> words;
+    words.assign(num_words, 0);
+    if (fp.getNumBits() == nbits) {
+        copy_fingerprint_words(fp, words.data());
+    } else {
+        // Width mismatch: fall back to copying the overlapping bits.
+        const std::size_t limit = std::min<std::size_t>(nbits, fp.getNumBits());
+        for (std::size_t bit = 0; bit < limit; ++bit) {
+            if (fp.getBit(static_cast<unsigned int>(bit))) {
+                words[bit / 64] |= std::uint64_t{1} << (bit % 64);
+            }
+        }
+    }
+
+    write_fingerprint_words(words.data(), nbits, layout, out);
+}
+
+} // namespace rdktools
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+namespace rdktools {
+
+/**
+ * @brief Blocking FIFO with a fixed capacity connecting pipeline stages.
+ *
+ * Producers block while the queue is full and consumers while it is empty,
+ * which bounds the memory held between stages. close() marks the end of
+ * input (consumers drain what is left); cancel() drops everything and wakes
+ * both sides so a pipeline can be torn down early.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(std::size_t capacity) : capacity_(capacity == 0 ? 1 : capacity) {}
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Append an item, waiting for space
+     * @return false if the queue was closed or cancelled (the item is dropped)
+     */
+    bool push(T item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return items_.size() < capacity_ || closed_; });
+        if (closed_) {
+            return false;
+        }
+        items_.push_back(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Remove the oldest item, waiting for one to arrive
+     * @return false once the queue is closed and drained, or cancelled
+     */
+    bool pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+        if (items_.empty() || cancelled_) {
+            return false;
+        }
+        item = std::move(items_.front());
+        items_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Signal that no more items will be pushed
+     */
+    void close() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+    /**
+     * @brief Drop queued items and release every waiting producer and consumer
+     */
+    void cancel() {
+        std::lock_guard<std::mutex> guard(mutex_);
+        closed_ = true;
+        cancelled_ = true;
+        items_.clear();
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    const std::size_t capacity_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<T> items_;
+    bool closed_ = false;
+    bool cancelled_ = false;
+};
+
+} // namespace rdktools
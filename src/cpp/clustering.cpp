@@ -0,0 +1,275 @@
+#include "clustering.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace rdktools {
+
+namespace {
+
+// Rows per neighbor-search task. Small enough to balance the uneven work of
+// popcount-sorted rows, large enough that per-task pair lists stay few.
+constexpr std::size_t kSearchBlockRows = 256;
+// Rows per MaxMin update task; each task also reports its best candidate.
+constexpr std::size_t kPickBlockRows = 16 * 1024;
+// Marks picked rows in the MaxMin similarity array (similarities are <= 1)
+constexpr float kPicked = 2.0f;
+
+using Pair = std::pair<std::uint32_t, std::uint32_t>;
+
+std::size_t ceil_div(std::size_t value, std::size_t divisor) {
+    return (value + divisor - 1) / divisor;
+}
+
+const std::uint32_t* resolve_popcounts(const FingerprintView& fps,
+                                       const std::uint32_t* popcounts,
+                                       int num_threads,
+                                       std::vector<std::uint32_t>& storage) {
+    if (popcounts) {
+        return popcounts;
+    }
+    storage = row_popcounts(fps, num_threads);
+    return storage.data();
+}
+
+} // namespace
+
+NeighborLists tanimoto_neighbors(const FingerprintView& fps,
+                                 const std::uint32_t* popcounts,
+                                 float threshold,
+                                 int num_threads) {
+    if (!(threshold > 0.0f && threshold <= 1.0f)) {
+        throw std::invalid_argument("threshold must be in (0, 1]");
+    }
+    if (fps.rows >= std::numeric_limits<std::uint32_t>::max()) {
+        throw std::invalid_argument("neighbor search supports fewer than 2^32 rows");
+    }
+    const std::size_t n = fps.rows;
+    std::vector<std::uint32_t> computed;
+    const std::uint32_t* counts = resolve_popcounts(fps, popcounts, num_threads, computed);
+
+    std::vector<std::uint32_t> order(n);
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return counts[a] < counts[b];
+    });
+
+    // Pairs found by each block, kept apart so no task shares a vector
+    const std::size_t num_blocks = ceil_div(n, kSearchBlockRows);
+    std::vector<std::vector<Pair>> block_pairs(num_blocks);
+    parallel_for(num_blocks, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t block = begin; block < end; ++block) {
+            std::vector<Pair>& pairs = block_pairs[block];
+            const std::size_t p1 = std::min(n, (block + 1) * kSearchBlockRows);
+            for (std::size_t p = block * kSearchBlockRows; p < p1; ++p) {
+                const std::uint32_t i = order[p];
+                const std::uint8_t* row_i = fps.row(i);
+                const std::uint32_t count_i = counts[i];
+                for (std::size_t q = p + 1; q < n; ++q) {
+                    const std::uint32_t j = order[q];
+                    // |a| <= |b| from here on, so |a| / |b| bounds the
+                    // similarity, and only grows looser further along
+                    if (tanimoto_from_counts(count_i, count_i, counts[j]) < threshold) {
+                        break;
+                    }
+                    const std::uint64_t common = and_popcount(row_i, fps.row(j), fps.row_bytes);
+                    if (tanimoto_from_counts(common, count_i, counts[j]) >= threshold) {
+                        pairs.emplace_back(i, j);
+                    }
+                }
+            }
+        }
+    });
+
+    NeighborLists lists;
+    lists.offsets.assign(n + 1, 0);
+    for (const std::vector<Pair>& pairs : block_pairs) {
+        for (const Pair& pair : pairs) {
+            ++lists.offsets[pair.first + 1];
+            ++lists.offsets[pair.second + 1];
+        }
+    }
+    std::partial_sum(lists.offsets.begin(), lists.offsets.end(), lists.offsets.begin());
+    lists.neighbors.resize(static_cast<std::size_t>(lists.offsets[n]));
+    std::vector<std::int64_t> cursor(lists.offsets.begin(), lists.offsets.end() - 1);
+    for (std::vector<Pair>& pairs : block_pairs) {
+        for (const Pair& pair : pairs) {
+            lists.neighbors[static_cast<std::size_t>(cursor[pair.first]++)] = pair.second;
+            lists.neighbors[static_cast<std::size_t>(cursor[pair.second]++)] = pair.first;
+        }
+        std::vector<Pair>().swap(pairs);
+    }
+    return lists;
+}
+
+ButinaClusters butina_cluster(const FingerprintView& fps,
+                              const std::uint32_t* popcounts,
+                              float threshold,
+                              bool reordering,
+                              int num_threads) {
+    const NeighborLists lists = tanimoto_neighbors(fps, popcounts, threshold, num_threads);
+    const std::size_t n = fps.rows;
+
+    ButinaClusters clusters;
+    clusters.labels.assign(n, -1);
+    std::vector<std::size_t> degree(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        degree[i] = lists.degree(i);
+    }
+
+    auto take_cluster = [&](std::size_t centroid) {
+        const auto label = static_cast<std::int64_t>(clusters.centroids.size());
+        clusters.centroids.push_back(static_cast<std::int64_t>(centroid));
+        clusters.labels[centroid] = label;
+        const std::int64_t begin = lists.offsets[centroid];
+        const std::int64_t end = lists.offsets[centroid + 1];
+        for (std::int64_t k = begin; k < end; ++k) {
+            const std::uint32_t member = lists.neighbors[static_cast<std::size_t>(k)];
+            if (clusters.labels[member] < 0) {
+                clusters.labels[member] = label;
+            }
+        }
+        return label;
+    };
+
+    if (!reordering) {
+        std::vector<std::uint32_t> order(n);
+        std::iota(order.begin(), order.end(), 0U);
+        std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return degree[a] > degree[b];
+        });
+        for (const std::uint32_t centroid : order) {
+            if (clusters.labels[centroid] < 0) {
+                take_cluster(centroid);
+            }
+        }
+        return clusters;
+    }
+
+    // Max-heap on (unassigned neighbors, lower index); entries whose count
+    // went stale are pushed again with the current one when they surface
+    using Entry = std::pair<std::size_t, std::int64_t>;
+    std::priority_queue<Entry> heap;
+    for (std::size_t i = 0; i < n; ++i) {
+        heap.emplace(degree[i], -static_cast<std::int64_t>(i));
+    }
+    std::vector<std::uint32_t> members;
+    while (!heap.empty()) {
+        const Entry top = heap.top();
+        heap.pop();
+        const auto centroid = static_cast<std::size_t>(-top.second);
+        if (clusters.labels[centroid] >= 0) {
+            continue;
+        }
+        if (top.first != degree[centroid]) {
+            heap.emplace(degree[centroid], top.second);
+            continue;
+        }
+
+        members.clear();
+        members.push_back(static_cast<std::uint32_t>(centroid));
+        for (std::int64_t k = lists.offsets[centroid]; k < lists.offsets[centroid + 1]; ++k) {
+            const std::uint32_t member = lists.neighbors[static_cast<std::size_t>(k)];
+            if (clusters.labels[member] < 0) {
+                members.push_back(member);
+            }
+        }
+        take_cluster(centroid);
+        for (const std::uint32_t member : members) {
+            for (std::int64_t k = lists.offsets[member]; k < lists.offsets[member + 1]; ++k) {
+                const std::uint32_t other = lists.neighbors[static_cast<std::size_t>(k)];
+                if (clusters.labels[other] < 0) {
+                    --degree[other];
+                }
+            }
+        }
+    }
+    return clusters;
+}
+
+std::vector<std::int64_t> maxmin_pick(const FingerprintView& fps,
+                                      const std::uint32_t* popcounts,
+                                      std::size_t k,
+                                      const std::vector<std::int64_t>& first_picks,
+                                      std::uint64_t seed,
+                                      int num_threads) {
+    const std::size_t n = fps.rows;
+    if (k > n) {
+        throw std::invalid_argument("cannot pick " + std::to_string(k) + " of " +
+                                    std::to_string(n) + " rows");
+    }
+    if (first_picks.size() > k) {
+        throw std::invalid_argument("more first_picks than rows to pick");
+    }
+    std::vector<std::int64_t> picks;
+    if (k == 0) {
+        return picks;
+    }
+    std::vector<std::uint32_t> computed;
+    const std::uint32_t* counts = resolve_popcounts(fps, popcounts, num_threads, computed);
+
+    // Highest similarity of every row to the picks so far
+    std::vector<float> nearest(n, -1.0f);
+    const std::size_t num_blocks = ceil_div(n, kPickBlockRows);
+    std::vector<std::pair<float, std::size_t>> block_best(num_blocks);
+
+    // Fold pick into nearest and return the next MaxMin candidate
+    auto add_pick = [&](std::size_t pick) {
+        picks.push_back(static_cast<std::int64_t>(pick));
+        nearest[pick] = kPicked;
+        const std::uint8_t* row_pick = fps.row(pick);
+        parallel_for(num_blocks, num_threads, [&](std::size_t begin, std::size_t end) {
+            for (std::size_t block = begin; block < end; ++block) {
+                std::pair<float, std::size_t> best{kPicked, n};
+                const std::size_t i1 = std::min(n, (block + 1) * kPickBlockRows);
+                for (std::size_t i = block * kPickBlockRows; i < i1; ++i) {
+                    if (nearest[i] == kPicked) {
+                        continue;
+                    }
+                    const std::uint64_t common = and_popcount(fps.row(i), row_pick, fps.row_bytes);
+                    const float score = tanimoto_from_counts(common, counts[i], counts[pick]);
+                    nearest[i] = std::max(nearest[i], score);
+                    if (nearest[i] < best.first) {
+                        best = {nearest[i], i};
+                    }
+                }
+                block_best[block] = best;
+            }
+        });
+        std::pair<float, std::size_t> best{kPicked, n};
+        for (const auto& candidate : block_best) {
+            if (candidate.first < best.first) {
+                best = candidate;
+            }
+        }
+        return best.second;
+    };
+
+    std::size_t next = n;
+    for (const std::int64_t pick : first_picks) {
+        if (pick < 0 || static_cast<std::size_t>(pick) >= n) {
+            throw std::invalid_argument("first pick " + std::to_string(pick) + " is out of range");
+        }
+        if (nearest[static_cast<std::size_t>(pick)] == kPicked) {
+            throw std::invalid_argument("first pick " + std::to_string(pick) + " is repeated");
+        }
+        next = add_pick(static_cast<std::size_t>(pick));
+    }
+    if (picks.empty()) {
+        std::mt19937_64 rng(seed);
+        next = add_pick(std::uniform_int_distribution<std::size_t>(0, n - 1)(rng));
+    }
+    while (picks.size() < k) {
+        next = add_pick(next);
+    }
+    return picks;
+}
+
+} // namespace rdktools
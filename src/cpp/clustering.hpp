@@ -0,0 +1,84 @@
+#pragma once
+
+#include "similarity.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief Symmetric thresholded neighbor lists in CSR form
+ *
+ * The neighbors of row i are neighbors[offsets[i]:offsets[i + 1]], in no
+ * particular order and never including i itself.
+ */
+struct NeighborLists {
+    std::vector<std::int64_t> offsets;
+    std::vector<std::uint32_t> neighbors;
+
+    std::size_t degree(std::size_t row) const {
+        return static_cast<std::size_t>(offsets[row + 1] - offsets[row]);
+    }
+};
+
+/**
+ * @brief Every pair of rows with Tanimoto similarity >= threshold
+ * @param fps packed fingerprints (fewer than 2^32 rows)
+ * @param popcounts bit counts of the rows, or nullptr to compute them
+ * @param threshold minimum similarity, in (0, 1]
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ *
+ * Rows are visited in popcount order, so each row is only compared with the
+ * rows whose popcount allows a similarity of at least threshold
+ * (t * |a| <= |b| <= |a| / t). The similarity matrix is never built; memory
+ * grows with the number of neighbor pairs.
+ *
+ * @throws std::invalid_argument for thresholds outside (0, 1] or too many rows
+ */
+NeighborLists tanimoto_neighbors(const FingerprintView& fps,
+                                 const std::uint32_t* popcounts,
+                                 float threshold,
+                                 int num_threads = 0);
+
+struct ButinaClusters {
+    std::vector<std::int64_t> labels;     // cluster of every row
+    std::vector<std::int64_t> centroids;  // row index of every cluster's centroid
+};
+
+/**
+ * @brief Taylor-Butina clustering at a similarity threshold
+ *
+ * Rows with the most unassigned neighbors become centroids first (ties go to
+ * the lower row index) and take all their unassigned neighbors. Without
+ * reordering, neighbor counts are the initial ones, as in RDKit's Butina
+ * module; with reordering, they are updated as rows are assigned. Clusters
+ * are numbered in the order they are formed.
+ */
+ButinaClusters butina_cluster(const FingerprintView& fps,
+                              const std::uint32_t* popcounts,
+                              float threshold,
+                              bool reordering = false,
+                              int num_threads = 0);
+
+/**
+ * @brief MaxMin diversity picking
+ * @param k number of rows to pick (at most fps.rows)
+ * @param first_picks rows picked before the first MaxMin step; when empty,
+ *        the first row is drawn at random from seed
+ *
+ * Each step picks the row whose highest similarity to the rows picked so far
+ * is lowest (ties go to the lower row index). One parallel pass per pick
+ * updates those per-row maxima against the newest pick, so memory is O(N).
+ *
+ * @throws std::invalid_argument if k exceeds the number of rows, or
+ *         first_picks has more than k entries, one out of range or a repeat
+ */
+std::vector<std::int64_t> maxmin_pick(const FingerprintView& fps,
+                                      const std::uint32_t* popcounts,
+                                      std::size_t k,
+                                      const std::vector<std::int64_t>& first_picks,
+                                      std::uint64_t seed,
+                                      int num_threads = 0);
+
+} // namespace rdktools
@@ -0,0 +1,233 @@
+#include "descriptor_registry.hpp"
+#include "stats.hpp"
+#include <GraphMol/Descriptors/MolDescriptors.h>
+#include <GraphMol/MolOps.h>
+#include <GraphMol/RingInfo.h>
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+
+namespace rdktools {
+
+void DescriptorContext::ensure_crippen() {
+    if (have_crippen_) {
+        return;
+    }
+    // One pass over the Crippen atom contributions yields both values
+    RDKit::Descriptors::calcCrippenDescriptors(mol_, logp_, mr_);
+    have_crippen_ = true;
+}
+
+double DescriptorContext::crippen_logp() {
+    ensure_crippen();
+    return logp_;
+}
+
+double DescriptorContext::crippen_mr() {
+    ensure_crippen();
+    return mr_;
+}
+
+void DescriptorContext::ensure_rings() {
+    if (have_rings_) {
+        return;
+    }
+    const RDKit::RingInfo* rings = mol_.getRingInfo();
+    if (!rings->isInitialized()) {
+        RDKit::MolOps::findSSSR(mol_);
+    }
+    // Same definitions as RDKit's calcNum{Aromatic,Aliphatic}Rings and
+    // calcNumHeterocycles, classified in a single walk over the rings
+    for (const auto& bond_ring : rings->bondRings()) {
+        const bool aromatic = std::all_of(bond_ring.begin(), bond_ring.end(), [&](int idx) {
+            return mol_.getBondWithIdx(idx)->getIsAromatic();
+        });
+        ++(aromatic ? aromatic_rings_ : aliphatic_rings_);
+    }
+    for (const auto& atom_ring : rings->atomRings()) {
+        const bool hetero = std::any_of(atom_ring.begin(), atom_ring.end(), [&](int idx) {
+            return mol_.getAtomWithIdx(idx)->getAtomicNum() != 6;
+        });
+        if (hetero) {
+            ++heterocycles_;
+        }
+    }
+    have_rings_ = true;
+}
+
+unsigned int DescriptorContext::num_aromatic_rings() {
+    ensure_rings();
+    return aromatic_rings_;
+}
+
+unsigned int DescriptorContext::num_aliphatic_rings() {
+    ensure_rings();
+    return aliphatic_rings_;
+}
+
+unsigned int DescriptorContext::num_heterocycles() {
+    ensure_rings();
+    return heterocycles_;
+}
+
+namespace {
+
+// RDKit's calculators take extra defaulted arguments and return a mix of
+// double and unsigned, so each gets a plain adapter over the shared context.
+
+using namespace RDKit::Descriptors;
+using Context = DescriptorContext;
+
+double molecular_weight(Context& c) { return calcAMW(c.mol()); }
+double exact_molecular_weight(Context& c) { return calcExactMW(c.mol()); }
+double logp(Context& c) { return c.crippen_logp(); }
+double molar_refractivity(Context& c) { return c.crippen_mr(); }
+double tpsa(Context& c) { return calcTPSA(c.mol()); }
+double labute_asa(Context& c) { return calcLabuteASA(c.mol()); }
+double num_hba(Context& c) { return calcNumHBA(c.mol()); }
+double num_hbd(Context& c) { return calcNumHBD(c.mol()); }
+double num_lipinski_hba(Context& c) { return calcLipinskiHBA(c.mol()); }
+double num_lipinski_hbd(Context& c) { return calcLipinskiHBD(c.mol()); }
+double num_rotatable_bonds(Context& c) { return calcNumRotatableBonds(c.mol()); }
+double num_heavy_atoms(Context& c) { return c.mol().getNumHeavyAtoms(); }
+double num_heteroatoms(Context& c) { return calcNumHeteroatoms(c.mol()); }
+double num_rings(Context& c) { return c.num_aromatic_rings() + c.num_aliphatic_rings(); }
+double num_aromatic_rings(Context& c) { return c.num_aromatic_rings(); }
+double num_aliphatic_rings(Context& c) { return c.num_aliphatic_rings(); }
+double num_heterocycles(Context& c) { return c.num_heterocycles(); }
+double num_amide_bonds(Context& c) { return calcNumAmideBonds(c.mol()); }
+double fraction_csp3(Context& c) { return calcFractionCSP3(c.mol()); }
+double num_atoms(Context& c) { return calcNumAtoms(c.mol()); }
+double num_saturated_rings(Context& c) { return calcNumSaturatedRings(c.mol()); }
+double num_aromatic_carbocycles(Context& c) { return calcNumAromaticCarbocycles(c.mol()); }
+double num_aromatic_heterocycles(Context& c) { return calcNumAromaticHeterocycles(c.mol()); }
+double num_saturated_heterocycles(Context& c) { return calcNumSaturatedHeterocycles(c.mol()); }
+double num_aliphatic_heterocycles(Context& c) { return calcNumAliphaticHeterocycles(c.mol()); }
+double num_spiro_atoms(Context& c) { return calcNumSpiroAtoms(c.mol()); }
+double num_bridgehead_atoms(Context& c) { return calcNumBridgeheadAtoms(c.mol()); }
+double num_atom_stereo_centers(Context& c) { return calcNumAtomStereoCenters(c.mol()); }
+double chi0v(Context& c) { return calcChi0v(c.mol()); }
+double chi1v(Context& c) { return calcChi1v(c.mol()); }
+double chi2v(Context& c) { return calcChi2v(c.mol()); }
+double chi3v(Context& c) { return calcChi3v(c.mol()); }
+double chi4v(Context& c) { return calcChi4v(c.mol()); }
+double chi0n(Context& c) { return calcChi0n(c.mol()); }
+double chi1n(Context& c) { return calcChi1n(c.mol()); }
+double chi2n(Context& c) { return calcChi2n(c.mol()); }
+double chi3n(Context& c) { return calcChi3n(c.mol()); }
+double chi4n(Context& c) { return calcChi4n(c.mol()); }
+double hall_kier_alpha(Context& c) { return calcHallKierAlpha(c.mol()); }
+double kappa1(Context& c) { return calcKappa1(c.mol()); }
+double kappa2(Context& c) { return calcKappa2(c.mol()); }
+double kappa3(Context& c) { return calcKappa3(c.mol()); }
+double phi(Context& c) { return calcPhi(c.mol()); }
+
+} // namespace
+
+const std::vector<DescriptorEntry>& descriptor_registry() {
+    static const std::vector<DescriptorEntry> registry = {
+        {"molecular_weight", molecular_weight},
+        {"exact_molecular_weight", exact_molecular_weight},
+        {"logp", logp},
+        {"molar_refractivity", molar_refractivity},
+        {"tpsa", tpsa},
+        {"labute_asa", labute_asa},
+        {"num_hba", num_hba},
+        {"num_hbd", num_hbd},
+        {"num_lipinski_hba", num_lipinski_hba},
+        {"num_lipinski_hbd", num_lipinski_hbd},
+        {"num_rotatable_bonds", num_rotatable_bonds},
+        {"num_heavy_atoms", num_heavy_atoms},
+        {"num_heteroatoms", num_heteroatoms},
+        {"num_rings", num_rings},
+        {"num_aromatic_rings", num_aromatic_rings},
+        {"num_aliphatic_rings", num_aliphatic_rings},
+        {"num_heterocycles", num_heterocycles},
+        {"num_amide_bonds", num_amide_bonds},
+        {"fraction_csp3", fraction_csp3},
+        {"num_atoms", num_atoms},
+        {"num_saturated_rings", num_saturated_rings},
+        {"num_aromatic_carbocycles", num_aromatic_carbocycles},
+        {"num_aromatic_heterocycles", num_aromatic_heterocycles},
+        {"num_saturated_heterocycles", num_saturated_heterocycles},
+        {"num_aliphatic_heterocycles", num_aliphatic_heterocycles},
+        {"num_spiro_atoms", num_spiro_atoms},
+        {"num_bridgehead_atoms", num_bridgehead_atoms},
+        {"num_atom_stereo_centers", num_atom_stereo_centers},
+        {"chi0v", chi0v},
+        {"chi1v", chi1v},
+        {"chi2v", chi2v},
+        {"chi3v", chi3v},
+        {"chi4v", chi4v},
+        {"chi0n", chi0n},
+        {"chi1n", chi1n},
+        {"chi2n", chi2n},
+        {"chi3n", chi3n},
+        {"chi4n", chi4n},
+        {"hall_kier_alpha", hall_kier_alpha},
+        {"kappa1", kappa1},
+        {"kappa2", kappa2},
+        {"kappa3", kappa3},
+        {"phi", phi},
+    };
+    return registry;
+}
+
+std::vector<std::string> descriptor_names() {
+    std::vector<std::string> names;
+    names.reserve(descriptor_registry().size());
+    for (const DescriptorEntry& entry : descriptor_registry()) {
+        names.emplace_back(entry.name);
+    }
+    return names;
+}
+
+DescriptorFunction descriptor_function(const std::string& name) {
+    for (const DescriptorEntry& entry : descriptor_registry()) {
+        if (name == entry.name) {
+            return entry.compute;
+        }
+    }
+    throw std::invalid_argument("unknown descriptor '" + name + "'");
+}
+
+DescriptorPlan::DescriptorPlan(const std::vector<std::string>& names)
+    : names_(names.empty() ? descriptor_names() : names) {
+    functions_.reserve(names_.size());
+    for (const std::string& name : names_) {
+        functions_.push_back(descriptor_function(name));
+    }
+}
+
+template <typename T>
+void DescriptorPlan::compute_row(const RDKit::ROMol& mol, T* row) const {
+    RDKTOOLS_STAGE(Descriptors);
+    DescriptorContext context(mol);
+    try {
+        for (std::size_t d = 0; d < functions_.size(); ++d) {
+            row[d] = static_cast<T>(functions_[d](context));
+        }
+    } catch (const std::exception&) {
+        RDKTOOLS_COUNT(Exceptions);
+        fill_invalid(row);
+    }
+}
+
+void DescriptorPlan::compute(const RDKit::ROMol& mol, double* row) const {
+    compute_row(mol, row);
+}
+
+void DescriptorPlan::compute(const RDKit::ROMol& mol, float* row) const {
+    compute_row(mol, row);
+}
+
+void DescriptorPlan::fill_invalid(double* row) const {
+    std::fill_n(row, functions_.size(), std::numeric_limits<double>::quiet_NaN());
+}
+
+void DescriptorPlan::fill_invalid(float* row) const {
+    std::fill_n(row, functions_.size(), std::numeric_limits<float>::quiet_NaN());
+}
+
+} // namespace rdktools
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <GraphMol/ROMol.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief Per-molecule scratch shared by every descriptor of one plan row.
+ *
+ * Intermediates that several descriptors derive from (Crippen atom
+ * contributions, ring classification) are computed on first use and reused
+ * for the rest of the row, instead of every calculator walking the molecule
+ * again.
+ */
+class DescriptorContext {
+public:
+    explicit DescriptorContext(const RDKit::ROMol& mol) : mol_(mol) {}
+
+    const RDKit::ROMol& mol() const { return mol_; }
+
+    double crippen_logp();
+    double crippen_mr();
+
+    unsigned int num_aromatic_rings();
+    unsigned int num_aliphatic_rings();
+    unsigned int num_heterocycles();
+
+private:
+    void ensure_crippen();
+    void ensure_rings();
+
+    const RDKit::ROMol& mol_;
+    bool have_crippen_ = false;
+    double logp_ = 0.0;
+    double mr_ = 0.0;
+    bool have_rings_ = false;
+    unsigned int aromatic_rings_ = 0;
+    unsigned int aliphatic_rings_ = 0;
+    unsigned int heterocycles_ = 0;
+};
+
+/**
+ * @brief A scalar molecular descriptor
+ */
+using DescriptorFunction = double (*)(DescriptorContext& context);
+
+/**
+ * @brief Named descriptor known to the registry
+ */
+struct DescriptorEntry {
+    const char* name;
+    DescriptorFunction compute;
+};
+
+/**
+ * @brief Every registered descriptor, in a stable order
+ */
+const std::vector<DescriptorEntry>& descriptor_registry();
+
+/**
+ * @brief Names of every registered descriptor, in registry order
+ */
+std::vector<std::string> descriptor_names();
+
+/**
+ * @brief Look up a descriptor by name
+ * @throws std::invalid_argument for unknown names
+ */
+DescriptorFunction descriptor_function(const std::string& name);
+
+/**
+ * @brief A list of descriptor names resolved against the registry once.
+ *
+ * compute() fills one row of size() values for a molecule, sharing a
+ * DescriptorContext between the columns; fill_invalid() writes the NaN row
+ * used for unparsable input.
+ */
+class DescriptorPlan {
+public:
+    /**
+     * @brief Resolve names; an empty list selects every registered descriptor
+     * @throws std::invalid_argument for unknown names
+     */
+    explicit DescriptorPlan(const std::vector<std::string>& names);
+
+    std::size_t size() const { return functions_.size(); }
+    const std::vector<std::string>& names() const { return names_; }
+
+    /**
+     * @brief Write the descriptors of mol into row[0, size()), or NaN for the
+     *        whole row if any calculator throws
+     */
+    void compute(const RDKit::ROMol& mol, double* row) const;
+    void compute(const RDKit::ROMol& mol, float* row) const;
+
+    void fill_invalid(double* row) const;
+    void fill_invalid(float* row) const;
+
+private:
+    template <typename T>
+    void compute_row(const RDKit::ROMol& mol, T* row) const;
+
+    std::vector<std::string> names_;
+    std::vector<DescriptorFunction> functions_;
+};
+
+} // namespace rdktools
@@ -1,9 +1,14 @@
 #include "ecfp_trace.hpp"
+#include "mol_batch.hpp"
+#include "result_cache.hpp"
+#include "sharded_cache.hpp"
+#include "stats.hpp"
+#include "trace_vocab.hpp"
 
 #include <DataStructs/ExplicitBitVect.h>
+#include <DataStructs/SparseIntVect.h>
 #include <GraphMol/Descriptors/MolDescriptors.h>
 #include <GraphMol/Fingerprints/FingerprintGenerator.h>
-#include <GraphMol/Fingerprints/MorganFingerprints.h>
 #include <GraphMol/Fingerprints/MorganGenerator.h>
 #include <GraphMol/MolOps.h>
 #include <GraphMol/RingInfo.h>
@@ -12,15 +17,14 @@
 #include <GraphMol/Subgraphs/Subgraphs.h>
 #include <RDGeneral/RDLog.h>
 #include <algorithm>
+#include <cstdlib>
 #include <limits>
 #include <map>
 #include <memory>
-#include <mutex>
 #include <set>
 #include <sstream>
 #include <string>
 #include <tuple>
-#include <unordered_map>
 #include <vector>
 
 namespace {
@@ -107,31 +111,66 @@ TokenMetrics compute_metrics(const std::string& token) {
     return metrics;
 }
 
-TokenMetrics token_metrics(const std::string& token) {
-    static std::mutex cache_mutex;
-    static std::unordered_map<std::string, TokenMetrics> cache;
+constexpr std::size_t kDefaultTraceCacheCapacity = std::size_t{1} << 16;
 
-    {
-        std::lock_guard<std::mutex> guard(cache_mutex);
-        auto it = cache.find(token);
-        if (it != cache.end()) {
-            return it->second;
+std::size_t initial_trace_cache_capacity() {
+    if (const char* env = std::getenv("RDKTOOLS_TRACE_CACHE_SIZE")) {
+        try {
+            const long long value = std::stoll(env);
+            if (value >= 0) {
+                return static_cast<std::size_t>(value);
+            }
+        } catch (const std::exception&) {
         }
     }
+    return kDefaultTraceCacheCapacity;
+}
 
-    TokenMetrics computed = compute_metrics(token);
+rdktools::ShardedCache<std::string, TokenMetrics>& token_metrics_cache() {
+    static rdktools::ShardedCache<std::string, TokenMetrics> cache(
+        initial_trace_cache_capacity());
+    return cache;
+}
+
+TokenMetrics token_metrics(const std::string& token) {
+    auto& cache = token_metrics_cache();
+    TokenMetrics metrics;
+    if (cache.find(token, metrics)) {
+        RDKTOOLS_COUNT(MetricsCacheHits);
+        return metrics;
+    }
+    RDKTOOLS_COUNT(MetricsCacheMisses);
     {
-        std::lock_guard<std::mutex> guard(cache_mutex);
-        auto [it, _] = cache.emplace(token, computed);
-        return it->second;
+        RDKTOOLS_STAGE(TokenMetrics);
+        metrics = compute_metrics(token);
     }
+    cache.insert(token, metrics);
+    return metrics;
 }
 
-auto complexity_key(const std::string& token) {
-    const TokenMetrics metrics = token_metrics(token);
-    return std::make_tuple(metrics.radius, metrics.numAtoms, metrics.numBonds,
-                           metrics.hasRing, metrics.numHetero,
-                           metrics.hasUnsat, metrics.token);
+// Order tokens by complexity. Metrics are looked up once per token up
+// front, so the comparisons themselves touch no cache.
+template <typename Item>
+void sort_by_complexity(std::vector<Item>& items) {
+    std::vector<std::pair<TokenMetrics, std::size_t>> keyed;
+    keyed.reserve(items.size());
+    for (std::size_t i = 0; i < items.size(); ++i) {
+        keyed.emplace_back(token_metrics(items[i].first), i);
+    }
+    std::sort(keyed.begin(), keyed.end(), [](const auto& lhs, const auto& rhs) {
+        const TokenMetrics& a = lhs.first;
+        const TokenMetrics& b = rhs.first;
+        return std::tie(a.radius, a.numAtoms, a.numBonds, a.hasRing, a.numHetero,
+                        a.hasUnsat, a.token) <
+               std::tie(b.radius, b.numAtoms, b.numBonds, b.hasRing, b.numHetero,
+                        b.hasUnsat, b.token);
+    });
+    std::vector<Item> sorted;
+    sorted.reserve(items.size());
+    for (const auto& entry : keyed) {
+        sorted.push_back(std::move(items[entry.second]));
+    }
+    items = std::move(sorted);
 }
 
 std::string join_lines(const std::vector<std::string>& lines) {
@@ -157,75 +196,157 @@ std::string join_with(const std::vector<std::string>& items,
     return oss.str();
 }
 
-BitInfoMap collect_morgan_bitinfo(const RDKit::ROMol& mol, unsigned int radius,
-                                  bool includeChirality) {
-    RDKit::AdditionalOutput additionalOutput;
-    additionalOutput.allocateBitInfoMap();
+using MorganGenerator = RDKit::FingerprintGenerator<std::uint32_t>;
+
+constexpr std::size_t kMaxCachedGenerators = 16;
+
+// Generators are costly to build and not documented as safe for concurrent
+// use, so every thread keeps its own, keyed by (radius, chirality, size).
+MorganGenerator& morgan_generator(unsigned int radius, bool includeChirality,
+                                  std::uint32_t fpSize) {
+    using Key = std::tuple<unsigned int, bool, std::uint32_t>;
+    thread_local std::map<Key, std::unique_ptr<MorganGenerator>> cache;
+
+    const Key key{radius, includeChirality, fpSize};
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+        if (cache.size() >= kMaxCachedGenerators) {
+            cache.clear();
+        }
+        std::unique_ptr<MorganGenerator> generator(
+            RDKit::MorganFingerprint::getMorganGenerator<std::uint32_t>(
+                radius, false, includeChirality, true, false, nullptr, nullptr,
+                fpSize));
+        it = cache.emplace(key, std::move(generator)).first;
+    }
+    return *it->second;
+}
+
+bool valid_fingerprint_size(std::size_t fingerprint_size) {
+    return fingerprint_size != 0 &&
+           fingerprint_size <= std::numeric_limits<std::uint32_t>::max();
+}
 
-    auto generator = std::unique_ptr<RDKit::FingerprintGenerator<std::uint64_t>>(
-        RDKit::MorganFingerprint::getMorganGenerator<std::uint64_t>(
-            radius, true, includeChirality, true));
+struct MorganPass {
+    BitInfoMap bitInfo;
+    std::vector<std::uint8_t> bits;
+};
 
-    auto fingerprint =
-        generator->getFingerprint(mol, nullptr, nullptr, -1, &additionalOutput);
+// One generator run yielding both the bit-info map and the folded bits.
+// Invalid sizes still produce bit info (from a default-sized generator)
+// and leave the bits zeroed.
+MorganPass morgan_pass(const RDKit::ROMol& mol, unsigned int radius,
+                       bool includeChirality, std::size_t fingerprint_size,
+                       rdktools::FingerprintLayout layout) {
+    MorganPass pass;
+    pass.bits.assign(rdktools::fingerprint_row_bytes(fingerprint_size, layout), 0);
+    const bool valid_size = valid_fingerprint_size(fingerprint_size);
+    const auto fpSize = static_cast<std::uint32_t>(
+        valid_size ? fingerprint_size : rdktools::kECFPReasoningFingerprintSize);
 
-    (void)fingerprint;
-    return additionalOutput.bitInfoMap ? *additionalOutput.bitInfoMap
-                                       : BitInfoMap{};
+    RDKit::AdditionalOutput additionalOutput;
+    additionalOutput.allocateBitInfoMap();
+    std::unique_ptr<::ExplicitBitVect> fp =
+        morgan_generator(radius, includeChirality, fpSize)
+            .getFingerprint(mol, nullptr, nullptr, -1, &additionalOutput);
+
+    if (additionalOutput.bitInfoMap) {
+        pass.bitInfo = std::move(*additionalOutput.bitInfoMap);
+    }
+    if (fp && valid_size) {
+        rdktools::write_fingerprint_row(*fp, fingerprint_size, layout,
+                                        pass.bits.data());
+    }
+    return pass;
 }
 
 std::vector<std::uint8_t> compute_morgan_fingerprint_bits(
     const RDKit::ROMol& mol,
     unsigned int radius,
     bool includeChirality,
-    std::size_t fingerprint_size) {
-    std::vector<std::uint8_t> bits(fingerprint_size, 0);
-    if (fingerprint_size == 0 ||
-        fingerprint_size > std::numeric_limits<unsigned int>::max()) {
-        return bits;
-    }
-    const auto num_bits =
-        static_cast<unsigned int>(fingerprint_size);
-    try {
-        std::unique_ptr<::ExplicitBitVect> fp(
-            RDKit::MorganFingerprints::getFingerprintAsBitVect(
-                mol,
-                radius,
-                num_bits,
-                nullptr,
-                nullptr,
-                includeChirality,
-                true,
-                false,
-                nullptr));
-        if (!fp) {
-            return bits;
-        }
+    std::size_t fingerprint_size,
+    rdktools::FingerprintLayout layout) {
+    std::vector<std::uint8_t> bits(
+        rdktools::fingerprint_row_bytes(fingerprint_size, layout), 0);
+    rdktools::morgan_fingerprint_row(mol, radius, includeChirality,
+                                     fingerprint_size, layout, bits.data());
+    return bits;
+}
+
+rdktools::ShardedCache<std::string, std::string>& fragment_smarts_cache() {
+    static rdktools::ShardedCache<std::string, std::string> cache(
+        initial_trace_cache_capacity());
+    return cache;
+}
+
+template <typename T>
+void append_key(std::string& key, T value) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
 
-        for (unsigned int idx = 0;
-             idx < num_bits; ++idx) {
-            bits[idx] = fp->getBit(idx) ? 1U : 0U;
+// Molecule-independent signature of a fragment as MolFragmentToSmarts sees
+// it (root marked, or with the original map numbers when mark_root is off):
+// every atom and bond property the SMARTS writer reads, with atoms
+// numbered by their order in atomList and bonds in index order. Equal
+// signatures therefore write identical SMARTS, which keeps memoized traces
+// byte-for-byte the same as freshly written ones. (Folded Morgan bit ids
+// collide, so they cannot serve as the key on their own.)
+void fragment_signature(const RDKit::ROMol& mol, const std::vector<int>& atomList,
+                        std::vector<int> bondIndices, unsigned int root,
+                        bool mark_root, bool isomeric, std::vector<int>& local,
+                        std::string& key) {
+    key.clear();
+    append_key(key, static_cast<std::uint8_t>(isomeric));
+    append_key(key, static_cast<std::uint32_t>(atomList.size()));
+    for (std::size_t i = 0; i < atomList.size(); ++i) {
+        local[static_cast<std::size_t>(atomList[i])] = static_cast<int>(i);
+    }
+    for (const int idx : atomList) {
+        const auto atom = mol.getAtomWithIdx(static_cast<unsigned int>(idx));
+        append_key(key, static_cast<std::int32_t>(
+                            mark_root ? (idx == static_cast<int>(root) ? 1 : 0)
+                                      : atom->getAtomMapNum()));
+        append_key(key, static_cast<std::uint16_t>(atom->getAtomicNum()));
+        append_key(key, static_cast<std::uint8_t>(atom->getIsAromatic()));
+        append_key(key, static_cast<std::int8_t>(atom->getFormalCharge()));
+        append_key(key, static_cast<std::uint8_t>(atom->getTotalNumHs()));
+        append_key(key, static_cast<std::uint8_t>(atom->getNumExplicitHs()));
+        append_key(key, static_cast<std::uint8_t>(atom->getNumRadicalElectrons()));
+        append_key(key, static_cast<std::uint16_t>(atom->getIsotope()));
+        append_key(key, static_cast<std::uint8_t>(atom->getChiralTag()));
+        if (isomeric && atom->getChiralTag() != RDKit::Atom::CHI_UNSPECIFIED) {
+            // Chirality parity follows the atom's bond order
+            for (const auto bond : mol.atomBonds(atom)) {
+                const auto other = bond->getOtherAtomIdx(atom->getIdx());
+                append_key(key, static_cast<std::int32_t>(local[other]));
+            }
+            append_key(key, std::int32_t{-2});
         }
-    } catch (const std::exception&) {
-        // Leave bits zeroed on failure.
     }
-    return bits;
+    std::sort(bondIndices.begin(), bondIndices.end());
+    for (const int bidx : bondIndices) {
+        const auto bond = mol.getBondWithIdx(static_cast<unsigned int>(bidx));
+        append_key(key, static_cast<std::int32_t>(local[bond->getBeginAtomIdx()]));
+        append_key(key, static_cast<std::int32_t>(local[bond->getEndAtomIdx()]));
+        append_key(key, static_cast<std::uint8_t>(bond->getBondType()));
+        append_key(key, static_cast<std::uint8_t>(bond->getIsAromatic()));
+        append_key(key, static_cast<std::uint8_t>(bond->getBondDir()));
+        append_key(key, static_cast<std::uint8_t>(bond->getStereo()));
+    }
+    for (const int idx : atomList) {
+        local[static_cast<std::size_t>(idx)] = -1;
+    }
 }
 
+// Fragment SMARTS for every (center, radius) environment in bitInfo.
+// Recurring fragments are served from a cache shared across molecules. On a
+// miss the fragment is written from a private copy of mol, made on first
+// use, whose map numbers are cleared once so marking the root touches a
+// single atom.
 std::map<unsigned int, std::map<unsigned int, std::string>>
-ecfp_env_tokens_by_center(const RDKit::ROMol& source, unsigned int radius,
-                          bool isomeric, bool kekulize,
+ecfp_env_tokens_by_center(const RDKit::ROMol& mol, const BitInfoMap& bitInfo,
+                          unsigned int radius, bool isomeric,
                           bool include_radius_tag, bool mark_root) {
-    RDKit::RWMol mol(source);
-    if (kekulize) {
-        try {
-            RDKit::MolOps::Kekulize(mol);
-        } catch (const RDKit::MolSanitizeException&) {
-        } catch (const RDKit::KekulizeException&) {
-        }
-    }
-
-    BitInfoMap bitInfo = collect_morgan_bitinfo(mol, radius, isomeric);
     std::set<CenterRadiusPair> pairs;
     for (const auto& entry : bitInfo) {
         for (const auto& occurrence : entry.second) {
@@ -235,11 +356,11 @@ ecfp_env_tokens_by_center(const RDKit::ROMol& source, unsigned int radius,
         }
     }
 
-    std::vector<int> originalMapNums;
-    originalMapNums.reserve(mol.getNumAtoms());
-    for (const auto atom : mol.atoms()) {
-        originalMapNums.push_back(atom->getAtomMapNum());
-    }
+    auto& cache = fragment_smarts_cache();
+    std::unique_ptr<RDKit::RWMol> writable;
+    std::vector<int> local(mol.getNumAtoms(), -1);
+    std::string key;
+    std::string smarts;
 
     std::map<unsigned int, std::map<unsigned int, std::string>> perCenter;
     for (const auto& pr : pairs) {
@@ -260,25 +381,30 @@ ecfp_env_tokens_by_center(const RDKit::ROMol& source, unsigned int radius,
         std::vector<int> atomList(atomSet.begin(), atomSet.end());
         std::sort(atomList.begin(), atomList.end());
 
-        if (mark_root) {
-            for (std::size_t idx = 0; idx < originalMapNums.size(); ++idx) {
-                mol.getAtomWithIdx(static_cast<unsigned int>(idx))
-                    ->setAtomMapNum(0);
+        fragment_signature(mol, atomList, bondIndices, center, mark_root,
+                           isomeric, local, key);
+        if (cache.find(key, smarts)) {
+            RDKTOOLS_COUNT(SmartsCacheHits);
+        } else {
+            RDKTOOLS_COUNT(SmartsCacheMisses);
+            if (!writable) {
+                writable = std::make_unique<RDKit::RWMol>(mol);
+                if (mark_root) {
+                    for (const auto atom : writable->atoms()) {
+                        atom->setAtomMapNum(0);
+                    }
+                }
             }
-            mol.getAtomWithIdx(center)->setAtomMapNum(1);
-        }
-
-        const std::vector<int>* bondPtr =
-            bondIndices.empty() ? nullptr : &bondIndices;
-
-        std::string smarts =
-            RDKit::MolFragmentToSmarts(mol, atomList, bondPtr, isomeric);
-
-        if (mark_root) {
-            for (std::size_t idx = 0; idx < originalMapNums.size(); ++idx) {
-                mol.getAtomWithIdx(static_cast<unsigned int>(idx))
-                    ->setAtomMapNum(originalMapNums[idx]);
+            if (mark_root) {
+                writable->getAtomWithIdx(center)->setAtomMapNum(1);
+            }
+            const std::vector<int>* bondPtr =
+                bondIndices.empty() ? nullptr : &bondIndices;
+            smarts = RDKit::MolFragmentToSmarts(*writable, atomList, bondPtr, isomeric);
+            if (mark_root) {
+                writable->getAtomWithIdx(center)->setAtomMapNum(0);
             }
+            cache.insert(key, smarts);
         }
 
         std::ostringstream oss;
@@ -294,59 +420,288 @@ ecfp_env_tokens_by_center(const RDKit::ROMol& source, unsigned int radius,
     return perCenter;
 }
 
-std::unique_ptr<RDKit::ROMol> smiles_to_mol(const std::string& smiles) {
-    try {
-        return std::unique_ptr<RDKit::ROMol>(RDKit::SmilesToMol(smiles));
-    } catch (const std::exception&) {
-        return nullptr;
+// What a trace is written from: the fingerprint row and each center's
+// environments by layer. Text and token traces format the same parts, so
+// they always describe the same environments.
+struct TraceParts {
+    std::vector<std::uint8_t> fingerprint;
+    std::map<unsigned int, std::map<unsigned int, std::string>> per_center;
+};
+
+using RadiusTokens =
+    std::vector<std::pair<unsigned int, std::vector<std::pair<std::string, unsigned int>>>>;
+
+TraceParts trace_parts(const RDKit::ROMol& mol, unsigned int radius, bool isomeric,
+                       bool kekulize, std::size_t fingerprint_size,
+                       rdktools::FingerprintLayout layout) {
+    TraceParts parts;
+    std::unique_ptr<RDKit::RWMol> kekulized;
+    MorganPass pass;
+    if (kekulize) {
+        kekulized = std::make_unique<RDKit::RWMol>(mol);
+        try {
+            RDKit::MolOps::Kekulize(*kekulized);
+        } catch (const RDKit::MolSanitizeException&) {
+            RDKTOOLS_COUNT(Exceptions);
+        } catch (const RDKit::KekulizeException&) {
+            RDKTOOLS_COUNT(Exceptions);
+        }
+    }
+    {
+        RDKTOOLS_STAGE(Morgan);
+        if (kekulized) {
+            // Kekulized bond types change the environments, so the
+            // fingerprint of the original molecule needs its own pass
+            pass = morgan_pass(*kekulized, radius, isomeric, 0, layout);
+            parts.fingerprint = compute_morgan_fingerprint_bits(
+                mol, radius, isomeric, fingerprint_size, layout);
+        } else {
+            pass = morgan_pass(mol, radius, isomeric, fingerprint_size, layout);
+            parts.fingerprint = std::move(pass.bits);
+        }
+    }
+    {
+        RDKTOOLS_STAGE(EnvironmentSmarts);
+        parts.per_center = ecfp_env_tokens_by_center(
+            kekulized ? *kekulized : mol, pass.bitInfo, radius, isomeric, true, true);
     }
+    return parts;
+}
+
+// Per radius, the distinct environments with their counts in complexity
+// order
+RadiusTokens tokens_by_radius(
+    const std::map<unsigned int, std::map<unsigned int, std::string>>& per_center) {
+    std::map<unsigned int, std::map<std::string, unsigned int>> counts;
+    for (const auto& center_entry : per_center) {
+        for (const auto& layer_entry : center_entry.second) {
+            counts[layer_entry.first][layer_entry.second] += 1;
+        }
+    }
+    RadiusTokens by_radius;
+    for (const auto& radius_entry : counts) {
+        std::vector<std::pair<std::string, unsigned int>> tokens(
+            radius_entry.second.begin(), radius_entry.second.end());
+        sort_by_complexity(tokens);
+        by_radius.emplace_back(radius_entry.first, std::move(tokens));
+    }
+    return by_radius;
 }
 
 } // namespace
 
 namespace rdktools {
 
+void morgan_fingerprint_row(const RDKit::ROMol& mol,
+                            unsigned int radius,
+                            bool include_chirality,
+                            std::size_t fingerprint_size,
+                            FingerprintLayout layout,
+                            std::uint8_t* out) {
+    const std::size_t row_bytes = fingerprint_row_bytes(fingerprint_size, layout);
+    std::fill_n(out, row_bytes, static_cast<std::uint8_t>(0));
+    if (!valid_fingerprint_size(fingerprint_size)) {
+        return;
+    }
+    RDKTOOLS_STAGE(Morgan);
+    try {
+        std::unique_ptr<::ExplicitBitVect> fp =
+            morgan_generator(radius, include_chirality,
+                             static_cast<std::uint32_t>(fingerprint_size))
+                .getFingerprint(mol);
+        if (fp) {
+            write_fingerprint_row(*fp, fingerprint_size, layout, out);
+        }
+    } catch (const std::exception&) {
+        RDKTOOLS_COUNT(Exceptions);
+        // Leave the row zeroed on failure.
+        std::fill_n(out, row_bytes, static_cast<std::uint8_t>(0));
+    }
+}
+
+void morgan_count_row(const RDKit::ROMol& mol,
+                      unsigned int radius,
+                      bool include_chirality,
+                      std::size_t fingerprint_size,
+                      std::uint8_t* out) {
+    std::fill_n(out, fingerprint_size, static_cast<std::uint8_t>(0));
+    if (!valid_fingerprint_size(fingerprint_size)) {
+        return;
+    }
+    RDKTOOLS_STAGE(Morgan);
+    try {
+        std::unique_ptr<RDKit::SparseIntVect<std::uint32_t>> fp =
+            morgan_generator(radius, include_chirality,
+                             static_cast<std::uint32_t>(fingerprint_size))
+                .getCountFingerprint(mol);
+        if (!fp) {
+            return;
+        }
+        for (const auto& element : fp->getNonzeroElements()) {
+            out[element.first] = static_cast<std::uint8_t>(
+                std::min<int>(element.second, std::numeric_limits<std::uint8_t>::max()));
+        }
+    } catch (const std::exception&) {
+        RDKTOOLS_COUNT(Exceptions);
+        std::fill_n(out, fingerprint_size, static_cast<std::uint8_t>(0));
+    }
+}
+
+void morgan_sweep_rows(const RDKit::ROMol& mol,
+                       const std::vector<MorganFold>& folds,
+                       bool include_chirality,
+                       FingerprintLayout layout,
+                       std::uint8_t* const* out) {
+    for (std::size_t f = 0; f < folds.size(); ++f) {
+        std::fill_n(out[f], fingerprint_row_bytes(folds[f].fingerprint_size, layout),
+                    static_cast<std::uint8_t>(0));
+    }
+    if (folds.empty()) {
+        return;
+    }
+    unsigned int max_radius = 0;
+    for (const MorganFold& fold : folds) {
+        max_radius = std::max(max_radius, fold.radius);
+    }
+
+    RDKTOOLS_STAGE(Morgan);
+    try {
+        // Sparse ids are unfolded, so the generator's own size is irrelevant
+        RDKit::AdditionalOutput additionalOutput;
+        additionalOutput.allocateBitInfoMap();
+        morgan_generator(max_radius, include_chirality,
+                         static_cast<std::uint32_t>(kECFPReasoningFingerprintSize))
+            .getSparseFingerprint(mol, nullptr, nullptr, -1, &additionalOutput);
+
+        thread_local std::vector<std::pair<std::uint64_t, unsigned int>> ids;
+        ids.clear();
+        if (additionalOutput.bitInfoMap) {
+            for (const auto& [id, environments] : *additionalOutput.bitInfoMap) {
+                unsigned int first_radius = std::numeric_limits<unsigned int>::max();
+                for (const auto& environment : environments) {
+                    first_radius = std::min(first_radius, environment.second);
+                }
+                ids.emplace_back(id, first_radius);
+            }
+        }
+
+        thread_local std::vector<std::uint64_t> words;
+        for (std::size_t f = 0; f < folds.size(); ++f) {
+            const std::size_t size = folds[f].fingerprint_size;
+            if (!valid_fingerprint_size(size)) {
+                continue;
+            }
+            words.assign(packed_num_words(size), 0);
+            for (const auto& [id, first_radius] : ids) {
+                if (first_radius <= folds[f].radius) {
+                    const std::size_t bit = id % size;
+                    words[bit / 64] |= std::uint64_t{1} << (bit % 64);
+                }
+            }
+            write_fingerprint_words(words.data(), size, layout, out[f]);
+        }
+    } catch (const std::exception&) {
+        RDKTOOLS_COUNT(Exceptions);
+        // Leave every row zeroed on failure.
+        for (std::size_t f = 0; f < folds.size(); ++f) {
+            std::fill_n(out[f], fingerprint_row_bytes(folds[f].fingerprint_size, layout),
+                        static_cast<std::uint8_t>(0));
+        }
+    }
+}
+
+std::string trace_cache_tag(unsigned int radius,
+                            bool isomeric,
+                            bool kekulize,
+                            bool include_per_center,
+                            std::size_t fingerprint_size,
+                            FingerprintLayout layout) {
+    std::ostringstream tag;
+    tag << "trace:" << radius << ':' << isomeric << kekulize << include_per_center << ':'
+        << fingerprint_size << ':' << static_cast<int>(layout);
+    return tag.str();
+}
+
+std::string trace_tokens_cache_tag(unsigned int radius,
+                                   bool isomeric,
+                                   bool kekulize,
+                                   bool include_per_center,
+                                   std::size_t fingerprint_size,
+                                   FingerprintLayout layout,
+                                   const TraceVocabulary& vocabulary) {
+    return "tokens:" + std::to_string(vocabulary.generation()) + ':' +
+           trace_cache_tag(radius, isomeric, kekulize, include_per_center, fingerprint_size,
+                           layout);
+}
+
+void set_trace_cache_capacity(std::size_t capacity) {
+    token_metrics_cache().set_capacity(capacity);
+    fragment_smarts_cache().set_capacity(capacity);
+}
+
+std::size_t trace_cache_capacity() {
+    return token_metrics_cache().capacity();
+}
+
 ReasoningTraceResult ecfp_reasoning_trace_from_smiles(
     const std::string& smiles,
     unsigned int radius,
     bool isomeric,
     bool kekulize,
     bool include_per_center,
-    std::size_t fingerprint_size) {
-    std::vector<std::uint8_t> fingerprint(
-        fingerprint_size,
-        static_cast<std::uint8_t>(0));
+    std::size_t fingerprint_size,
+    FingerprintLayout layout) {
+    const std::size_t row_bytes = fingerprint_row_bytes(fingerprint_size, layout);
+    ResultCache& cache = result_cache();
+    std::string key;
+    if (cache.enabled()) {
+        key = result_cache_key(trace_cache_tag(radius, isomeric, kekulize,
+                                               include_per_center, fingerprint_size,
+                                               layout),
+                               smiles);
+        std::string blob;
+        if (cache.find(key, blob) && blob.size() >= row_bytes) {
+            return {blob.substr(row_bytes),
+                    std::vector<std::uint8_t>(blob.begin(), blob.begin() + row_bytes)};
+        }
+    }
 
+    ReasoningTraceResult result;
     auto mol = smiles_to_mol(smiles);
-    if (!mol) {
-        return {std::string(), std::move(fingerprint)};
+    if (mol) {
+        result = ecfp_reasoning_trace_from_mol(*mol, radius, isomeric, kekulize,
+                                               include_per_center, fingerprint_size,
+                                               layout);
+    } else {
+        std::get<1>(result).assign(row_bytes, static_cast<std::uint8_t>(0));
     }
 
-    const auto per_center = ecfp_env_tokens_by_center(
-        *mol, radius, isomeric, kekulize, true, true);
-    fingerprint = compute_morgan_fingerprint_bits(
-        *mol, radius, isomeric, fingerprint_size);
-
-    std::map<unsigned int, std::map<std::string, unsigned int>> by_radius;
-    for (const auto& center_entry : per_center) {
-        for (const auto& layer_entry : center_entry.second) {
-            by_radius[layer_entry.first][layer_entry.second] += 1;
-        }
+    if (!key.empty()) {
+        const std::vector<std::uint8_t>& bits = std::get<1>(result);
+        std::string blob(bits.begin(), bits.end());
+        blob.append(std::get<0>(result));
+        cache.insert(key, std::move(blob));
     }
+    return result;
+}
 
-    std::vector<std::string> lines;
-    for (const auto& radius_entry : by_radius) {
-        std::vector<std::pair<std::string, unsigned int>> tokens(
-            radius_entry.second.begin(), radius_entry.second.end());
-        std::sort(tokens.begin(), tokens.end(),
-                  [](const auto& lhs, const auto& rhs) {
-                      return complexity_key(lhs.first) <
-                             complexity_key(rhs.first);
-                  });
+ReasoningTraceResult ecfp_reasoning_trace_from_mol(
+    const RDKit::ROMol& mol,
+    unsigned int radius,
+    bool isomeric,
+    bool kekulize,
+    bool include_per_center,
+    std::size_t fingerprint_size,
+    FingerprintLayout layout) {
+    TraceParts parts =
+        trace_parts(mol, radius, isomeric, kekulize, fingerprint_size, layout);
 
+    RDKTOOLS_STAGE(Format);
+    std::vector<std::string> lines;
+    for (const auto& radius_entry : tokens_by_radius(parts.per_center)) {
         std::vector<std::string> pieces;
-        pieces.reserve(tokens.size());
-        for (const auto& token_count : tokens) {
+        pieces.reserve(radius_entry.second.size());
+        for (const auto& token_count : radius_entry.second) {
             std::ostringstream oss;
             oss << token_count.first << kCountSeparator << token_count.second;
             pieces.push_back(oss.str());
@@ -357,24 +712,18 @@ ReasoningTraceResult ecfp_reasoning_trace_from_smiles(
         lines.push_back(line.str());
     }
 
-    if (include_per_center && !per_center.empty()) {
+    if (include_per_center && !parts.per_center.empty()) {
         lines.emplace_back("");
         lines.emplace_back("# per-center chains");
 
-        for (const auto& center_entry : per_center) {
+        for (const auto& center_entry : parts.per_center) {
             const unsigned int atom_idx = center_entry.first;
-            const auto atom = mol->getAtomWithIdx(atom_idx);
-
-            std::vector<std::pair<unsigned int, std::string>> chain(
-                center_entry.second.begin(), center_entry.second.end());
-            std::sort(chain.begin(), chain.end(),
-                      [](const auto& lhs, const auto& rhs) {
-                          return lhs.first < rhs.first;
-                      });
+            const auto atom = mol.getAtomWithIdx(atom_idx);
 
+            // Layers are map keys, so the chain is already in radius order
             std::vector<std::string> tokens;
-            tokens.reserve(chain.size());
-            for (const auto& item : chain) {
+            tokens.reserve(center_entry.second.size());
+            for (const auto& item : center_entry.second) {
                 tokens.push_back(item.second);
             }
 
@@ -385,7 +734,93 @@ ReasoningTraceResult ecfp_reasoning_trace_from_smiles(
         }
     }
 
-    return {join_lines(lines), std::move(fingerprint)};
+    return {join_lines(lines), std::move(parts.fingerprint)};
+}
+
+ReasoningTokensResult ecfp_reasoning_tokens_from_mol(
+    const RDKit::ROMol& mol,
+    TraceVocabulary& vocabulary,
+    unsigned int radius,
+    bool isomeric,
+    bool kekulize,
+    bool include_per_center,
+    std::size_t fingerprint_size,
+    FingerprintLayout layout,
+    std::vector<std::string>* pending) {
+    // Reject radii without a marker token before doing any work
+    radius_token(radius);
+    TraceParts parts =
+        trace_parts(mol, radius, isomeric, kekulize, fingerprint_size, layout);
+
+    RDKTOOLS_STAGE(Format);
+    auto token_id = [&](const std::string& token) {
+        if (!pending) {
+            return vocabulary.id(token);
+        }
+        std::int32_t id = vocabulary.find(token);
+        if (id < 0) {
+            pending->push_back(token);
+            id = -static_cast<std::int32_t>(pending->size());
+        }
+        return id;
+    };
+    std::vector<std::int32_t> ids;
+    std::size_t num_lines = 0;
+    auto begin_line = [&] {
+        if (num_lines++ != 0) {
+            ids.push_back(kNewlineToken);
+        }
+    };
+
+    for (const auto& radius_entry : tokens_by_radius(parts.per_center)) {
+        begin_line();
+        ids.push_back(radius_token(radius_entry.first));
+        for (const auto& token_count : radius_entry.second) {
+            ids.push_back(token_id(token_count.first));
+            ids.push_back(kCountToken);
+            append_number_tokens(token_count.second, ids);
+        }
+    }
+
+    if (include_per_center && !parts.per_center.empty()) {
+        begin_line();
+        begin_line();
+        ids.push_back(kChainsToken);
+
+        for (const auto& center_entry : parts.per_center) {
+            begin_line();
+            ids.push_back(token_id(mol.getAtomWithIdx(center_entry.first)->getSymbol()));
+            append_number_tokens(center_entry.first, ids);
+            bool first = true;
+            for (const auto& item : center_entry.second) {
+                if (!first) {
+                    ids.push_back(kArrowToken);
+                }
+                first = false;
+                ids.push_back(token_id(item.second));
+            }
+        }
+    }
+
+    return {std::move(ids), std::move(parts.fingerprint)};
+}
+
+void resolve_pending_tokens(std::vector<std::int32_t>& ids,
+                            const std::vector<std::string>& pending,
+                            TraceVocabulary& vocabulary) {
+    if (pending.empty()) {
+        return;
+    }
+    std::vector<std::int32_t> resolved;
+    resolved.reserve(pending.size());
+    for (const std::string& token : pending) {
+        resolved.push_back(vocabulary.id(token));
+    }
+    for (std::int32_t& id : ids) {
+        if (id < 0) {
+            id = resolved[static_cast<std::size_t>(-id) - 1];
+        }
+    }
 }
 
 } // namespace rdktools
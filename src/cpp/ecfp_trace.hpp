@@ -1,5 +1,7 @@
 #pragma once
 
+#include "bit_packing.hpp"
+#include "trace_vocab.hpp"
 #include <GraphMol/GraphMol.h>
 #include <cstddef>
 #include <cstdint>
@@ -14,12 +16,170 @@ inline constexpr std::size_t kECFPReasoningFingerprintSize = 2048;
 using ReasoningTraceResult =
     std::tuple<std::string, std::vector<std::uint8_t>>;
 
+/**
+ * @brief Build the reasoning trace and fingerprint for an already parsed molecule
+ *
+ * The fingerprint bytes follow the requested layout: one byte per bit for
+ * Dense, np.packbits order for PackedBytes, little-endian uint64 words for
+ * PackedWords.
+ */
+ReasoningTraceResult ecfp_reasoning_trace_from_mol(
+    const RDKit::ROMol& mol,
+    unsigned int radius,
+    bool isomeric,
+    bool kekulize,
+    bool include_per_center,
+    std::size_t fingerprint_size = kECFPReasoningFingerprintSize,
+    FingerprintLayout layout = FingerprintLayout::Dense);
+
+using ReasoningTokensResult =
+    std::tuple<std::vector<std::int32_t>, std::vector<std::uint8_t>>;
+
+/**
+ * @brief Build the reasoning trace as token ids instead of text
+ *
+ * Describes the same environments in the same order as
+ * ecfp_reasoning_trace_from_mol(), and vocabulary.decode() of the ids
+ * reproduces its text exactly; no text is assembled on the way. Environments
+ * and atom symbols missing from a frozen vocabulary become kUnknownToken.
+ *
+ * Without pending, pieces a growing vocabulary has not seen are added as they
+ * are met. With it they are left out of the vocabulary: the k-th such piece
+ * is appended to pending and written as id -k, for the caller to intern with
+ * resolve_pending_tokens() in a fixed order.
+ *
+ * @throws std::invalid_argument if radius exceeds kMaxTokenRadius
+ */
+ReasoningTokensResult ecfp_reasoning_tokens_from_mol(
+    const RDKit::ROMol& mol,
+    TraceVocabulary& vocabulary,
+    unsigned int radius,
+    bool isomeric,
+    bool kekulize,
+    bool include_per_center,
+    std::size_t fingerprint_size = kECFPReasoningFingerprintSize,
+    FingerprintLayout layout = FingerprintLayout::Dense,
+    std::vector<std::string>* pending = nullptr);
+
+/**
+ * @brief Intern the pending pieces of one row and patch their ids
+ *
+ * Replaces every id -k in ids with vocabulary.id(pending[k - 1]). Calling
+ * it row by row in input order gives new pieces the same ids however the
+ * rows were scheduled.
+ */
+void resolve_pending_tokens(std::vector<std::int32_t>& ids,
+                            const std::vector<std::string>& pending,
+                            TraceVocabulary& vocabulary);
+
+/**
+ * @brief Parse a SMILES string and build its reasoning trace and fingerprint
+ *
+ * Invalid SMILES yield an empty trace and an all-zero fingerprint.
+ */
 ReasoningTraceResult ecfp_reasoning_trace_from_smiles(
     const std::string& smiles,
     unsigned int radius,
     bool isomeric,
     bool kekulize,
     bool include_per_center,
-    std::size_t fingerprint_size = kECFPReasoningFingerprintSize);
+    std::size_t fingerprint_size = kECFPReasoningFingerprintSize,
+    FingerprintLayout layout = FingerprintLayout::Dense);
+
+/**
+ * @brief Write the folded Morgan fingerprint of a molecule into one row
+ *
+ * Uses the same per-thread generator cache as the traces. The row holds
+ * fingerprint_row_bytes(fingerprint_size, layout) bytes and is left zeroed
+ * for invalid sizes or when fingerprinting fails.
+ */
+void morgan_fingerprint_row(const RDKit::ROMol& mol,
+                            unsigned int radius,
+                            bool include_chirality,
+                            std::size_t fingerprint_size,
+                            FingerprintLayout layout,
+                            std::uint8_t* out);
+
+/**
+ * @brief Write folded Morgan environment counts, one byte per bit
+ *        (saturating at 255), into a row of fingerprint_size bytes
+ */
+void morgan_count_row(const RDKit::ROMol& mol,
+                      unsigned int radius,
+                      bool include_chirality,
+                      std::size_t fingerprint_size,
+                      std::uint8_t* out);
+
+/**
+ * @brief One (radius, fold size) combination of a Morgan sweep
+ */
+struct MorganFold {
+    unsigned int radius;
+    std::size_t fingerprint_size;
+};
+
+/**
+ * @brief Write the folded Morgan fingerprint of every fold from one
+ *        environment enumeration
+ *
+ * Morgan is iterative, so the pass at the largest radius already contains
+ * every lower-radius environment. Its raw ids are kept with the first radius
+ * they appear at, and fold f sets bit id % size for the ids reached within
+ * its radius, which gives the same row as morgan_fingerprint_row() with
+ * that radius and size.
+ *
+ * @param out one row per fold, of fingerprint_row_bytes(size, layout) bytes;
+ *        rows of invalid sizes, and all rows when fingerprinting fails, are
+ *        left zeroed
+ */
+void morgan_sweep_rows(const RDKit::ROMol& mol,
+                       const std::vector<MorganFold>& folds,
+                       bool include_chirality,
+                       FingerprintLayout layout,
+                       std::uint8_t* const* out);
+
+/**
+ * @brief Result-cache tag for a trace computed with these options
+ *
+ * Cached trace results are encoded as the fingerprint row
+ * (fingerprint_row_bytes(fingerprint_size, layout) bytes) followed by the
+ * trace text; see result_cache.hpp.
+ */
+std::string trace_cache_tag(unsigned int radius,
+                            bool isomeric,
+                            bool kekulize,
+                            bool include_per_center,
+                            std::size_t fingerprint_size,
+                            FingerprintLayout layout);
+
+/**
+ * @brief Result-cache tag for tokenized traces computed with these options
+ *
+ * Includes the vocabulary generation, so replacing the process vocabulary
+ * retires every cached token row. Entries hold the fingerprint row
+ * followed by the little-endian int32 ids.
+ */
+std::string trace_tokens_cache_tag(unsigned int radius,
+                                   bool isomeric,
+                                   bool kekulize,
+                                   bool include_per_center,
+                                   std::size_t fingerprint_size,
+                                   FingerprintLayout layout,
+                                   const TraceVocabulary& vocabulary);
+
+/**
+ * @brief Resize the process-wide trace caches (environment SMARTS and the
+ *        fragment metrics used to order tokens; entries each, 0 disables)
+ *
+ * The initial capacity is RDKTOOLS_TRACE_CACHE_SIZE when set, otherwise
+ * 65536 entries. Capacities are rounded up to a multiple of the shard count
+ * and shrinking evicts the oldest entries immediately.
+ */
+void set_trace_cache_capacity(std::size_t capacity);
+
+/**
+ * @brief Current capacity of each trace cache (entries)
+ */
+std::size_t trace_cache_capacity();
 
 } // namespace rdktools
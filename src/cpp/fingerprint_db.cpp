@@ -0,0 +1,258 @@
+#include "fingerprint_db.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'R', 'D', 'K', 'F', 'P', 'D', 'B', '\0'};
+constexpr std::uint64_t kSectionAlignment = 64;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "the fingerprint database format is little-endian"
+#endif
+
+std::uint64_t align_up(std::uint64_t value) {
+    return (value + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+}
+
+std::uint32_t layout_code(rdktools::FingerprintLayout layout) {
+    switch (layout) {
+    case rdktools::FingerprintLayout::PackedBytes:
+        return 0;
+    case rdktools::FingerprintLayout::PackedWords:
+        return 1;
+    case rdktools::FingerprintLayout::Dense:
+    default:
+        throw std::invalid_argument(
+            "fingerprint databases store packed fingerprints ('bytes' or 'uint64')");
+    }
+}
+
+std::runtime_error db_error(const std::string& path, const std::string& what) {
+    return std::runtime_error("fingerprint database '" + path + "': " + what);
+}
+
+// Mode a plain ofstream would create files with. umask can only be read by
+// setting it, so it is read once and put straight back.
+mode_t new_file_mode() {
+    static const mode_t mode = [] {
+        const mode_t mask = ::umask(0);
+        ::umask(mask);
+        return static_cast<mode_t>(0666 & ~mask);
+    }();
+    return mode;
+}
+
+void write_padding(std::ofstream& out, std::uint64_t& position, std::uint64_t target) {
+    static const char zeros[kSectionAlignment] = {};
+    while (position < target) {
+        const std::uint64_t chunk = std::min<std::uint64_t>(target - position, sizeof(zeros));
+        out.write(zeros, static_cast<std::streamsize>(chunk));
+        position += chunk;
+    }
+}
+
+void write_bytes(std::ofstream& out, std::uint64_t& position, const void* data,
+                 std::uint64_t size) {
+    out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    position += size;
+}
+
+} // namespace
+
+namespace rdktools {
+
+void write_fingerprint_db(const std::string& path,
+                          const FingerprintView& fps,
+                          FingerprintLayout layout,
+                          std::size_t num_bits,
+                          const std::vector<std::string>* ids,
+                          int num_threads) {
+    FingerprintDbHeader header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFingerprintDbVersion;
+    header.layout = layout_code(layout);
+    header.num_rows = fps.rows;
+    header.row_bytes = fps.row_bytes;
+    header.num_bits = num_bits == 0 ? fps.row_bytes * 8 : num_bits;
+    if (header.num_bits > fps.row_bytes * 8) {
+        throw std::invalid_argument("num_bits exceeds the fingerprint row width");
+    }
+    if (ids && ids->size() != fps.rows) {
+        throw std::invalid_argument("ids must have one entry per fingerprint row");
+    }
+
+    std::vector<std::uint64_t> id_offsets;
+    if (ids) {
+        id_offsets.reserve(ids->size() + 1);
+        id_offsets.push_back(0);
+        for (const auto& id : *ids) {
+            id_offsets.push_back(id_offsets.back() + id.size());
+        }
+    }
+
+    header.rows_offset = align_up(sizeof(FingerprintDbHeader));
+    header.popcounts_offset = align_up(header.rows_offset + fps.rows * fps.row_bytes);
+    const std::uint64_t popcounts_end =
+        header.popcounts_offset + fps.rows * sizeof(std::uint32_t);
+    if (ids) {
+        header.id_offsets_offset = align_up(popcounts_end);
+        header.id_data_offset = align_up(
+            header.id_offsets_offset + id_offsets.size() * sizeof(std::uint64_t));
+        header.id_data_size = id_offsets.back();
+    }
+
+    const std::vector<std::uint32_t> popcounts = row_popcounts(fps, num_threads);
+
+    // Write next to the destination and rename, so readers never map a
+    // half-written file. The temp name is unique so concurrent writers to
+    // the same path never share one.
+    std::string tmp_path = path + ".tmp.XXXXXX";
+    const int tmp_fd = ::mkstemp(tmp_path.data());
+    if (tmp_fd < 0) {
+        throw db_error(tmp_path, std::string("cannot create: ") + std::strerror(errno));
+    }
+    // mkstemp creates the file owner-only; give it the mode ofstream would
+    if (::fchmod(tmp_fd, new_file_mode()) != 0) {
+        const std::string reason = std::strerror(errno);
+        ::close(tmp_fd);
+        std::remove(tmp_path.c_str());
+        throw db_error(tmp_path, "cannot set permissions: " + reason);
+    }
+    ::close(tmp_fd);
+    {
+        std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::remove(tmp_path.c_str());
+            throw db_error(tmp_path, "cannot open for writing");
+        }
+        std::uint64_t position = 0;
+        write_bytes(out, position, &header, sizeof(header));
+        write_padding(out, position, header.rows_offset);
+        write_bytes(out, position, fps.data, fps.rows * fps.row_bytes);
+        write_padding(out, position, header.popcounts_offset);
+        write_bytes(out, position, popcounts.data(), popcounts.size() * sizeof(std::uint32_t));
+        if (ids) {
+            write_padding(out, position, header.id_offsets_offset);
+            write_bytes(out, position, id_offsets.data(), id_offsets.size() * sizeof(std::uint64_t));
+            write_padding(out, position, header.id_data_offset);
+            for (const auto& id : *ids) {
+                write_bytes(out, position, id.data(), id.size());
+            }
+        }
+        out.flush();
+        if (!out) {
+            std::remove(tmp_path.c_str());
+            throw db_error(tmp_path, "write failed");
+        }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        const std::string reason = std::strerror(errno);
+        std::remove(tmp_path.c_str());
+        throw db_error(path, "rename failed: " + reason);
+    }
+}
+
+FingerprintDb::FingerprintDb(const std::string& path) : path_(path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw db_error(path, std::strerror(errno));
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        const std::string reason = std::strerror(errno);
+        ::close(fd);
+        throw db_error(path, reason);
+    }
+    mapping_size_ = static_cast<std::size_t>(info.st_size);
+    if (mapping_size_ < sizeof(FingerprintDbHeader)) {
+        ::close(fd);
+        throw db_error(path, "file too small");
+    }
+    mapping_ = ::mmap(nullptr, mapping_size_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping_ == MAP_FAILED) {
+        mapping_ = nullptr;
+        throw db_error(path, std::string("mmap failed: ") + std::strerror(errno));
+    }
+
+    const auto* base = static_cast<const std::uint8_t*>(mapping_);
+    header_ = reinterpret_cast<const FingerprintDbHeader*>(base);
+    const std::uint64_t file_size = mapping_size_;
+    const auto section_fits = [&](std::uint64_t offset, std::uint64_t count,
+                                  std::uint64_t element_size) {
+        return offset % kSectionAlignment == 0 &&
+               offset >= sizeof(FingerprintDbHeader) && offset <= file_size &&
+               (element_size == 0 || count <= (file_size - offset) / element_size);
+    };
+
+    const char* problem = nullptr;
+    if (std::memcmp(header_->magic, kMagic, sizeof(kMagic)) != 0) {
+        problem = "not a fingerprint database";
+    } else if (header_->version != kFingerprintDbVersion) {
+        problem = "unsupported format version";
+    } else if (header_->layout > 1) {
+        problem = "unknown fingerprint layout";
+    } else if (header_->layout == 1 && header_->row_bytes % sizeof(std::uint64_t) != 0) {
+        problem = "word rows must be a multiple of 8 bytes";
+    } else if (header_->num_bits > header_->row_bytes * 8) {
+        problem = "num_bits exceeds the row width";
+    } else if (header_->row_bytes == 0 && header_->num_rows != 0) {
+        problem = "zero-width rows";
+    } else if (!section_fits(header_->rows_offset, header_->num_rows, header_->row_bytes) ||
+               !section_fits(header_->popcounts_offset, header_->num_rows,
+                             sizeof(std::uint32_t))) {
+        problem = "truncated file";
+    } else if (header_->id_offsets_offset != 0 &&
+               (!section_fits(header_->id_offsets_offset, header_->num_rows + 1,
+                              sizeof(std::uint64_t)) ||
+                !section_fits(header_->id_data_offset, header_->id_data_size, 1))) {
+        problem = "truncated ID table";
+    }
+    if (problem) {
+        ::munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+        throw db_error(path, problem);
+    }
+
+    layout_ = header_->layout == 0 ? FingerprintLayout::PackedBytes
+                                   : FingerprintLayout::PackedWords;
+    fingerprints_.data = base + header_->rows_offset;
+    fingerprints_.rows = static_cast<std::size_t>(header_->num_rows);
+    fingerprints_.row_bytes = static_cast<std::size_t>(header_->row_bytes);
+    popcounts_ = reinterpret_cast<const std::uint32_t*>(base + header_->popcounts_offset);
+    if (header_->id_offsets_offset != 0) {
+        id_offsets_ = reinterpret_cast<const std::uint64_t*>(base + header_->id_offsets_offset);
+        id_data_ = reinterpret_cast<const char*>(base + header_->id_data_offset);
+    }
+}
+
+FingerprintDb::~FingerprintDb() {
+    if (mapping_) {
+        ::munmap(mapping_, mapping_size_);
+    }
+}
+
+std::string_view FingerprintDb::id(std::size_t index) const {
+    if (!id_offsets_) {
+        return {};
+    }
+    const std::uint64_t begin = id_offsets_[index];
+    const std::uint64_t end = id_offsets_[index + 1];
+    if (begin > end || end > header_->id_data_size) {
+        return {};
+    }
+    return std::string_view(id_data_ + begin, static_cast<std::size_t>(end - begin));
+}
+
+} // namespace rdktools
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "bit_packing.hpp"
+#include "similarity.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief On-disk header of a fingerprint database file (format version 1)
+ *
+ * All fields are native little-endian. Sections start on 64-byte boundaries:
+ * packed fingerprint rows, one uint32 popcount per row and, when present, an
+ * ID table made of num_rows + 1 uint64 offsets into a UTF-8 blob.
+ */
+struct FingerprintDbHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t layout;  // 0 = np.packbits bytes, 1 = uint64 words
+    std::uint64_t num_rows;
+    std::uint64_t num_bits;
+    std::uint64_t row_bytes;
+    std::uint64_t rows_offset;
+    std::uint64_t popcounts_offset;
+    std::uint64_t id_offsets_offset;  // 0 when the file has no ID table
+    std::uint64_t id_data_offset;
+    std::uint64_t id_data_size;
+    std::uint64_t reserved[6];
+};
+static_assert(sizeof(FingerprintDbHeader) == 128,
+              "fingerprint database header must stay 128 bytes");
+
+constexpr std::uint32_t kFingerprintDbVersion = 1;
+
+/**
+ * @brief Write packed fingerprints to a database file
+ * @param path destination file; written to a temporary file and renamed
+ * @param fps packed fingerprint rows
+ * @param layout FingerprintLayout::PackedBytes or FingerprintLayout::PackedWords
+ * @param num_bits fingerprint length in bits (0 uses the full row width)
+ * @param ids optional per-row identifiers (nullptr for none)
+ * @param num_threads worker threads used for the popcounts
+ * @throws std::invalid_argument for bad arguments, std::runtime_error on I/O errors
+ */
+void write_fingerprint_db(const std::string& path,
+                          const FingerprintView& fps,
+                          FingerprintLayout layout,
+                          std::size_t num_bits,
+                          const std::vector<std::string>* ids,
+                          int num_threads = 0);
+
+/**
+ * @brief Read-only memory-mapped fingerprint database.
+ *
+ * The file is mapped shared, so every process opening the same database uses
+ * one copy in the page cache and opening costs only header validation.
+ */
+class FingerprintDb {
+public:
+    /**
+     * @brief Map and validate a database file
+     * @throws std::runtime_error if the file cannot be mapped or is malformed
+     */
+    explicit FingerprintDb(const std::string& path);
+    ~FingerprintDb();
+
+    FingerprintDb(const FingerprintDb&) = delete;
+    FingerprintDb& operator=(const FingerprintDb&) = delete;
+
+    const std::string& path() const { return path_; }
+    std::size_t size() const { return static_cast<std::size_t>(header_->num_rows); }
+    std::size_t num_bits() const { return static_cast<std::size_t>(header_->num_bits); }
+    FingerprintLayout layout() const { return layout_; }
+
+    /**
+     * @brief Fingerprint rows pointing straight into the mapping
+     */
+    FingerprintView fingerprints() const { return fingerprints_; }
+
+    /**
+     * @brief Precomputed bit count of every row
+     */
+    const std::uint32_t* popcounts() const { return popcounts_; }
+
+    bool has_ids() const { return id_offsets_ != nullptr; }
+
+    /**
+     * @brief Identifier of a row (empty when the file has no ID table)
+     */
+    std::string_view id(std::size_t index) const;
+
+private:
+    std::string path_;
+    void* mapping_ = nullptr;
+    std::size_t mapping_size_ = 0;
+    const FingerprintDbHeader* header_ = nullptr;
+    FingerprintLayout layout_ = FingerprintLayout::PackedBytes;
+    FingerprintView fingerprints_;
+    const std::uint32_t* popcounts_ = nullptr;
+    const std::uint64_t* id_offsets_ = nullptr;
+    const char* id_data_ = nullptr;
+};
+
+} // namespace rdktools
@@ -0,0 +1,125 @@
+#include "mol_batch.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
+#include <GraphMol/MolOps.h>
+#include <GraphMol/MolPickler.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <string_view>
+
+namespace rdktools {
+
+std::unique_ptr<RDKit::ROMol> smiles_to_mol_or_throw(const std::string& smiles) {
+    RDKTOOLS_STAGE(Parse);
+    try {
+        std::unique_ptr<RDKit::ROMol> mol(RDKit::SmilesToMol(smiles));
+        if (mol) {
+            RDKTOOLS_COUNT(MoleculesParsed);
+        } else {
+            RDKTOOLS_COUNT(InvalidSmiles);
+        }
+        return mol;
+    } catch (const std::exception&) {
+        RDKTOOLS_COUNT(InvalidSmiles);
+        RDKTOOLS_COUNT(Exceptions);
+        throw;
+    }
+}
+
+// Helper function to create molecule from SMILES
+std::unique_ptr<RDKit::ROMol> smiles_to_mol(const std::string& smiles) {
+    try {
+        return smiles_to_mol_or_throw(smiles);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+std::string mol_to_pickle(const RDKit::ROMol& mol) {
+    std::string pickle;
+    RDKit::MolPickler::pickleMol(mol, pickle);
+    return pickle;
+}
+
+std::unique_ptr<RDKit::ROMol> pickle_to_mol(std::string_view pickle) {
+    RDKTOOLS_STAGE(Unpickle);
+    if (pickle.empty()) {
+        RDKTOOLS_COUNT(InvalidSmiles);
+        return nullptr;
+    }
+    try {
+        auto mol = std::make_unique<RDKit::ROMol>();
+        RDKit::MolPickler::molFromPickle(std::string(pickle), mol.get());
+        if (!mol->getRingInfo()->isInitialized()) {
+            RDKit::MolOps::findSSSR(*mol);
+        }
+        RDKTOOLS_COUNT(MoleculesUnpickled);
+        return mol;
+    } catch (const std::exception&) {
+        RDKTOOLS_COUNT(InvalidSmiles);
+        RDKTOOLS_COUNT(Exceptions);
+        return nullptr;
+    }
+}
+
+ValidationLevel parse_validation_level(const std::string& name) {
+    if (name == "syntax") {
+        return ValidationLevel::Syntax;
+    }
+    if (name == "valence") {
+        return ValidationLevel::Valence;
+    }
+    if (name.empty() || name == "full") {
+        return ValidationLevel::Full;
+    }
+    throw std::invalid_argument(
+        "unknown validation level '" + name + "' (expected 'syntax', 'valence' or 'full')");
+}
+
+bool smiles_is_valid(const std::string& smiles, ValidationLevel level) {
+    if (level == ValidationLevel::Full) {
+        return smiles_to_mol(smiles) != nullptr;
+    }
+    // Without sanitization the parser reports syntax errors by returning
+    // nullptr rather than throwing
+    RDKit::SmilesParserParams params;
+    params.sanitize = false;
+    params.removeHs = false;
+    try {
+        std::unique_ptr<RDKit::RWMol> mol(RDKit::SmilesToMol(smiles, params));
+        if (!mol) {
+            return false;
+        }
+        if (level == ValidationLevel::Syntax) {
+            return true;
+        }
+        // Cleanup first so nitro-style N(=O)=O passes, as it does when sanitized
+        constexpr unsigned int checks = RDKit::MolOps::SANITIZE_CLEANUP |
+                                        RDKit::MolOps::SANITIZE_PROPERTIES |
+                                        RDKit::MolOps::SANITIZE_KEKULIZE;
+        return RDKit::MolOps::detectChemistryProblems(*mol, checks).empty();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+MolBatch::MolBatch(const SmilesColumn& smiles_list, int num_threads, MolInput input)
+    : mols_(smiles_list.size()), valid_(smiles_list.size(), 0) {
+    parallel_for(smiles_list.size(), num_threads, [&](std::size_t begin, std::size_t end) {
+        std::string scratch;
+        for (std::size_t i = begin; i < end; ++i) {
+            if (!smiles_list.is_null(i)) {
+                mols_[i] = input == MolInput::Pickle
+                               ? pickle_to_mol(smiles_list.view(i, scratch))
+                               : smiles_to_mol(smiles_list.str(i, scratch));
+            }
+            valid_[i] = mols_[i] ? 1 : 0;
+        }
+    });
+    num_valid_ = static_cast<std::size_t>(
+        std::count(valid_.begin(), valid_.end(), std::uint8_t{1}));
+}
+
+} // namespace rdktools
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "smiles_column.hpp"
+#include <GraphMol/ROMol.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief Parse and sanitize a SMILES string
+ * @param smiles SMILES string to parse
+ * @return parsed molecule, or nullptr when parsing or sanitization fails
+ */
+std::unique_ptr<RDKit::ROMol> smiles_to_mol(const std::string& smiles);
+
+/**
+ * @brief smiles_to_mol() that lets sanitization errors propagate, counted first
+ * @return parsed molecule, or nullptr when the SMILES does not parse
+ */
+std::unique_ptr<RDKit::ROMol> smiles_to_mol_or_throw(const std::string& smiles);
+
+/**
+ * @brief Serialize a molecule with RDKit's binary MolPickler format
+ */
+std::string mol_to_pickle(const RDKit::ROMol& mol);
+
+/**
+ * @brief Rebuild a molecule from a MolPickler pickle
+ *
+ * Pickles carry the sanitized molecule, so this skips the SMILES parser and
+ * sanitizer entirely; ring information is recomputed only when the pickle
+ * does not include it.
+ *
+ * @return the molecule, or nullptr for empty or malformed pickles
+ */
+std::unique_ptr<RDKit::ROMol> pickle_to_mol(std::string_view pickle);
+
+/**
+ * @brief Encoding of the strings a MolBatch is built from
+ */
+enum class MolInput {
+    Smiles,
+    Pickle,  // MolPickler bytes, as written by mol_to_pickle()
+};
+
+/**
+ * @brief How much of the RDKit pipeline smiles_is_valid() runs per string
+ */
+enum class ValidationLevel {
+    Syntax,   // parse only, no sanitization
+    Valence,  // parse, then check valences and kekulization
+    Full,     // complete sanitization, as smiles_to_mol()
+};
+
+/**
+ * @brief Parse "syntax", "valence" or "full"
+ * @throws std::invalid_argument for any other name
+ */
+ValidationLevel parse_validation_level(const std::string& name);
+
+/**
+ * @brief Check a SMILES string without keeping the molecule
+ *
+ * Lower levels skip sanitization in the parser and, for Valence, report
+ * chemistry problems through MolOps::detectChemistryProblems() instead of an
+ * exception, so the common invalid inputs never unwind.
+ */
+bool smiles_is_valid(const std::string& smiles, ValidationLevel level);
+
+/**
+ * @brief A list of molecules parsed once and shared by every batch function.
+ *
+ * Invalid inputs keep their row (as a null molecule) so results computed from
+ * a batch line up with the original input list.
+ */
+class MolBatch {
+public:
+    MolBatch() = default;
+
+    /**
+     * @brief Parse a list of SMILES strings (or pickles) on the worker pool
+     * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+     * @param num_threads worker threads to use (<= 0 selects the module default)
+     * @param input encoding of the elements; Pickle rows go through pickle_to_mol()
+     */
+    explicit MolBatch(const SmilesColumn& smiles_list,
+                      int num_threads = 0,
+                      MolInput input = MolInput::Smiles);
+
+    MolBatch(const MolBatch&) = delete;
+    MolBatch& operator=(const MolBatch&) = delete;
+
+    std::size_t size() const { return mols_.size(); }
+
+    /**
+     * @brief Molecule at the given row, or nullptr if the input was invalid
+     */
+    const RDKit::ROMol* mol(std::size_t index) const {
+        return mols_[index].get();
+    }
+
+    /**
+     * @brief Validity mask with one entry per input row (1 = parsed)
+     */
+    const std::vector<std::uint8_t>& valid_mask() const { return valid_; }
+
+    std::size_t num_valid() const { return num_valid_; }
+
+    /**
+     * @brief Mutex serialising batch functions that share this batch.
+     *
+     * RDKit caches descriptor results and output orderings as properties on
+     * the molecule, so two calls must not walk the same ROMol concurrently.
+     */
+    std::mutex& usage_mutex() const { return usage_mutex_; }
+
+private:
+    std::vector<std::unique_ptr<RDKit::ROMol>> mols_;
+    std::vector<std::uint8_t> valid_;
+    std::size_t num_valid_ = 0;
+    mutable std::mutex usage_mutex_;
+};
+
+} // namespace rdktools
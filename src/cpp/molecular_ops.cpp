@@ -1,13 +1,27 @@
 #include "molecular_ops.hpp"
+#include "bit_packing.hpp"
+#include "clustering.hpp"
+#include "descriptor_registry.hpp"
 #include "ecfp_trace.hpp"
+#include "result_cache.hpp"
+#include "stats.hpp"
+#include "substructure.hpp"
+#include "thread_pool.hpp"
+#include "trace_vocab.hpp"
+#include <DataStructs/ExplicitBitVect.h>
+#include <DataStructs/SparseIntVect.h>
 #include <GraphMol/Descriptors/MolDescriptors.h>
+#include <GraphMol/Fingerprints/FingerprintGenerator.h>
 #include <GraphMol/Fingerprints/MorganFingerprints.h>
+#include <GraphMol/Fingerprints/MorganGenerator.h>
 #include <GraphMol/FileParsers/MolSupplier.h>
 #include <GraphMol/MolOps.h>
 #include <GraphMol/SmilesParse/SmilesParse.h>
 #include <GraphMol/SmilesParse/SmilesWrite.h>
 #include <RDGeneral/RDLog.h>
 #include <algorithm>
+#include <cstring>
+#include <initializer_list>
 #include <iostream>
 #include <limits>
 #include <map>
@@ -15,217 +29,897 @@
 #include <set>
 #include <sstream>
 #include <stdexcept>
+#include <type_traits>
 
 namespace rdktools {
 
 namespace nb = nanobind;
 
-// Helper function to create molecule from SMILES
-std::unique_ptr<RDKit::ROMol> smiles_to_mol(const std::string& smiles) {
-    try {
-        std::unique_ptr<RDKit::ROMol> mol(RDKit::SmilesToMol(smiles));
-        return mol;
-    } catch (const std::exception& e) {
-        return nullptr;
+namespace {
+
+template <typename T>
+nb::capsule array_owner(T* data) {
+    return nb::capsule(data, [](void* p) noexcept {
+        delete[] static_cast<T*>(p);
+    });
+}
+
+// Hand a vector's storage to numpy without copying it
+template <typename T>
+nb::ndarray<nb::numpy, T> vector_array(std::vector<T>&& values,
+                                       std::initializer_list<size_t> shape) {
+    auto* owned = new std::vector<T>(std::move(values));
+    nb::capsule owner(owned, [](void* p) noexcept {
+        delete static_cast<std::vector<T>*>(p);
+    });
+    return nb::ndarray<nb::numpy, T>(owned->data(), shape, owner);
+}
+
+template <typename T>
+constexpr const char* dtype_label() {
+    if constexpr (std::is_same_v<T, float>) {
+        return "float32";
+    } else if constexpr (std::is_same_v<T, double>) {
+        return "float64";
+    } else if constexpr (std::is_same_v<T, bool>) {
+        return "bool";
+    } else if constexpr (std::is_same_v<T, uint8_t>) {
+        return "uint8";
+    } else if constexpr (std::is_same_v<T, int64_t>) {
+        return "int64";
+    } else {
+        static_assert(std::is_same_v<T, uint64_t>, "unsupported output dtype");
+        return "uint64";
     }
 }
 
-nb::ndarray<nb::numpy, double> calculate_molecular_weights(const std::vector<std::string>& smiles_list) {
-    size_t size = smiles_list.size();
-    
-    // Allocate memory for result
-    double* data = new double[size];
-    
-    // Process each SMILES
-    for (size_t i = 0; i < size; ++i) {
-        auto mol = smiles_to_mol(smiles_list[i]);
-        if (mol) {
-            data[i] = RDKit::Descriptors::calcAMW(*mol);
-        } else {
-            data[i] = std::numeric_limits<double>::quiet_NaN();
+// Destination of a batch result: data is written by the workers and array is
+// what the binding returns
+template <typename T>
+struct Output {
+    T* data;
+    nb::object array;
+};
+
+// Number of elements in an array of this shape
+template <typename T>
+size_t checked_count(std::initializer_list<size_t> shape) {
+    size_t count = 1;
+    for (size_t extent : shape) {
+        if (extent != 0 && count > std::numeric_limits<size_t>::max() / sizeof(T) / extent) {
+            throw std::overflow_error("result array is too large");
         }
+        count *= extent;
+    }
+    return count;
+}
+
+// Use the caller's out= array after checking it matches the result exactly,
+// or allocate a fresh one when out is None. Must be called with the GIL held.
+template <typename T>
+Output<T> make_output(const nb::object& out, std::initializer_list<size_t> shape) {
+    const size_t count = checked_count<T>(shape);
+    if (out.is_none()) {
+        // Owned here until the capsule takes over, so a throw in between
+        // cannot leak the buffer
+        std::unique_ptr<T[]> buffer(new T[count]);
+        nb::capsule owner = array_owner(buffer.get());
+        T* data = buffer.release();
+        return {data, nb::cast(nb::ndarray<nb::numpy, T>(data, shape, owner))};
     }
-    
-    // Create nanobind capsule for memory management
-    nb::capsule owner(data, [](void *p) noexcept {
-        delete[] static_cast<double*>(p);
+
+    std::ostringstream expected;
+    expected << "out must be a writable C-contiguous " << dtype_label<T>() << " array of shape (";
+    for (auto it = shape.begin(); it != shape.end(); ++it) {
+        expected << (it == shape.begin() ? "" : ", ") << *it;
+    }
+    expected << (shape.size() == 1 ? ",)" : ")");
+
+    OutputArray array;
+    if (!nb::try_cast(out, array, false)) {
+        throw nb::type_error(expected.str().c_str());
+    }
+    bool matches = array.dtype() == nb::dtype<T>() && array.ndim() == shape.size();
+    int64_t stride = 1;
+    for (size_t d = shape.size(); matches && d-- > 0;) {
+        const size_t extent = *(shape.begin() + d);
+        matches = array.shape(d) == extent && (extent <= 1 || array.stride(d) == stride);
+        stride *= static_cast<int64_t>(extent);
+    }
+    if (!matches) {
+        throw std::invalid_argument(expected.str());
+    }
+    return {static_cast<T*>(array.data()), out};
+}
+
+// Split an out= tuple of several result arrays into one out per array, all
+// None when out is None
+std::vector<nb::object> output_parts(const nb::object& out, size_t count, const char* what) {
+    if (out.is_none()) {
+        return std::vector<nb::object>(count, nb::none());
+    }
+    nb::tuple parts;
+    if (!nb::try_cast(out, parts, false) || parts.size() != count) {
+        throw nb::type_error(("out must be a tuple of " + std::string(what)).c_str());
+    }
+    std::vector<nb::object> result;
+    for (size_t i = 0; i < count; ++i) {
+        result.push_back(parts[i]);
+    }
+    return result;
+}
+
+size_t input_size(const SmilesColumn& smiles_list) {
+    return smiles_list.size();
+}
+
+size_t input_size(const MolBatch& batch) {
+    return batch.size();
+}
+
+// Visit every input row on the worker pool. The callback receives the row
+// index and the molecule, or nullptr when the input is invalid or null.
+// Callers must release the GIL first.
+template <typename Fn>
+void for_each_mol(const SmilesColumn& smiles_list, int num_threads, Fn&& fn) {
+    parallel_for(smiles_list.size(), num_threads, [&](size_t begin, size_t end) {
+        std::string scratch;
+        for (size_t i = begin; i < end; ++i) {
+            if (smiles_list.is_null(i)) {
+                fn(i, nullptr);
+                continue;
+            }
+            auto mol = smiles_to_mol(smiles_list.str(i, scratch));
+            fn(i, mol.get());
+        }
     });
-    
-    // Create nanobind ndarray
-    return nb::ndarray<nb::numpy, double>(data, {size}, owner);
 }
 
-nb::ndarray<nb::numpy, double> calculate_logp(const std::vector<std::string>& smiles_list) {
-    size_t size = smiles_list.size();
-    
-    double* data = new double[size];
-    
-    for (size_t i = 0; i < size; ++i) {
-        auto mol = smiles_to_mol(smiles_list[i]);
-        if (mol) {
-            data[i] = RDKit::Descriptors::calcClogP(*mol);
-        } else {
-            data[i] = std::numeric_limits<double>::quiet_NaN();
+template <typename Fn>
+void for_each_mol(const MolBatch& batch, int num_threads, Fn&& fn) {
+    std::lock_guard<std::mutex> guard(batch.usage_mutex());
+    parallel_for(batch.size(), num_threads, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            fn(i, batch.mol(i));
         }
-    }
-    
-    nb::capsule owner(data, [](void *p) noexcept {
-        delete[] static_cast<double*>(p);
     });
-    
-    return nb::ndarray<nb::numpy, double>(data, {size}, owner);
 }
 
-nb::ndarray<nb::numpy, double> calculate_tpsa(const std::vector<std::string>& smiles_list) {
-    size_t size = smiles_list.size();
-    
-    double* data = new double[size];
-    
-    for (size_t i = 0; i < size; ++i) {
-        auto mol = smiles_to_mol(smiles_list[i]);
-        if (mol) {
-            data[i] = RDKit::Descriptors::calcTPSA(*mol);
-        } else {
-            data[i] = std::numeric_limits<double>::quiet_NaN();
+// Like for_each_mol, but rows whose result for tag is in the process-wide
+// result cache are restored with load(i, blob) without being parsed; freshly
+// computed rows are encoded with store(i, blob) and inserted. load returns
+// false for a stale or malformed entry. With dedup, only the first
+// occurrence of each distinct SMILES is computed and the repeats are copied
+// from it through the same store/load encoding. Pre-parsed MolBatch input
+// has no SMILES key and bypasses both.
+template <typename Compute, typename Load, typename Store>
+void for_each_mol_cached(const SmilesColumn& smiles_list, int num_threads, bool dedup,
+                         const std::string& tag, Compute&& compute, Load&& load,
+                         Store&& store) {
+    ResultCache& cache = result_cache();
+    if (!cache.enabled() && !dedup) {
+        for_each_mol(smiles_list, num_threads, compute);
+        return;
+    }
+
+    std::vector<size_t> rows;
+    std::vector<size_t> first;
+    if (dedup) {
+        first = first_occurrences(smiles_list);
+        for (size_t i = 0; i < first.size(); ++i) {
+            if (first[i] == i) {
+                rows.push_back(i);
+            }
         }
     }
-    
-    nb::capsule owner(data, [](void *p) noexcept {
-        delete[] static_cast<double*>(p);
+    const size_t count = dedup ? rows.size() : smiles_list.size();
+
+    parallel_for(count, num_threads, [&](size_t begin, size_t end) {
+        std::string scratch;
+        std::string blob;
+        for (size_t k = begin; k < end; ++k) {
+            const size_t i = dedup ? rows[k] : k;
+            if (smiles_list.is_null(i)) {
+                compute(i, nullptr);
+                continue;
+            }
+            const std::string& smiles = smiles_list.str(i, scratch);
+            if (!cache.enabled()) {
+                auto mol = smiles_to_mol(smiles);
+                compute(i, mol.get());
+                continue;
+            }
+            std::string key = result_cache_key(tag, smiles);
+            if (cache.find(key, blob) && load(i, blob)) {
+                continue;
+            }
+            auto mol = smiles_to_mol(smiles);
+            compute(i, mol.get());
+            blob.clear();
+            store(i, blob);
+            cache.insert(key, blob);
+        }
     });
-    
-    return nb::ndarray<nb::numpy, double>(data, {size}, owner);
+
+    if (dedup && rows.size() < first.size()) {
+        parallel_for(first.size(), num_threads, [&](size_t begin, size_t end) {
+            std::string blob;
+            for (size_t i = begin; i < end; ++i) {
+                if (first[i] != i) {
+                    blob.clear();
+                    store(first[i], blob);
+                    load(i, blob);
+                }
+            }
+        });
+    }
 }
 
-nb::ndarray<nb::numpy, bool> validate_smiles(const std::vector<std::string>& smiles_list) {
-    size_t size = smiles_list.size();
-    
-    bool* data = new bool[size];
-    
-    for (size_t i = 0; i < size; ++i) {
-        auto mol = smiles_to_mol(smiles_list[i]);
-        data[i] = (mol != nullptr);
+template <typename Compute, typename Load, typename Store>
+void for_each_mol_cached(const MolBatch& batch, int num_threads, bool, const std::string&,
+                         Compute&& compute, Load&&, Store&&) {
+    for_each_mol(batch, num_threads, compute);
+}
+
+// Fixed-size rows are cached as their raw bytes
+template <typename T>
+bool load_row(const std::string& blob, T* row, size_t count) {
+    if (blob.size() != count * sizeof(T)) {
+        return false;
     }
-    
-    nb::capsule owner(data, [](void *p) noexcept {
-        delete[] static_cast<bool*>(p);
-    });
-    
-    return nb::ndarray<nb::numpy, bool>(data, {size}, owner);
+    std::memcpy(row, blob.data(), blob.size());
+    return true;
+}
+
+template <typename T>
+void store_row(std::string& blob, const T* row, size_t count) {
+    blob.assign(reinterpret_cast<const char*>(row), count * sizeof(T));
+}
+
+// Apply a per-molecule descriptor, writing NaN for invalid input.
+template <typename T, typename Input, typename Descriptor>
+nb::object descriptor_array(
+    const Input& input,
+    int num_threads,
+    bool dedup,
+    const std::string& name,
+    Descriptor descriptor,
+    const nb::object& out
+) {
+    size_t size = input_size(input);
+    Output<T> result = make_output<T>(out, {size});
+    T* data = result.data;
+
+    {
+        nb::gil_scoped_release release;
+        for_each_mol_cached(
+            input, num_threads, dedup, name + ':' + dtype_label<T>(),
+            [&](size_t i, const RDKit::ROMol* mol) {
+                if (mol) {
+                    data[i] = static_cast<T>(descriptor(*mol));
+                } else {
+                    data[i] = std::numeric_limits<T>::quiet_NaN();
+                }
+            },
+            [&](size_t i, const std::string& blob) { return load_row(blob, data + i, 1); },
+            [&](size_t i, std::string& blob) { store_row(blob, data + i, 1); });
+    }
+
+    return result.array;
+}
+
+template <typename Input, typename Descriptor>
+nb::object descriptor_column(
+    const Input& input,
+    int num_threads,
+    bool dedup,
+    const std::string& name,
+    Descriptor descriptor,
+    const std::string& dtype,
+    const nb::object& out
+) {
+    if (dtype == "float64") {
+        return descriptor_array<double>(input, num_threads, dedup, name, descriptor, out);
+    }
+    if (dtype == "float32") {
+        return descriptor_array<float>(input, num_threads, dedup, name, descriptor, out);
+    }
+    throw std::invalid_argument("dtype must be 'float32' or 'float64'");
+}
+
+double molecular_weight(const RDKit::ROMol& mol) {
+    return RDKit::Descriptors::calcAMW(mol);
+}
+
+double logp(const RDKit::ROMol& mol) {
+    return RDKit::Descriptors::calcClogP(mol);
+}
+
+double tpsa(const RDKit::ROMol& mol) {
+    return RDKit::Descriptors::calcTPSA(mol);
 }
 
-nb::dict calculate_multiple_descriptors(const std::vector<std::string>& smiles_list) {
+template <typename Input>
+nb::object validate_impl(const Input& input, int num_threads, const nb::object& out) {
+    size_t size = input_size(input);
+
+    Output<bool> result = make_output<bool>(out, {size});
+    bool* data = result.data;
+
+    {
+        nb::gil_scoped_release release;
+        for_each_mol(input, num_threads, [&](size_t i, const RDKit::ROMol* mol) {
+            data[i] = (mol != nullptr);
+        });
+    }
+
+    return result.array;
+}
+
+// Validity below full sanitization, without building a kept molecule
+nb::object validate_level(const SmilesColumn& smiles_list, ValidationLevel level,
+                          int num_threads, const nb::object& out) {
     size_t size = smiles_list.size();
-    
-    // Allocate memory for arrays
-    double* mw_data = new double[size];
-    double* logp_data = new double[size];
-    double* tpsa_data = new double[size];
-    
-    // Process each SMILES once and calculate all descriptors
-    for (size_t i = 0; i < size; ++i) {
-        auto mol = smiles_to_mol(smiles_list[i]);
-        if (mol) {
-            mw_data[i] = RDKit::Descriptors::calcAMW(*mol);
-            logp_data[i] = RDKit::Descriptors::calcClogP(*mol);
-            tpsa_data[i] = RDKit::Descriptors::calcTPSA(*mol);
-        } else {
-            mw_data[i] = std::numeric_limits<double>::quiet_NaN();
-            logp_data[i] = std::numeric_limits<double>::quiet_NaN();
-            tpsa_data[i] = std::numeric_limits<double>::quiet_NaN();
-        }
-    }
-    
-    // Create capsules for memory management
-    nb::capsule mw_owner(mw_data, [](void *p) noexcept { delete[] static_cast<double*>(p); });
-    nb::capsule logp_owner(logp_data, [](void *p) noexcept { delete[] static_cast<double*>(p); });
-    nb::capsule tpsa_owner(tpsa_data, [](void *p) noexcept { delete[] static_cast<double*>(p); });
-    
-    // Create arrays
-    auto mw_result = nb::ndarray<nb::numpy, double>(mw_data, {size}, mw_owner);
-    auto logp_result = nb::ndarray<nb::numpy, double>(logp_data, {size}, logp_owner);
-    auto tpsa_result = nb::ndarray<nb::numpy, double>(tpsa_data, {size}, tpsa_owner);
-    
+
+    Output<bool> result = make_output<bool>(out, {size});
+    bool* data = result.data;
+
+    {
+        nb::gil_scoped_release release;
+        parallel_for(size, num_threads, [&](size_t begin, size_t end) {
+            std::string scratch;
+            for (size_t i = begin; i < end; ++i) {
+                data[i] = !smiles_list.is_null(i) &&
+                          smiles_is_valid(smiles_list.str(i, scratch), level);
+            }
+        });
+    }
+
+    return result.array;
+}
+
+template <typename Input>
+nb::dict multiple_descriptors_impl(const Input& input, int num_threads, bool dedup,
+                                   const nb::object& out) {
+    size_t size = input_size(input);
+    const std::vector<nb::object> outs =
+        output_parts(out, 3, "three float64 arrays (molecular_weight, logp, tpsa)");
+    Output<double> mw = make_output<double>(outs[0], {size});
+    Output<double> logp_out = make_output<double>(outs[1], {size});
+    Output<double> tpsa_out = make_output<double>(outs[2], {size});
+    double* mw_data = mw.data;
+    double* logp_data = logp_out.data;
+    double* tpsa_data = tpsa_out.data;
+
+    // Process each molecule once and calculate all descriptors
+    {
+        nb::gil_scoped_release release;
+        // Same tag and row encoding as calculate_descriptors with these three
+        // names as float64, so the two share cached rows
+        for_each_mol_cached(
+            input, num_threads, dedup, "descriptors:float64:molecular_weight,logp,tpsa",
+            [&](size_t i, const RDKit::ROMol* mol) {
+                if (mol) {
+                    mw_data[i] = molecular_weight(*mol);
+                    logp_data[i] = logp(*mol);
+                    tpsa_data[i] = tpsa(*mol);
+                } else {
+                    mw_data[i] = std::numeric_limits<double>::quiet_NaN();
+                    logp_data[i] = std::numeric_limits<double>::quiet_NaN();
+                    tpsa_data[i] = std::numeric_limits<double>::quiet_NaN();
+                }
+            },
+            [&](size_t i, const std::string& blob) {
+                double row[3];
+                if (!load_row(blob, row, 3)) {
+                    return false;
+                }
+                mw_data[i] = row[0];
+                logp_data[i] = row[1];
+                tpsa_data[i] = row[2];
+                return true;
+            },
+            [&](size_t i, std::string& blob) {
+                const double row[3] = {mw_data[i], logp_data[i], tpsa_data[i]};
+                store_row(blob, row, 3);
+            });
+    }
+
     nb::dict result;
-    result["molecular_weight"] = mw_result;
-    result["logp"] = logp_result;
-    result["tpsa"] = tpsa_result;
-    
+    result["molecular_weight"] = mw.array;
+    result["logp"] = logp_out.array;
+    result["tpsa"] = tpsa_out.array;
+
     return result;
 }
 
-std::vector<std::string> canonicalize_smiles(const std::vector<std::string>& smiles_list) {
-    std::vector<std::string> result;
-    result.reserve(smiles_list.size());
-    
-    for (const auto& smiles : smiles_list) {
-        auto mol = smiles_to_mol(smiles);
-        if (mol) {
-            result.push_back(RDKit::MolToSmiles(*mol));
-        } else {
-            result.push_back("");
-        }
+// Fill one contiguous N x D matrix from a plan resolved once up front
+template <typename T, typename Input>
+nb::object descriptor_matrix(
+    const Input& input,
+    const DescriptorPlan& plan,
+    const std::string& dtype,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
+) {
+    const size_t size = input_size(input);
+    const size_t width = plan.size();
+    Output<T> result = make_output<T>(out, {size, width});
+    T* values = result.data;
+
+    std::string tag = "descriptors:" + dtype + ":";
+    for (size_t d = 0; d < width; ++d) {
+        tag += (d ? "," : "") + plan.names()[d];
+    }
+
+    {
+        nb::gil_scoped_release release;
+        for_each_mol_cached(
+            input, num_threads, dedup, tag,
+            [&](size_t i, const RDKit::ROMol* mol) {
+                T* row = values + i * width;
+                if (mol) {
+                    plan.compute(*mol, row);
+                } else {
+                    plan.fill_invalid(row);
+                }
+            },
+            [&](size_t i, const std::string& blob) {
+                return load_row(blob, values + i * width, width);
+            },
+            [&](size_t i, std::string& blob) {
+                store_row(blob, values + i * width, width);
+            });
     }
-    
+
+    return result.array;
+}
+
+template <typename Input>
+nb::object descriptors_impl(
+    const Input& input,
+    const std::vector<std::string>& names,
+    const std::string& dtype,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
+) {
+    const DescriptorPlan plan(names);
+    if (dtype == "float32") {
+        return descriptor_matrix<float>(input, plan, dtype, num_threads, dedup, out);
+    }
+    if (dtype == "float64") {
+        return descriptor_matrix<double>(input, plan, dtype, num_threads, dedup, out);
+    }
+    throw std::invalid_argument("dtype must be 'float32' or 'float64'");
+}
+
+template <typename Input>
+std::vector<std::string> canonicalize_impl(const Input& input, int num_threads, bool dedup) {
+    std::vector<std::string> result(input_size(input));
+
+    nb::gil_scoped_release release;
+    for_each_mol_cached(
+        input, num_threads, dedup, "canonical_smiles",
+        [&](size_t i, const RDKit::ROMol* mol) {
+            if (mol) {
+                result[i] = RDKit::MolToSmiles(*mol);
+            }
+        },
+        [&](size_t i, const std::string& blob) {
+            result[i] = blob;
+            return true;
+        },
+        [&](size_t i, std::string& blob) { blob = result[i]; });
+
     return result;
 }
 
-nb::ndarray<nb::numpy, uint8_t> calculate_morgan_fingerprints(
-    const std::vector<std::string>& smiles_list,
+template <typename Element, typename Input>
+nb::object morgan_fingerprints_array(
+    const Input& input,
     int radius,
-    int nbits
+    int nbits,
+    FingerprintLayout layout,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
 ) {
-    size_t size = smiles_list.size();
-    
-    // Allocate memory for 2D array (size x nbits)
-    uint8_t* data = new uint8_t[size * nbits];
-    
-    for (size_t i = 0; i < size; ++i) {
-        auto mol = smiles_to_mol(smiles_list[i]);
-        if (mol) {
-            try {
-                auto fp = RDKit::MorganFingerprints::getFingerprintAsBitVect(*mol, radius, nbits);
-                
-                // Copy bits to result array
-                for (int j = 0; j < nbits; ++j) {
-                    data[i * nbits + j] = fp->getBit(j) ? 1 : 0;
+    size_t size = input_size(input);
+    const size_t row_elements = fingerprint_row_elements(static_cast<size_t>(nbits), layout);
+    const size_t row_bytes = fingerprint_row_bytes(static_cast<size_t>(nbits), layout);
+
+    // Every row is written by a worker, so neither buffer is zeroed up front
+    Output<Element> result = make_output<Element>(out, {size, row_elements});
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(result.data);
+
+    // Layouts share cached rows only with themselves, so the tag carries it
+    const std::string tag = "morgan:" + std::to_string(radius) + ':' + std::to_string(nbits) +
+                            ':' + std::to_string(static_cast<int>(layout));
+
+    {
+        nb::gil_scoped_release release;
+        for_each_mol_cached(
+            input, num_threads, dedup, tag,
+            [&](size_t i, const RDKit::ROMol* mol) {
+                if (!mol) {
+                    std::fill_n(bytes + i * row_bytes, row_bytes, uint8_t{0});
+                    return;
                 }
-            } catch (const std::exception& e) {
-                // On error, set all bits to 0
-                for (int j = 0; j < nbits; ++j) {
-                    data[i * nbits + j] = 0;
+                try {
+                    std::unique_ptr<ExplicitBitVect> fp(
+                        RDKit::MorganFingerprints::getFingerprintAsBitVect(*mol, radius, nbits));
+
+                    // Copy storage words to result array
+                    write_fingerprint_row(*fp, static_cast<size_t>(nbits), layout, bytes + i * row_bytes);
+                } catch (const std::exception& e) {
+                    // On error, leave the row zeroed
+                    std::fill_n(bytes + i * row_bytes, row_bytes, uint8_t{0});
+                }
+            },
+            [&](size_t i, const std::string& blob) {
+                return load_row(blob, bytes + i * row_bytes, row_bytes);
+            },
+            [&](size_t i, std::string& blob) { store_row(blob, bytes + i * row_bytes, row_bytes); });
+    }
+
+    return result.array;
+}
+
+template <typename Input>
+nb::object morgan_fingerprints_impl(
+    const Input& input,
+    int radius,
+    int nbits,
+    int num_threads,
+    const std::string& layout_name,
+    bool dedup,
+    const nb::object& out
+) {
+    if (nbits <= 0) {
+        throw std::invalid_argument("nbits must be positive");
+    }
+    const FingerprintLayout layout = parse_fingerprint_layout(layout_name);
+    if (layout == FingerprintLayout::PackedWords) {
+        return morgan_fingerprints_array<uint64_t>(input, radius, nbits, layout, num_threads,
+                                                   dedup, out);
+    }
+    return morgan_fingerprints_array<uint8_t>(input, radius, nbits, layout, num_threads, dedup,
+                                              out);
+}
+
+// Every (radius, nbits) fold from one Morgan enumeration per molecule, one
+// matrix per fold keyed by (radius, nbits). Folds found in the out dict are
+// written in place; the rest are allocated.
+template <typename Element, typename Input>
+nb::dict morgan_sweep_arrays(
+    const Input& input,
+    const std::vector<MorganFold>& folds,
+    FingerprintLayout layout,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
+) {
+    const size_t size = input_size(input);
+    nb::dict outs;
+    if (!out.is_none() && !nb::try_cast(out, outs, false)) {
+        throw nb::type_error("out must be a dict mapping (radius, nbits) to an array");
+    }
+
+    nb::dict result;
+    std::vector<uint8_t*> buffers;
+    std::vector<size_t> row_bytes;
+    size_t total_bytes = 0;
+    // A cached row holds every fold's row back to back, so the tag names
+    // the whole fold set
+    std::string tag = "morgan_sweep:" + std::to_string(static_cast<int>(layout));
+    for (const MorganFold& fold : folds) {
+        nb::tuple key = nb::make_tuple(fold.radius, fold.fingerprint_size);
+        Output<Element> matrix = make_output<Element>(
+            outs.contains(key) ? nb::object(outs[key]) : nb::none(),
+            {size, fingerprint_row_elements(fold.fingerprint_size, layout)});
+        result[key] = matrix.array;
+        buffers.push_back(reinterpret_cast<uint8_t*>(matrix.data));
+        row_bytes.push_back(fingerprint_row_bytes(fold.fingerprint_size, layout));
+        total_bytes += row_bytes.back();
+        tag += ':' + std::to_string(fold.radius) + '/' + std::to_string(fold.fingerprint_size);
+    }
+
+    {
+        nb::gil_scoped_release release;
+        for_each_mol_cached(
+            input, num_threads, dedup, tag,
+            [&](size_t i, const RDKit::ROMol* mol) {
+                thread_local std::vector<uint8_t*> rows;
+                rows.resize(folds.size());
+                for (size_t f = 0; f < folds.size(); ++f) {
+                    rows[f] = buffers[f] + i * row_bytes[f];
+                    if (!mol) {
+                        std::fill_n(rows[f], row_bytes[f], uint8_t{0});
+                    }
                 }
+                if (mol) {
+                    morgan_sweep_rows(*mol, folds, false, layout, rows.data());
+                }
+            },
+            [&](size_t i, const std::string& blob) {
+                if (blob.size() != total_bytes) {
+                    return false;
+                }
+                const char* source = blob.data();
+                for (size_t f = 0; f < folds.size(); ++f) {
+                    std::memcpy(buffers[f] + i * row_bytes[f], source, row_bytes[f]);
+                    source += row_bytes[f];
+                }
+                return true;
+            },
+            [&](size_t i, std::string& blob) {
+                blob.clear();
+                for (size_t f = 0; f < folds.size(); ++f) {
+                    blob.append(reinterpret_cast<const char*>(buffers[f] + i * row_bytes[f]),
+                                row_bytes[f]);
+                }
+            });
+    }
+
+    return result;
+}
+
+template <typename Input>
+nb::dict morgan_sweep_impl(
+    const Input& input,
+    const std::vector<int>& radii,
+    const std::vector<int>& nbits,
+    int num_threads,
+    const std::string& layout_name,
+    bool dedup,
+    const nb::object& out
+) {
+    if (radii.empty() || nbits.empty()) {
+        throw std::invalid_argument("radii and nbits must not be empty");
+    }
+    std::vector<MorganFold> folds;
+    std::set<std::pair<int, int>> seen;
+    for (const int radius : radii) {
+        if (radius < 0) {
+            throw std::invalid_argument("radius must be non-negative");
+        }
+        for (const int size : nbits) {
+            if (size <= 0) {
+                throw std::invalid_argument("nbits must be positive");
             }
+            if (seen.emplace(radius, size).second) {
+                folds.push_back({static_cast<unsigned int>(radius), static_cast<size_t>(size)});
+            }
+        }
+    }
+    const FingerprintLayout layout = parse_fingerprint_layout(layout_name);
+    if (layout == FingerprintLayout::PackedWords) {
+        return morgan_sweep_arrays<uint64_t>(input, folds, layout, num_threads, dedup, out);
+    }
+    return morgan_sweep_arrays<uint8_t>(input, folds, layout, num_threads, dedup, out);
+}
+
+template <typename Id>
+using SparseRow = std::vector<std::pair<Id, std::uint32_t>>;
+
+// Sort a row of folded ids and sum the counts of ids that collided.
+template <typename Id>
+void merge_folded_ids(SparseRow<Id>& row) {
+    std::sort(row.begin(), row.end());
+    size_t out = 0;
+    for (size_t i = 0; i < row.size(); ++i) {
+        if (out != 0 && row[out - 1].first == row[i].first) {
+            row[out - 1].second += row[i].second;
         } else {
-            // Invalid SMILES, set all bits to 0
-            for (int j = 0; j < nbits; ++j) {
-                data[i * nbits + j] = 0;
+            row[out++] = row[i];
+        }
+    }
+    row.resize(out);
+}
+
+// Morgan ids per molecule in CSR form. fold == 0 keeps the raw hash ids;
+// otherwise ids are reduced modulo fold, which matches the dense bit layout.
+template <typename Id, typename Input>
+nb::dict morgan_sparse_array(
+    const Input& input,
+    unsigned int radius,
+    std::uint64_t fold,
+    bool include_counts,
+    int num_threads
+) {
+    size_t size = input_size(input);
+    std::vector<SparseRow<Id>> rows(size);
+
+    std::vector<int64_t> indptr(size + 1);
+    std::vector<Id> indices;
+    std::vector<uint32_t> counts;
+    size_t nnz = 0;
+
+    {
+        nb::gil_scoped_release release;
+        std::unique_ptr<RDKit::FingerprintGenerator<Id>> generator(
+            RDKit::MorganFingerprint::getMorganGenerator<Id>(radius));
+
+        for_each_mol(input, num_threads, [&](size_t i, const RDKit::ROMol* mol) {
+            if (!mol) {
+                return;
+            }
+            auto& row = rows[i];
+            try {
+                std::unique_ptr<RDKit::SparseIntVect<Id>> fp(
+                    generator->getSparseCountFingerprint(*mol));
+                const auto& elements = fp->getNonzeroElements();
+                row.reserve(elements.size());
+                for (const auto& element : elements) {
+                    const Id id = fold != 0 ? static_cast<Id>(element.first % fold)
+                                            : element.first;
+                    row.emplace_back(id, static_cast<std::uint32_t>(element.second));
+                }
+                if (fold != 0) {
+                    merge_folded_ids(row);
+                }
+            } catch (const std::exception& e) {
+                // On error, leave the row empty
+                row.clear();
+            }
+        });
+
+        indptr[0] = 0;
+        for (size_t i = 0; i < size; ++i) {
+            indptr[i + 1] = indptr[i] + static_cast<int64_t>(rows[i].size());
+        }
+        nnz = static_cast<size_t>(indptr[size]);
+
+        indices.reserve(nnz);
+        if (include_counts) {
+            counts.reserve(nnz);
+        }
+        for (size_t i = 0; i < size; ++i) {
+            for (const auto& entry : rows[i]) {
+                indices.push_back(entry.first);
+                if (include_counts) {
+                    counts.push_back(entry.second);
+                }
             }
         }
     }
-    
-    nb::capsule owner(data, [](void *p) noexcept {
-        delete[] static_cast<uint8_t*>(p);
-    });
-    
-    // Create 2D nanobind ndarray
-    return nb::ndarray<nb::numpy, uint8_t>(data, {size, static_cast<size_t>(nbits)}, owner);
+
+    nb::dict result;
+    result["indptr"] = vector_array(std::move(indptr), {size + 1});
+    result["indices"] = vector_array(std::move(indices), {nnz});
+    if (include_counts) {
+        result["counts"] = vector_array(std::move(counts), {nnz});
+    }
+    return result;
 }
 
-nb::tuple ecfp_reasoning_trace(const std::string& smiles,
-                               int radius,
-                               bool isomeric,
-                               bool kekulize,
-                               bool include_per_center,
-                               int fingerprint_size) {
-    const unsigned int fp_radius =
-        radius < 0 ? 0U : static_cast<unsigned int>(radius);
-    const std::size_t fp_bits =
-        fingerprint_size <= 0
-            ? kECFPReasoningFingerprintSize
-            : static_cast<std::size_t>(fingerprint_size);
-    auto trace_result = ecfp_reasoning_trace_from_smiles(
-        smiles, fp_radius, isomeric, kekulize, include_per_center, fp_bits);
+template <typename Input>
+nb::dict morgan_sparse_impl(
+    const Input& input,
+    int radius,
+    int nbits,
+    int num_threads,
+    bool unfolded,
+    int hash_bits,
+    bool include_counts
+) {
+    if (radius < 0) {
+        throw std::invalid_argument("radius must be non-negative");
+    }
+    const auto morgan_radius = static_cast<unsigned int>(radius);
+    if (!unfolded) {
+        if (nbits <= 0) {
+            throw std::invalid_argument("nbits must be positive");
+        }
+        return morgan_sparse_array<std::uint32_t>(
+            input, morgan_radius, static_cast<std::uint64_t>(nbits), include_counts, num_threads);
+    }
+    if (hash_bits == 32) {
+        return morgan_sparse_array<std::uint32_t>(input, morgan_radius, 0, include_counts, num_threads);
+    }
+    if (hash_bits == 64) {
+        return morgan_sparse_array<std::uint64_t>(input, morgan_radius, 0, include_counts, num_threads);
+    }
+    throw std::invalid_argument("hash_bits must be 32 or 64");
+}
+
+FingerprintView fingerprint_view(const FingerprintArray& fps, const char* name) {
+    if (fps.dtype() != nb::dtype<uint8_t>() && fps.dtype() != nb::dtype<uint64_t>()) {
+        throw std::invalid_argument(
+            std::string(name) + " must be a packed uint8 or uint64 fingerprint matrix");
+    }
+    FingerprintView view;
+    view.data = static_cast<const uint8_t*>(fps.data());
+    view.rows = fps.shape(0);
+    view.row_bytes = fps.shape(1) * fps.itemsize();
+    return view;
+}
+
+void check_same_layout(const FingerprintArray& a, const FingerprintArray& b) {
+    if (a.dtype() != b.dtype() || a.shape(1) != b.shape(1)) {
+        throw std::invalid_argument(
+            "fingerprint matrices must share the same dtype and width");
+    }
+}
+
+void check_db_layout(const FingerprintArray& fps, const FingerprintDb& db) {
+    const bool words = db.layout() == FingerprintLayout::PackedWords;
+    if (fps.dtype() != (words ? nb::dtype<uint64_t>() : nb::dtype<uint8_t>()) ||
+        fps.shape(1) * fps.itemsize() != db.fingerprints().row_bytes) {
+        throw std::invalid_argument(
+            "fingerprints must match the database dtype and width");
+    }
+}
+
+nb::tuple topk_tuple(const FingerprintView& queries,
+                     const FingerprintView& library,
+                     const uint32_t* library_popcounts,
+                     size_t k,
+                     float threshold,
+                     int num_threads,
+                     const nb::object& out) {
+    const size_t m = queries.rows;
+    // Hits past the library size would only ever be padding
+    k = std::min(k, library.rows);
+    const std::vector<nb::object> outs =
+        output_parts(out, 2, "an int64 and a float32 array (indices, scores)");
+    Output<int64_t> indices = make_output<int64_t>(outs[0], {m, k});
+    Output<float> scores = make_output<float>(outs[1], {m, k});
+    {
+        nb::gil_scoped_release release;
+        tanimoto_topk(queries, library, library_popcounts, k, threshold, num_threads,
+                      indices.data, scores.data);
+    }
+    return nb::make_tuple(indices.array, scores.array);
+}
+
+nb::object matrix_array(const FingerprintView& a,
+                        const FingerprintView& b,
+                        const uint32_t* b_popcounts,
+                        int num_threads,
+                        const nb::object& out) {
+    Output<float> result = make_output<float>(out, {a.rows, b.rows});
+    {
+        nb::gil_scoped_release release;
+        tanimoto_matrix(a, b, b_popcounts, result.data, num_threads);
+    }
+    return result.array;
+}
+
+nb::tuple butina_tuple(const FingerprintView& fps,
+                       const uint32_t* popcounts,
+                       float threshold,
+                       bool reordering,
+                       int num_threads) {
+    ButinaClusters clusters;
+    {
+        nb::gil_scoped_release release;
+        clusters = butina_cluster(fps, popcounts, threshold, reordering, num_threads);
+    }
+    const size_t num_rows = clusters.labels.size();
+    const size_t num_clusters = clusters.centroids.size();
+    return nb::make_tuple(vector_array(std::move(clusters.labels), {num_rows}),
+                          vector_array(std::move(clusters.centroids), {num_clusters}));
+}
+
+nb::ndarray<nb::numpy, int64_t> maxmin_array(const FingerprintView& fps,
+                                             const uint32_t* popcounts,
+                                             size_t k,
+                                             const std::vector<int64_t>& first_picks,
+                                             uint64_t seed,
+                                             int num_threads) {
+    std::vector<int64_t> picks;
+    {
+        nb::gil_scoped_release release;
+        picks = maxmin_pick(fps, popcounts, k, first_picks, seed, num_threads);
+    }
+    const size_t num_picks = picks.size();
+    return vector_array(std::move(picks), {num_picks});
+}
+
+nb::tuple trace_tuple(ReasoningTraceResult trace_result) {
     std::string trace = std::move(std::get<0>(trace_result));
     std::vector<std::uint8_t> fingerprint =
         std::move(std::get<1>(trace_result));
@@ -233,13 +927,899 @@ nb::tuple ecfp_reasoning_trace(const std::string& smiles,
     const std::size_t fp_size = fingerprint.size();
     uint8_t* data = new uint8_t[fp_size];
     std::copy(fingerprint.begin(), fingerprint.end(), data);
-    nb::capsule owner(data, [](void* p) noexcept {
-        delete[] static_cast<uint8_t*>(p);
-    });
     auto fingerprint_array =
-        nb::ndarray<nb::numpy, uint8_t>(data, {fp_size}, owner);
+        nb::ndarray<nb::numpy, uint8_t>(data, {fp_size}, array_owner(data));
 
     return nb::make_tuple(std::move(trace), std::move(fingerprint_array));
 }
 
+unsigned int trace_radius(int radius) {
+    return radius < 0 ? 0U : static_cast<unsigned int>(radius);
+}
+
+std::size_t trace_fingerprint_size(int fingerprint_size) {
+    return fingerprint_size <= 0
+               ? kECFPReasoningFingerprintSize
+               : static_cast<std::size_t>(fingerprint_size);
+}
+
+template <typename Element, typename Input>
+nb::tuple reasoning_traces_array(
+    const Input& input,
+    unsigned int radius,
+    bool isomeric,
+    bool kekulize,
+    bool include_per_center,
+    std::size_t fp_bits,
+    FingerprintLayout layout,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
+) {
+    const size_t size = input_size(input);
+    const size_t row_elements = fingerprint_row_elements(fp_bits, layout);
+    const size_t row_bytes = fingerprint_row_bytes(fp_bits, layout);
+
+    std::vector<std::string> traces(size);
+    Output<Element> fingerprints = make_output<Element>(out, {size, row_elements});
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(fingerprints.data);
+
+    {
+        nb::gil_scoped_release release;
+        for_each_mol_cached(
+            input, num_threads, dedup,
+            trace_cache_tag(radius, isomeric, kekulize, include_per_center, fp_bits, layout),
+            [&](size_t i, const RDKit::ROMol* mol) {
+                std::fill_n(bytes + i * row_bytes, row_bytes, uint8_t{0});
+                if (!mol) {
+                    return;
+                }
+                ReasoningTraceResult result = ecfp_reasoning_trace_from_mol(
+                    *mol, radius, isomeric, kekulize, include_per_center, fp_bits, layout);
+                traces[i] = std::move(std::get<0>(result));
+                const std::vector<std::uint8_t>& row = std::get<1>(result);
+                std::copy(row.begin(), row.end(), bytes + i * row_bytes);
+            },
+            [&](size_t i, const std::string& blob) {
+                if (blob.size() < row_bytes) {
+                    return false;
+                }
+                std::memcpy(bytes + i * row_bytes, blob.data(), row_bytes);
+                traces[i] = blob.substr(row_bytes);
+                return true;
+            },
+            [&](size_t i, std::string& blob) {
+                blob.assign(reinterpret_cast<const char*>(bytes + i * row_bytes), row_bytes);
+                blob.append(traces[i]);
+            });
+    }
+
+    return nb::make_tuple(std::move(traces), fingerprints.array);
+}
+
+template <typename Input>
+nb::tuple reasoning_traces_impl(
+    const Input& input,
+    int radius,
+    bool isomeric,
+    bool kekulize,
+    bool include_per_center,
+    int fingerprint_size,
+    const std::string& layout_name,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
+) {
+    const FingerprintLayout layout = parse_fingerprint_layout(layout_name);
+    const std::size_t fp_bits = trace_fingerprint_size(fingerprint_size);
+    if (layout == FingerprintLayout::PackedWords) {
+        return reasoning_traces_array<uint64_t>(input, trace_radius(radius), isomeric, kekulize,
+                                                include_per_center, fp_bits, layout, num_threads,
+                                                dedup, out);
+    }
+    return reasoning_traces_array<uint8_t>(input, trace_radius(radius), isomeric, kekulize,
+                                           include_per_center, fp_bits, layout, num_threads,
+                                           dedup, out);
+}
+
+template <typename Element, typename Input>
+nb::tuple reasoning_tokens_array(
+    const Input& input,
+    unsigned int radius,
+    bool isomeric,
+    bool kekulize,
+    bool include_per_center,
+    std::size_t fp_bits,
+    FingerprintLayout layout,
+    int num_threads,
+    bool dedup
+) {
+    const size_t size = input_size(input);
+    const size_t row_elements = fingerprint_row_elements(fp_bits, layout);
+    const size_t row_bytes = fingerprint_row_bytes(fp_bits, layout);
+    TraceVocabulary& vocabulary = trace_vocabulary();
+
+    // Unseen pieces stay pending while the workers run and are interned in
+    // row order afterwards, so new ids do not depend on thread scheduling
+    std::vector<std::vector<int32_t>> rows(size);
+    std::vector<std::vector<std::string>> pending(size);
+    std::vector<Element> fingerprints(size * row_elements);
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(fingerprints.data());
+
+    {
+        nb::gil_scoped_release release;
+        // A cached row is the fingerprint, the id count, the ids and then
+        // each pending piece followed by a NUL
+        for_each_mol_cached(
+            input, num_threads, dedup,
+            trace_tokens_cache_tag(radius, isomeric, kekulize, include_per_center, fp_bits,
+                                   layout, vocabulary),
+            [&](size_t i, const RDKit::ROMol* mol) {
+                if (!mol) {
+                    return;
+                }
+                ReasoningTokensResult result = ecfp_reasoning_tokens_from_mol(
+                    *mol, vocabulary, radius, isomeric, kekulize, include_per_center,
+                    fp_bits, layout, &pending[i]);
+                rows[i] = std::move(std::get<0>(result));
+                const std::vector<std::uint8_t>& row = std::get<1>(result);
+                std::copy(row.begin(), row.end(), bytes + i * row_bytes);
+            },
+            [&](size_t i, const std::string& blob) {
+                uint32_t count = 0;
+                if (blob.size() < row_bytes + sizeof(count)) {
+                    return false;
+                }
+                std::memcpy(&count, blob.data() + row_bytes, sizeof(count));
+                const size_t ids_end = row_bytes + sizeof(count) + count * sizeof(int32_t);
+                if (blob.size() < ids_end || (blob.size() > ids_end && blob.back() != '\0')) {
+                    return false;
+                }
+                std::memcpy(bytes + i * row_bytes, blob.data(), row_bytes);
+                rows[i].resize(count);
+                std::memcpy(rows[i].data(), blob.data() + row_bytes + sizeof(count),
+                            count * sizeof(int32_t));
+                pending[i].clear();
+                for (size_t pos = ids_end; pos < blob.size();) {
+                    const size_t end = blob.find('\0', pos);
+                    pending[i].emplace_back(blob, pos, end - pos);
+                    pos = end + 1;
+                }
+                return true;
+            },
+            [&](size_t i, std::string& blob) {
+                const auto count = static_cast<uint32_t>(rows[i].size());
+                blob.assign(reinterpret_cast<const char*>(bytes + i * row_bytes), row_bytes);
+                blob.append(reinterpret_cast<const char*>(&count), sizeof(count));
+                blob.append(reinterpret_cast<const char*>(rows[i].data()),
+                            rows[i].size() * sizeof(int32_t));
+                for (const std::string& token : pending[i]) {
+                    blob.append(token).push_back('\0');
+                }
+            });
+
+        for (size_t i = 0; i < size; ++i) {
+            resolve_pending_tokens(rows[i], pending[i], vocabulary);
+        }
+    }
+
+    std::vector<int64_t> row_splits(size + 1, 0);
+    for (size_t i = 0; i < size; ++i) {
+        row_splits[i + 1] = row_splits[i] + static_cast<int64_t>(rows[i].size());
+    }
+    std::vector<int32_t> values(static_cast<size_t>(row_splits[size]));
+    for (size_t i = 0; i < size; ++i) {
+        std::copy(rows[i].begin(), rows[i].end(), values.begin() + row_splits[i]);
+    }
+    const size_t num_values = values.size();
+    return nb::make_tuple(vector_array(std::move(values), {num_values}),
+                          vector_array(std::move(row_splits), {size + 1}),
+                          vector_array(std::move(fingerprints), {size, row_elements}));
+}
+
+template <typename Input>
+nb::tuple reasoning_tokens_impl(
+    const Input& input,
+    int radius,
+    bool isomeric,
+    bool kekulize,
+    bool include_per_center,
+    int fingerprint_size,
+    const std::string& layout_name,
+    int num_threads,
+    bool dedup
+) {
+    const FingerprintLayout layout = parse_fingerprint_layout(layout_name);
+    const std::size_t fp_bits = trace_fingerprint_size(fingerprint_size);
+    radius_token(trace_radius(radius));
+    if (layout == FingerprintLayout::PackedWords) {
+        return reasoning_tokens_array<uint64_t>(input, trace_radius(radius), isomeric, kekulize,
+                                                include_per_center, fp_bits, layout,
+                                                num_threads, dedup);
+    }
+    return reasoning_tokens_array<uint8_t>(input, trace_radius(radius), isomeric, kekulize,
+                                           include_per_center, fp_bits, layout, num_threads,
+                                           dedup);
+}
+
+template <typename Input>
+nb::object substructure_impl(
+    const Input& input,
+    const std::vector<std::string>& patterns,
+    bool use_chirality,
+    int num_threads,
+    const nb::object& out
+) {
+    const SubstructurePatterns queries(patterns, use_chirality);
+    const size_t size = input_size(input);
+    const size_t num_patterns = queries.size();
+    Output<bool> result = make_output<bool>(out, {size, num_patterns});
+    bool* data = result.data;
+
+    {
+        nb::gil_scoped_release release;
+        for_each_mol(input, num_threads, [&](size_t i, const RDKit::ROMol* mol) {
+            bool* row = data + i * num_patterns;
+            if (!mol) {
+                std::fill_n(row, num_patterns, false);
+                return;
+            }
+            try {
+                queries.match(*mol, row);
+            } catch (const std::exception&) {
+                RDKTOOLS_COUNT(Exceptions);
+                std::fill_n(row, num_patterns, false);
+            }
+        });
+    }
+
+    return result.array;
+}
+
+} // namespace
+
+nb::object calculate_molecular_weights(
+    const SmilesColumn& smiles_list,
+    int num_threads,
+    bool dedup,
+    const std::string& dtype,
+    const nb::object& out
+) {
+    return descriptor_column(smiles_list, num_threads, dedup, "molecular_weight", molecular_weight, dtype, out);
+}
+
+nb::object calculate_molecular_weights(
+    const MolBatch& batch,
+    int num_threads,
+    bool dedup,
+    const std::string& dtype,
+    const nb::object& out
+) {
+    return descriptor_column(batch, num_threads, dedup, "molecular_weight", molecular_weight, dtype, out);
+}
+
+nb::object calculate_logp(
+    const SmilesColumn& smiles_list,
+    int num_threads,
+    bool dedup,
+    const std::string& dtype,
+    const nb::object& out
+) {
+    return descriptor_column(smiles_list, num_threads, dedup, "logp", logp, dtype, out);
+}
+
+nb::object calculate_logp(
+    const MolBatch& batch,
+    int num_threads,
+    bool dedup,
+    const std::string& dtype,
+    const nb::object& out
+) {
+    return descriptor_column(batch, num_threads, dedup, "logp", logp, dtype, out);
+}
+
+nb::object calculate_tpsa(
+    const SmilesColumn& smiles_list,
+    int num_threads,
+    bool dedup,
+    const std::string& dtype,
+    const nb::object& out
+) {
+    return descriptor_column(smiles_list, num_threads, dedup, "tpsa", tpsa, dtype, out);
+}
+
+nb::object calculate_tpsa(
+    const MolBatch& batch,
+    int num_threads,
+    bool dedup,
+    const std::string& dtype,
+    const nb::object& out
+) {
+    return descriptor_column(batch, num_threads, dedup, "tpsa", tpsa, dtype, out);
+}
+
+nb::object validate_smiles(
+    const SmilesColumn& smiles_list,
+    int num_threads,
+    const std::string& level,
+    const nb::object& out
+) {
+    const ValidationLevel validation = parse_validation_level(level);
+    if (validation == ValidationLevel::Full) {
+        return validate_impl(smiles_list, num_threads, out);
+    }
+    return validate_level(smiles_list, validation, num_threads, out);
+}
+
+nb::object validate_smiles(
+    const MolBatch& batch,
+    int num_threads,
+    const std::string& level,
+    const nb::object& out
+) {
+    // Batch rows were fully sanitized when parsed; reject bad names all the same
+    parse_validation_level(level);
+    return validate_impl(batch, num_threads, out);
+}
+
+nb::dict calculate_multiple_descriptors(
+    const SmilesColumn& smiles_list,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
+) {
+    return multiple_descriptors_impl(smiles_list, num_threads, dedup, out);
+}
+
+nb::dict calculate_multiple_descriptors(
+    const MolBatch& batch,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
+) {
+    return multiple_descriptors_impl(batch, num_threads, dedup, out);
+}
+
+nb::object calculate_descriptors(
+    const SmilesColumn& smiles_list,
+    const std::vector<std::string>& names,
+    const std::string& dtype,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
+) {
+    return descriptors_impl(smiles_list, names, dtype, num_threads, dedup, out);
+}
+
+nb::object calculate_descriptors(
+    const MolBatch& batch,
+    const std::vector<std::string>& names,
+    const std::string& dtype,
+    int num_threads,
+    bool dedup,
+    const nb::object& out
+) {
+    return descriptors_impl(batch, names, dtype, num_threads, dedup, out);
+}
+
+std::vector<std::string> canonicalize_smiles(
+    const SmilesColumn& smiles_list,
+    int num_threads,
+    bool dedup
+) {
+    return canonicalize_impl(smiles_list, num_threads, dedup);
+}
+
+std::vector<std::string> canonicalize_smiles(
+    const MolBatch& batch,
+    int num_threads,
+    bool dedup
+) {
+    return canonicalize_impl(batch, num_threads, dedup);
+}
+
+template <typename Input>
+nb::object pickles_impl(const Input& input, int num_threads, bool as_buffer) {
+    size_t size = input_size(input);
+    std::vector<std::string> pickles(size);
+    {
+        nb::gil_scoped_release release;
+        for_each_mol(input, num_threads, [&](size_t i, const RDKit::ROMol* mol) {
+            if (mol) {
+                pickles[i] = mol_to_pickle(*mol);
+            }
+        });
+    }
+
+    if (!as_buffer) {
+        nb::list result;
+        for (const std::string& pickle : pickles) {
+            result.append(nb::bytes(pickle.data(), pickle.size()));
+        }
+        return result;
+    }
+
+    std::vector<int64_t> offsets(size + 1, 0);
+    for (size_t i = 0; i < size; ++i) {
+        offsets[i + 1] = offsets[i] + static_cast<int64_t>(pickles[i].size());
+    }
+    std::vector<uint8_t> buffer(static_cast<size_t>(offsets[size]));
+    for (size_t i = 0; i < size; ++i) {
+        std::memcpy(buffer.data() + offsets[i], pickles[i].data(), pickles[i].size());
+    }
+    const size_t buffer_size = buffer.size();
+    return nb::make_tuple(vector_array(std::move(buffer), {buffer_size}),
+                          vector_array(std::move(offsets), {size + 1}));
+}
+
+nb::object smiles_to_pickles(
+    const SmilesColumn& smiles_list,
+    int num_threads,
+    bool as_buffer
+) {
+    return pickles_impl(smiles_list, num_threads, as_buffer);
+}
+
+nb::object smiles_to_pickles(
+    const MolBatch& batch,
+    int num_threads,
+    bool as_buffer
+) {
+    return pickles_impl(batch, num_threads, as_buffer);
+}
+
+SmilesColumn pickle_column(const nb::object& pickles, const nb::object& offsets) {
+    if (offsets.is_none()) {
+        SmilesColumn column;
+        if (detail::load_arrow(pickles, column)) {
+            return column;
+        }
+        if (nb::isinstance<nb::bytes>(pickles) || nb::isinstance<nb::str>(pickles)) {
+            throw nb::type_error("pickles must be a sequence of bytes, not a single object");
+        }
+        std::vector<std::string> rows;
+        for (nb::handle item : pickles) {
+            if (item.is_none()) {
+                rows.emplace_back();
+            } else if (nb::isinstance<nb::bytes>(item)) {
+                nb::bytes bytes = nb::borrow<nb::bytes>(item);
+                rows.emplace_back(bytes.c_str(), bytes.size());
+            } else {
+                throw nb::type_error("pickles must be bytes objects");
+            }
+        }
+        return SmilesColumn::owning(std::move(rows));
+    }
+
+    using Buffer = nb::ndarray<const uint8_t, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+    using Offsets = nb::ndarray<const int64_t, nb::ndim<1>, nb::c_contig, nb::device::cpu>;
+    Buffer buffer;
+    Offsets offset_array;
+    if (!nb::try_cast(pickles, buffer, false)) {
+        throw nb::type_error("with offsets, pickles must be a contiguous 1D uint8 buffer");
+    }
+    if (!nb::try_cast(offsets, offset_array, false)) {
+        throw nb::type_error("offsets must be a contiguous 1D int64 array");
+    }
+    if (offset_array.shape(0) == 0) {
+        throw std::invalid_argument("offsets must hold N + 1 entries");
+    }
+    const int64_t* bounds = offset_array.data();
+    const size_t size = offset_array.shape(0) - 1;
+    if (bounds[0] < 0 || bounds[size] > static_cast<int64_t>(buffer.shape(0))) {
+        throw std::invalid_argument("offsets run past the pickle buffer");
+    }
+    for (size_t i = 0; i < size; ++i) {
+        if (bounds[i + 1] < bounds[i]) {
+            throw std::invalid_argument("offsets must be non-decreasing");
+        }
+    }
+    // Same layout as an Arrow large_binary array: view it without copying
+    static const uint8_t empty_data = 0;
+    const uint8_t* data = buffer.shape(0) ? buffer.data() : &empty_data;
+    return SmilesColumn::arrow(nullptr, bounds, true, reinterpret_cast<const char*>(data),
+                               size, 0, detail::python_keepalive(nb::make_tuple(pickles, offsets)));
+}
+
+nb::object calculate_morgan_fingerprints(
+    const SmilesColumn& smiles_list,
+    int radius,
+    int nbits,
+    int num_threads,
+    const std::string& layout,
+    bool dedup,
+    const nb::object& out
+) {
+    return morgan_fingerprints_impl(smiles_list, radius, nbits, num_threads, layout, dedup, out);
+}
+
+nb::object calculate_morgan_fingerprints(
+    const MolBatch& batch,
+    int radius,
+    int nbits,
+    int num_threads,
+    const std::string& layout,
+    bool dedup,
+    const nb::object& out
+) {
+    return morgan_fingerprints_impl(batch, radius, nbits, num_threads, layout, dedup, out);
+}
+
+nb::dict calculate_morgan_sweep(
+    const SmilesColumn& smiles_list,
+    const std::vector<int>& radii,
+    const std::vector<int>& nbits,
+    int num_threads,
+    const std::string& layout,
+    bool dedup,
+    const nb::object& out
+) {
+    return morgan_sweep_impl(smiles_list, radii, nbits, num_threads, layout, dedup, out);
+}
+
+nb::dict calculate_morgan_sweep(
+    const MolBatch& batch,
+    const std::vector<int>& radii,
+    const std::vector<int>& nbits,
+    int num_threads,
+    const std::string& layout,
+    bool dedup,
+    const nb::object& out
+) {
+    return morgan_sweep_impl(batch, radii, nbits, num_threads, layout, dedup, out);
+}
+
+nb::dict calculate_morgan_sparse(
+    const SmilesColumn& smiles_list,
+    int radius,
+    int nbits,
+    int num_threads,
+    bool unfolded,
+    int hash_bits,
+    bool counts
+) {
+    return morgan_sparse_impl(smiles_list, radius, nbits, num_threads, unfolded, hash_bits, counts);
+}
+
+nb::dict calculate_morgan_sparse(
+    const MolBatch& batch,
+    int radius,
+    int nbits,
+    int num_threads,
+    bool unfolded,
+    int hash_bits,
+    bool counts
+) {
+    return morgan_sparse_impl(batch, radius, nbits, num_threads, unfolded, hash_bits, counts);
+}
+
+nb::tuple ecfp_reasoning_trace(const std::string& smiles,
+                               int radius,
+                               bool isomeric,
+                               bool kekulize,
+                               bool include_per_center,
+                               int fingerprint_size) {
+    ReasoningTraceResult trace_result;
+    {
+        nb::gil_scoped_release release;
+        trace_result = ecfp_reasoning_trace_from_smiles(
+            smiles, trace_radius(radius), isomeric, kekulize,
+            include_per_center, trace_fingerprint_size(fingerprint_size));
+    }
+    return trace_tuple(std::move(trace_result));
+}
+
+nb::tuple ecfp_reasoning_trace(const MolBatch& batch,
+                               size_t index,
+                               int radius,
+                               bool isomeric,
+                               bool kekulize,
+                               bool include_per_center,
+                               int fingerprint_size) {
+    if (index >= batch.size()) {
+        throw nb::index_error("MolBatch index out of range");
+    }
+    const std::size_t fp_bits = trace_fingerprint_size(fingerprint_size);
+    ReasoningTraceResult trace_result;
+    {
+        nb::gil_scoped_release release;
+        std::lock_guard<std::mutex> guard(batch.usage_mutex());
+        const RDKit::ROMol* mol = batch.mol(index);
+        if (mol) {
+            trace_result = ecfp_reasoning_trace_from_mol(
+                *mol, trace_radius(radius), isomeric, kekulize,
+                include_per_center, fp_bits);
+        } else {
+            trace_result = ReasoningTraceResult(
+                std::string(), std::vector<std::uint8_t>(fp_bits, 0));
+        }
+    }
+    return trace_tuple(std::move(trace_result));
+}
+
+nb::tuple ecfp_reasoning_traces(const SmilesColumn& smiles_list,
+                                int radius,
+                                bool isomeric,
+                                bool kekulize,
+                                bool include_per_center,
+                                int fingerprint_size,
+                                const std::string& layout,
+                                int num_threads,
+                                bool dedup,
+                                const nb::object& out) {
+    return reasoning_traces_impl(smiles_list, radius, isomeric, kekulize, include_per_center,
+                                 fingerprint_size, layout, num_threads, dedup, out);
+}
+
+nb::tuple ecfp_reasoning_traces(const MolBatch& batch,
+                                int radius,
+                                bool isomeric,
+                                bool kekulize,
+                                bool include_per_center,
+                                int fingerprint_size,
+                                const std::string& layout,
+                                int num_threads,
+                                bool dedup,
+                                const nb::object& out) {
+    return reasoning_traces_impl(batch, radius, isomeric, kekulize, include_per_center,
+                                 fingerprint_size, layout, num_threads, dedup, out);
+}
+
+nb::tuple ecfp_reasoning_trace_tokens(const SmilesColumn& smiles_list,
+                                      int radius,
+                                      bool isomeric,
+                                      bool kekulize,
+                                      bool include_per_center,
+                                      int fingerprint_size,
+                                      const std::string& layout,
+                                      int num_threads,
+                                      bool dedup) {
+    return reasoning_tokens_impl(smiles_list, radius, isomeric, kekulize, include_per_center,
+                                 fingerprint_size, layout, num_threads, dedup);
+}
+
+nb::tuple ecfp_reasoning_trace_tokens(const MolBatch& batch,
+                                      int radius,
+                                      bool isomeric,
+                                      bool kekulize,
+                                      bool include_per_center,
+                                      int fingerprint_size,
+                                      const std::string& layout,
+                                      int num_threads,
+                                      bool dedup) {
+    return reasoning_tokens_impl(batch, radius, isomeric, kekulize, include_per_center,
+                                 fingerprint_size, layout, num_threads, dedup);
+}
+
+std::string decode_trace_tokens(
+    const nb::ndarray<const int32_t, nb::ndim<1>, nb::c_contig, nb::device::cpu>& ids) {
+    return trace_vocabulary().decode(ids.data(), ids.shape(0));
+}
+
+nb::object substructure_match(
+    const SmilesColumn& smiles_list,
+    const std::vector<std::string>& patterns,
+    bool use_chirality,
+    int num_threads,
+    const nb::object& out
+) {
+    return substructure_impl(smiles_list, patterns, use_chirality, num_threads, out);
+}
+
+nb::object substructure_match(
+    const MolBatch& batch,
+    const std::vector<std::string>& patterns,
+    bool use_chirality,
+    int num_threads,
+    const nb::object& out
+) {
+    return substructure_impl(batch, patterns, use_chirality, num_threads, out);
+}
+
+nb::object calculate_tanimoto_matrix(
+    const FingerprintArray& a,
+    const FingerprintArray& b,
+    int num_threads,
+    const nb::object& out
+) {
+    const FingerprintView view_a = fingerprint_view(a, "a");
+    const FingerprintView view_b = fingerprint_view(b, "b");
+    check_same_layout(a, b);
+    return matrix_array(view_a, view_b, nullptr, num_threads, out);
+}
+
+nb::object calculate_tanimoto_matrix(
+    const FingerprintArray& a,
+    const FingerprintDb& db,
+    int num_threads,
+    const nb::object& out
+) {
+    const FingerprintView view_a = fingerprint_view(a, "a");
+    check_db_layout(a, db);
+    return matrix_array(view_a, db.fingerprints(), db.popcounts(), num_threads, out);
+}
+
+nb::tuple calculate_tanimoto_topk(
+    const FingerprintArray& queries,
+    const FingerprintArray& library,
+    size_t k,
+    float threshold,
+    int num_threads,
+    const nb::object& out
+) {
+    const FingerprintView view_q = fingerprint_view(queries, "queries");
+    const FingerprintView view_l = fingerprint_view(library, "library");
+    check_same_layout(queries, library);
+    return topk_tuple(view_q, view_l, nullptr, k, threshold, num_threads, out);
+}
+
+nb::tuple calculate_tanimoto_topk(
+    const FingerprintArray& queries,
+    const FingerprintDb& db,
+    size_t k,
+    float threshold,
+    int num_threads,
+    const nb::object& out
+) {
+    const FingerprintView view_q = fingerprint_view(queries, "queries");
+    check_db_layout(queries, db);
+    return topk_tuple(view_q, db.fingerprints(), db.popcounts(), k, threshold, num_threads,
+                      out);
+}
+
+nb::tuple calculate_butina_clusters(
+    const FingerprintArray& fps,
+    float threshold,
+    bool reordering,
+    int num_threads
+) {
+    return butina_tuple(fingerprint_view(fps, "fps"), nullptr, threshold, reordering,
+                        num_threads);
+}
+
+nb::tuple calculate_butina_clusters(
+    const FingerprintDb& db,
+    float threshold,
+    bool reordering,
+    int num_threads
+) {
+    return butina_tuple(db.fingerprints(), db.popcounts(), threshold, reordering, num_threads);
+}
+
+nb::ndarray<nb::numpy, int64_t> calculate_maxmin_picks(
+    const FingerprintArray& fps,
+    size_t k,
+    const std::vector<int64_t>& first_picks,
+    uint64_t seed,
+    int num_threads
+) {
+    return maxmin_array(fingerprint_view(fps, "fps"), nullptr, k, first_picks, seed,
+                        num_threads);
+}
+
+nb::ndarray<nb::numpy, int64_t> calculate_maxmin_picks(
+    const FingerprintDb& db,
+    size_t k,
+    const std::vector<int64_t>& first_picks,
+    uint64_t seed,
+    int num_threads
+) {
+    return maxmin_array(db.fingerprints(), db.popcounts(), k, first_picks, seed, num_threads);
+}
+
+void write_fingerprint_db(
+    const std::string& path,
+    const FingerprintArray& fingerprints,
+    const std::optional<std::vector<std::string>>& ids,
+    size_t num_bits,
+    int num_threads
+) {
+    const FingerprintView view = fingerprint_view(fingerprints, "fingerprints");
+    const FingerprintLayout layout = fingerprints.dtype() == nb::dtype<uint64_t>()
+                                         ? FingerprintLayout::PackedWords
+                                         : FingerprintLayout::PackedBytes;
+    nb::gil_scoped_release release;
+    write_fingerprint_db(path, view, layout, num_bits, ids ? &*ids : nullptr, num_threads);
+}
+
+nb::object fingerprint_db_fingerprints(nb::handle db_handle) {
+    const FingerprintDb& db = nb::cast<const FingerprintDb&>(db_handle);
+    const FingerprintView view = db.fingerprints();
+    const bool words = db.layout() == FingerprintLayout::PackedWords;
+    const size_t width = words ? view.row_bytes / sizeof(uint64_t) : view.row_bytes;
+    return nb::cast(nb::ndarray<nb::numpy, nb::ro>(
+        view.data, {view.rows, width}, db_handle, {},
+        words ? nb::dtype<uint64_t>() : nb::dtype<uint8_t>()));
+}
+
+nb::object fingerprint_db_popcounts(nb::handle db_handle) {
+    const FingerprintDb& db = nb::cast<const FingerprintDb&>(db_handle);
+    return nb::cast(nb::ndarray<nb::numpy, const uint32_t>(
+        db.popcounts(), {db.size()}, db_handle));
+}
+
+std::vector<std::string> fingerprint_db_ids(
+    const FingerprintDb& db,
+    const std::vector<int64_t>& indices
+) {
+    std::vector<std::string> result;
+    result.reserve(indices.size());
+    for (const int64_t index : indices) {
+        if (index == -1) {
+            result.emplace_back();
+            continue;
+        }
+        if (index < 0 || static_cast<size_t>(index) >= db.size()) {
+            throw nb::index_error("FingerprintDB index out of range");
+        }
+        result.emplace_back(db.id(static_cast<size_t>(index)));
+    }
+    return result;
+}
+
+nb::dict smiles_reader_next(SmilesFileReader& reader) {
+    SmilesFeatureBatch batch;
+    bool more;
+    {
+        nb::gil_scoped_release release;
+        more = reader.next(batch);
+    }
+    if (!more) {
+        throw nb::stop_iteration();
+    }
+
+    const SmilesReaderOptions& options = reader.options();
+    const size_t size = batch.smiles.size();
+    nb::dict result;
+    result["offset"] = batch.first_row;
+    result["smiles"] = std::move(batch.smiles);
+    if (options.id_column >= 0 || !options.id_column_name.empty()) {
+        result["ids"] = std::move(batch.ids);
+    } else {
+        result["ids"] = nb::none();
+    }
+
+    bool* valid = new bool[size];
+    for (size_t i = 0; i < size; ++i) {
+        valid[i] = batch.valid[i] != 0;
+    }
+    result["valid"] = nb::ndarray<nb::numpy, bool>(valid, {size}, array_owner(valid));
+
+    if (options.descriptors) {
+        result["molecular_weight"] = vector_array(std::move(batch.molecular_weight), {size});
+        result["logp"] = vector_array(std::move(batch.logp), {size});
+        result["tpsa"] = vector_array(std::move(batch.tpsa), {size});
+    }
+    if (options.fingerprints) {
+        const size_t nbits = static_cast<size_t>(options.nbits);
+        const size_t width = fingerprint_row_elements(nbits, options.fingerprint_layout);
+        if (options.fingerprint_layout == FingerprintLayout::PackedWords) {
+            // Rows hold little-endian words and vector storage comes from
+            // operator new, so the bytes are viewed as uint64 in place
+            auto* owned = new std::vector<uint8_t>(std::move(batch.fingerprints));
+            nb::capsule owner(owned, [](void* p) noexcept {
+                delete static_cast<std::vector<uint8_t>*>(p);
+            });
+            result["fingerprints"] = nb::ndarray<nb::numpy>(
+                owned->data(), {size, width}, owner, {}, nb::dtype<uint64_t>());
+        } else {
+            result["fingerprints"] = vector_array(std::move(batch.fingerprints), {size, width});
+        }
+    }
+    if (options.traces) {
+        result["traces"] = std::move(batch.traces);
+    }
+    return result;
+}
+
+nb::ndarray<nb::numpy, bool> mol_batch_valid_mask(const MolBatch& batch) {
+    const auto& mask = batch.valid_mask();
+    size_t size = mask.size();
+    bool* data = new bool[size];
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = mask[i] != 0;
+    }
+    return nb::ndarray<nb::numpy, bool>(data, {size}, array_owner(data));
+}
+
 } // namespace rdktools
@@ -1,6 +1,11 @@
 #pragma once
 
 #include "ecfp_trace.hpp"
+#include "fingerprint_db.hpp"
+#include "mol_batch.hpp"
+#include "similarity.hpp"
+#include "smiles_column_caster.hpp"
+#include "smiles_reader.hpp"
 #include <GraphMol/GraphMol.h>
 #include <GraphMol/SmilesParse/SmilesParse.h>
 #include <GraphMol/Descriptors/MolDescriptors.h>
@@ -8,79 +13,372 @@
 #include <GraphMol/MolPickler.h>
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
 #include <nanobind/stl/vector.h>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 namespace rdktools {
 
+/**
+ * @brief Packed fingerprint matrix accepted by the similarity functions
+ *        (uint8 np.packbits rows or uint64 word rows, viewed without copying)
+ */
+using FingerprintArray = nanobind::ndarray<
+    nanobind::ro, nanobind::ndim<2>, nanobind::c_contig, nanobind::device::cpu>;
+
+/**
+ * @brief Writable caller-provided result buffer (out=); dtype, shape and
+ *        C-contiguity are checked against the result before anything is written
+ */
+using OutputArray = nanobind::ndarray<nanobind::device::cpu>;
+
 /**
  * @brief Process SMILES strings from list and return molecular weights
- * @param smiles_list list of SMILES strings
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
+ * @param dtype "float64" (default) or "float32"
+ * @param out optional preallocated 1D array of that dtype, written in place and returned
  * @return numpy array of molecular weights
+ * @throws std::invalid_argument for unsupported dtypes or a mismatched out
  */
-nanobind::ndarray<nanobind::numpy, double> calculate_molecular_weights(
-    const std::vector<std::string>& smiles_list
+nanobind::object calculate_molecular_weights(
+    const SmilesColumn& smiles_list,
+    int num_threads = 0,
+    bool dedup = false,
+    const std::string& dtype = "float64",
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of calculate_molecular_weights() reusing pre-parsed molecules
+ */
+nanobind::object calculate_molecular_weights(
+    const MolBatch& batch,
+    int num_threads = 0,
+    bool dedup = false,
+    const std::string& dtype = "float64",
+    const nanobind::object& out = nanobind::none()
 );
 
 /**
  * @brief Calculate LogP values for SMILES strings
- * @param smiles_list list of SMILES strings
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
+ * @param dtype "float64" (default) or "float32"
+ * @param out optional preallocated 1D array of that dtype, written in place and returned
  * @return numpy array of LogP values
+ * @throws std::invalid_argument for unsupported dtypes or a mismatched out
  */
-nanobind::ndarray<nanobind::numpy, double> calculate_logp(
-    const std::vector<std::string>& smiles_list
+nanobind::object calculate_logp(
+    const SmilesColumn& smiles_list,
+    int num_threads = 0,
+    bool dedup = false,
+    const std::string& dtype = "float64",
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of calculate_logp() reusing pre-parsed molecules
+ */
+nanobind::object calculate_logp(
+    const MolBatch& batch,
+    int num_threads = 0,
+    bool dedup = false,
+    const std::string& dtype = "float64",
+    const nanobind::object& out = nanobind::none()
 );
 
 /**
  * @brief Calculate TPSA (Topological Polar Surface Area) values
- * @param smiles_list list of SMILES strings
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
+ * @param dtype "float64" (default) or "float32"
+ * @param out optional preallocated 1D array of that dtype, written in place and returned
  * @return numpy array of TPSA values
+ * @throws std::invalid_argument for unsupported dtypes or a mismatched out
+ */
+nanobind::object calculate_tpsa(
+    const SmilesColumn& smiles_list,
+    int num_threads = 0,
+    bool dedup = false,
+    const std::string& dtype = "float64",
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of calculate_tpsa() reusing pre-parsed molecules
  */
-nanobind::ndarray<nanobind::numpy, double> calculate_tpsa(
-    const std::vector<std::string>& smiles_list
+nanobind::object calculate_tpsa(
+    const MolBatch& batch,
+    int num_threads = 0,
+    bool dedup = false,
+    const std::string& dtype = "float64",
+    const nanobind::object& out = nanobind::none()
 );
 
 /**
  * @brief Validate SMILES strings and return boolean array
- * @param smiles_list list of SMILES strings
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param level "syntax" (parse only), "valence" (parse plus valence and
+ *        kekulization checks) or "full" (complete sanitization, the default)
+ * @param out optional preallocated bool mask, written in place and returned
  * @return numpy array of boolean values (true for valid SMILES)
+ * @throws std::invalid_argument for unknown levels
+ */
+nanobind::object validate_smiles(
+    const SmilesColumn& smiles_list,
+    int num_threads = 0,
+    const std::string& level = "full",
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of validate_smiles() reusing pre-parsed molecules;
+ *        the batch was fully sanitized, so every level reports its mask
  */
-nanobind::ndarray<nanobind::numpy, bool> validate_smiles(
-    const std::vector<std::string>& smiles_list
+nanobind::object validate_smiles(
+    const MolBatch& batch,
+    int num_threads = 0,
+    const std::string& level = "full",
+    const nanobind::object& out = nanobind::none()
 );
 
 /**
  * @brief Calculate multiple descriptors at once for efficiency
- * @param smiles_list list of SMILES strings
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
+ * @param out optional tuple of three preallocated float64 1D arrays
+ *        (molecular_weight, logp, tpsa), written in place and returned
  * @return dictionary with arrays of molecular weights, LogP, and TPSA
  */
 nanobind::dict calculate_multiple_descriptors(
-    const std::vector<std::string>& smiles_list
+    const SmilesColumn& smiles_list,
+    int num_threads = 0,
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of calculate_multiple_descriptors() reusing pre-parsed molecules
+ */
+nanobind::dict calculate_multiple_descriptors(
+    const MolBatch& batch,
+    int num_threads = 0,
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief Calculate named descriptors into one row-major N x D matrix
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param names descriptor names; empty selects every registered descriptor
+ * @param dtype "float32" or "float64"
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
+ * @param out optional preallocated N x D array of dtype, written in place and returned
+ * @return numpy array with one row per input (NaN rows for invalid SMILES)
+ * @throws std::invalid_argument for unknown names or dtypes, or a mismatched out
+ */
+nanobind::object calculate_descriptors(
+    const SmilesColumn& smiles_list,
+    const std::vector<std::string>& names,
+    const std::string& dtype = "float32",
+    int num_threads = 0,
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of calculate_descriptors() reusing pre-parsed molecules
+ */
+nanobind::object calculate_descriptors(
+    const MolBatch& batch,
+    const std::vector<std::string>& names,
+    const std::string& dtype = "float32",
+    int num_threads = 0,
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
 );
 
 /**
  * @brief Convert SMILES to canonical SMILES
- * @param smiles_list list of SMILES strings
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
  * @return list of canonical SMILES strings
  */
 std::vector<std::string> canonicalize_smiles(
-    const std::vector<std::string>& smiles_list
+    const SmilesColumn& smiles_list,
+    int num_threads = 0,
+    bool dedup = false
+);
+
+/**
+ * @brief MolBatch overload of canonicalize_smiles() reusing pre-parsed molecules
+ */
+std::vector<std::string> canonicalize_smiles(
+    const MolBatch& batch,
+    int num_threads = 0,
+    bool dedup = false
+);
+
+/**
+ * @brief Parse SMILES once and serialize the molecules as MolPickler pickles
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param as_buffer return one concatenated buffer instead of a list of bytes
+ * @return list of bytes (empty for invalid SMILES), or with as_buffer a
+ *         (uint8 buffer, int64 offsets) tuple where row i spans
+ *         buffer[offsets[i]:offsets[i + 1]]
+ */
+nanobind::object smiles_to_pickles(
+    const SmilesColumn& smiles_list,
+    int num_threads = 0,
+    bool as_buffer = false
+);
+
+/**
+ * @brief MolBatch overload of smiles_to_pickles() pickling pre-parsed molecules
+ */
+nanobind::object smiles_to_pickles(
+    const MolBatch& batch,
+    int num_threads = 0,
+    bool as_buffer = false
+);
+
+/**
+ * @brief Column view of pickled molecules for MolBatch(..., MolInput::Pickle)
+ * @param pickles sequence of bytes (None marks an invalid row), an Arrow
+ *        binary array, or with offsets a 1D uint8 buffer
+ * @param offsets None, or int64 offsets of length N + 1 into pickles
+ * @throws nanobind::type_error for unsupported pickle containers
+ * @throws std::invalid_argument for offsets that are not non-decreasing or
+ *         run past the buffer
+ */
+SmilesColumn pickle_column(
+    const nanobind::object& pickles,
+    const nanobind::object& offsets = nanobind::none()
 );
 
 /**
  * @brief Calculate Morgan fingerprints as bit vectors
- * @param smiles_list list of SMILES strings
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
  * @param radius fingerprint radius (default: 2)
  * @param nbits number of bits in fingerprint (default: 2048)
- * @return 2D numpy array where each row is a fingerprint bit vector
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param layout "dense" (one uint8 per bit), "bytes" (np.packbits order) or
+ *        "uint64" (64 bits per word, bit i at position i % 64)
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
+ * @param out optional preallocated fingerprint matrix, written in place and returned
+ * @return 2D numpy array where each row is a fingerprint; uint8 for dense and
+ *         bytes layouts, uint64 for the word layout
+ */
+nanobind::object calculate_morgan_fingerprints(
+    const SmilesColumn& smiles_list,
+    int radius = 2,
+    int nbits = 2048,
+    int num_threads = 0,
+    const std::string& layout = "dense",
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of calculate_morgan_fingerprints() reusing pre-parsed molecules
+ */
+nanobind::object calculate_morgan_fingerprints(
+    const MolBatch& batch,
+    int radius = 2,
+    int nbits = 2048,
+    int num_threads = 0,
+    const std::string& layout = "dense",
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief Calculate Morgan fingerprints as CSR sparse rows
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param radius fingerprint radius (default: 2)
+ * @param nbits fold size; folded ids are the set bits of the dense fingerprint
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param unfolded keep raw Morgan hash ids instead of folding them into nbits
+ * @param hash_bits width of unfolded ids, 32 or 64
+ * @param counts also return the occurrence count of every id
+ * @return dictionary with "indptr" (int64, size + 1), "indices" (uint32, or
+ *         uint64 for 64-bit unfolded ids, sorted within each row) and, when
+ *         requested, "counts" (uint32). Invalid SMILES yield empty rows.
+ */
+nanobind::dict calculate_morgan_sparse(
+    const SmilesColumn& smiles_list,
+    int radius = 2,
+    int nbits = 2048,
+    int num_threads = 0,
+    bool unfolded = false,
+    int hash_bits = 32,
+    bool counts = false
+);
+
+/**
+ * @brief MolBatch overload of calculate_morgan_sparse() reusing pre-parsed molecules
  */
-nanobind::ndarray<nanobind::numpy, uint8_t> calculate_morgan_fingerprints(
-    const std::vector<std::string>& smiles_list,
+nanobind::dict calculate_morgan_sparse(
+    const MolBatch& batch,
     int radius = 2,
-    int nbits = 2048
+    int nbits = 2048,
+    int num_threads = 0,
+    bool unfolded = false,
+    int hash_bits = 32,
+    bool counts = false
+);
+
+/**
+ * @brief Calculate Morgan fingerprints for several radii and sizes at once
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param radii fingerprint radii
+ * @param nbits fold sizes; every radius is folded into every size
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param layout "dense", "bytes" or "uint64", as for calculate_morgan_fingerprints()
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
+ * @param out optional dict mapping (radius, nbits) to a preallocated matrix for
+ *        that fold, written in place and returned; other folds are allocated
+ *
+ * Environments are enumerated once per molecule up to the largest radius and
+ * their raw ids folded into every combination, so each matrix equals
+ * calculate_morgan_fingerprints() with that radius and size.
+ *
+ * @return dictionary mapping (radius, nbits) to a fingerprint matrix
+ */
+nanobind::dict calculate_morgan_sweep(
+    const SmilesColumn& smiles_list,
+    const std::vector<int>& radii,
+    const std::vector<int>& nbits,
+    int num_threads = 0,
+    const std::string& layout = "dense",
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of calculate_morgan_sweep() reusing pre-parsed molecules
+ */
+nanobind::dict calculate_morgan_sweep(
+    const MolBatch& batch,
+    const std::vector<int>& radii,
+    const std::vector<int>& nbits,
+    int num_threads = 0,
+    const std::string& layout = "dense",
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
 );
 
 /**
@@ -103,4 +401,324 @@ nanobind::tuple ecfp_reasoning_trace(
         static_cast<int>(kECFPReasoningFingerprintSize)
 );
 
+/**
+ * @brief Generate an ECFP-style reasoning trace for one molecule of a MolBatch.
+ * @param batch pre-parsed molecules
+ * @param index row of the molecule to analyse
+ * @return Same tuple as the SMILES overload; invalid rows yield an empty trace.
+ */
+nanobind::tuple ecfp_reasoning_trace(
+    const MolBatch& batch,
+    std::size_t index,
+    int radius = 2,
+    bool isomeric = true,
+    bool kekulize = false,
+    bool include_per_center = true,
+    int fingerprint_size =
+        static_cast<int>(kECFPReasoningFingerprintSize)
+);
+
+/**
+ * @brief Reasoning traces and fingerprints for a whole list of SMILES strings
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param radius Morgan fingerprint radius (default: 2)
+ * @param isomeric Whether to include stereochemistry when generating SMARTS
+ * @param kekulize Whether to kekulize the molecule before generating fragments
+ * @param include_per_center Whether to include per-atom chains in the trace
+ * @param fingerprint_size fingerprint length in bits (<= 0 uses the default)
+ * @param layout "dense" (default), "bytes" or "uint64" fingerprint rows
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
+ * @param out optional preallocated fingerprint matrix, written in place and returned
+ * @return (list of traces, fingerprint matrix with one row per input);
+ *         invalid SMILES yield an empty trace and a zero row
+ */
+nanobind::tuple ecfp_reasoning_traces(
+    const SmilesColumn& smiles_list,
+    int radius = 2,
+    bool isomeric = true,
+    bool kekulize = false,
+    bool include_per_center = true,
+    int fingerprint_size =
+        static_cast<int>(kECFPReasoningFingerprintSize),
+    const std::string& layout = "dense",
+    int num_threads = 0,
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of ecfp_reasoning_traces()
+ */
+nanobind::tuple ecfp_reasoning_traces(
+    const MolBatch& batch,
+    int radius = 2,
+    bool isomeric = true,
+    bool kekulize = false,
+    bool include_per_center = true,
+    int fingerprint_size =
+        static_cast<int>(kECFPReasoningFingerprintSize),
+    const std::string& layout = "dense",
+    int num_threads = 0,
+    bool dedup = false,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief Reasoning traces as int32 token ids from the process trace vocabulary
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param radius Morgan fingerprint radius (0 to kMaxTokenRadius)
+ * @param isomeric Whether to include stereochemistry when generating SMARTS
+ * @param kekulize Whether to kekulize the molecule before generating fragments
+ * @param include_per_center Whether to include per-atom chains in the trace
+ * @param fingerprint_size fingerprint length in bits (<= 0 uses the default)
+ * @param layout "dense" (default), "bytes" or "uint64" fingerprint rows
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param dedup compute each distinct SMILES once and copy its result to the repeats
+ * @return (int32 values, int64 row splits of length N + 1, fingerprint
+ *         matrix); row i's ids are values[splits[i]:splits[i + 1]], empty
+ *         for invalid SMILES
+ * @throws std::invalid_argument if radius exceeds kMaxTokenRadius
+ */
+nanobind::tuple ecfp_reasoning_trace_tokens(
+    const SmilesColumn& smiles_list,
+    int radius = 2,
+    bool isomeric = true,
+    bool kekulize = false,
+    bool include_per_center = true,
+    int fingerprint_size =
+        static_cast<int>(kECFPReasoningFingerprintSize),
+    const std::string& layout = "dense",
+    int num_threads = 0,
+    bool dedup = false
+);
+
+/**
+ * @brief MolBatch overload of ecfp_reasoning_trace_tokens()
+ */
+nanobind::tuple ecfp_reasoning_trace_tokens(
+    const MolBatch& batch,
+    int radius = 2,
+    bool isomeric = true,
+    bool kekulize = false,
+    bool include_per_center = true,
+    int fingerprint_size =
+        static_cast<int>(kECFPReasoningFingerprintSize),
+    const std::string& layout = "dense",
+    int num_threads = 0,
+    bool dedup = false
+);
+
+/**
+ * @brief Text trace rebuilt from token ids of the process trace vocabulary
+ * @throws std::invalid_argument for ids outside the vocabulary
+ */
+std::string decode_trace_tokens(
+    const nanobind::ndarray<const int32_t, nanobind::ndim<1>, nanobind::c_contig,
+                            nanobind::device::cpu>& ids);
+
+/**
+ * @brief Match SMARTS queries against every molecule
+ * @param smiles_list SMILES strings (sequence, numpy U/S array or Arrow string array)
+ * @param patterns SMARTS queries, each compiled once per call
+ * @param use_chirality require matching stereochemistry
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param out optional preallocated bool (N, len(patterns)) array, written in place and returned
+ * @return bool numpy array of shape (N, len(patterns)); invalid rows are all false
+ * @throws std::invalid_argument for a SMARTS that does not parse
+ */
+nanobind::object substructure_match(
+    const SmilesColumn& smiles_list,
+    const std::vector<std::string>& patterns,
+    bool use_chirality = false,
+    int num_threads = 0,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief MolBatch overload of substructure_match() reusing pre-parsed molecules
+ */
+nanobind::object substructure_match(
+    const MolBatch& batch,
+    const std::vector<std::string>& patterns,
+    bool use_chirality = false,
+    int num_threads = 0,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief All-pairs Tanimoto similarity between packed fingerprint matrices
+ * @param a query fingerprints (m rows)
+ * @param b library fingerprints (n rows, same dtype and width as a)
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param out optional preallocated float32 (m, n) array, written in place and returned
+ * @return float32 numpy array of shape (m, n)
+ * @throws std::overflow_error if the result does not fit in memory
+ */
+nanobind::object calculate_tanimoto_matrix(
+    const FingerprintArray& a,
+    const FingerprintArray& b,
+    int num_threads = 0,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief k most similar library fingerprints for every query
+ * @param queries query fingerprints (m rows)
+ * @param library library fingerprints (n rows, same dtype and width as queries)
+ * @param k number of hits per query, capped at n
+ * @param threshold minimum similarity for a hit
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param out optional tuple of preallocated int64 and float32 arrays of the
+ *        result shape, written in place and returned
+ * @return tuple (indices, scores) of shape (m, min(k, n)) with int64 library
+ *         rows and float32 similarities, best first; missing hits have
+ *         index -1
+ * @throws std::overflow_error if the result does not fit in memory
+ */
+nanobind::tuple calculate_tanimoto_topk(
+    const FingerprintArray& queries,
+    const FingerprintArray& library,
+    std::size_t k = 10,
+    float threshold = 0.0f,
+    int num_threads = 0,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief FingerprintDb overload of calculate_tanimoto_matrix() scanning the
+ *        mapped rows with their stored popcounts
+ */
+nanobind::object calculate_tanimoto_matrix(
+    const FingerprintArray& a,
+    const FingerprintDb& db,
+    int num_threads = 0,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief FingerprintDb overload of calculate_tanimoto_topk() scanning the
+ *        mapped rows with their stored popcounts
+ */
+nanobind::tuple calculate_tanimoto_topk(
+    const FingerprintArray& queries,
+    const FingerprintDb& db,
+    std::size_t k = 10,
+    float threshold = 0.0f,
+    int num_threads = 0,
+    const nanobind::object& out = nanobind::none()
+);
+
+/**
+ * @brief Taylor-Butina clustering of packed fingerprints
+ * @param fps packed fingerprints (uint8 np.packbits or uint64 word rows)
+ * @param threshold minimum Tanimoto similarity between a centroid and its members
+ * @param reordering update neighbor counts as rows are assigned
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @return (labels, centroids): int64 cluster of every row and int64 row
+ *         index of every cluster's centroid
+ */
+nanobind::tuple calculate_butina_clusters(
+    const FingerprintArray& fps,
+    float threshold,
+    bool reordering = false,
+    int num_threads = 0
+);
+
+/**
+ * @brief FingerprintDb overload of calculate_butina_clusters() using the
+ *        mapped rows and stored popcounts
+ */
+nanobind::tuple calculate_butina_clusters(
+    const FingerprintDb& db,
+    float threshold,
+    bool reordering = false,
+    int num_threads = 0
+);
+
+/**
+ * @brief MaxMin diversity picks from packed fingerprints
+ * @param fps packed fingerprints (uint8 np.packbits or uint64 word rows)
+ * @param k number of rows to pick, including first_picks
+ * @param first_picks rows to start from; empty draws the first pick from seed
+ * @param seed random seed for the first pick
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @return int64 row indices in pick order
+ */
+nanobind::ndarray<nanobind::numpy, int64_t> calculate_maxmin_picks(
+    const FingerprintArray& fps,
+    size_t k,
+    const std::vector<int64_t>& first_picks,
+    uint64_t seed = 0,
+    int num_threads = 0
+);
+
+/**
+ * @brief FingerprintDb overload of calculate_maxmin_picks()
+ */
+nanobind::ndarray<nanobind::numpy, int64_t> calculate_maxmin_picks(
+    const FingerprintDb& db,
+    size_t k,
+    const std::vector<int64_t>& first_picks,
+    uint64_t seed = 0,
+    int num_threads = 0
+);
+
+/**
+ * @brief Write a packed fingerprint matrix to a memory-mappable database file
+ * @param path destination file
+ * @param fingerprints packed uint8 (np.packbits) or uint64 fingerprint matrix
+ * @param ids optional identifier per row
+ * @param num_bits fingerprint length in bits (0 uses the full row width)
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ */
+void write_fingerprint_db(
+    const std::string& path,
+    const FingerprintArray& fingerprints,
+    const std::optional<std::vector<std::string>>& ids = std::nullopt,
+    std::size_t num_bits = 0,
+    int num_threads = 0
+);
+
+/**
+ * @brief Zero-copy numpy view of the rows of a FingerprintDb
+ * @param db Python handle of the database, kept alive by the returned array
+ * @return read-only uint8 or uint64 array of shape (rows, width)
+ */
+nanobind::object fingerprint_db_fingerprints(nanobind::handle db);
+
+/**
+ * @brief Zero-copy numpy view of the stored popcounts of a FingerprintDb
+ * @param db Python handle of the database, kept alive by the returned array
+ */
+nanobind::object fingerprint_db_popcounts(nanobind::handle db);
+
+/**
+ * @brief Identifiers of selected FingerprintDb rows
+ * @param db fingerprint database
+ * @param indices rows to look up; -1 entries (top-k padding) map to ""
+ */
+std::vector<std::string> fingerprint_db_ids(
+    const FingerprintDb& db,
+    const std::vector<std::int64_t>& indices
+);
+
+/**
+ * @brief Wait for the next batch of a SmilesFileReader (GIL released)
+ * @param reader open streaming reader
+ * @return dict with "offset", "smiles", "ids" (or None), "valid" and, when
+ *         requested, "molecular_weight"/"logp"/"tpsa", "fingerprints", "traces"
+ * @throws nanobind::stop_iteration at end of file
+ */
+nanobind::dict smiles_reader_next(SmilesFileReader& reader);
+
+/**
+ * @brief Validity mask of a MolBatch as a numpy boolean array
+ * @param batch pre-parsed molecules
+ * @return numpy array of boolean values (true for rows that parsed)
+ */
+nanobind::ndarray<nanobind::numpy, bool> mol_batch_valid_mask(
+    const MolBatch& batch
+);
+
 } // namespace rdktools
@@ -1,8 +1,15 @@
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
 #include <nanobind/stl/vector.h>
+#include <nanobind/stl/optional.h>
 #include <nanobind/stl/string.h>
+#include <nanobind/stl/unique_ptr.h>
+#include "async_submit.hpp"
+#include "descriptor_registry.hpp"
+#include "result_cache.hpp"
 #include "molecular_ops.hpp"
+#include "stats.hpp"
+#include "thread_pool.hpp"
  
 // Helper macros to stringify VERSION_INFO passed from CMake
 #ifndef STRINGIFY
@@ -18,45 +25,344 @@ using namespace nb::literals;
 NB_MODULE(_rdktools_core, m) {
     m.doc() = "High-performance molecular operations using RDKit C++";
     
+    // Parse-once molecule container shared by batch functions
+    nb::class_<rdktools::MolBatch>(m, "MolBatch",
+                                   "SMILES list parsed once and reused across batch functions")
+        .def("__init__",
+             [](rdktools::MolBatch* self, const rdktools::SmilesColumn& smiles_list,
+                int num_threads) {
+                 nb::gil_scoped_release release;
+                 new (self) rdktools::MolBatch(smiles_list, num_threads);
+             },
+             "smiles_list"_a,
+             "num_threads"_a = 0)
+        .def_static("from_pickles",
+                    [](const nb::object& pickles, const nb::object& offsets, int num_threads) {
+                        rdktools::SmilesColumn column = rdktools::pickle_column(pickles, offsets);
+                        nb::gil_scoped_release release;
+                        return std::make_unique<rdktools::MolBatch>(
+                            column, num_threads, rdktools::MolInput::Pickle);
+                    },
+                    "Rebuild a MolBatch from MolPickler pickles without re-parsing SMILES",
+                    "pickles"_a,
+                    "offsets"_a = nb::none(),
+                    "num_threads"_a = 0)
+        .def("__len__", &rdktools::MolBatch::size)
+        .def_prop_ro("num_valid", &rdktools::MolBatch::num_valid,
+                     "Number of rows that parsed successfully")
+        .def_prop_ro("valid", &rdktools::mol_batch_valid_mask,
+                     "Boolean validity mask with one entry per input row");
+    
+    // Memory-mapped fingerprint database
+    nb::class_<rdktools::FingerprintDb>(m, "FingerprintDB",
+                                        "Read-only memory-mapped fingerprint database")
+        .def(nb::init<const std::string&>(), "path"_a)
+        .def("__len__", &rdktools::FingerprintDb::size)
+        .def_prop_ro("path", &rdktools::FingerprintDb::path)
+        .def_prop_ro("num_bits", &rdktools::FingerprintDb::num_bits,
+                     "Fingerprint length in bits")
+        .def_prop_ro("layout",
+                     [](const rdktools::FingerprintDb& db) {
+                         return db.layout() == rdktools::FingerprintLayout::PackedWords
+                                    ? "uint64"
+                                    : "bytes";
+                     },
+                     "Packed layout of the rows: 'bytes' or 'uint64'")
+        .def_prop_ro("has_ids", &rdktools::FingerprintDb::has_ids)
+        .def_prop_ro("fingerprints", &rdktools::fingerprint_db_fingerprints,
+                     "Read-only view of the mapped fingerprint rows")
+        .def_prop_ro("popcounts", &rdktools::fingerprint_db_popcounts,
+                     "Read-only view of the stored per-row bit counts")
+        .def("ids", &rdktools::fingerprint_db_ids,
+             "Identifiers of the given rows (-1 maps to '')",
+             "indices"_a);
+
+    // Streaming file reader with pipelined read / split / featurize stages
+    nb::class_<rdktools::SmilesFileReader>(m, "SmilesFileReader",
+                                           "Iterator over featurized batches of a SMILES file")
+        .def("__init__",
+             [](rdktools::SmilesFileReader* self, const std::string& path,
+                std::size_t batch_size, const std::string& delimiter, bool header,
+                int smiles_column, const std::string& smiles_column_name, int id_column,
+                const std::string& id_column_name, bool descriptors, bool fingerprints,
+                int radius, int nbits, const std::string& layout, bool traces,
+                int num_threads, std::size_t chunk_bytes, std::size_t queue_depth) {
+                 if (delimiter.size() > 1) {
+                     throw std::invalid_argument("delimiter must be a single character");
+                 }
+                 rdktools::SmilesReaderOptions options;
+                 options.path = path;
+                 options.batch_size = batch_size;
+                 options.delimiter = delimiter.empty() ? '\0' : delimiter[0];
+                 options.header = header;
+                 options.smiles_column = smiles_column;
+                 options.smiles_column_name = smiles_column_name;
+                 options.id_column = id_column;
+                 options.id_column_name = id_column_name;
+                 options.descriptors = descriptors;
+                 options.fingerprints = fingerprints;
+                 options.radius = radius;
+                 options.nbits = nbits;
+                 options.fingerprint_layout = rdktools::parse_fingerprint_layout(layout);
+                 options.traces = traces;
+                 options.num_threads = num_threads;
+                 options.chunk_bytes = chunk_bytes;
+                 options.queue_depth = queue_depth;
+                 new (self) rdktools::SmilesFileReader(std::move(options));
+             },
+             "path"_a,
+             "batch_size"_a = 10000,
+             "delimiter"_a = "",
+             "header"_a = false,
+             "smiles_column"_a = 0,
+             "smiles_column_name"_a = "",
+             "id_column"_a = -1,
+             "id_column_name"_a = "",
+             "descriptors"_a = true,
+             "fingerprints"_a = false,
+             "radius"_a = 2,
+             "nbits"_a = 2048,
+             "layout"_a = "dense",
+             "traces"_a = false,
+             "num_threads"_a = 0,
+             "chunk_bytes"_a = std::size_t{4} << 20,
+             "queue_depth"_a = 2)
+        .def("__iter__", [](nb::handle self) { return self; })
+        .def("__next__", &rdktools::smiles_reader_next)
+        .def("close",
+             [](rdktools::SmilesFileReader& reader) {
+                 nb::gil_scoped_release release;
+                 reader.close();
+             },
+             "Stop the pipeline and release the file")
+        .def_prop_ro("rows_read", &rdktools::SmilesFileReader::rows_read,
+                     "Records returned so far");
+
     // Molecular weight calculation
-    m.def("calculate_molecular_weights", &rdktools::calculate_molecular_weights,
+    m.def("calculate_molecular_weights",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, bool, const std::string&,
+                            const nb::object&>(&rdktools::calculate_molecular_weights),
           "Calculate molecular weights for SMILES strings",
-          "smiles_list"_a);
+          "smiles_list"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "dtype"_a = "float64",
+          "out"_a = nb::none());
+    m.def("calculate_molecular_weights",
+          nb::overload_cast<const rdktools::MolBatch&, int, bool, const std::string&,
+                            const nb::object&>(&rdktools::calculate_molecular_weights),
+          "Calculate molecular weights for a MolBatch",
+          "batch"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "dtype"_a = "float64",
+          "out"_a = nb::none());
     
     // LogP calculation
-    m.def("calculate_logp", &rdktools::calculate_logp,
+    m.def("calculate_logp",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, bool, const std::string&,
+                            const nb::object&>(&rdktools::calculate_logp),
           "Calculate LogP values for SMILES strings",
-          "smiles_list"_a);
+          "smiles_list"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "dtype"_a = "float64",
+          "out"_a = nb::none());
+    m.def("calculate_logp",
+          nb::overload_cast<const rdktools::MolBatch&, int, bool, const std::string&,
+                            const nb::object&>(&rdktools::calculate_logp),
+          "Calculate LogP values for a MolBatch",
+          "batch"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "dtype"_a = "float64",
+          "out"_a = nb::none());
     
     // TPSA calculation
-    m.def("calculate_tpsa", &rdktools::calculate_tpsa,
+    m.def("calculate_tpsa",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, bool, const std::string&,
+                            const nb::object&>(&rdktools::calculate_tpsa),
           "Calculate TPSA values for SMILES strings",
-          "smiles_list"_a);
+          "smiles_list"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "dtype"_a = "float64",
+          "out"_a = nb::none());
+    m.def("calculate_tpsa",
+          nb::overload_cast<const rdktools::MolBatch&, int, bool, const std::string&,
+                            const nb::object&>(&rdktools::calculate_tpsa),
+          "Calculate TPSA values for a MolBatch",
+          "batch"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "dtype"_a = "float64",
+          "out"_a = nb::none());
     
     // SMILES validation
-    m.def("validate_smiles", &rdktools::validate_smiles,
-          "Validate SMILES strings and return boolean array",
-          "smiles_list"_a);
+    m.def("validate_smiles",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, const std::string&,
+                            const nb::object&>(&rdktools::validate_smiles),
+          "Validate SMILES strings at the given level and return boolean array",
+          "smiles_list"_a,
+          "num_threads"_a = 0,
+          "level"_a = "full",
+          "out"_a = nb::none());
+    m.def("validate_smiles",
+          nb::overload_cast<const rdktools::MolBatch&, int, const std::string&,
+                            const nb::object&>(&rdktools::validate_smiles),
+          "Validate a MolBatch and return boolean array",
+          "batch"_a,
+          "num_threads"_a = 0,
+          "level"_a = "full",
+          "out"_a = nb::none());
     
     // Multiple descriptors calculation
-    m.def("calculate_multiple_descriptors", &rdktools::calculate_multiple_descriptors,
+    m.def("calculate_multiple_descriptors",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, bool, const nb::object&>(
+              &rdktools::calculate_multiple_descriptors),
           "Calculate multiple descriptors efficiently for SMILES strings",
-          "smiles_list"_a);
+          "smiles_list"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "out"_a = nb::none());
+    m.def("calculate_multiple_descriptors",
+          nb::overload_cast<const rdktools::MolBatch&, int, bool, const nb::object&>(
+              &rdktools::calculate_multiple_descriptors),
+          "Calculate multiple descriptors efficiently for a MolBatch",
+          "batch"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "out"_a = nb::none());
+    
+    // Configurable descriptor matrix
+    m.def("calculate_descriptors",
+          nb::overload_cast<const rdktools::SmilesColumn&, const std::vector<std::string>&,
+                            const std::string&, int, bool, const nb::object&>(
+              &rdktools::calculate_descriptors),
+          "Calculate named descriptors into an N x D matrix for SMILES strings",
+          "smiles_list"_a,
+          "names"_a = std::vector<std::string>(),
+          "dtype"_a = "float32",
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "out"_a = nb::none());
+    m.def("calculate_descriptors",
+          nb::overload_cast<const rdktools::MolBatch&, const std::vector<std::string>&,
+                            const std::string&, int, bool, const nb::object&>(
+              &rdktools::calculate_descriptors),
+          "Calculate named descriptors into an N x D matrix for a MolBatch",
+          "batch"_a,
+          "names"_a = std::vector<std::string>(),
+          "dtype"_a = "float32",
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "out"_a = nb::none());
+    m.def("descriptor_names", &rdktools::descriptor_names,
+          "Names accepted by calculate_descriptors, in registry order");
     
     // SMILES canonicalization
-    m.def("canonicalize_smiles", &rdktools::canonicalize_smiles,
+    m.def("canonicalize_smiles",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, bool>(&rdktools::canonicalize_smiles),
           "Convert SMILES to canonical form",
-          "smiles_list"_a);
+          "smiles_list"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false);
+    m.def("canonicalize_smiles",
+          nb::overload_cast<const rdktools::MolBatch&, int, bool>(&rdktools::canonicalize_smiles),
+          "Convert a MolBatch to canonical SMILES",
+          "batch"_a,
+          "num_threads"_a = 0,
+          "dedup"_a = false);
+
+    // Binary molecule serialization
+    m.def("smiles_to_pickles",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, bool>(&rdktools::smiles_to_pickles),
+          "Parse SMILES and serialize the molecules as RDKit pickles",
+          "smiles_list"_a,
+          "num_threads"_a = 0,
+          "as_buffer"_a = false);
+    m.def("smiles_to_pickles",
+          nb::overload_cast<const rdktools::MolBatch&, int, bool>(&rdktools::smiles_to_pickles),
+          "Serialize a MolBatch as RDKit pickles",
+          "batch"_a,
+          "num_threads"_a = 0,
+          "as_buffer"_a = false);
     
     // Morgan fingerprints
-    m.def("calculate_morgan_fingerprints", &rdktools::calculate_morgan_fingerprints,
+    m.def("calculate_morgan_fingerprints",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, int, int, const std::string&, bool,
+                            const nb::object&>(&rdktools::calculate_morgan_fingerprints),
           "Calculate Morgan fingerprints as bit vectors",
           "smiles_list"_a,
           "radius"_a = 2,
-          "nbits"_a = 2048);
+          "nbits"_a = 2048,
+          "num_threads"_a = 0,
+          "layout"_a = "dense",
+          "dedup"_a = false,
+          "out"_a = nb::none());
+    m.def("calculate_morgan_fingerprints",
+          nb::overload_cast<const rdktools::MolBatch&, int, int, int, const std::string&, bool,
+                            const nb::object&>(&rdktools::calculate_morgan_fingerprints),
+          "Calculate Morgan fingerprints as bit vectors for a MolBatch",
+          "batch"_a,
+          "radius"_a = 2,
+          "nbits"_a = 2048,
+          "num_threads"_a = 0,
+          "layout"_a = "dense",
+          "dedup"_a = false,
+          "out"_a = nb::none());
+    
+    m.def("calculate_morgan_sparse",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, int, int, bool, int, bool>(
+              &rdktools::calculate_morgan_sparse),
+          "Calculate Morgan fingerprints as CSR arrays (indptr, indices, counts)",
+          "smiles_list"_a,
+          "radius"_a = 2,
+          "nbits"_a = 2048,
+          "num_threads"_a = 0,
+          "unfolded"_a = false,
+          "hash_bits"_a = 32,
+          "counts"_a = false);
+    m.def("calculate_morgan_sparse",
+          nb::overload_cast<const rdktools::MolBatch&, int, int, int, bool, int, bool>(
+              &rdktools::calculate_morgan_sparse),
+          "Calculate Morgan fingerprints as CSR arrays for a MolBatch",
+          "batch"_a,
+          "radius"_a = 2,
+          "nbits"_a = 2048,
+          "num_threads"_a = 0,
+          "unfolded"_a = false,
+          "hash_bits"_a = 32,
+          "counts"_a = false);
+    m.def("calculate_morgan_sweep",
+          nb::overload_cast<const rdktools::SmilesColumn&, const std::vector<int>&,
+                            const std::vector<int>&, int, const std::string&, bool,
+                            const nb::object&>(&rdktools::calculate_morgan_sweep),
+          "Calculate Morgan fingerprints for every (radius, nbits) combination in one pass",
+          "smiles_list"_a,
+          "radii"_a,
+          "nbits"_a,
+          "num_threads"_a = 0,
+          "layout"_a = "dense",
+          "dedup"_a = false,
+          "out"_a = nb::none());
+    m.def("calculate_morgan_sweep",
+          nb::overload_cast<const rdktools::MolBatch&, const std::vector<int>&,
+                            const std::vector<int>&, int, const std::string&, bool,
+                            const nb::object&>(&rdktools::calculate_morgan_sweep),
+          "Calculate Morgan fingerprints for every (radius, nbits) combination of a MolBatch",
+          "batch"_a,
+          "radii"_a,
+          "nbits"_a,
+          "num_threads"_a = 0,
+          "layout"_a = "dense",
+          "dedup"_a = false,
+          "out"_a = nb::none());
     
     // ECFP reasoning trace
-    m.def("ecfp_reasoning_trace", &rdktools::ecfp_reasoning_trace,
+    m.def("ecfp_reasoning_trace",
+          nb::overload_cast<const std::string&, int, bool, bool, bool, int>(
+              &rdktools::ecfp_reasoning_trace),
           "Generate an ECFP reasoning trace and fingerprint for a SMILES string",
           "smiles"_a,
           "radius"_a = 2,
@@ -65,6 +371,283 @@ NB_MODULE(_rdktools_core, m) {
           "include_per_center"_a = true,
           "fingerprint_size"_a =
               static_cast<int>(rdktools::kECFPReasoningFingerprintSize));
+    m.def("ecfp_reasoning_trace",
+          nb::overload_cast<const rdktools::MolBatch&, size_t, int, bool, bool, bool, int>(
+              &rdktools::ecfp_reasoning_trace),
+          "Generate an ECFP reasoning trace and fingerprint for one MolBatch row",
+          "batch"_a,
+          "index"_a,
+          "radius"_a = 2,
+          "isomeric"_a = true,
+          "kekulize"_a = false,
+          "include_per_center"_a = true,
+          "fingerprint_size"_a =
+              static_cast<int>(rdktools::kECFPReasoningFingerprintSize));
+    m.def("ecfp_reasoning_traces",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, bool, bool, bool, int,
+                            const std::string&, int, bool, const nb::object&>(
+              &rdktools::ecfp_reasoning_traces),
+          "Generate ECFP reasoning traces and a fingerprint matrix for SMILES strings",
+          "smiles_list"_a,
+          "radius"_a = 2,
+          "isomeric"_a = true,
+          "kekulize"_a = false,
+          "include_per_center"_a = true,
+          "fingerprint_size"_a =
+              static_cast<int>(rdktools::kECFPReasoningFingerprintSize),
+          "layout"_a = "dense",
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "out"_a = nb::none());
+    m.def("ecfp_reasoning_traces",
+          nb::overload_cast<const rdktools::MolBatch&, int, bool, bool, bool, int,
+                            const std::string&, int, bool, const nb::object&>(
+              &rdktools::ecfp_reasoning_traces),
+          "Generate ECFP reasoning traces and a fingerprint matrix for a MolBatch",
+          "batch"_a,
+          "radius"_a = 2,
+          "isomeric"_a = true,
+          "kekulize"_a = false,
+          "include_per_center"_a = true,
+          "fingerprint_size"_a =
+              static_cast<int>(rdktools::kECFPReasoningFingerprintSize),
+          "layout"_a = "dense",
+          "num_threads"_a = 0,
+          "dedup"_a = false,
+          "out"_a = nb::none());
+    m.def("ecfp_reasoning_trace_tokens",
+          nb::overload_cast<const rdktools::SmilesColumn&, int, bool, bool, bool, int,
+                            const std::string&, int, bool>(
+              &rdktools::ecfp_reasoning_trace_tokens),
+          "Generate ECFP reasoning traces as ragged token ids for SMILES strings",
+          "smiles_list"_a,
+          "radius"_a = 2,
+          "isomeric"_a = true,
+          "kekulize"_a = false,
+          "include_per_center"_a = true,
+          "fingerprint_size"_a =
+              static_cast<int>(rdktools::kECFPReasoningFingerprintSize),
+          "layout"_a = "dense",
+          "num_threads"_a = 0,
+          "dedup"_a = false);
+    m.def("ecfp_reasoning_trace_tokens",
+          nb::overload_cast<const rdktools::MolBatch&, int, bool, bool, bool, int,
+                            const std::string&, int, bool>(
+              &rdktools::ecfp_reasoning_trace_tokens),
+          "Generate ECFP reasoning traces as ragged token ids for a MolBatch",
+          "batch"_a,
+          "radius"_a = 2,
+          "isomeric"_a = true,
+          "kekulize"_a = false,
+          "include_per_center"_a = true,
+          "fingerprint_size"_a =
+              static_cast<int>(rdktools::kECFPReasoningFingerprintSize),
+          "layout"_a = "dense",
+          "num_threads"_a = 0,
+          "dedup"_a = false);
+    m.def("decode_trace_tokens", &rdktools::decode_trace_tokens,
+          "Rebuild the text trace from token ids",
+          "ids"_a);
+    
+    // Substructure search
+    m.def("substructure_match",
+          nb::overload_cast<const rdktools::SmilesColumn&, const std::vector<std::string>&, bool,
+                            int, const nb::object&>(&rdktools::substructure_match),
+          "Match SMARTS queries against SMILES with a pattern fingerprint prescreen",
+          "smiles_list"_a,
+          "patterns"_a,
+          "use_chirality"_a = false,
+          "num_threads"_a = 0,
+          "out"_a = nb::none());
+    m.def("substructure_match",
+          nb::overload_cast<const rdktools::MolBatch&, const std::vector<std::string>&, bool,
+                            int, const nb::object&>(&rdktools::substructure_match),
+          "Match SMARTS queries against a MolBatch with a pattern fingerprint prescreen",
+          "batch"_a,
+          "patterns"_a,
+          "use_chirality"_a = false,
+          "num_threads"_a = 0,
+          "out"_a = nb::none());
+    
+    // Fingerprint similarity
+    m.def("calculate_tanimoto_matrix",
+          nb::overload_cast<const rdktools::FingerprintArray&, const rdktools::FingerprintArray&, int,
+                            const nb::object&>(&rdktools::calculate_tanimoto_matrix),
+          "All-pairs Tanimoto similarity between packed fingerprint matrices",
+          "a"_a,
+          "b"_a,
+          "num_threads"_a = 0,
+          "out"_a = nb::none());
+    m.def("calculate_tanimoto_matrix",
+          nb::overload_cast<const rdktools::FingerprintArray&, const rdktools::FingerprintDb&, int,
+                            const nb::object&>(&rdktools::calculate_tanimoto_matrix),
+          "Tanimoto similarity of packed fingerprints against a FingerprintDB",
+          "a"_a,
+          "db"_a,
+          "num_threads"_a = 0,
+          "out"_a = nb::none());
+    m.def("calculate_tanimoto_topk",
+          nb::overload_cast<const rdktools::FingerprintArray&, const rdktools::FingerprintArray&,
+                            size_t, float, int, const nb::object&>(
+              &rdktools::calculate_tanimoto_topk),
+          "Top-k Tanimoto search of packed query fingerprints against a library",
+          "queries"_a,
+          "library"_a,
+          "k"_a = 10,
+          "threshold"_a = 0.0f,
+          "num_threads"_a = 0,
+          "out"_a = nb::none());
+    m.def("calculate_tanimoto_topk",
+          nb::overload_cast<const rdktools::FingerprintArray&, const rdktools::FingerprintDb&,
+                            size_t, float, int, const nb::object&>(
+              &rdktools::calculate_tanimoto_topk),
+          "Top-k Tanimoto search of packed query fingerprints against a FingerprintDB",
+          "queries"_a,
+          "db"_a,
+          "k"_a = 10,
+          "threshold"_a = 0.0f,
+          "num_threads"_a = 0,
+          "out"_a = nb::none());
+    m.def("calculate_butina_clusters",
+          nb::overload_cast<const rdktools::FingerprintArray&, float, bool, int>(
+              &rdktools::calculate_butina_clusters),
+          "Taylor-Butina clustering of packed fingerprints at a similarity threshold",
+          "fps"_a,
+          "threshold"_a,
+          "reordering"_a = false,
+          "num_threads"_a = 0);
+    m.def("calculate_butina_clusters",
+          nb::overload_cast<const rdktools::FingerprintDb&, float, bool, int>(
+              &rdktools::calculate_butina_clusters),
+          "Taylor-Butina clustering of a FingerprintDB at a similarity threshold",
+          "db"_a,
+          "threshold"_a,
+          "reordering"_a = false,
+          "num_threads"_a = 0);
+    m.def("calculate_maxmin_picks",
+          nb::overload_cast<const rdktools::FingerprintArray&, size_t,
+                            const std::vector<int64_t>&, uint64_t, int>(
+              &rdktools::calculate_maxmin_picks),
+          "MaxMin diversity picks from packed fingerprints",
+          "fps"_a,
+          "k"_a,
+          "first_picks"_a = std::vector<int64_t>(),
+          "seed"_a = 0,
+          "num_threads"_a = 0);
+    m.def("calculate_maxmin_picks",
+          nb::overload_cast<const rdktools::FingerprintDb&, size_t,
+                            const std::vector<int64_t>&, uint64_t, int>(
+              &rdktools::calculate_maxmin_picks),
+          "MaxMin diversity picks from a FingerprintDB",
+          "db"_a,
+          "k"_a,
+          "first_picks"_a = std::vector<int64_t>(),
+          "seed"_a = 0,
+          "num_threads"_a = 0);
+    m.def("write_fingerprint_db",
+          nb::overload_cast<const std::string&, const rdktools::FingerprintArray&,
+                            const std::optional<std::vector<std::string>>&, size_t, int>(
+              &rdktools::write_fingerprint_db),
+          "Write packed fingerprints to a memory-mappable database file",
+          "path"_a,
+          "fingerprints"_a,
+          "ids"_a = nb::none(),
+          "num_bits"_a = 0,
+          "num_threads"_a = 0);
+    m.def("popcount_kernel", &rdktools::popcount_kernel_name,
+          "Name of the popcount kernel selected for this CPU");
+    
+    // Worker pool configuration
+    m.def("set_num_threads", &rdktools::set_default_num_threads,
+          "Set the default number of worker threads used by batch functions",
+          "num_threads"_a);
+    m.def("get_num_threads", &rdktools::default_num_threads,
+          "Get the default number of worker threads used by batch functions");
+    
+    // Asynchronous submission
+    m.def("submit_call", &rdktools::submit_call,
+          "Run fn(*args, **kwargs) on the worker pool and resolve a concurrent.futures.Future",
+          "future"_a,
+          "fn"_a,
+          "args"_a,
+          "kwargs"_a,
+          "block"_a = true);
+    m.def("set_max_in_flight", &rdktools::set_max_in_flight,
+          "Bound the number of submitted jobs queued or running at once",
+          "limit"_a);
+    m.def("get_max_in_flight", &rdktools::max_in_flight,
+          "Bound on submitted jobs queued or running at once");
+    m.def("get_in_flight", &rdktools::in_flight,
+          "Number of submitted jobs not yet finished");
+    m.def("wait_for_submitted", &rdktools::wait_for_submitted,
+          "Block until every submitted job finished");
+
+    // Reasoning trace caches
+    m.def("set_trace_cache_capacity", &rdktools::set_trace_cache_capacity,
+          "Resize the fragment metrics cache used to order trace tokens",
+          "capacity"_a);
+    m.def("get_trace_cache_capacity", &rdktools::trace_cache_capacity,
+          "Capacity of the fragment metrics cache used to order trace tokens");
+
+    // Trace token vocabulary
+    m.def("get_trace_vocabulary",
+          [] { return rdktools::trace_vocabulary().tokens(); },
+          "Every trace token in id order");
+    m.def("set_trace_vocabulary",
+          [](const std::vector<std::string>& tokens, bool frozen) {
+              rdktools::trace_vocabulary().assign(tokens, frozen);
+          },
+          "Replace the trace vocabulary, e.g. with one saved from an earlier run",
+          "tokens"_a,
+          "frozen"_a = false);
+
+    // Cross-call result cache
+    m.def("set_result_cache_capacity",
+          [](size_t capacity_bytes) { rdktools::result_cache().set_capacity(capacity_bytes); },
+          "Bound the per-SMILES result cache in bytes; 0 disables it",
+          "capacity_bytes"_a);
+    m.def("get_result_cache_capacity",
+          []() { return rdktools::result_cache().capacity(); },
+          "Capacity of the per-SMILES result cache in bytes");
+    m.def("result_cache_stats", []() {
+        const rdktools::ResultCache::Stats stats = rdktools::result_cache().stats();
+        nb::dict out;
+        out["hits"] = stats.hits;
+        out["misses"] = stats.misses;
+        out["evictions"] = stats.evictions;
+        out["entries"] = stats.entries;
+        out["bytes"] = stats.bytes;
+        out["capacity"] = stats.capacity;
+        return out;
+    }, "Hit, miss and eviction counters and current size of the result cache");
+    m.def("clear_result_cache", []() {
+        rdktools::result_cache().clear();
+        rdktools::result_cache().reset_stats();
+    }, "Drop every cached result and zero the counters");
+
+    // Per-stage timers and counters
+    m.def("get_stats", []() {
+        const rdktools::StatsSnapshot snapshot = rdktools::stats_snapshot();
+        nb::dict counters;
+        for (size_t i = 0; i < rdktools::kNumCounters; ++i) {
+            counters[rdktools::counter_name(static_cast<rdktools::Counter>(i))] =
+                snapshot.counters[i];
+        }
+        nb::dict stages;
+        for (size_t i = 0; i < rdktools::kNumStages; ++i) {
+            nb::dict stage;
+            stage["calls"] = snapshot.stages[i].calls;
+            stage["seconds"] = static_cast<double>(snapshot.stages[i].nanoseconds) * 1e-9;
+            stages[rdktools::stage_name(static_cast<rdktools::Stage>(i))] = stage;
+        }
+        nb::dict out;
+        out["enabled"] = rdktools::kStatsEnabled;
+        out["counters"] = counters;
+        out["stages"] = stages;
+        return out;
+    }, "Hot-path counters and per-stage call counts and times since the last reset");
+    m.def("reset_stats", &rdktools::reset_stats,
+          "Zero the hot-path counters and stage timers");
     
     // Module version
     m.attr("__version__") = MACRO_STRINGIFY(VERSION_INFO);
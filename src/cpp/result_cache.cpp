@@ -0,0 +1,157 @@
+#include "result_cache.hpp"
+#include "stats.hpp"
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace rdktools {
+
+namespace {
+
+// Rough per-entry cost of the map node, clock slot and string headers
+constexpr std::size_t kEntryOverheadBytes = 96;
+
+std::size_t entry_bytes(const std::string& key, const std::string& value) {
+    return key.size() + value.size() + kEntryOverheadBytes;
+}
+
+std::size_t initial_result_cache_bytes() {
+    if (const char* env = std::getenv("RDKTOOLS_RESULT_CACHE_BYTES")) {
+        char* end = nullptr;
+        const unsigned long long value = std::strtoull(env, &end, 10);
+        if (end != env) {
+            return static_cast<std::size_t>(value);
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+ResultCache::ResultCache(std::size_t capacity_bytes) {
+    set_capacity(capacity_bytes);
+}
+
+ResultCache::Shard& ResultCache::shard_for(const std::string& key) {
+    const std::size_t h = std::hash<std::string>{}(key);
+    return shards_[(h ^ (h >> 29)) % kShards];
+}
+
+bool ResultCache::find(const std::string& key, std::string& out) {
+    if (!enabled()) {
+        return false;
+    }
+    Shard& shard = shard_for(key);
+    {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        const auto it = shard.items.find(key);
+        if (it != shard.items.end()) {
+            out = it->second.value;
+            it->second.referenced.store(true, std::memory_order_relaxed);
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            RDKTOOLS_COUNT(ResultCacheHits);
+            return true;
+        }
+    }
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    RDKTOOLS_COUNT(ResultCacheMisses);
+    return false;
+}
+
+void ResultCache::insert(const std::string& key, std::string value) {
+    const std::size_t limit = shard_capacity_.load(std::memory_order_relaxed);
+    const std::size_t bytes = entry_bytes(key, value);
+    if (limit == 0 || bytes > limit) {
+        return;
+    }
+    Shard& shard = shard_for(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto [it, inserted] = shard.items.try_emplace(key);
+    if (!inserted) {
+        return;
+    }
+    it->second.value = std::move(value);
+    shard.clock.push_back(&it->first);
+    shard.bytes += bytes;
+    evict(shard, limit);
+}
+
+void ResultCache::evict(Shard& shard, std::size_t limit) {
+    while (shard.bytes > limit && !shard.clock.empty()) {
+        const std::string* key = shard.clock.front();
+        shard.clock.pop_front();
+        const auto it = shard.items.find(*key);
+        if (it->second.referenced.exchange(false, std::memory_order_relaxed)) {
+            // Second chance: recently hit entries go to the back of the clock
+            shard.clock.push_back(key);
+            continue;
+        }
+        shard.bytes -= entry_bytes(it->first, it->second.value);
+        shard.items.erase(it);
+        shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void ResultCache::set_capacity(std::size_t capacity_bytes) {
+    const std::size_t limit =
+        capacity_bytes == 0 ? 0 : (capacity_bytes + kShards - 1) / kShards;
+    shard_capacity_.store(limit, std::memory_order_relaxed);
+    for (Shard& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        if (limit == 0) {
+            shard.clock.clear();
+            shard.items.clear();
+            shard.bytes = 0;
+        } else {
+            evict(shard, limit);
+        }
+    }
+}
+
+ResultCache::Stats ResultCache::stats() const {
+    Stats stats;
+    stats.capacity = capacity();
+    for (const Shard& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        stats.hits += shard.hits.load(std::memory_order_relaxed);
+        stats.misses += shard.misses.load(std::memory_order_relaxed);
+        stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+        stats.entries += shard.items.size();
+        stats.bytes += shard.bytes;
+    }
+    return stats;
+}
+
+void ResultCache::reset_stats() {
+    for (Shard& shard : shards_) {
+        shard.hits.store(0, std::memory_order_relaxed);
+        shard.misses.store(0, std::memory_order_relaxed);
+        shard.evictions.store(0, std::memory_order_relaxed);
+    }
+}
+
+void ResultCache::clear() {
+    for (Shard& shard : shards_) {
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.clock.clear();
+        shard.items.clear();
+        shard.bytes = 0;
+    }
+}
+
+ResultCache& result_cache() {
+    static ResultCache cache(initial_result_cache_bytes());
+    return cache;
+}
+
+std::string result_cache_key(std::string_view tag, std::string_view smiles) {
+    std::string key;
+    key.reserve(tag.size() + 1 + smiles.size());
+    key.append(tag);
+    key.push_back('\0');
+    key.append(smiles);
+    return key;
+}
+
+} // namespace rdktools
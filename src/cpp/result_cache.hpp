@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace rdktools {
+
+/**
+ * @brief Process-wide, byte-bounded cache of per-SMILES results.
+ *
+ * Entries map a key naming the function, its parameters and the input SMILES
+ * (see result_cache_key()) to the encoded result row, so repeated inputs skip
+ * parsing and featurization entirely. Keys are spread over kShards shards;
+ * a hit takes only a shared lock on its shard and marks the entry as
+ * referenced, so concurrent readers never serialise. Eviction approximates
+ * LRU with the CLOCK (second chance) policy: referenced entries are requeued
+ * once before they can be dropped. A capacity of 0 disables the cache, which
+ * is the default unless RDKTOOLS_RESULT_CACHE_BYTES is set.
+ */
+class ResultCache {
+public:
+    static constexpr std::size_t kShards = 32;
+
+    struct Stats {
+        std::uint64_t hits = 0;
+        std::uint64_t misses = 0;
+        std::uint64_t evictions = 0;
+        std::size_t entries = 0;
+        std::size_t bytes = 0;
+        std::size_t capacity = 0;
+    };
+
+    explicit ResultCache(std::size_t capacity_bytes);
+
+    ResultCache(const ResultCache&) = delete;
+    ResultCache& operator=(const ResultCache&) = delete;
+
+    bool enabled() const { return shard_capacity_.load(std::memory_order_relaxed) != 0; }
+
+    /**
+     * @brief Copy the cached value for key into out
+     * @return false on a miss, or when the cache is disabled
+     */
+    bool find(const std::string& key, std::string& out);
+
+    /**
+     * @brief Insert a value unless the key is present, evicting entries of
+     *        the same shard until it fits its share of the capacity
+     */
+    void insert(const std::string& key, std::string value);
+
+    /**
+     * @brief Change the capacity in bytes, trimming shards that are over it
+     */
+    void set_capacity(std::size_t capacity_bytes);
+
+    std::size_t capacity() const {
+        return shard_capacity_.load(std::memory_order_relaxed) * kShards;
+    }
+
+    Stats stats() const;
+    void reset_stats();
+    void clear();
+
+private:
+    struct Entry {
+        std::string value;
+        std::atomic<bool> referenced{false};
+    };
+
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, Entry> items;
+        std::deque<const std::string*> clock;  // node keys are stable
+        std::size_t bytes = 0;
+        std::atomic<std::uint64_t> hits{0};
+        std::atomic<std::uint64_t> misses{0};
+        std::atomic<std::uint64_t> evictions{0};
+    };
+
+    Shard& shard_for(const std::string& key);
+    static void evict(Shard& shard, std::size_t limit);
+
+    std::array<Shard, kShards> shards_;
+    std::atomic<std::size_t> shard_capacity_{0};
+};
+
+/**
+ * @brief The cache shared by every batch function and TF op in this module
+ */
+ResultCache& result_cache();
+
+/**
+ * @brief Cache key for the result of function tag (which encodes its
+ *        parameters) applied to smiles
+ */
+std::string result_cache_key(std::string_view tag, std::string_view smiles);
+
+} // namespace rdktools
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace rdktools {
+
+/**
+ * @brief Bounded, read-mostly concurrent key/value cache.
+ *
+ * Keys are spread over a fixed number of shards, each guarded by its own
+ * shared_mutex: lookups take a shared lock, so concurrent readers never
+ * serialise, and writers only contend within one shard. Every shard keeps
+ * at most capacity / kShards entries and evicts in insertion order (FIFO),
+ * which needs no bookkeeping on the read path. A capacity of 0 disables
+ * caching.
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedCache {
+public:
+    static constexpr std::size_t kShards = 16;
+
+    explicit ShardedCache(std::size_t capacity) { set_capacity(capacity); }
+
+    ShardedCache(const ShardedCache&) = delete;
+    ShardedCache& operator=(const ShardedCache&) = delete;
+
+    /**
+     * @brief Copy the cached value for key into out
+     * @return false on a miss
+     */
+    bool find(const Key& key, Value& out) const {
+        const Shard& shard = shard_for(key);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        const auto it = shard.items.find(key);
+        if (it == shard.items.end()) {
+            return false;
+        }
+        out = it->second;
+        return true;
+    }
+
+    /**
+     * @brief Insert a value unless the key is already present, evicting the
+     *        shard's oldest entries to stay within capacity
+     */
+    void insert(const Key& key, Value value) {
+        const std::size_t limit = shard_capacity_.load(std::memory_order_relaxed);
+        if (limit == 0) {
+            return;
+        }
+        Shard& shard = shard_for(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.items.emplace(key, std::move(value));
+        if (!inserted) {
+            return;
+        }
+        shard.order.push_back(&it->first);
+        evict(shard, limit);
+    }
+
+    /**
+     * @brief Change the total capacity, trimming shards that are over it
+     */
+    void set_capacity(std::size_t capacity) {
+        const std::size_t limit = capacity == 0 ? 0 : (capacity + kShards - 1) / kShards;
+        shard_capacity_.store(limit, std::memory_order_relaxed);
+        for (Shard& shard : shards_) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            evict(shard, limit);
+        }
+    }
+
+    std::size_t capacity() const {
+        return shard_capacity_.load(std::memory_order_relaxed) * kShards;
+    }
+
+    std::size_t size() const {
+        std::size_t total = 0;
+        for (const Shard& shard : shards_) {
+            std::shared_lock<std::shared_mutex> lock(shard.mutex);
+            total += shard.items.size();
+        }
+        return total;
+    }
+
+    void clear() {
+        for (Shard& shard : shards_) {
+            std::unique_lock<std::shared_mutex> lock(shard.mutex);
+            shard.order.clear();
+            shard.items.clear();
+        }
+    }
+
+private:
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Key, Value, Hash> items;
+        std::deque<const Key*> order;  // insertion order; node keys are stable
+    };
+
+    Shard& shard_for(const Key& key) {
+        return shards_[shard_index(key)];
+    }
+
+    const Shard& shard_for(const Key& key) const {
+        return shards_[shard_index(key)];
+    }
+
+    std::size_t shard_index(const Key& key) const {
+        // Mix the high bits in: std::hash is the identity for integers
+        const std::size_t h = Hash{}(key);
+        return (h ^ (h >> 17) ^ (h >> 31)) % kShards;
+    }
+
+    static void evict(Shard& shard, std::size_t limit) {
+        while (shard.items.size() > limit) {
+            const auto oldest = shard.items.find(*shard.order.front());
+            shard.order.pop_front();
+            shard.items.erase(oldest);
+        }
+    }
+
+    std::array<Shard, kShards> shards_;
+    std::atomic<std::size_t> shard_capacity_{0};
+};
+
+} // namespace rdktools
@@ -0,0 +1,412 @@
+#include "similarity.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RDKTOOLS_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define RDKTOOLS_NEON_KERNELS 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+using AndPopcountFn = std::uint64_t (*)(const std::uint8_t*,
+                                        const std::uint8_t*,
+                                        std::size_t);
+using BitSubsetFn = bool (*)(const std::uint8_t*,
+                             const std::uint8_t*,
+                             std::size_t);
+
+// Tile sizes chosen so a query tile stays in L1 and a library tile in L2.
+constexpr std::size_t kQueryTileBytes = 16 * 1024;
+constexpr std::size_t kLibraryTileBytes = 256 * 1024;
+constexpr std::size_t kTasksPerThread = 4;
+
+inline std::uint64_t load_word(const std::uint8_t* p) {
+    std::uint64_t word;
+    std::memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+// Remaining bytes after the vector loop: whole words, then single bytes.
+inline std::uint64_t and_popcount_tail(const std::uint8_t* a,
+                                       const std::uint8_t* b,
+                                       std::size_t num_bytes) {
+    std::uint64_t total = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= num_bytes; i += 8) {
+        total += static_cast<std::uint64_t>(
+            __builtin_popcountll(load_word(a + i) & load_word(b + i)));
+    }
+    for (; i < num_bytes; ++i) {
+        total += static_cast<std::uint64_t>(
+            __builtin_popcount(static_cast<unsigned int>(a[i] & b[i])));
+    }
+    return total;
+}
+
+std::uint64_t and_popcount_scalar(const std::uint8_t* a,
+                                  const std::uint8_t* b,
+                                  std::size_t num_bytes) {
+    return and_popcount_tail(a, b, num_bytes);
+}
+
+// sub & ~super over the remaining bytes, stopping at the first stray bit.
+inline bool bit_subset_tail(const std::uint8_t* sub,
+                            const std::uint8_t* super,
+                            std::size_t num_bytes) {
+    std::size_t i = 0;
+    for (; i + 8 <= num_bytes; i += 8) {
+        if (load_word(sub + i) & ~load_word(super + i)) {
+            return false;
+        }
+    }
+    for (; i < num_bytes; ++i) {
+        if (sub[i] & ~super[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#if defined(RDKTOOLS_X86_KERNELS)
+
+__attribute__((target("popcnt")))
+std::uint64_t and_popcount_popcnt(const std::uint8_t* a,
+                                  const std::uint8_t* b,
+                                  std::size_t num_bytes) {
+    return and_popcount_tail(a, b, num_bytes);
+}
+
+// Nibble lookup popcount (Mula et al.), summed per 64-bit lane with SAD.
+__attribute__((target("avx2")))
+std::uint64_t and_popcount_avx2(const std::uint8_t* a,
+                                const std::uint8_t* b,
+                                std::size_t num_bytes) {
+    const __m256i lookup = _mm256_setr_epi8(
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    std::size_t i = 0;
+    for (; i + 32 <= num_bytes; i += 32) {
+        const __m256i v = _mm256_and_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+        const __m256i lo = _mm256_and_si256(v, low_mask);
+        const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+        const __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                               _mm256_shuffle_epi8(lookup, hi));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(counts, zero));
+    }
+    alignas(32) std::uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] +
+           and_popcount_tail(a + i, b + i, num_bytes - i);
+}
+
+__attribute__((target("avx2")))
+bool bit_subset_avx2(const std::uint8_t* sub,
+                     const std::uint8_t* super,
+                     std::size_t num_bytes) {
+    std::size_t i = 0;
+    for (; i + 32 <= num_bytes; i += 32) {
+        // testc sets CF when ~super & sub is all zero
+        if (!_mm256_testc_si256(
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(super + i)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sub + i)))) {
+            return false;
+        }
+    }
+    return bit_subset_tail(sub + i, super + i, num_bytes - i);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+std::uint64_t and_popcount_avx512(const std::uint8_t* a,
+                                  const std::uint8_t* b,
+                                  std::size_t num_bytes) {
+    __m512i acc = _mm512_setzero_si512();
+    std::size_t i = 0;
+    for (; i + 64 <= num_bytes; i += 64) {
+        const __m512i v = _mm512_and_si512(_mm512_loadu_si512(a + i),
+                                           _mm512_loadu_si512(b + i));
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(v));
+    }
+    alignas(64) std::uint64_t lanes[8];
+    _mm512_store_si512(lanes, acc);
+    std::uint64_t total = and_popcount_tail(a + i, b + i, num_bytes - i);
+    for (const std::uint64_t lane : lanes) {
+        total += lane;
+    }
+    return total;
+}
+
+__attribute__((target("avx512f")))
+bool bit_subset_avx512(const std::uint8_t* sub,
+                       const std::uint8_t* super,
+                       std::size_t num_bytes) {
+    const __m512i ones = _mm512_set1_epi64(-1);
+    std::size_t i = 0;
+    for (; i + 64 <= num_bytes; i += 64) {
+        const __m512i missing = _mm512_xor_si512(_mm512_loadu_si512(super + i), ones);
+        if (_mm512_test_epi64_mask(_mm512_loadu_si512(sub + i), missing) != 0) {
+            return false;
+        }
+    }
+    return bit_subset_tail(sub + i, super + i, num_bytes - i);
+}
+
+#endif // RDKTOOLS_X86_KERNELS
+
+#if defined(RDKTOOLS_NEON_KERNELS)
+
+std::uint64_t and_popcount_neon(const std::uint8_t* a,
+                                const std::uint8_t* b,
+                                std::size_t num_bytes) {
+    uint64x2_t acc = vdupq_n_u64(0);
+    std::size_t i = 0;
+    for (; i + 16 <= num_bytes; i += 16) {
+        const uint8x16_t v = vandq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        acc = vpadalq_u32(acc, vpaddlq_u16(vpaddlq_u8(vcntq_u8(v))));
+    }
+    return vaddvq_u64(acc) + and_popcount_tail(a + i, b + i, num_bytes - i);
+}
+
+bool bit_subset_neon(const std::uint8_t* sub,
+                     const std::uint8_t* super,
+                     std::size_t num_bytes) {
+    std::size_t i = 0;
+    for (; i + 16 <= num_bytes; i += 16) {
+        if (vmaxvq_u8(vbicq_u8(vld1q_u8(sub + i), vld1q_u8(super + i))) != 0) {
+            return false;
+        }
+    }
+    return bit_subset_tail(sub + i, super + i, num_bytes - i);
+}
+
+#endif // RDKTOOLS_NEON_KERNELS
+
+struct PopcountKernel {
+    const char* name;
+    AndPopcountFn fn;
+    BitSubsetFn subset;
+};
+
+PopcountKernel select_kernel() {
+#if defined(RDKTOOLS_X86_KERNELS)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") &&
+        __builtin_cpu_supports("avx512vpopcntdq")) {
+        return {"avx512vpopcntdq", and_popcount_avx512, bit_subset_avx512};
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return {"avx2", and_popcount_avx2, bit_subset_avx2};
+    }
+    if (__builtin_cpu_supports("popcnt")) {
+        return {"popcnt", and_popcount_popcnt, bit_subset_tail};
+    }
+#elif defined(RDKTOOLS_NEON_KERNELS)
+    return {"neon", and_popcount_neon, bit_subset_neon};
+#endif
+    return {"scalar", and_popcount_scalar, bit_subset_tail};
+}
+
+const PopcountKernel& kernel() {
+    static const PopcountKernel selected = select_kernel();
+    return selected;
+}
+
+std::size_t tile_rows(std::size_t tile_bytes, std::size_t row_bytes) {
+    return std::max<std::size_t>(1, tile_bytes / std::max<std::size_t>(1, row_bytes));
+}
+
+std::size_t ceil_div(std::size_t value, std::size_t divisor) {
+    return (value + divisor - 1) / divisor;
+}
+
+struct Hit {
+    float score;
+    std::int64_t index;
+};
+
+// Strict "ranks ahead of" order: higher score first, then lower index. Used
+// as the heap comparator, it keeps the weakest retained hit at the front.
+inline bool ranks_ahead(const Hit& lhs, const Hit& rhs) {
+    return lhs.score > rhs.score ||
+           (lhs.score == rhs.score && lhs.index < rhs.index);
+}
+
+} // namespace
+
+namespace rdktools {
+
+const char* popcount_kernel_name() {
+    return kernel().name;
+}
+
+std::uint64_t and_popcount(const std::uint8_t* a,
+                           const std::uint8_t* b,
+                           std::size_t num_bytes) {
+    return kernel().fn(a, b, num_bytes);
+}
+
+bool is_bit_subset(const std::uint8_t* sub,
+                   const std::uint8_t* super,
+                   std::size_t num_bytes) {
+    return kernel().subset(sub, super, num_bytes);
+}
+
+std::vector<std::uint32_t> row_popcounts(const FingerprintView& fps,
+                                         int num_threads) {
+    std::vector<std::uint32_t> counts(fps.rows);
+    const AndPopcountFn fn = kernel().fn;
+    parallel_for(fps.rows, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            const std::uint8_t* row = fps.row(i);
+            counts[i] = static_cast<std::uint32_t>(fn(row, row, fps.row_bytes));
+        }
+    });
+    return counts;
+}
+
+void tanimoto_matrix(const FingerprintView& a,
+                     const FingerprintView& b,
+                     const std::uint32_t* b_popcounts,
+                     float* out,
+                     int num_threads) {
+    if (a.rows == 0 || b.rows == 0) {
+        return;
+    }
+    const std::vector<std::uint32_t> count_a = row_popcounts(a, num_threads);
+    std::vector<std::uint32_t> computed_b;
+    if (!b_popcounts) {
+        if (a.data == b.data && a.rows == b.rows) {
+            b_popcounts = count_a.data();
+        } else {
+            computed_b = row_popcounts(b, num_threads);
+            b_popcounts = computed_b.data();
+        }
+    }
+
+    const std::size_t a_tile = tile_rows(kQueryTileBytes, a.row_bytes);
+    const std::size_t b_tile = tile_rows(kLibraryTileBytes, b.row_bytes);
+    const std::size_t a_tiles = ceil_div(a.rows, a_tile);
+    const std::size_t b_tiles = ceil_div(b.rows, b_tile);
+    const AndPopcountFn fn = kernel().fn;
+
+    parallel_for(a_tiles * b_tiles, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t tile = begin; tile < end; ++tile) {
+            const std::size_t i0 = (tile / b_tiles) * a_tile;
+            const std::size_t j0 = (tile % b_tiles) * b_tile;
+            const std::size_t i1 = std::min(a.rows, i0 + a_tile);
+            const std::size_t j1 = std::min(b.rows, j0 + b_tile);
+            for (std::size_t i = i0; i < i1; ++i) {
+                const std::uint8_t* row_a = a.row(i);
+                float* out_row = out + i * b.rows;
+                for (std::size_t j = j0; j < j1; ++j) {
+                    const std::uint64_t common = fn(row_a, b.row(j), a.row_bytes);
+                    out_row[j] = tanimoto_from_counts(common, count_a[i], b_popcounts[j]);
+                }
+            }
+        }
+    });
+}
+
+void tanimoto_topk(const FingerprintView& queries,
+                   const FingerprintView& library,
+                   const std::uint32_t* library_popcounts,
+                   std::size_t k,
+                   float threshold,
+                   int num_threads,
+                   std::int64_t* indices,
+                   float* scores) {
+    const std::size_t m = queries.rows;
+    std::fill_n(indices, m * k, std::int64_t{-1});
+    std::fill_n(scores, m * k, 0.0f);
+    if (m == 0 || k == 0 || library.rows == 0) {
+        return;
+    }
+
+    const std::vector<std::uint32_t> count_q = row_popcounts(queries, num_threads);
+    std::vector<std::uint32_t> computed_counts;
+    if (!library_popcounts) {
+        computed_counts = row_popcounts(library, num_threads);
+        library_popcounts = computed_counts.data();
+    }
+
+    const std::size_t q_tile = tile_rows(kQueryTileBytes, queries.row_bytes);
+    const std::size_t l_tile = tile_rows(kLibraryTileBytes, library.row_bytes);
+    const std::size_t q_tiles = ceil_div(m, q_tile);
+    const std::size_t l_tiles = ceil_div(library.rows, l_tile);
+
+    // Split the library into stripes so a handful of queries still spreads
+    // over every thread; each (stripe, query) pair keeps its own heap.
+    const std::size_t target_tasks =
+        static_cast<std::size_t>(resolve_num_threads(num_threads)) * kTasksPerThread;
+    const std::size_t stripes =
+        std::min(l_tiles, std::max<std::size_t>(1, ceil_div(target_tasks, q_tiles)));
+    const std::size_t tiles_per_stripe = ceil_div(l_tiles, stripes);
+    std::vector<std::vector<Hit>> heaps(stripes * m);
+    const AndPopcountFn fn = kernel().fn;
+
+    parallel_for(q_tiles * stripes, num_threads, [&](std::size_t begin, std::size_t end) {
+        for (std::size_t task = begin; task < end; ++task) {
+            const std::size_t stripe = task % stripes;
+            const std::size_t i0 = (task / stripes) * q_tile;
+            const std::size_t i1 = std::min(m, i0 + q_tile);
+            const std::size_t t1 = std::min(l_tiles, (stripe + 1) * tiles_per_stripe);
+            for (std::size_t t = stripe * tiles_per_stripe; t < t1; ++t) {
+                const std::size_t j0 = t * l_tile;
+                const std::size_t j1 = std::min(library.rows, j0 + l_tile);
+                for (std::size_t i = i0; i < i1; ++i) {
+                    const std::uint8_t* query = queries.row(i);
+                    std::vector<Hit>& heap = heaps[stripe * m + i];
+                    for (std::size_t j = j0; j < j1; ++j) {
+                        const std::uint64_t common = fn(query, library.row(j), queries.row_bytes);
+                        const Hit hit{
+                            tanimoto_from_counts(common, count_q[i], library_popcounts[j]),
+                            static_cast<std::int64_t>(j)};
+                        if (hit.score < threshold) {
+                            continue;
+                        }
+                        if (heap.size() < k) {
+                            heap.push_back(hit);
+                            std::push_heap(heap.begin(), heap.end(), ranks_ahead);
+                        } else if (ranks_ahead(hit, heap.front())) {
+                            std::pop_heap(heap.begin(), heap.end(), ranks_ahead);
+                            heap.back() = hit;
+                            std::push_heap(heap.begin(), heap.end(), ranks_ahead);
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    parallel_for(m, num_threads, [&](std::size_t begin, std::size_t end) {
+        std::vector<Hit> merged;
+        for (std::size_t i = begin; i < end; ++i) {
+            merged.clear();
+            for (std::size_t stripe = 0; stripe < stripes; ++stripe) {
+                const auto& heap = heaps[stripe * m + i];
+                merged.insert(merged.end(), heap.begin(), heap.end());
+            }
+            const std::size_t count = std::min(k, merged.size());
+            std::partial_sort(merged.begin(), merged.begin() + count, merged.end(),
+                              ranks_ahead);
+            for (std::size_t r = 0; r < count; ++r) {
+                indices[i * k + r] = merged[r].index;
+                scores[i * k + r] = merged[r].score;
+            }
+        }
+    });
+}
+
+} // namespace rdktools
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief Read-only view of a row-major matrix of packed fingerprints
+ *
+ * Rows are raw bytes, so both the np.packbits byte layout and the uint64 word
+ * layout of calculate_morgan_fingerprints() can be viewed without copying.
+ * Similarities are only meaningful between fingerprints of the same layout.
+ */
+struct FingerprintView {
+    const std::uint8_t* data = nullptr;
+    std::size_t rows = 0;
+    std::size_t row_bytes = 0;
+
+    const std::uint8_t* row(std::size_t index) const {
+        return data + index * row_bytes;
+    }
+};
+
+/**
+ * @brief Name of the popcount kernel selected for this CPU
+ * @return "avx512vpopcntdq", "avx2", "neon", "popcnt" or "scalar"
+ */
+const char* popcount_kernel_name();
+
+/**
+ * @brief Number of bits set in a & b over num_bytes bytes
+ */
+std::uint64_t and_popcount(const std::uint8_t* a,
+                           const std::uint8_t* b,
+                           std::size_t num_bytes);
+
+/**
+ * @brief True if every bit set in sub is also set in super
+ *
+ * The substructure prescreen: a query's pattern fingerprint must be a subset
+ * of the molecule's for SubstructMatch to have a chance.
+ */
+bool is_bit_subset(const std::uint8_t* sub,
+                   const std::uint8_t* super,
+                   std::size_t num_bytes);
+
+/**
+ * @brief Number of bits set in every row of a fingerprint matrix
+ */
+std::vector<std::uint32_t> row_popcounts(const FingerprintView& fps,
+                                         int num_threads = 0);
+
+/**
+ * @brief Tanimoto similarity from bit counts; two empty fingerprints score 0
+ */
+inline float tanimoto_from_counts(std::uint64_t common,
+                                  std::uint64_t count_a,
+                                  std::uint64_t count_b) {
+    const std::uint64_t denominator = count_a + count_b - common;
+    return denominator == 0
+               ? 0.0f
+               : static_cast<float>(static_cast<double>(common) /
+                                    static_cast<double>(denominator));
+}
+
+/**
+ * @brief All-pairs Tanimoto similarity between two fingerprint matrices
+ * @param a query fingerprints (m rows)
+ * @param b library fingerprints (n rows, same row_bytes as a)
+ * @param b_popcounts bit counts of the rows of b, or nullptr to compute them
+ * @param out destination for the row-major m x n similarity matrix
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ */
+void tanimoto_matrix(const FingerprintView& a,
+                     const FingerprintView& b,
+                     const std::uint32_t* b_popcounts,
+                     float* out,
+                     int num_threads = 0);
+
+/**
+ * @brief k most similar library rows for every query
+ * @param queries query fingerprints (m rows)
+ * @param library library fingerprints (n rows, same row_bytes as queries)
+ * @param library_popcounts bit counts of the library rows, or nullptr to
+ *        compute them on the fly
+ * @param k number of hits per query
+ * @param threshold minimum similarity for a hit
+ * @param num_threads worker threads to use (<= 0 selects the module default)
+ * @param indices destination for m x k library row indices
+ * @param scores destination for m x k similarities
+ *
+ * Hits are ordered by descending similarity, ties by ascending index. Queries
+ * with fewer than k hits are padded with index -1 and score 0.
+ */
+void tanimoto_topk(const FingerprintView& queries,
+                   const FingerprintView& library,
+                   const std::uint32_t* library_popcounts,
+                   std::size_t k,
+                   float threshold,
+                   int num_threads,
+                   std::int64_t* indices,
+                   float* scores);
+
+} // namespace rdktools
@@ -0,0 +1,160 @@
+#include "smiles_column.hpp"
+
+#include <cstring>
+#include <deque>
+#include <unordered_map>
+
+namespace {
+
+void append_utf8(std::string& out, std::uint32_t code_point) {
+    if (code_point < 0x80) {
+        out.push_back(static_cast<char>(code_point));
+    } else if (code_point < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else if (code_point < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+    }
+}
+
+} // namespace
+
+namespace rdktools {
+
+SmilesColumn::SmilesColumn(const std::vector<std::string>& strings)
+    : kind_(Kind::Strings), size_(strings.size()), strings_(&strings) {}
+
+SmilesColumn SmilesColumn::owning(std::vector<std::string> strings) {
+    auto owned = std::make_shared<const std::vector<std::string>>(std::move(strings));
+    SmilesColumn column(*owned);
+    column.keepalive_ = std::move(owned);
+    return column;
+}
+
+SmilesColumn SmilesColumn::fixed_width(const char* data,
+                                       std::size_t size,
+                                       std::size_t itemsize,
+                                       std::ptrdiff_t stride,
+                                       bool ucs4,
+                                       std::shared_ptr<const void> keepalive) {
+    SmilesColumn column;
+    column.kind_ = ucs4 ? Kind::Ucs4 : Kind::Bytes;
+    column.size_ = size;
+    column.data_ = data;
+    column.itemsize_ = itemsize;
+    column.stride_ = stride;
+    column.keepalive_ = std::move(keepalive);
+    return column;
+}
+
+SmilesColumn SmilesColumn::arrow(const std::uint8_t* validity,
+                                 const void* offsets,
+                                 bool large_offsets,
+                                 const char* data,
+                                 std::size_t size,
+                                 std::int64_t offset,
+                                 std::shared_ptr<const void> keepalive) {
+    SmilesColumn column;
+    column.kind_ = large_offsets ? Kind::Arrow64 : Kind::Arrow32;
+    column.size_ = size;
+    column.validity_ = validity;
+    column.offsets_ = offsets;
+    column.data_ = data;
+    column.offset_ = offset;
+    column.keepalive_ = std::move(keepalive);
+    return column;
+}
+
+bool SmilesColumn::is_null(std::size_t index) const {
+    if (!validity_) {
+        return false;
+    }
+    const auto bit = static_cast<std::uint64_t>(offset_) + index;
+    return (validity_[bit / 8] & (1U << (bit % 8))) == 0;
+}
+
+std::string_view SmilesColumn::view(std::size_t index, std::string& scratch) const {
+    switch (kind_) {
+    case Kind::Strings:
+        return (*strings_)[index];
+    case Kind::Bytes: {
+        const char* item = data_ + static_cast<std::ptrdiff_t>(index) * stride_;
+        // numpy pads fixed-width strings with trailing NULs
+        std::size_t length = itemsize_;
+        while (length > 0 && item[length - 1] == '\0') {
+            --length;
+        }
+        return std::string_view(item, length);
+    }
+    case Kind::Ucs4: {
+        const char* item = data_ + static_cast<std::ptrdiff_t>(index) * stride_;
+        const std::size_t units = itemsize_ / sizeof(std::uint32_t);
+        scratch.clear();
+        for (std::size_t unit = 0; unit < units; ++unit) {
+            std::uint32_t code_point;
+            std::memcpy(&code_point, item + unit * sizeof(code_point), sizeof(code_point));
+            if (code_point == 0) {
+                break;
+            }
+            append_utf8(scratch, code_point);
+        }
+        return scratch;
+    }
+    case Kind::Arrow32: {
+        const auto* offsets = static_cast<const std::int32_t*>(offsets_) + offset_;
+        return std::string_view(data_ + offsets[index],
+                                static_cast<std::size_t>(offsets[index + 1] - offsets[index]));
+    }
+    case Kind::Arrow64:
+    default: {
+        const auto* offsets = static_cast<const std::int64_t*>(offsets_) + offset_;
+        return std::string_view(data_ + offsets[index],
+                                static_cast<std::size_t>(offsets[index + 1] - offsets[index]));
+    }
+    }
+}
+
+const std::string& SmilesColumn::str(std::size_t index, std::string& scratch) const {
+    if (kind_ == Kind::Strings) {
+        return (*strings_)[index];
+    }
+    const std::string_view value = view(index, scratch);
+    if (value.data() != scratch.data()) {
+        scratch.assign(value.data(), value.size());
+    }
+    return scratch;
+}
+
+std::vector<std::size_t> first_occurrences(const SmilesColumn& column) {
+    const std::size_t size = column.size();
+    std::vector<std::size_t> first(size);
+    std::unordered_map<std::string_view, std::size_t> seen;
+    seen.reserve(size);
+    // Transcoded UCS-4 elements only live in scratch, so keys are kept here
+    std::deque<std::string> owned;
+    std::string scratch;
+    for (std::size_t i = 0; i < size; ++i) {
+        first[i] = i;
+        if (column.is_null(i)) {
+            continue;
+        }
+        std::string_view value = column.view(i, scratch);
+        if (value.data() == scratch.data()) {
+            value = owned.emplace_back(value);
+        }
+        const auto [it, inserted] = seen.emplace(value, i);
+        if (!inserted) {
+            first[i] = it->second;
+        }
+    }
+    return first;
+}
+
+} // namespace rdktools
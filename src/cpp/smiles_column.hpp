@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief Read-only column of SMILES strings viewed in place.
+ *
+ * A column borrows its storage from one of:
+ * - a std::vector<std::string> (owned or borrowed),
+ * - a fixed-width byte (numpy "S") or UCS-4 (numpy "U") buffer,
+ * - an Arrow utf8 / large_utf8 array (int32 or int64 offsets).
+ *
+ * Elements are read without a per-element allocation: byte and Arrow storage
+ * is returned as string_view and UCS-4 is transcoded into a caller-provided
+ * scratch string. Whatever owns the underlying buffer is held through an
+ * opaque keepalive handle, so a column can be moved freely and outlive the
+ * binding layer call that created it.
+ */
+class SmilesColumn {
+public:
+    SmilesColumn() = default;
+
+    /**
+     * @brief View an existing vector of strings (not owned; must outlive the column)
+     */
+    SmilesColumn(const std::vector<std::string>& strings);  // NOLINT: implicit by design
+
+    /**
+     * @brief Take ownership of a vector of strings
+     */
+    static SmilesColumn owning(std::vector<std::string> strings);
+
+    /**
+     * @brief View a fixed-width character buffer
+     * @param data address of element 0
+     * @param size number of elements
+     * @param itemsize bytes per element
+     * @param stride bytes between consecutive elements
+     * @param ucs4 true for 4-byte code units (numpy "U"), false for bytes ("S")
+     * @param keepalive owner of the buffer
+     */
+    static SmilesColumn fixed_width(const char* data,
+                                    std::size_t size,
+                                    std::size_t itemsize,
+                                    std::ptrdiff_t stride,
+                                    bool ucs4,
+                                    std::shared_ptr<const void> keepalive);
+
+    /**
+     * @brief View an Arrow variable-length string array
+     * @param validity validity bitmap, or nullptr when no element is null
+     * @param offsets offsets buffer (int32 or int64 entries)
+     * @param large_offsets true for int64 offsets (large_utf8)
+     * @param data character data buffer
+     * @param size number of elements
+     * @param offset Arrow array offset applied to validity and offsets
+     * @param keepalive owner of the buffers
+     */
+    static SmilesColumn arrow(const std::uint8_t* validity,
+                              const void* offsets,
+                              bool large_offsets,
+                              const char* data,
+                              std::size_t size,
+                              std::int64_t offset,
+                              std::shared_ptr<const void> keepalive);
+
+    std::size_t size() const { return size_; }
+
+    /**
+     * @brief True for Arrow null entries; callers treat them as invalid input
+     */
+    bool is_null(std::size_t index) const;
+
+    /**
+     * @brief Element as a view into the source buffer (or into scratch)
+     */
+    std::string_view view(std::size_t index, std::string& scratch) const;
+
+    /**
+     * @brief Element as a std::string, for APIs that need one
+     *
+     * Vector-backed columns return the stored string itself; every other
+     * layout is copied into scratch, which reuses its capacity across calls.
+     */
+    const std::string& str(std::size_t index, std::string& scratch) const;
+
+private:
+    enum class Kind {
+        Strings,
+        Bytes,
+        Ucs4,
+        Arrow32,
+        Arrow64,
+    };
+
+    Kind kind_ = Kind::Strings;
+    std::size_t size_ = 0;
+    const std::vector<std::string>* strings_ = nullptr;
+    const char* data_ = nullptr;
+    std::size_t itemsize_ = 0;
+    std::ptrdiff_t stride_ = 0;
+    const std::uint8_t* validity_ = nullptr;
+    const void* offsets_ = nullptr;
+    std::int64_t offset_ = 0;
+    std::shared_ptr<const void> keepalive_;
+};
+
+/**
+ * @brief Row of the first occurrence of each element, found by hashing.
+ *
+ * Rows with result[i] == i hold the distinct strings; every other row
+ * repeats row result[i] byte for byte. Null entries are never merged.
+ */
+std::vector<std::size_t> first_occurrences(const SmilesColumn& column);
+
+} // namespace rdktools
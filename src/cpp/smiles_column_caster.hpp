@@ -0,0 +1,204 @@
+#pragma once
+
+#include "smiles_column.hpp"
+#include <nanobind/nanobind.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/vector.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rdktools {
+
+// Arrow C data interface structs, copied verbatim from the (ABI-stable) spec.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+namespace detail {
+
+// Python owners of borrowed buffers. The GIL is re-acquired on release
+// because columns may be dropped from worker threads.
+inline std::shared_ptr<const void> python_keepalive(nanobind::object owner) {
+    PyObject* ptr = owner.release().ptr();
+    return std::shared_ptr<const void>(ptr, [](const void* p) {
+        nanobind::gil_scoped_acquire gil;
+        Py_DECREF(static_cast<PyObject*>(const_cast<void*>(p)));
+    });
+}
+
+struct PyBufferHolder {
+    Py_buffer view{};
+    bool acquired = false;
+
+    ~PyBufferHolder() {
+        if (acquired) {
+            nanobind::gil_scoped_acquire gil;
+            PyBuffer_Release(&view);
+        }
+    }
+};
+
+// Parse a numpy buffer format of the form [byte order][count]('s'|'w').
+inline bool parse_fixed_width_format(const char* format, bool& ucs4) {
+    if (!format) {
+        return false;
+    }
+    if (*format == '@' || *format == '=' || *format == '<' || *format == '>' ||
+        *format == '!') {
+        const bool little = *format != '>' && *format != '!';
+        // UCS-4 data is only usable in native (little-endian) order
+        if (!little && std::strchr(format, 'w') != nullptr) {
+            return false;
+        }
+        ++format;
+    }
+    while (*format >= '0' && *format <= '9') {
+        ++format;
+    }
+    if (format[0] == 's' && format[1] == '\0') {
+        ucs4 = false;
+        return true;
+    }
+    if (format[0] == 'w' && format[1] == '\0') {
+        ucs4 = true;
+        return true;
+    }
+    return false;
+}
+
+inline bool load_fixed_width(nanobind::handle src, SmilesColumn& out) {
+    if (!PyObject_CheckBuffer(src.ptr())) {
+        return false;
+    }
+    auto holder = std::make_shared<PyBufferHolder>();
+    if (PyObject_GetBuffer(src.ptr(), &holder->view, PyBUF_FORMAT | PyBUF_STRIDES) != 0) {
+        PyErr_Clear();
+        return false;
+    }
+    holder->acquired = true;
+    const Py_buffer& view = holder->view;
+    bool ucs4 = false;
+    if (view.ndim != 1 || !parse_fixed_width_format(view.format, ucs4) ||
+        (ucs4 && view.itemsize % 4 != 0)) {
+        return false;
+    }
+    out = SmilesColumn::fixed_width(static_cast<const char*>(view.buf),
+                                    static_cast<std::size_t>(view.shape[0]),
+                                    static_cast<std::size_t>(view.itemsize),
+                                    static_cast<std::ptrdiff_t>(view.strides[0]), ucs4,
+                                    std::move(holder));
+    return true;
+}
+
+inline bool load_arrow(nanobind::handle src, SmilesColumn& out) {
+    if (!PyObject_HasAttrString(src.ptr(), "__arrow_c_array__")) {
+        return false;
+    }
+    try {
+        nanobind::object exported = src.attr("__arrow_c_array__")();
+        nanobind::tuple capsules = nanobind::cast<nanobind::tuple>(exported);
+        if (capsules.size() != 2) {
+            return false;
+        }
+        auto* schema = static_cast<ArrowSchema*>(
+            PyCapsule_GetPointer(capsules[0].ptr(), "arrow_schema"));
+        auto* array = static_cast<ArrowArray*>(
+            PyCapsule_GetPointer(capsules[1].ptr(), "arrow_array"));
+        if (!schema || !array) {
+            PyErr_Clear();
+            return false;
+        }
+        const std::string format = schema->format ? schema->format : "";
+        const bool large = format == "U" || format == "Z";
+        if (!(large || format == "u" || format == "z") || schema->dictionary ||
+            !array->release || array->n_buffers != 3 || array->length < 0) {
+            return false;
+        }
+        const auto* validity = array->null_count != 0
+                                   ? static_cast<const std::uint8_t*>(array->buffers[0])
+                                   : nullptr;
+        const char* data = static_cast<const char*>(array->buffers[2]);
+        static const char empty_data = '\0';
+        out = SmilesColumn::arrow(validity, array->buffers[1], large,
+                                  data ? data : &empty_data,
+                                  static_cast<std::size_t>(array->length), array->offset,
+                                  python_keepalive(std::move(capsules)));
+        return true;
+    } catch (const nanobind::python_error&) {
+        return false;
+    } catch (const nanobind::cast_error&) {
+        return false;
+    }
+}
+
+} // namespace detail
+} // namespace rdktools
+
+NAMESPACE_BEGIN(NB_NAMESPACE)
+NAMESPACE_BEGIN(detail)
+
+/**
+ * Accepts numpy fixed-width "U"/"S" arrays and Arrow utf8/large_utf8 arrays
+ * (via __arrow_c_array__) without copying, and any other sequence of str by
+ * converting it to an owned std::vector<std::string>.
+ */
+template <> struct type_caster<rdktools::SmilesColumn> {
+    NB_TYPE_CASTER(rdktools::SmilesColumn, const_name("collections.abc.Sequence[str]"))
+
+    bool from_python(handle src, uint8_t flags, cleanup_list* cleanup) noexcept {
+        // Casters must not throw: a failed column build (bad_alloc, invalid
+        // offsets, ...) rejects the argument instead of terminating
+        try {
+            if (rdktools::detail::load_arrow(src, value) ||
+                rdktools::detail::load_fixed_width(src, value)) {
+                return true;
+            }
+            make_caster<std::vector<std::string>> strings;
+            if (!strings.from_python(src, flags, cleanup)) {
+                return false;
+            }
+            value = rdktools::SmilesColumn::owning(std::move(strings.value));
+            return true;
+        } catch (...) {
+            PyErr_Clear();
+            return false;
+        }
+    }
+};
+
+NAMESPACE_END(detail)
+NAMESPACE_END(NB_NAMESPACE)
@@ -0,0 +1,385 @@
+#include "smiles_reader.hpp"
+#include "ecfp_trace.hpp"
+#include "mol_batch.hpp"
+#include "thread_pool.hpp"
+#include <GraphMol/Descriptors/MolDescriptors.h>
+#include <zlib.h>
+#include <algorithm>
+#include <climits>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <utility>
+
+namespace rdktools {
+
+namespace {
+
+constexpr unsigned kGzipBufferBytes = 1U << 17;
+
+// Split a record into fields. '\0' splits on runs of blanks (.smi);
+// any other delimiter splits CSV-style, honouring double-quoted fields,
+// which may span lines (see find_record_end()).
+void split_fields(std::string_view line, char delimiter, std::vector<std::string>& fields) {
+    fields.clear();
+    if (delimiter == '\0') {
+        std::size_t pos = 0;
+        while (pos < line.size()) {
+            while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) {
+                ++pos;
+            }
+            if (pos == line.size()) {
+                break;
+            }
+            const std::size_t start = pos;
+            while (pos < line.size() && line[pos] != ' ' && line[pos] != '\t') {
+                ++pos;
+            }
+            fields.emplace_back(line.substr(start, pos - start));
+        }
+        return;
+    }
+
+    std::string field;
+    std::size_t pos = 0;
+    while (true) {
+        field.clear();
+        if (pos < line.size() && line[pos] == '"') {
+            ++pos;
+            while (pos < line.size()) {
+                if (line[pos] == '"') {
+                    if (pos + 1 < line.size() && line[pos + 1] == '"') {
+                        field.push_back('"');
+                        pos += 2;
+                        continue;
+                    }
+                    ++pos;
+                    break;
+                }
+                field.push_back(line[pos++]);
+            }
+        }
+        while (pos < line.size() && line[pos] != delimiter) {
+            field.push_back(line[pos++]);
+        }
+        fields.push_back(field);
+        if (pos >= line.size()) {
+            break;
+        }
+        ++pos;  // skip the delimiter
+    }
+}
+
+// Offset of the newline that ends the current record in text, or npos.
+// CSV records run on past newlines inside double quotes; quoted carries the
+// quote state into the next call when a record spans chunks.
+std::size_t find_record_end(std::string_view text, char delimiter, bool& quoted) {
+    if (delimiter == '\0') {
+        return text.find('\n');
+    }
+    for (std::size_t pos = text.find_first_of("\"\n"); pos != std::string_view::npos;
+         pos = text.find_first_of("\"\n", pos + 1)) {
+        if (text[pos] == '"') {
+            quoted = !quoted;
+        } else if (!quoted) {
+            return pos;
+        }
+    }
+    return std::string_view::npos;
+}
+
+int find_column(const std::vector<std::string>& header, const std::string& name) {
+    const auto it = std::find(header.begin(), header.end(), name);
+    if (it == header.end()) {
+        throw std::invalid_argument("column '" + name + "' not found in header");
+    }
+    return static_cast<int>(it - header.begin());
+}
+
+} // namespace
+
+SmilesFileReader::SmilesFileReader(SmilesReaderOptions options)
+    : options_(std::move(options)),
+      chunks_(options_.queue_depth),
+      records_(options_.queue_depth),
+      results_(options_.queue_depth) {
+    if (options_.batch_size == 0) {
+        throw std::invalid_argument("batch_size must be positive");
+    }
+    if (options_.chunk_bytes == 0 || options_.chunk_bytes > static_cast<std::size_t>(INT_MAX)) {
+        throw std::invalid_argument("chunk_bytes must be between 1 and INT_MAX");
+    }
+    if ((options_.fingerprints || options_.traces) && options_.nbits <= 0) {
+        throw std::invalid_argument("nbits must be positive");
+    }
+    if (options_.smiles_column < 0 && options_.smiles_column_name.empty()) {
+        throw std::invalid_argument("smiles_column must be non-negative");
+    }
+    if ((!options_.smiles_column_name.empty() || !options_.id_column_name.empty()) &&
+        !options_.header) {
+        throw std::invalid_argument("column names require a header row");
+    }
+
+    gzFile file = gzopen(options_.path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("cannot open SMILES file '" + options_.path + "'");
+    }
+    gzbuffer(file, kGzipBufferBytes);
+    file_ = file;
+
+    reader_ = std::thread([this] { read_stage(); });
+    splitter_ = std::thread([this] { split_stage(); });
+    featurizer_ = std::thread([this] { featurize_stage(); });
+}
+
+SmilesFileReader::~SmilesFileReader() {
+    close();
+}
+
+void SmilesFileReader::close() {
+    if (closed_.exchange(true)) {
+        return;
+    }
+    chunks_.cancel();
+    records_.cancel();
+    results_.cancel();
+    for (std::thread* stage : {&reader_, &splitter_, &featurizer_}) {
+        if (stage->joinable()) {
+            stage->join();
+        }
+    }
+    if (file_) {
+        gzclose(static_cast<gzFile>(file_));
+        file_ = nullptr;
+    }
+}
+
+bool SmilesFileReader::next(SmilesFeatureBatch& batch) {
+    if (results_.pop(batch)) {
+        rows_read_ = batch.first_row + batch.smiles.size();
+        return true;
+    }
+    std::lock_guard<std::mutex> guard(error_mutex_);
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    return false;
+}
+
+void SmilesFileReader::fail(std::exception_ptr error) {
+    {
+        std::lock_guard<std::mutex> guard(error_mutex_);
+        if (!error_) {
+            error_ = std::move(error);
+        }
+    }
+    chunks_.cancel();
+    records_.cancel();
+    results_.cancel();
+}
+
+void SmilesFileReader::read_stage() {
+    try {
+        gzFile file = static_cast<gzFile>(file_);
+        while (true) {
+            std::string chunk(options_.chunk_bytes, '\0');
+            const int count = gzread(file, chunk.data(), static_cast<unsigned>(chunk.size()));
+            if (count < 0) {
+                int code = 0;
+                const char* message = gzerror(file, &code);
+                throw std::runtime_error("error reading SMILES file '" + options_.path +
+                                         "': " + (message ? message : "unknown error"));
+            }
+            if (count == 0) {
+                break;
+            }
+            chunk.resize(static_cast<std::size_t>(count));
+            if (!chunks_.push(std::move(chunk))) {
+                return;
+            }
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+    chunks_.close();
+}
+
+void SmilesFileReader::split_stage() {
+    try {
+        const char delimiter = options_.delimiter;
+        bool need_header = options_.header;
+        int smiles_column = options_.smiles_column;
+        int id_column = options_.id_column;
+        std::size_t next_row = 0;
+        std::vector<std::string> fields;
+
+        RecordBatch batch;
+        auto flush = [&] {
+            if (batch.smiles.empty()) {
+                return true;
+            }
+            RecordBatch full = std::move(batch);
+            batch = RecordBatch{};
+            batch.first_row = next_row;
+            return records_.push(std::move(full));
+        };
+
+        auto handle_line = [&](std::string_view line) {
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            const std::size_t first = line.find_first_not_of(" \t");
+            if (first == std::string_view::npos || line[first] == '#') {
+                return true;
+            }
+            split_fields(line, delimiter, fields);
+            if (need_header) {
+                need_header = false;
+                if (!options_.smiles_column_name.empty()) {
+                    smiles_column = find_column(fields, options_.smiles_column_name);
+                }
+                if (!options_.id_column_name.empty()) {
+                    id_column = find_column(fields, options_.id_column_name);
+                }
+                return true;
+            }
+            const auto column = static_cast<std::size_t>(smiles_column);
+            // Short rows keep their slot (as an empty, invalid SMILES) so row
+            // numbers stay aligned with the file
+            batch.smiles.push_back(column < fields.size() ? std::move(fields[column])
+                                                          : std::string());
+            if (id_column >= 0) {
+                const auto id = static_cast<std::size_t>(id_column);
+                batch.ids.push_back(id < fields.size() ? std::move(fields[id]) : std::string());
+            }
+            ++next_row;
+            if (batch.smiles.size() == options_.batch_size) {
+                return flush();
+            }
+            return true;
+        };
+
+        std::string carry;
+        std::string chunk;
+        bool running = true;
+        bool quoted = false;
+        while (running && chunks_.pop(chunk)) {
+            std::string_view rest(chunk);
+            std::size_t newline = find_record_end(rest, delimiter, quoted);
+            if (!carry.empty()) {
+                if (newline == std::string_view::npos) {
+                    carry.append(rest);
+                    continue;
+                }
+                carry.append(rest.substr(0, newline));
+                running = handle_line(carry);
+                carry.clear();
+                rest.remove_prefix(newline + 1);
+                newline = find_record_end(rest, delimiter, quoted);
+            }
+            while (running && newline != std::string_view::npos) {
+                running = handle_line(rest.substr(0, newline));
+                rest.remove_prefix(newline + 1);
+                newline = find_record_end(rest, delimiter, quoted);
+            }
+            carry.assign(rest);
+        }
+        if (running && !carry.empty()) {
+            running = handle_line(carry);
+        }
+        if (running) {
+            flush();
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+    records_.close();
+}
+
+void SmilesFileReader::featurize_stage() {
+    try {
+        const std::size_t nbits = static_cast<std::size_t>(std::max(options_.nbits, 1));
+        const std::size_t row_bytes =
+            fingerprint_row_bytes(nbits, options_.fingerprint_layout);
+        const unsigned int radius =
+            options_.radius < 0 ? 0U : static_cast<unsigned int>(options_.radius);
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+
+        RecordBatch records;
+        while (records_.pop(records)) {
+            const std::size_t size = records.smiles.size();
+            SmilesFeatureBatch batch;
+            batch.first_row = records.first_row;
+            batch.valid.assign(size, 0);
+            if (options_.descriptors) {
+                batch.molecular_weight.assign(size, nan);
+                batch.logp.assign(size, nan);
+                batch.tpsa.assign(size, nan);
+            }
+            if (options_.fingerprints) {
+                batch.fingerprints.assign(size * row_bytes, 0);
+            }
+            if (options_.traces) {
+                batch.traces.resize(size);
+            }
+
+            parallel_for(size, options_.num_threads, [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    auto mol = smiles_to_mol(records.smiles[i]);
+                    if (!mol) {
+                        continue;
+                    }
+                    batch.valid[i] = 1;
+                    if (options_.descriptors) {
+                        batch.molecular_weight[i] = RDKit::Descriptors::calcAMW(*mol);
+                        batch.logp[i] = RDKit::Descriptors::calcClogP(*mol);
+                        batch.tpsa[i] = RDKit::Descriptors::calcTPSA(*mol);
+                    }
+                    // Traces already hash the chiral environments, so a chiral
+                    // fingerprint comes out of the same pass
+                    const bool fused = options_.traces && options_.fingerprints &&
+                                       options_.chirality;
+                    std::uint8_t* row = options_.fingerprints
+                                            ? batch.fingerprints.data() + i * row_bytes
+                                            : nullptr;
+                    if (options_.traces) {
+                        try {
+                            ReasoningTraceResult result = ecfp_reasoning_trace_from_mol(
+                                *mol, radius, true, false, true, nbits,
+                                options_.fingerprint_layout);
+                            batch.traces[i] = std::move(std::get<0>(result));
+                            if (fused) {
+                                const std::vector<std::uint8_t>& bits = std::get<1>(result);
+                                std::copy_n(bits.begin(), std::min(bits.size(), row_bytes), row);
+                            }
+                        } catch (const std::exception&) {
+                            batch.traces[i].clear();
+                            if (fused) {
+                                // Same row as the unfused path would produce
+                                morgan_fingerprint_row(*mol, radius, options_.chirality, nbits,
+                                                       options_.fingerprint_layout, row);
+                            }
+                        }
+                    }
+                    if (options_.fingerprints && !fused) {
+                        // Leaves the row zeroed on failure, as the in-memory batch path does
+                        morgan_fingerprint_row(*mol, radius, options_.chirality, nbits,
+                                               options_.fingerprint_layout, row);
+                    }
+                }
+            });
+
+            batch.smiles = std::move(records.smiles);
+            batch.ids = std::move(records.ids);
+            if (!results_.push(std::move(batch))) {
+                return;
+            }
+        }
+    } catch (...) {
+        fail(std::current_exception());
+    }
+    results_.close();
+}
+
+} // namespace rdktools
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "bit_packing.hpp"
+#include "bounded_queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief Configuration of a SmilesFileReader
+ */
+struct SmilesReaderOptions {
+    std::string path;
+    std::size_t batch_size = 10000;
+    std::size_t chunk_bytes = std::size_t{4} << 20;
+    std::size_t queue_depth = 2;
+
+    // Record format. delimiter '\0' splits on runs of spaces/tabs (.smi);
+    // any other character splits CSV-style with double-quote support
+    // (quoted fields may contain the delimiter and newlines).
+    char delimiter = '\0';
+    bool header = false;
+    int smiles_column = 0;
+    std::string smiles_column_name;  // overrides smiles_column when set
+    int id_column = -1;              // -1: no ID column
+    std::string id_column_name;      // overrides id_column when set
+
+    // Features computed per batch
+    bool descriptors = true;
+    bool fingerprints = false;
+    int radius = 2;
+    int nbits = 2048;
+    FingerprintLayout fingerprint_layout = FingerprintLayout::Dense;
+    bool chirality = false;  // fingerprints include chirality (traces always do)
+    bool traces = false;
+    int num_threads = 0;
+};
+
+/**
+ * @brief Features of one batch of records, in file order
+ */
+struct SmilesFeatureBatch {
+    std::size_t first_row = 0;
+    std::vector<std::string> smiles;
+    std::vector<std::string> ids;
+    std::vector<std::uint8_t> valid;
+    std::vector<double> molecular_weight;
+    std::vector<double> logp;
+    std::vector<double> tpsa;
+    std::vector<std::uint8_t> fingerprints;  // rows of fingerprint_row_bytes()
+    std::vector<std::string> traces;
+};
+
+/**
+ * @brief Streaming reader for large (optionally gzip-compressed) SMILES files.
+ *
+ * Three pipeline threads are connected by bounded queues:
+ * read + decompress fixed-size chunks, split them into records and batches,
+ * then parse and featurize each batch on the shared worker pool. Memory stays
+ * flat regardless of file size, and I/O, decompression and RDKit work overlap.
+ */
+class SmilesFileReader {
+public:
+    /**
+     * @brief Open the file and start the pipeline
+     * @throws std::runtime_error if the file cannot be opened
+     * @throws std::invalid_argument for inconsistent options
+     */
+    explicit SmilesFileReader(SmilesReaderOptions options);
+    ~SmilesFileReader();
+
+    SmilesFileReader(const SmilesFileReader&) = delete;
+    SmilesFileReader& operator=(const SmilesFileReader&) = delete;
+
+    /**
+     * @brief Wait for the next batch
+     * @return false at end of file
+     * @throws the first error raised by a pipeline stage
+     */
+    bool next(SmilesFeatureBatch& batch);
+
+    /**
+     * @brief Stop the pipeline and join its threads (idempotent)
+     */
+    void close();
+
+    const SmilesReaderOptions& options() const { return options_; }
+
+    /**
+     * @brief Records handed out so far
+     */
+    std::size_t rows_read() const { return rows_read_; }
+
+private:
+    struct RecordBatch {
+        std::size_t first_row = 0;
+        std::vector<std::string> smiles;
+        std::vector<std::string> ids;
+    };
+
+    void read_stage();
+    void split_stage();
+    void featurize_stage();
+    void fail(std::exception_ptr error);
+
+    SmilesReaderOptions options_;
+    void* file_ = nullptr;  // gzFile; reads plain files transparently
+
+    BoundedQueue<std::string> chunks_;
+    BoundedQueue<RecordBatch> records_;
+    BoundedQueue<SmilesFeatureBatch> results_;
+
+    std::mutex error_mutex_;
+    std::exception_ptr error_;
+
+    std::size_t rows_read_ = 0;
+    std::atomic<bool> closed_{false};
+    std::thread reader_;
+    std::thread splitter_;
+    std::thread featurizer_;
+};
+
+} // namespace rdktools
@@ -0,0 +1,207 @@
+#include "stats.hpp"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace rdktools {
+
+namespace {
+
+// Every thread bumps its own block, so the hot paths never touch a cache
+// line another thread writes. Only the owning thread writes a block (plain
+// load + store, no read-modify-write); snapshots read all blocks.
+struct ThreadBlock {
+    std::array<std::atomic<std::uint64_t>, kNumCounters> counters{};
+    std::array<std::atomic<std::uint64_t>, kNumStages> stage_calls{};
+    std::array<std::atomic<std::uint64_t>, kNumStages> stage_nanoseconds{};
+};
+
+void bump(std::atomic<std::uint64_t>& value, std::uint64_t n) {
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// Totals only ever grow: exited threads fold theirs into retired, and a
+// reset records the current totals as the baseline that snapshots subtract
+// instead of writing into blocks other threads own.
+struct Registry {
+    std::mutex mutex;
+    std::vector<const ThreadBlock*> blocks;
+    StatsSnapshot retired;
+    StatsSnapshot baseline;
+};
+
+Registry& registry() {
+    // Intentionally leaked: threads may retire their blocks during exit
+    static Registry* instance = new Registry();
+    return *instance;
+}
+
+void add_block(StatsSnapshot& totals, const ThreadBlock& block) {
+    for (std::size_t i = 0; i < kNumCounters; ++i) {
+        totals.counters[i] += block.counters[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < kNumStages; ++i) {
+        totals.stages[i].calls += block.stage_calls[i].load(std::memory_order_relaxed);
+        totals.stages[i].nanoseconds +=
+            block.stage_nanoseconds[i].load(std::memory_order_relaxed);
+    }
+}
+
+// Must be called with the registry mutex held
+StatsSnapshot totals_locked(const Registry& r) {
+    StatsSnapshot totals = r.retired;
+    for (const ThreadBlock* block : r.blocks) {
+        add_block(totals, *block);
+    }
+    return totals;
+}
+
+class ThreadStats {
+public:
+    ThreadStats() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.mutex);
+        r.blocks.push_back(&block_);
+    }
+
+    ~ThreadStats() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.mutex);
+        add_block(r.retired, block_);
+        r.blocks.erase(std::find(r.blocks.begin(), r.blocks.end(), &block_));
+    }
+
+    ThreadStats(const ThreadStats&) = delete;
+    ThreadStats& operator=(const ThreadStats&) = delete;
+
+    ThreadBlock& block() { return block_; }
+
+private:
+    ThreadBlock block_;
+};
+
+ThreadBlock& thread_block() {
+    thread_local ThreadStats stats;
+    return stats.block();
+}
+
+std::atomic<StageTraceBegin> trace_begin{nullptr};
+std::atomic<StageTraceEnd> trace_end{nullptr};
+
+} // namespace
+
+const char* stage_name(Stage stage) {
+    switch (stage) {
+        case Stage::Parse:
+            return "parse";
+        case Stage::Unpickle:
+            return "unpickle";
+        case Stage::Morgan:
+            return "morgan";
+        case Stage::EnvironmentSmarts:
+            return "environment_smarts";
+        case Stage::TokenMetrics:
+            return "token_metrics";
+        case Stage::Format:
+            return "format";
+        case Stage::Descriptors:
+            return "descriptors";
+        case Stage::Formula:
+            return "formula";
+        case Stage::Substructure:
+            return "substructure";
+        case Stage::Count:
+            break;
+    }
+    return "unknown";
+}
+
+const char* counter_name(Counter counter) {
+    switch (counter) {
+        case Counter::MoleculesParsed:
+            return "molecules_parsed";
+        case Counter::MoleculesUnpickled:
+            return "molecules_unpickled";
+        case Counter::InvalidSmiles:
+            return "invalid_smiles";
+        case Counter::Exceptions:
+            return "exceptions";
+        case Counter::ResultCacheHits:
+            return "result_cache_hits";
+        case Counter::ResultCacheMisses:
+            return "result_cache_misses";
+        case Counter::SmartsCacheHits:
+            return "smarts_cache_hits";
+        case Counter::SmartsCacheMisses:
+            return "smarts_cache_misses";
+        case Counter::MetricsCacheHits:
+            return "metrics_cache_hits";
+        case Counter::MetricsCacheMisses:
+            return "metrics_cache_misses";
+        case Counter::SubstructurePrescreenRejects:
+            return "substructure_prescreen_rejects";
+        case Counter::SubstructureMatchCalls:
+            return "substructure_match_calls";
+        case Counter::Count:
+            break;
+    }
+    return "unknown";
+}
+
+StatsSnapshot stats_snapshot() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    StatsSnapshot snapshot = totals_locked(r);
+    for (std::size_t i = 0; i < kNumCounters; ++i) {
+        snapshot.counters[i] -= r.baseline.counters[i];
+    }
+    for (std::size_t i = 0; i < kNumStages; ++i) {
+        snapshot.stages[i].calls -= r.baseline.stages[i].calls;
+        snapshot.stages[i].nanoseconds -= r.baseline.stages[i].nanoseconds;
+    }
+    return snapshot;
+}
+
+void reset_stats() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> guard(r.mutex);
+    r.baseline = totals_locked(r);
+}
+
+void count(Counter counter, std::uint64_t n) {
+    bump(thread_block().counters[static_cast<std::size_t>(counter)], n);
+}
+
+void record_stage(Stage stage, std::uint64_t nanoseconds) {
+    const auto index = static_cast<std::size_t>(stage);
+    ThreadBlock& block = thread_block();
+    bump(block.stage_calls[index], 1);
+    bump(block.stage_nanoseconds[index], nanoseconds);
+}
+
+void set_stage_tracer(StageTraceBegin begin, StageTraceEnd end) {
+    trace_end.store(end, std::memory_order_relaxed);
+    trace_begin.store(begin, std::memory_order_release);
+}
+
+StageTimer::StageTimer(Stage stage) : stage_(stage) {
+    if (const StageTraceBegin begin = trace_begin.load(std::memory_order_acquire)) {
+        trace_id_ = begin(stage);
+    }
+    start_ = std::chrono::steady_clock::now();
+}
+
+StageTimer::~StageTimer() {
+    const auto elapsed = std::chrono::steady_clock::now() - start_;
+    record_stage(stage_, static_cast<std::uint64_t>(
+                             std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                                 .count()));
+    if (trace_id_ != 0) {
+        if (const StageTraceEnd end = trace_end.load(std::memory_order_relaxed)) {
+            end(trace_id_);
+        }
+    }
+}
+
+} // namespace rdktools
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Per-stage timers and counters, kept per thread and summed on demand so
+// the hot paths never write a shared cache line. Build with
+// RDKTOOLS_ENABLE_STATS=0 to compile every RDKTOOLS_STAGE / RDKTOOLS_COUNT
+// site out entirely; the snapshot API stays available and reports zeros.
+#ifndef RDKTOOLS_ENABLE_STATS
+#define RDKTOOLS_ENABLE_STATS 1
+#endif
+
+namespace rdktools {
+
+inline constexpr bool kStatsEnabled = RDKTOOLS_ENABLE_STATS != 0;
+
+/**
+ * @brief Timed stages of the featurization hot paths
+ *
+ * Stages do not overlap except that TokenMetrics (parsing a token's SMARTS
+ * on a metrics cache miss) runs inside Format, which orders tokens by
+ * those metrics.
+ */
+enum class Stage : std::size_t {
+    Parse,              // SMILES parsing and sanitization
+    Unpickle,           // rebuilding molecules from MolPickler bytes
+    Morgan,             // Morgan environments and fingerprint bits
+    EnvironmentSmarts,  // SMARTS for every trace environment
+    TokenMetrics,       // complexity metrics of uncached trace tokens
+    Format,             // assembling the trace text
+    Descriptors,        // descriptor plan rows
+    Formula,            // molecular formula strings
+    Substructure,       // pattern fingerprint prescreen and SubstructMatch
+    Count,
+};
+
+enum class Counter : std::size_t {
+    MoleculesParsed,
+    MoleculesUnpickled,
+    InvalidSmiles,  // SMILES or pickles that yielded no molecule
+    Exceptions,  // exceptions caught and turned into invalid results
+    ResultCacheHits,
+    ResultCacheMisses,
+    SmartsCacheHits,
+    SmartsCacheMisses,
+    MetricsCacheHits,
+    MetricsCacheMisses,
+    SubstructurePrescreenRejects,  // (molecule, query) pairs rejected by fingerprint
+    SubstructureMatchCalls,        // pairs passed on to SubstructMatch
+    Count,
+};
+
+inline constexpr std::size_t kNumStages = static_cast<std::size_t>(Stage::Count);
+inline constexpr std::size_t kNumCounters = static_cast<std::size_t>(Counter::Count);
+
+/**
+ * @brief snake_case names used as keys by rdktools.get_stats()
+ */
+const char* stage_name(Stage stage);
+const char* counter_name(Counter counter);
+
+struct StageTotals {
+    std::uint64_t calls = 0;
+    std::uint64_t nanoseconds = 0;
+};
+
+struct StatsSnapshot {
+    std::array<std::uint64_t, kNumCounters> counters{};
+    std::array<StageTotals, kNumStages> stages{};
+};
+
+/**
+ * @brief Totals accumulated by every thread since the last reset_stats()
+ */
+StatsSnapshot stats_snapshot();
+
+void reset_stats();
+
+void count(Counter counter, std::uint64_t n = 1);
+
+void record_stage(Stage stage, std::uint64_t nanoseconds);
+
+/**
+ * @brief Hooks that mirror each timed stage into an external profiler
+ *
+ * begin(stage) runs when a stage starts and returns an id that is handed to
+ * end(id) on the same thread when it finishes. Install both once, before
+ * any stage runs; the TF op library uses them to emit TraceMe activities.
+ */
+using StageTraceBegin = std::int64_t (*)(Stage stage);
+using StageTraceEnd = void (*)(std::int64_t id);
+
+void set_stage_tracer(StageTraceBegin begin, StageTraceEnd end);
+
+/**
+ * @brief Times the enclosing scope as one call of stage
+ */
+class StageTimer {
+public:
+    explicit StageTimer(Stage stage);
+    ~StageTimer();
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+private:
+    Stage stage_;
+    std::int64_t trace_id_ = 0;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace rdktools
+
+#if RDKTOOLS_ENABLE_STATS
+#define RDKTOOLS_STATS_CONCAT_(a, b) a##b
+#define RDKTOOLS_STATS_CONCAT(a, b) RDKTOOLS_STATS_CONCAT_(a, b)
+#define RDKTOOLS_STAGE(stage) \
+    ::rdktools::StageTimer RDKTOOLS_STATS_CONCAT(rdktools_stage_, __LINE__)(::rdktools::Stage::stage)
+#define RDKTOOLS_COUNT(counter) ::rdktools::count(::rdktools::Counter::counter)
+#define RDKTOOLS_COUNT_N(counter, n) ::rdktools::count(::rdktools::Counter::counter, (n))
+#else
+#define RDKTOOLS_STAGE(stage) static_cast<void>(0)
+#define RDKTOOLS_COUNT(counter) static_cast<void>(0)
+#define RDKTOOLS_COUNT_N(counter, n) static_cast<void>(0)
+#endif
@@ -0,0 +1,79 @@
+#include "substructure.hpp"
+#include "bit_packing.hpp"
+#include "similarity.hpp"
+#include "stats.hpp"
+#include <DataStructs/ExplicitBitVect.h>
+#include <GraphMol/Fingerprints/Fingerprints.h>
+#include <GraphMol/MolOps.h>
+#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <GraphMol/Substruct/SubstructMatch.h>
+#include <stdexcept>
+
+namespace rdktools {
+
+namespace {
+
+constexpr std::size_t kRowWords = (kPatternFingerprintSize + 63) / 64;
+constexpr std::size_t kRowBytes = kRowWords * sizeof(std::uint64_t);
+
+void pattern_fingerprint(const RDKit::ROMol& mol, std::uint64_t* out) {
+    std::unique_ptr<ExplicitBitVect> fp(
+        RDKit::PatternFingerprintMol(mol, kPatternFingerprintSize));
+    copy_fingerprint_words(*fp, out);
+}
+
+const std::uint8_t* row_bytes(const std::uint64_t* words) {
+    return reinterpret_cast<const std::uint8_t*>(words);
+}
+
+} // namespace
+
+SubstructurePatterns::SubstructurePatterns(const std::vector<std::string>& smarts,
+                                           bool use_chirality)
+    : fingerprints_(smarts.size() * kRowWords), use_chirality_(use_chirality) {
+    queries_.reserve(smarts.size());
+    for (std::size_t i = 0; i < smarts.size(); ++i) {
+        std::unique_ptr<RDKit::ROMol> query;
+        if (!smarts[i].empty()) {
+            try {
+                query.reset(RDKit::SmartsToMol(smarts[i]));
+            } catch (const std::exception&) {
+                query.reset();
+            }
+        }
+        if (!query) {
+            throw std::invalid_argument("invalid SMARTS pattern '" + smarts[i] +
+                                        "' at index " + std::to_string(i));
+        }
+        // Ring queries need ring info on the query itself, for both the
+        // fingerprint and the matcher
+        RDKit::MolOps::fastFindRings(*query);
+        pattern_fingerprint(*query, fingerprints_.data() + i * kRowWords);
+        queries_.push_back(std::move(query));
+    }
+}
+
+void SubstructurePatterns::match(const RDKit::ROMol& mol, bool* out) const {
+    RDKTOOLS_STAGE(Substructure);
+    std::uint64_t mol_fingerprint[kRowWords];
+    pattern_fingerprint(mol, mol_fingerprint);
+
+    RDKit::SubstructMatchParameters params;
+    params.maxMatches = 1;
+    params.useChirality = use_chirality_;
+
+    std::uint64_t calls = 0;
+    for (std::size_t q = 0; q < queries_.size(); ++q) {
+        if (!is_bit_subset(row_bytes(fingerprints_.data() + q * kRowWords),
+                           row_bytes(mol_fingerprint), kRowBytes)) {
+            out[q] = false;
+            continue;
+        }
+        ++calls;
+        out[q] = !RDKit::SubstructMatch(mol, *queries_[q], params).empty();
+    }
+    RDKTOOLS_COUNT_N(SubstructureMatchCalls, calls);
+    RDKTOOLS_COUNT_N(SubstructurePrescreenRejects, queries_.size() - calls);
+}
+
+} // namespace rdktools
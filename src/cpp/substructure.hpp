@@ -0,0 +1,49 @@
+#pragma once
+
+#include <GraphMol/ROMol.h>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace rdktools {
+
+inline constexpr std::size_t kPatternFingerprintSize = 2048;
+
+/**
+ * @brief SMARTS queries compiled once and matched against many molecules
+ *
+ * Each query keeps its packed pattern fingerprint. A molecule is only handed
+ * to SubstructMatch for the queries whose fingerprint bits are all set in
+ * the molecule's own pattern fingerprint, which rejects most non-matches
+ * with a few word-wide AND tests. Matching is read-only, so one instance can
+ * be shared by every worker thread.
+ */
+class SubstructurePatterns {
+public:
+    /**
+     * @brief Compile SMARTS queries
+     * @throws std::invalid_argument naming the first SMARTS that fails to parse
+     */
+    explicit SubstructurePatterns(const std::vector<std::string>& smarts,
+                                  bool use_chirality = false);
+
+    SubstructurePatterns(const SubstructurePatterns&) = delete;
+    SubstructurePatterns& operator=(const SubstructurePatterns&) = delete;
+
+    std::size_t size() const { return queries_.size(); }
+
+    /**
+     * @brief Match every query against mol
+     * @param out one entry per query, set to 1 where the query matches
+     */
+    void match(const RDKit::ROMol& mol, bool* out) const;
+
+private:
+    std::vector<std::unique_ptr<RDKit::ROMol>> queries_;
+    std::vector<std::uint64_t> fingerprints_;  // packed pattern fingerprint per query
+    bool use_chirality_;
+};
+
+} // namespace rdktools
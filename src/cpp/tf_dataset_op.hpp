@@ -0,0 +1,35 @@
+#pragma once
+
+#include "tensorflow/core/framework/dataset.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/shape_inference.h"
+
+#include <string>
+
+namespace tensorflow {
+
+// Source dataset streaming batched SMILES (and optionally fused traces and
+// fingerprints) out of .smi/.csv/.tsv files, gzip-compressed or not
+class SmilesFileDatasetOp : public DatasetOpKernel {
+ public:
+  explicit SmilesFileDatasetOp(OpKernelConstruction* context);
+  void MakeDataset(OpKernelContext* context, DatasetBase** output) override;
+
+ private:
+  class Dataset;
+
+  int64 batch_size_ = 0;
+  int64 smiles_column_ = 0;
+  std::string delimiter_;
+  bool header_ = false;
+  bool featurize_ = false;
+  int64 radius_ = 2;
+  int64 fingerprint_size_ = 0;
+  bool packed_ = false;
+  int64 num_threads_ = 0;
+  SmilesFileDatasetOp(const SmilesFileDatasetOp&) = delete;
+  void operator=(const SmilesFileDatasetOp&) = delete;
+};
+
+}  // namespace tensorflow
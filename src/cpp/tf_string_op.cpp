@@ -1,5 +1,8 @@
 #include "tf_string_op.hpp"
 #include "ecfp_trace.hpp"
+#include "mol_batch.hpp"
+#include "result_cache.hpp"
+#include "stats.hpp"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/shape_inference.h"
@@ -7,22 +10,158 @@
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/profiler/lib/traceme.h"
+#include "tensorflow/core/profiler/lib/traceme_encode.h"
+#include "tensorflow/core/util/work_sharder.h"
 #include <GraphMol/Descriptors/MolDescriptors.h>
-#include <GraphMol/SmilesParse/SmilesParse.h>
+#include <GraphMol/SmilesParse/SmilesWrite.h>
 #include <GraphMol/GraphMol.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <exception>
+#include <limits>
 #include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
 #include <string>
 #include <vector>
 
 namespace tensorflow {
 
+namespace {
+
+// Rough per-element costs (in cycles) handed to Shard(). Shard runs small
+// batches inline on the calling thread and splits larger ones over the
+// intra-op pool; traces parse the molecule and write SMARTS for every
+// environment, fingerprints parse and hash environments, while formulas
+// only parse and count atoms.
+constexpr int64_t kTraceCostPerElement = 250000;
+constexpr int64_t kFingerprintCostPerElement = 50000;
+constexpr int64_t kFormulaCostPerElement = 25000;
+constexpr int64_t kDescriptorCostPerDescriptor = 10000;
+
+// TraceMe level of the per-molecule stage activities; kernel-level
+// activities use the default kCritical level
+constexpr int kStageTraceLevel = 2;
+
+// "rdktools:<stage>" activity names, built once so tracing a stage never
+// allocates
+const std::array<std::string, rdktools::kNumStages>& stage_trace_names() {
+  static const std::array<std::string, rdktools::kNumStages> names = [] {
+    std::array<std::string, rdktools::kNumStages> result;
+    for (std::size_t i = 0; i < rdktools::kNumStages; ++i) {
+      result[i] = std::string("rdktools:") +
+                  rdktools::stage_name(static_cast<rdktools::Stage>(i));
+    }
+    return result;
+  }();
+  return names;
+}
+
+std::int64_t trace_stage_begin(rdktools::Stage stage) {
+  return profiler::TraceMe::ActivityStart(
+      stage_trace_names()[static_cast<std::size_t>(stage)], kStageTraceLevel);
+}
+
+void trace_stage_end(std::int64_t id) { profiler::TraceMe::ActivityEnd(id); }
+
+// Mirror the shared per-stage timers into the TF profiler, so parsing,
+// Morgan, SMARTS and formatting show up under the kernels in TensorBoard
+const bool kStageTracerInstalled = [] {
+  stage_trace_names();
+  rdktools::set_stage_tracer(trace_stage_begin, trace_stage_end);
+  return true;
+}();
+
+// One input element: a SMILES string, or MolPickler bytes with
+// input_format="pickle". Empty or unreadable pickles yield nullptr.
+std::unique_ptr<RDKit::ROMol> parse_input(const std::string& input,
+                                          bool pickle) {
+  if (pickle) {
+    return rdktools::pickle_to_mol(input);
+  }
+  // Sanitization errors propagate so the kernels can report them
+  return rdktools::smiles_to_mol_or_throw(input);
+}
+
+// Reads the input_format attr shared by every kernel
+Status read_input_format(OpKernelConstruction* context, bool* pickle) {
+  std::string input_format;
+  TF_RETURN_IF_ERROR(context->GetAttr("input_format", &input_format));
+  *pickle = input_format == "pickle";
+  return ::tensorflow::OkStatus();
+}
+
+// "<formula>[SEP]<smiles>", shared by FormulaProcess and DescriptorProcess
+// Pickled inputs are not readable text, so their SMILES is written from the
+// molecule instead.
+std::string formula_string(const RDKit::ROMol& mol, const std::string& input,
+                           bool pickle) {
+  RDKTOOLS_STAGE(Formula);
+  const std::string formula = RDKit::Descriptors::calcMolFormula(mol);
+  const std::string smiles = pickle ? RDKit::MolToSmiles(mol) : input;
+  std::string result;
+  result.reserve(formula.size() + 5 + smiles.size());
+  result.append(formula);
+  result.append("[SEP]");
+  result.append(smiles);
+  return result;
+}
+
+// Row of the first occurrence of each input string; rows with
+// first[i] == i are the distinct SMILES of the batch
+std::vector<int64_t> first_occurrences(
+    const TTypes<tstring>::ConstFlat& input_flat) {
+  const int64_t num_elements = input_flat.size();
+  std::vector<int64_t> first(num_elements);
+  std::unordered_map<std::string_view, int64_t> seen;
+  seen.reserve(static_cast<std::size_t>(num_elements));
+  for (int64_t i = 0; i < num_elements; ++i) {
+    const tstring& smiles = input_flat(i);
+    const auto inserted =
+        seen.emplace(std::string_view(smiles.data(), smiles.size()), i);
+    first[i] = inserted.first->second;
+  }
+  return first;
+}
+
+// Fill a fixed-size row for smiles from the shared result cache, running
+// compute() and caching its output on a miss
+template <typename Compute>
+void cached_row(const std::string& tag, const std::string& smiles, void* row,
+                std::size_t row_bytes, Compute&& compute) {
+  rdktools::ResultCache& cache = rdktools::result_cache();
+  if (!cache.enabled()) {
+    compute();
+    return;
+  }
+  const std::string key = rdktools::result_cache_key(tag, smiles);
+  std::string blob;
+  if (cache.find(key, blob) && blob.size() == row_bytes) {
+    std::memcpy(row, blob.data(), row_bytes);
+    return;
+  }
+  compute();
+  cache.insert(key, std::string(static_cast<const char*>(row), row_bytes));
+}
+
+}  // namespace
+
 // Register the custom op
 REGISTER_OP("StringProcess")
     .Input("input_strings: string")
     .Output("output_strings: string")
     .Output("output_fingerprints: uint8")
     .Attr("fingerprint_size: int = 2048")
+    .Attr("packed: bool = false")
+    .Attr("radius: int = 2")
+    .Attr("isomeric: bool = true")
+    .Attr("kekulize: bool = false")
+    .Attr("include_per_center: bool = true")
+    .Attr("dedup: bool = false")
+    .Attr("input_format: {'smiles', 'pickle'} = 'smiles'")
     .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
       int fingerprint_size = 0;
       TF_RETURN_IF_ERROR(
@@ -31,13 +170,24 @@ REGISTER_OP("StringProcess")
         return errors::InvalidArgument(
             "fingerprint_size must be positive");
       }
+      int radius = 0;
+      TF_RETURN_IF_ERROR(c->GetAttr("radius", &radius));
+      if (radius < 0) {
+        return errors::InvalidArgument("radius must be non-negative");
+      }
+      bool packed = false;
+      TF_RETURN_IF_ERROR(c->GetAttr("packed", &packed));
       // Output shape for traces matches input
       const auto input_shape = c->input(0);
       c->set_output(0, input_shape);
 
       // Fingerprint output has an extra trailing dimension for the bit vector
+      const int64_t fingerprint_width =
+          packed ? static_cast<int64_t>(rdktools::packed_num_bytes(
+                       static_cast<std::size_t>(fingerprint_size)))
+                 : static_cast<int64_t>(fingerprint_size);
       ::tensorflow::shape_inference::ShapeHandle bit_vector =
-          c->Vector(static_cast<int64_t>(fingerprint_size));
+          c->Vector(fingerprint_width);
       ::tensorflow::shape_inference::ShapeHandle fingerprint_shape;
       TF_RETURN_IF_ERROR(
           c->Concatenate(input_shape, bit_vector, &fingerprint_shape));
@@ -55,6 +205,16 @@ input_strings: A tensor of SMILES strings to analyse.
 output_strings: A tensor of reasoning traces with the same shape as input.
 output_fingerprints: A tensor containing Morgan bit vectors alongside each trace.
 fingerprint_size: Positive integer attribute selecting the fingerprint length.
+packed: If true, fingerprints are bit-packed to ceil(fingerprint_size / 8)
+  bytes per row in np.packbits order instead of one byte per bit.
+radius: Maximum Morgan radius used for environments and fingerprints.
+isomeric: If true, environments and fingerprints include chirality.
+kekulize: If true, environments are written from a kekulized copy.
+include_per_center: If true, traces end with the per-atom chain summary.
+dedup: If true, each distinct SMILES of the batch is featurized once and its
+  trace and fingerprint are copied to the repeated rows.
+input_format: "smiles" for SMILES strings, or "pickle" for RDKit binary
+  pickles as written by rdktools.smiles_to_pickles.
 )doc");
 
 // Kernel implementation
@@ -65,9 +225,20 @@ StringProcessOp::StringProcessOp(OpKernelConstruction* context)
   OP_REQUIRES(context, fingerprint_size_ > 0,
               errors::InvalidArgument(
                   "fingerprint_size must be positive"));
+  OP_REQUIRES_OK(context, context->GetAttr("packed", &packed_));
+  OP_REQUIRES_OK(context, context->GetAttr("radius", &radius_));
+  OP_REQUIRES(context, radius_ >= 0,
+              errors::InvalidArgument("radius must be non-negative"));
+  OP_REQUIRES_OK(context, context->GetAttr("isomeric", &isomeric_));
+  OP_REQUIRES_OK(context, context->GetAttr("kekulize", &kekulize_));
+  OP_REQUIRES_OK(context, context->GetAttr("include_per_center",
+                                           &include_per_center_));
+  OP_REQUIRES_OK(context, context->GetAttr("dedup", &dedup_));
+  OP_REQUIRES_OK(context, read_input_format(context, &pickle_input_));
 }
 
 void StringProcessOp::Compute(OpKernelContext* context) {
+  profiler::TraceMe trace_me("StringProcess");
   // Get the input tensor
   const Tensor& input_tensor = context->input(0);
 
@@ -81,10 +252,15 @@ void StringProcessOp::Compute(OpKernelContext* context) {
                  context->allocate_output(0, input_tensor.shape(),
                                           &output_tensor));
 
+  const rdktools::FingerprintLayout layout =
+      packed_ ? rdktools::FingerprintLayout::PackedBytes
+              : rdktools::FingerprintLayout::Dense;
+  const std::size_t expected_size = rdktools::fingerprint_row_bytes(
+      static_cast<std::size_t>(fingerprint_size_), layout);
+
   Tensor* fingerprint_tensor = nullptr;
   TensorShape fingerprint_shape = input_tensor.shape();
-  fingerprint_shape.AddDim(
-      static_cast<int64_t>(fingerprint_size_));
+  fingerprint_shape.AddDim(static_cast<int64_t>(expected_size));
   OP_REQUIRES_OK(context,
                  context->allocate_output(1, fingerprint_shape,
                                           &fingerprint_tensor));
@@ -94,57 +270,633 @@ void StringProcessOp::Compute(OpKernelContext* context) {
   auto output_flat = output_tensor->flat<tstring>();
   auto fingerprint_flat = fingerprint_tensor->flat<uint8>();
 
-  const int64_t num_elements = input_flat.size();
-  for (int64_t i = 0; i < num_elements; ++i) {
-    const std::string smiles = input_flat(i);
-    rdktools::ReasoningTraceResult trace_result;
-    try {
-      trace_result = rdktools::ecfp_reasoning_trace_from_smiles(
-          smiles, 2U, true, false, true,
-          static_cast<std::size_t>(fingerprint_size_));
-    } catch (const std::exception& e) {
-      trace_result = rdktools::ReasoningTraceResult(
-          std::string("[error] ") + e.what(),
-          std::vector<std::uint8_t>(
-              static_cast<std::size_t>(fingerprint_size_), 0));
+  // With dedup only the first occurrence of each SMILES is featurized
+  std::vector<int64_t> first;
+  std::vector<int64_t> rows;
+  if (dedup_) {
+    profiler::TraceMe dedup_trace("StringProcess:dedup");
+    first = first_occurrences(input_flat);
+    for (int64_t i = 0; i < static_cast<int64_t>(first.size()); ++i) {
+      if (first[i] == i) {
+        rows.push_back(i);
+      }
     }
+  }
+
+  const int64_t num_elements =
+      dedup_ ? static_cast<int64_t>(rows.size()) : input_flat.size();
+  auto process = [&](int64_t begin, int64_t end) {
+    profiler::TraceMe shard_trace([&] {
+      return profiler::TraceMeEncode("StringProcess:shard",
+                                     {{"rows", end - begin}});
+    });
+    for (int64_t k = begin; k < end; ++k) {
+      const int64_t i = dedup_ ? rows[k] : k;
+      const std::string smiles = input_flat(i);
+      rdktools::ReasoningTraceResult trace_result;
+      try {
+        if (!pickle_input_) {
+          trace_result = rdktools::ecfp_reasoning_trace_from_smiles(
+              smiles, static_cast<unsigned int>(radius_), isomeric_,
+              kekulize_, include_per_center_,
+              static_cast<std::size_t>(fingerprint_size_), layout);
+        } else if (auto mol = rdktools::pickle_to_mol(smiles)) {
+          trace_result = rdktools::ecfp_reasoning_trace_from_mol(
+              *mol, static_cast<unsigned int>(radius_), isomeric_, kekulize_,
+              include_per_center_, static_cast<std::size_t>(fingerprint_size_),
+              layout);
+        }
+      } catch (const std::exception& e) {
+        RDKTOOLS_COUNT(Exceptions);
+        trace_result = rdktools::ReasoningTraceResult(
+            std::string("[error] ") + e.what(),
+            std::vector<std::uint8_t>(expected_size, 0));
+      }
 
-    std::string trace = std::move(std::get<0>(trace_result));
-    std::vector<std::uint8_t> fingerprint =
-        std::move(std::get<1>(trace_result));
+      std::string trace = std::move(std::get<0>(trace_result));
+      std::vector<std::uint8_t> fingerprint =
+          std::move(std::get<1>(trace_result));
 
-    const std::size_t expected_size =
-        static_cast<std::size_t>(fingerprint_size_);
-    if (fingerprint.size() != expected_size) {
-      fingerprint.resize(expected_size, 0);
-    }
+      if (fingerprint.size() != expected_size) {
+        fingerprint.resize(expected_size, 0);
+      }
 
-    if (trace.empty()) {
-      if (smiles.empty()) {
-        output_flat(i) = "";
+      if (trace.empty()) {
+        if (smiles.empty()) {
+          output_flat(i) = "";
+        } else {
+          output_flat(i) = "[invalid]";
+        }
       } else {
-        output_flat(i) = "[invalid]";
+        output_flat(i) = std::move(trace);
       }
-    } else {
-      output_flat(i) = std::move(trace);
-    }
 
-    const int64_t base_index =
-        i * static_cast<int64_t>(fingerprint_size_);
-    for (std::size_t j = 0; j < expected_size; ++j) {
-      fingerprint_flat(base_index + static_cast<int64_t>(j)) =
-          fingerprint[j];
+      const int64_t base_index =
+          i * static_cast<int64_t>(expected_size);
+      std::copy(fingerprint.begin(), fingerprint.end(),
+                fingerprint_flat.data() + base_index);
     }
+  };
+
+  const auto* workers = context->device()->tensorflow_cpu_worker_threads();
+  Shard(workers->num_threads, workers->workers, num_elements,
+        kTraceCostPerElement, process);
+
+  if (dedup_ && rows.size() < first.size()) {
+    auto copy_repeats = [&](int64_t begin, int64_t end) {
+      profiler::TraceMe shard_trace("StringProcess:copy_repeats");
+      for (int64_t i = begin; i < end; ++i) {
+        if (first[i] == i) {
+          continue;
+        }
+        output_flat(i) = output_flat(first[i]);
+        std::memcpy(fingerprint_flat.data() + i * expected_size,
+                    fingerprint_flat.data() + first[i] * expected_size,
+                    expected_size);
+      }
+    };
+    Shard(workers->num_threads, workers->workers,
+          static_cast<int64_t>(first.size()),
+          static_cast<int64_t>(expected_size), copy_repeats);
   }
 }
 
 // Register the kernel for CPU
 REGISTER_KERNEL_BUILDER(Name("StringProcess").Device(DEVICE_CPU), StringProcessOp);
 
+// Register the tokenized trace op
+REGISTER_OP("TraceTokens")
+    .Input("input_strings: string")
+    .Output("token_values: int32")
+    .Output("token_row_splits: int64")
+    .Output("output_fingerprints: uint8")
+    .Attr("fingerprint_size: int = 2048")
+    .Attr("packed: bool = false")
+    .Attr("radius: int = 2")
+    .Attr("isomeric: bool = true")
+    .Attr("kekulize: bool = false")
+    .Attr("include_per_center: bool = true")
+    .Attr("vocabulary: list(string) = []")
+    .Attr("input_format: {'smiles', 'pickle'} = 'smiles'")
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      int fingerprint_size = 0;
+      TF_RETURN_IF_ERROR(
+          c->GetAttr("fingerprint_size", &fingerprint_size));
+      if (fingerprint_size <= 0) {
+        return errors::InvalidArgument(
+            "fingerprint_size must be positive");
+      }
+      int radius = 0;
+      TF_RETURN_IF_ERROR(c->GetAttr("radius", &radius));
+      if (radius < 0 ||
+          radius > static_cast<int>(rdktools::kMaxTokenRadius)) {
+        return errors::InvalidArgument("radius must be between 0 and ",
+                                       rdktools::kMaxTokenRadius);
+      }
+      bool packed = false;
+      TF_RETURN_IF_ERROR(c->GetAttr("packed", &packed));
+
+      ::tensorflow::shape_inference::ShapeHandle input_shape;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 1, &input_shape));
+      ::tensorflow::shape_inference::DimensionHandle num_rows = c->Dim(input_shape, 0);
+      ::tensorflow::shape_inference::DimensionHandle num_splits;
+      TF_RETURN_IF_ERROR(c->Add(num_rows, 1, &num_splits));
+      c->set_output(0, c->Vector(c->UnknownDim()));
+      c->set_output(1, c->Vector(num_splits));
+
+      const int64_t fingerprint_width =
+          packed ? static_cast<int64_t>(rdktools::packed_num_bytes(
+                       static_cast<std::size_t>(fingerprint_size)))
+                 : static_cast<int64_t>(fingerprint_size);
+      c->set_output(2, c->Matrix(num_rows, fingerprint_width));
+      return ::tensorflow::OkStatus();
+    })
+    .Doc(R"doc(
+Generate ECFP reasoning traces as ragged int32 token ids for SMILES vectors.
+
+The ids are encoded straight from the environments StringProcess writes as
+text, without building the text; `token_values` and `token_row_splits` are the
+components of a RaggedTensor with one row per input. Invalid SMILES yield empty
+rows and all-zero fingerprints.
+
+input_strings: A rank-1 tensor of SMILES strings.
+token_values: Token ids of every row, concatenated.
+token_row_splits: Offsets of length N + 1; row i is
+  token_values[token_row_splits[i]:token_row_splits[i + 1]].
+output_fingerprints: A uint8 matrix with one Morgan fingerprint per row.
+fingerprint_size: Positive integer attribute selecting the fingerprint length.
+packed: If true, fingerprints are bit-packed to ceil(fingerprint_size / 8)
+  bytes per row in np.packbits order instead of one byte per bit.
+radius: Maximum Morgan radius, at most 15.
+isomeric: If true, environments and fingerprints include chirality.
+kekulize: If true, environments are written from a kekulized copy.
+include_per_center: If true, traces end with the per-atom chain summary.
+vocabulary: Tokens in id order, as from rdktools.get_trace_vocabulary(). The
+  kernel uses this vocabulary frozen, mapping unseen environments to [UNK].
+  When empty, the op library's shared vocabulary is used, and it must have
+  been frozen with rdktools.set_trace_vocabulary(tokens, frozen=True). Ids a
+  growing vocabulary hands out depend on the order workers first meet each
+  environment, so they differ between runs and processes.
+input_format: "smiles" for SMILES strings, or "pickle" for RDKit binary
+  pickles as written by rdktools.smiles_to_pickles.
+)doc");
+
+TraceTokensOp::TraceTokensOp(OpKernelConstruction* context)
+    : OpKernel(context) {
+  OP_REQUIRES_OK(context,
+                 context->GetAttr("fingerprint_size", &fingerprint_size_));
+  OP_REQUIRES(context, fingerprint_size_ > 0,
+              errors::InvalidArgument(
+                  "fingerprint_size must be positive"));
+  OP_REQUIRES_OK(context, context->GetAttr("packed", &packed_));
+  OP_REQUIRES_OK(context, context->GetAttr("radius", &radius_));
+  OP_REQUIRES(context,
+              radius_ >= 0 &&
+                  radius_ <= static_cast<int64>(rdktools::kMaxTokenRadius),
+              errors::InvalidArgument("radius must be between 0 and ",
+                                      rdktools::kMaxTokenRadius));
+  OP_REQUIRES_OK(context, context->GetAttr("isomeric", &isomeric_));
+  OP_REQUIRES_OK(context, context->GetAttr("kekulize", &kekulize_));
+  OP_REQUIRES_OK(context, context->GetAttr("include_per_center",
+                                           &include_per_center_));
+  OP_REQUIRES_OK(context, read_input_format(context, &pickle_input_));
+  std::vector<std::string> tokens;
+  OP_REQUIRES_OK(context, context->GetAttr("vocabulary", &tokens));
+  if (!tokens.empty()) {
+    try {
+      vocabulary_ = std::make_unique<rdktools::TraceVocabulary>(tokens, true);
+    } catch (const std::invalid_argument& e) {
+      context->CtxFailure(errors::InvalidArgument(e.what()));
+      return;
+    }
+  }
+}
+
+void TraceTokensOp::Compute(OpKernelContext* context) {
+  profiler::TraceMe trace_me("TraceTokens");
+  const Tensor& input_tensor = context->input(0);
+  OP_REQUIRES(context, TensorShapeUtils::IsVector(input_tensor.shape()),
+              errors::InvalidArgument("input_strings must be a vector"));
+
+  const rdktools::FingerprintLayout layout =
+      packed_ ? rdktools::FingerprintLayout::PackedBytes
+              : rdktools::FingerprintLayout::Dense;
+  const std::size_t row_bytes = rdktools::fingerprint_row_bytes(
+      static_cast<std::size_t>(fingerprint_size_), layout);
+  auto input_flat = input_tensor.flat<tstring>();
+  const int64_t num_rows = input_flat.size();
+
+  Tensor* fingerprint_tensor = nullptr;
+  OP_REQUIRES_OK(context,
+                 context->allocate_output(
+                     2, TensorShape({num_rows, static_cast<int64_t>(row_bytes)}),
+                     &fingerprint_tensor));
+  uint8* fingerprint_data = fingerprint_tensor->flat<uint8>().data();
+  rdktools::TraceVocabulary& vocabulary =
+      vocabulary_ ? *vocabulary_ : rdktools::trace_vocabulary();
+  OP_REQUIRES(context, vocabulary.frozen(),
+              errors::FailedPrecondition(
+                  "TraceTokens needs a frozen vocabulary: pass the vocabulary "
+                  "attr or call rdktools.set_trace_vocabulary(tokens, "
+                  "frozen=True) first"));
+
+  std::vector<std::vector<int32>> rows(static_cast<std::size_t>(num_rows));
+  auto process = [&](int64_t begin, int64_t end) {
+    profiler::TraceMe shard_trace([&] {
+      return profiler::TraceMeEncode("TraceTokens:shard",
+                                     {{"rows", end - begin}});
+    });
+    for (int64_t i = begin; i < end; ++i) {
+      uint8* row = fingerprint_data + i * static_cast<int64_t>(row_bytes);
+      std::fill_n(row, row_bytes, static_cast<uint8>(0));
+      const std::string smiles = input_flat(i);
+      if (smiles.empty()) {
+        continue;
+      }
+      try {
+        std::unique_ptr<RDKit::ROMol> mol = parse_input(smiles, pickle_input_);
+        if (!mol) {
+          continue;
+        }
+        rdktools::ReasoningTokensResult result =
+            rdktools::ecfp_reasoning_tokens_from_mol(
+                *mol, vocabulary, static_cast<unsigned int>(radius_),
+                isomeric_, kekulize_, include_per_center_,
+                static_cast<std::size_t>(fingerprint_size_), layout);
+        rows[i] = std::move(std::get<0>(result));
+        const std::vector<std::uint8_t>& bits = std::get<1>(result);
+        std::copy(bits.begin(), bits.end(), row);
+      } catch (const std::exception&) {
+        RDKTOOLS_COUNT(Exceptions);
+        rows[i].clear();
+        std::fill_n(row, row_bytes, static_cast<uint8>(0));
+      }
+    }
+  };
+
+  const auto* workers = context->device()->tensorflow_cpu_worker_threads();
+  Shard(workers->num_threads, workers->workers, num_rows, kTraceCostPerElement,
+        process);
+
+  Tensor* splits_tensor = nullptr;
+  OP_REQUIRES_OK(context, context->allocate_output(
+                              1, TensorShape({num_rows + 1}), &splits_tensor));
+  auto splits = splits_tensor->flat<int64>();
+  splits(0) = 0;
+  for (int64_t i = 0; i < num_rows; ++i) {
+    splits(i + 1) = splits(i) + static_cast<int64>(rows[i].size());
+  }
+
+  Tensor* values_tensor = nullptr;
+  OP_REQUIRES_OK(context,
+                 context->allocate_output(0, TensorShape({splits(num_rows)}),
+                                          &values_tensor));
+  int32* values = values_tensor->flat<int32>().data();
+  for (int64_t i = 0; i < num_rows; ++i) {
+    std::copy(rows[i].begin(), rows[i].end(), values + splits(i));
+  }
+}
+
+REGISTER_KERNEL_BUILDER(Name("TraceTokens").Device(DEVICE_CPU), TraceTokensOp);
+
+REGISTER_OP("TraceVocabulary")
+    .Output("tokens: string")
+    .SetIsStateful()
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      c->set_output(0, c->Vector(c->UnknownDim()));
+      return ::tensorflow::OkStatus();
+    })
+    .Doc(R"doc(
+Export the op library's shared trace vocabulary, in id order.
+
+tokens: The tokens TraceTokens uses when it has no vocabulary attr.
+)doc");
+
+TraceVocabularyOp::TraceVocabularyOp(OpKernelConstruction* context)
+    : OpKernel(context) {}
+
+void TraceVocabularyOp::Compute(OpKernelContext* context) {
+  const std::vector<std::string> tokens =
+      rdktools::trace_vocabulary().tokens();
+  Tensor* output = nullptr;
+  OP_REQUIRES_OK(context,
+                 context->allocate_output(
+                     0, TensorShape({static_cast<int64_t>(tokens.size())}),
+                     &output));
+  auto flat = output->flat<tstring>();
+  for (std::size_t i = 0; i < tokens.size(); ++i) {
+    flat(i) = tokens[i];
+  }
+}
+
+REGISTER_KERNEL_BUILDER(Name("TraceVocabulary").Device(DEVICE_CPU),
+                        TraceVocabularyOp);
+
+// Register the fingerprint-only op
+REGISTER_OP("MorganFingerprint")
+    .Input("input_strings: string")
+    .Output("fingerprints: uint8")
+    .Attr("radius: int = 2")
+    .Attr("use_chirality: bool = false")
+    .Attr("fingerprint_size: int = 2048")
+    .Attr("packed: bool = false")
+    .Attr("counts: bool = false")
+    .Attr("input_format: {'smiles', 'pickle'} = 'smiles'")
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      int radius = 0;
+      TF_RETURN_IF_ERROR(c->GetAttr("radius", &radius));
+      if (radius < 0) {
+        return errors::InvalidArgument("radius must be non-negative");
+      }
+      int fingerprint_size = 0;
+      TF_RETURN_IF_ERROR(
+          c->GetAttr("fingerprint_size", &fingerprint_size));
+      if (fingerprint_size <= 0) {
+        return errors::InvalidArgument(
+            "fingerprint_size must be positive");
+      }
+      bool packed = false;
+      TF_RETURN_IF_ERROR(c->GetAttr("packed", &packed));
+      bool counts = false;
+      TF_RETURN_IF_ERROR(c->GetAttr("counts", &counts));
+      if (packed && counts) {
+        return errors::InvalidArgument(
+            "packed and counts cannot both be set");
+      }
+
+      const int64_t fingerprint_width =
+          packed ? static_cast<int64_t>(rdktools::packed_num_bytes(
+                       static_cast<std::size_t>(fingerprint_size)))
+                 : static_cast<int64_t>(fingerprint_size);
+      ::tensorflow::shape_inference::ShapeHandle fingerprint_shape;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          c->input(0), c->Vector(fingerprint_width), &fingerprint_shape));
+      c->set_output(0, fingerprint_shape);
+      return ::tensorflow::OkStatus();
+    })
+    .Doc(R"doc(
+Generate Morgan fingerprints for SMILES tensors without building traces.
+
+Invalid or empty SMILES yield all-zero rows.
+
+input_strings: A tensor of SMILES strings to fingerprint.
+fingerprints: A uint8 tensor of shape input_shape + [width].
+radius: Maximum Morgan radius.
+use_chirality: If true, atom invariants include chirality.
+fingerprint_size: Positive integer attribute selecting the fingerprint length.
+packed: If true, fingerprints are bit-packed to ceil(fingerprint_size / 8)
+  bytes per row in np.packbits order instead of one byte per bit.
+counts: If true, each byte holds the number of environments hashed to that
+  bit (saturating at 255) instead of 0/1. Cannot be combined with packed.
+input_format: "smiles" for SMILES strings, or "pickle" for RDKit binary
+  pickles as written by rdktools.smiles_to_pickles.
+)doc");
+
+MorganFingerprintOp::MorganFingerprintOp(OpKernelConstruction* context)
+    : OpKernel(context) {
+  OP_REQUIRES_OK(context, context->GetAttr("radius", &radius_));
+  OP_REQUIRES(context, radius_ >= 0,
+              errors::InvalidArgument("radius must be non-negative"));
+  OP_REQUIRES_OK(context, context->GetAttr("use_chirality", &use_chirality_));
+  OP_REQUIRES_OK(context,
+                 context->GetAttr("fingerprint_size", &fingerprint_size_));
+  OP_REQUIRES(context, fingerprint_size_ > 0,
+              errors::InvalidArgument(
+                  "fingerprint_size must be positive"));
+  OP_REQUIRES_OK(context, context->GetAttr("packed", &packed_));
+  OP_REQUIRES_OK(context, context->GetAttr("counts", &counts_));
+  OP_REQUIRES(context, !(packed_ && counts_),
+              errors::InvalidArgument(
+                  "packed and counts cannot both be set"));
+  OP_REQUIRES_OK(context, read_input_format(context, &pickle_input_));
+  cache_tag_ = "morgan_generator:" + std::to_string(radius_) + ':' +
+               std::to_string(use_chirality_) + ':' +
+               std::to_string(fingerprint_size_) + ':' +
+               (counts_ ? "counts" : packed_ ? "bytes" : "dense");
+  if (pickle_input_) {
+    cache_tag_ += ":pickle";
+  }
+}
+
+void MorganFingerprintOp::Compute(OpKernelContext* context) {
+  profiler::TraceMe trace_me("MorganFingerprint");
+  const Tensor& input_tensor = context->input(0);
+  OP_REQUIRES(context, input_tensor.dtype() == DT_STRING,
+              errors::InvalidArgument("Input must be of type string"));
+
+  const rdktools::FingerprintLayout layout =
+      packed_ ? rdktools::FingerprintLayout::PackedBytes
+              : rdktools::FingerprintLayout::Dense;
+  const std::size_t fingerprint_size =
+      static_cast<std::size_t>(fingerprint_size_);
+  const std::size_t row_bytes =
+      rdktools::fingerprint_row_bytes(fingerprint_size, layout);
+
+  Tensor* fingerprint_tensor = nullptr;
+  TensorShape fingerprint_shape = input_tensor.shape();
+  fingerprint_shape.AddDim(static_cast<int64_t>(row_bytes));
+  OP_REQUIRES_OK(context,
+                 context->allocate_output(0, fingerprint_shape,
+                                          &fingerprint_tensor));
+
+  auto input_flat = input_tensor.flat<tstring>();
+  uint8* fingerprint_data = fingerprint_tensor->flat<uint8>().data();
+  const unsigned int radius = static_cast<unsigned int>(radius_);
+
+  const int64_t num_elements = input_flat.size();
+  auto process = [&](int64_t begin, int64_t end) {
+    profiler::TraceMe shard_trace([&] {
+      return profiler::TraceMeEncode("MorganFingerprint:shard",
+                                     {{"rows", end - begin}});
+    });
+    for (int64_t i = begin; i < end; ++i) {
+      uint8* row = fingerprint_data + i * static_cast<int64_t>(row_bytes);
+      std::fill_n(row, row_bytes, static_cast<uint8>(0));
+
+      const std::string smiles = input_flat(i);
+      if (smiles.empty()) {
+        continue;
+      }
+      cached_row(cache_tag_, smiles, row, row_bytes, [&] {
+        std::unique_ptr<RDKit::ROMol> mol;
+        try {
+          mol = parse_input(smiles, pickle_input_);
+        } catch (const std::exception&) {
+          mol.reset();
+        }
+        if (!mol) {
+          return;
+        }
+        if (counts_) {
+          rdktools::morgan_count_row(*mol, radius, use_chirality_,
+                                     fingerprint_size, row);
+        } else {
+          rdktools::morgan_fingerprint_row(*mol, radius, use_chirality_,
+                                           fingerprint_size, layout, row);
+        }
+      });
+    }
+  };
+
+  const auto* workers = context->device()->tensorflow_cpu_worker_threads();
+  Shard(workers->num_threads, workers->workers, num_elements,
+        kFingerprintCostPerElement, process);
+}
+
+REGISTER_KERNEL_BUILDER(Name("MorganFingerprint").Device(DEVICE_CPU),
+                        MorganFingerprintOp);
+
+// Register the multi-descriptor op
+REGISTER_OP("DescriptorProcess")
+    .Input("input_strings: string")
+    .Output("descriptors: float")
+    .Output("formulas: string")
+    .Attr("descriptors: list(string) = ['molecular_weight', 'logp', 'tpsa']")
+    .Attr("emit_formula: bool = false")
+    .Attr("input_format: {'smiles', 'pickle'} = 'smiles'")
+    .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
+      std::vector<std::string> names;
+      TF_RETURN_IF_ERROR(c->GetAttr("descriptors", &names));
+      if (names.empty()) {
+        return errors::InvalidArgument("descriptors must not be empty");
+      }
+      const auto input_shape = c->input(0);
+      ::tensorflow::shape_inference::ShapeHandle descriptor_shape;
+      TF_RETURN_IF_ERROR(c->Concatenate(
+          input_shape, c->Vector(static_cast<int64_t>(names.size())),
+          &descriptor_shape));
+      c->set_output(0, descriptor_shape);
+      c->set_output(1, input_shape);
+      return ::tensorflow::OkStatus();
+    })
+    .Doc(R"doc(
+Compute several molecular descriptors for SMILES tensors from one parse.
+
+Each SMILES string is parsed once and every requested descriptor is computed on
+the same molecule. Invalid or empty SMILES yield NaN rows.
+
+input_strings: A tensor of SMILES strings to analyse.
+descriptors: A float32 tensor of shape input_shape + [len(descriptors)].
+formulas: A string tensor matching the input shape. With emit_formula it holds
+  `<formula>[SEP]<smiles>` (or "[invalid]") computed from the same molecule;
+  otherwise every entry is empty.
+emit_formula: If true, fill `formulas` as FormulaProcess does.
+input_format: "smiles" for SMILES strings, or "pickle" for RDKit binary
+  pickles as written by rdktools.smiles_to_pickles.
+)doc");
+
+DescriptorProcessOp::DescriptorProcessOp(OpKernelConstruction* context)
+    : OpKernel(context) {
+  std::vector<std::string> names;
+  OP_REQUIRES_OK(context, context->GetAttr("descriptors", &names));
+  OP_REQUIRES(context, !names.empty(),
+              errors::InvalidArgument("descriptors must not be empty"));
+  try {
+    plan_ = std::make_unique<rdktools::DescriptorPlan>(names);
+  } catch (const std::invalid_argument& e) {
+    context->CtxFailure(errors::InvalidArgument(e.what()));
+    return;
+  }
+  OP_REQUIRES_OK(context, context->GetAttr("emit_formula", &emit_formula_));
+  OP_REQUIRES_OK(context, read_input_format(context, &pickle_input_));
+  // Same tag and float32 rows as rdktools.calculate_descriptors
+  cache_tag_ = "descriptors:float32:";
+  for (std::size_t d = 0; d < plan_->size(); ++d) {
+    cache_tag_ += (d ? "," : "") + plan_->names()[d];
+  }
+  if (pickle_input_) {
+    cache_tag_ += ":pickle";
+  }
+}
+
+void DescriptorProcessOp::Compute(OpKernelContext* context) {
+  profiler::TraceMe trace_me("DescriptorProcess");
+  const Tensor& input_tensor = context->input(0);
+  OP_REQUIRES(context, input_tensor.dtype() == DT_STRING,
+              errors::InvalidArgument("Input must be of type string"));
+
+  const int64_t num_descriptors = static_cast<int64_t>(plan_->size());
+  Tensor* descriptor_tensor = nullptr;
+  TensorShape descriptor_shape = input_tensor.shape();
+  descriptor_shape.AddDim(num_descriptors);
+  OP_REQUIRES_OK(context,
+                 context->allocate_output(0, descriptor_shape,
+                                          &descriptor_tensor));
+  Tensor* formula_tensor = nullptr;
+  OP_REQUIRES_OK(context,
+                 context->allocate_output(1, input_tensor.shape(),
+                                          &formula_tensor));
+
+  auto input_flat = input_tensor.flat<tstring>();
+  float* descriptor_data = descriptor_tensor->flat<float>().data();
+  auto formula_flat = formula_tensor->flat<tstring>();
+
+  const int64_t num_elements = input_flat.size();
+  auto process = [&](int64_t begin, int64_t end) {
+    profiler::TraceMe shard_trace([&] {
+      return profiler::TraceMeEncode("DescriptorProcess:shard",
+                                     {{"rows", end - begin}});
+    });
+    for (int64_t i = begin; i < end; ++i) {
+      float* row = descriptor_data + i * num_descriptors;
+      plan_->fill_invalid(row);
+
+      const std::string smiles = input_flat(i);
+      if (smiles.empty()) {
+        continue;
+      }
+      if (!emit_formula_) {
+        // Formulas need the parsed molecule, so only bare rows are cached
+        const std::size_t row_bytes = num_descriptors * sizeof(float);
+        cached_row(cache_tag_, smiles, row, row_bytes, [&] {
+          std::unique_ptr<RDKit::ROMol> mol;
+          try {
+            mol = parse_input(smiles, pickle_input_);
+          } catch (const std::exception&) {
+            mol.reset();
+          }
+          if (mol) {
+            plan_->compute(*mol, row);
+          }
+        });
+        continue;
+      }
+
+      std::unique_ptr<RDKit::ROMol> mol;
+      try {
+        mol = parse_input(smiles, pickle_input_);
+      } catch (const std::exception& e) {
+        formula_flat(i) = std::string("[error] ") + e.what();
+        continue;
+      }
+      if (!mol) {
+        formula_flat(i) = "[invalid]";
+        continue;
+      }
+
+      plan_->compute(*mol, row);
+      try {
+        formula_flat(i) = formula_string(*mol, smiles, pickle_input_);
+      } catch (const std::exception& e) {
+        RDKTOOLS_COUNT(Exceptions);
+        formula_flat(i) = std::string("[error] ") + e.what();
+      }
+    }
+  };
+
+  const auto* workers = context->device()->tensorflow_cpu_worker_threads();
+  Shard(workers->num_threads, workers->workers, num_elements,
+        kDescriptorCostPerDescriptor * (num_descriptors + 1), process);
+}
+
+REGISTER_KERNEL_BUILDER(Name("DescriptorProcess").Device(DEVICE_CPU),
+                        DescriptorProcessOp);
+
 // Register the formula op
 REGISTER_OP("FormulaProcess")
     .Input("input_strings: string")
     .Output("output_strings: string")
+    .Attr("input_format: {'smiles', 'pickle'} = 'smiles'")
     .SetShapeFn([](::tensorflow::shape_inference::InferenceContext* c) {
       const auto input_shape = c->input(0);
       c->set_output(0, input_shape);
@@ -158,12 +910,17 @@ molecular formula calculation. Invalid SMILES yield the literal string "[invalid
 
 input_strings: A tensor of SMILES strings to analyse.
 output_strings: A tensor of `<formula>[SEP]<smiles>` strings matching the input shape.
+input_format: "smiles" for SMILES strings, or "pickle" for RDKit binary
+  pickles as written by rdktools.smiles_to_pickles.
 )doc");
 
 FormulaProcessOp::FormulaProcessOp(OpKernelConstruction* context)
-    : OpKernel(context) {}
+    : OpKernel(context) {
+  OP_REQUIRES_OK(context, read_input_format(context, &pickle_input_));
+}
 
 void FormulaProcessOp::Compute(OpKernelContext* context) {
+  profiler::TraceMe trace_me("FormulaProcess");
   const Tensor& input_tensor = context->input(0);
   OP_REQUIRES(context, input_tensor.dtype() == DT_STRING,
               errors::InvalidArgument("Input must be of type string"));
@@ -177,33 +934,38 @@ void FormulaProcessOp::Compute(OpKernelContext* context) {
   auto output_flat = output_tensor->flat<tstring>();
 
   const int64_t num_elements = input_flat.size();
-  for (int64_t i = 0; i < num_elements; ++i) {
-    const std::string smiles = input_flat(i);
+  auto process = [&](int64_t begin, int64_t end) {
+    profiler::TraceMe shard_trace([&] {
+      return profiler::TraceMeEncode("FormulaProcess:shard",
+                                     {{"rows", end - begin}});
+    });
+    for (int64_t i = begin; i < end; ++i) {
+      const std::string smiles = input_flat(i);
 
-    if (smiles.empty()) {
-      output_flat(i) = "";
-      continue;
-    }
+      if (smiles.empty()) {
+        output_flat(i) = "";
+        continue;
+      }
 
-    std::string result;
-    try {
-      std::unique_ptr<RDKit::ROMol> mol(RDKit::SmilesToMol(smiles));
-      if (mol) {
-        const std::string formula =
-            RDKit::Descriptors::calcMolFormula(*mol);
-        result.reserve(formula.size() + 5 + smiles.size());
-        result.append(formula);
-        result.append("[SEP]");
-        result.append(smiles);
-      } else {
-        result = "[invalid]";
+      std::string result;
+      try {
+        std::unique_ptr<RDKit::ROMol> mol = parse_input(smiles, pickle_input_);
+        if (mol) {
+          result = formula_string(*mol, smiles, pickle_input_);
+        } else {
+          result = "[invalid]";
+        }
+      } catch (const std::exception& e) {
+        result = std::string("[error] ") + e.what();
       }
-    } catch (const std::exception& e) {
-      result = std::string("[error] ") + e.what();
+
+      output_flat(i) = std::move(result);
     }
+  };
 
-    output_flat(i) = std::move(result);
-  }
+  const auto* workers = context->device()->tensorflow_cpu_worker_threads();
+  Shard(workers->num_threads, workers->workers, num_elements,
+        kFormulaCostPerElement, process);
 }
 
 REGISTER_KERNEL_BUILDER(Name("FormulaProcess").Device(DEVICE_CPU),
@@ -7,6 +7,11 @@
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/platform/logging.h"
+#include "descriptor_registry.hpp"
+#include "trace_vocab.hpp"
+
+#include <memory>
+#include <string>
 
 namespace tensorflow {
 
@@ -18,16 +23,85 @@ class StringProcessOp : public OpKernel {
 
  private:
   int64 fingerprint_size_ = 0;
+  bool packed_ = false;
+  int64 radius_ = 2;
+  bool isomeric_ = true;
+  bool kekulize_ = false;
+  bool include_per_center_ = true;
+  bool dedup_ = false;
+  bool pickle_input_ = false;
   StringProcessOp(const StringProcessOp&) = delete;
   void operator=(const StringProcessOp&) = delete;
 };
 
+class TraceTokensOp : public OpKernel {
+ public:
+  explicit TraceTokensOp(OpKernelConstruction* context);
+  void Compute(OpKernelContext* context) override;
+
+ private:
+  int64 fingerprint_size_ = 0;
+  bool packed_ = false;
+  int64 radius_ = 2;
+  bool isomeric_ = true;
+  bool kekulize_ = false;
+  bool include_per_center_ = true;
+  bool pickle_input_ = false;
+  // Frozen vocabulary from the vocabulary attr; null uses the shared one,
+  // which must then be frozen
+  std::unique_ptr<rdktools::TraceVocabulary> vocabulary_;
+  TraceTokensOp(const TraceTokensOp&) = delete;
+  void operator=(const TraceTokensOp&) = delete;
+};
+
+class TraceVocabularyOp : public OpKernel {
+ public:
+  explicit TraceVocabularyOp(OpKernelConstruction* context);
+  void Compute(OpKernelContext* context) override;
+
+ private:
+  TraceVocabularyOp(const TraceVocabularyOp&) = delete;
+  void operator=(const TraceVocabularyOp&) = delete;
+};
+
+class MorganFingerprintOp : public OpKernel {
+ public:
+  explicit MorganFingerprintOp(OpKernelConstruction* context);
+  void Compute(OpKernelContext* context) override;
+
+ private:
+  int64 radius_ = 2;
+  bool use_chirality_ = false;
+  int64 fingerprint_size_ = 0;
+  bool packed_ = false;
+  bool counts_ = false;
+  bool pickle_input_ = false;
+  std::string cache_tag_;
+  MorganFingerprintOp(const MorganFingerprintOp&) = delete;
+  void operator=(const MorganFingerprintOp&) = delete;
+};
+
+class DescriptorProcessOp : public OpKernel {
+ public:
+  explicit DescriptorProcessOp(OpKernelConstruction* context);
+  void Compute(OpKernelContext* context) override;
+
+ private:
+  std::unique_ptr<rdktools::DescriptorPlan> plan_;
+  bool emit_formula_ = false;
+  bool pickle_input_ = false;
+  std::string cache_tag_;
+  DescriptorProcessOp(const DescriptorProcessOp&) = delete;
+  void operator=(const DescriptorProcessOp&) = delete;
+};
+
 class FormulaProcessOp : public OpKernel {
  public:
   explicit FormulaProcessOp(OpKernelConstruction* context);
   void Compute(OpKernelContext* context) override;
 
  private:
+  bool pickle_input_ = false;
   FormulaProcessOp(const FormulaProcessOp&) = delete;
   void operator=(const FormulaProcessOp&) = delete;
 };
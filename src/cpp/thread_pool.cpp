@@ -0,0 +1,211 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <string>
+
+namespace {
+
+// Chunks handed out per participating thread. Molecules vary wildly in cost,
+// so over-splitting keeps the tail short without much scheduling overhead.
+constexpr std::size_t kChunksPerThread = 4;
+
+unsigned int hardware_threads() {
+    const unsigned int detected = std::thread::hardware_concurrency();
+    return detected == 0 ? 1U : detected;
+}
+
+// Upper bound on threads per call, as a multiple of the hardware threads.
+// Workers are never reclaimed, so an oversized num_threads must not turn
+// into thousands of permanent OS threads.
+constexpr unsigned int kMaxThreadsPerCore = 4;
+
+unsigned int max_threads() {
+    return kMaxThreadsPerCore * hardware_threads();
+}
+
+unsigned int initial_default_threads() {
+    if (const char* env = std::getenv("RDKTOOLS_NUM_THREADS")) {
+        try {
+            const long value = std::stol(env);
+            if (value > 0) {
+                return static_cast<unsigned int>(value);
+            }
+        } catch (const std::exception&) {
+        }
+    }
+    return hardware_threads();
+}
+
+std::atomic<unsigned int>& default_threads_storage() {
+    static std::atomic<unsigned int> value{initial_default_threads()};
+    return value;
+}
+
+struct ParallelForState {
+    const rdktools::ThreadPool::RangeFunction* body = nullptr;
+    std::size_t count = 0;
+    std::size_t chunk_size = 1;
+    std::size_t num_chunks = 0;
+    std::atomic<std::size_t> next_chunk{0};
+    std::atomic<bool> failed{false};
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::size_t completed = 0;
+    std::exception_ptr error;
+};
+
+void run_chunks(ParallelForState& state) {
+    std::size_t finished = 0;
+    for (;;) {
+        const std::size_t chunk = state.next_chunk.fetch_add(1);
+        if (chunk >= state.num_chunks) {
+            break;
+        }
+        if (!state.failed.load(std::memory_order_relaxed)) {
+            const std::size_t begin = chunk * state.chunk_size;
+            const std::size_t end = std::min(state.count, begin + state.chunk_size);
+            try {
+                (*state.body)(begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(state.mutex);
+                if (!state.error) {
+                    state.error = std::current_exception();
+                }
+                state.failed.store(true, std::memory_order_relaxed);
+            }
+        }
+        ++finished;
+    }
+
+    if (finished != 0) {
+        std::lock_guard<std::mutex> guard(state.mutex);
+        state.completed += finished;
+        if (state.completed == state.num_chunks) {
+            state.cv.notify_all();
+        }
+    }
+}
+
+} // namespace
+
+namespace rdktools {
+
+ThreadPool& ThreadPool::instance() {
+    // Intentionally leaked: joining workers during static destruction races
+    // with interpreter shutdown.
+    static ThreadPool* pool = new ThreadPool();
+    return *pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        if (workers_.empty()) {
+            const std::size_t wanted =
+                std::max(1U, std::min(default_num_threads(), max_threads()) - 1);
+            for (std::size_t i = 0; i < wanted; ++i) {
+                workers_.emplace_back([this] { worker_loop(); });
+            }
+        }
+        tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void ThreadPool::parallel_for(std::size_t count, unsigned int num_threads,
+                              const RangeFunction& body) {
+    if (count == 0) {
+        return;
+    }
+    const std::size_t threads = std::min<std::size_t>(
+        std::clamp(num_threads, 1U, max_threads()), count);
+    if (threads == 1) {
+        body(0, count);
+        return;
+    }
+
+    ensure_workers(threads - 1);
+
+    auto state = std::make_shared<ParallelForState>();
+    state->body = &body;
+    state->count = count;
+    const std::size_t target_chunks = threads * kChunksPerThread;
+    state->chunk_size = std::max<std::size_t>(1, (count + target_chunks - 1) / target_chunks);
+    state->num_chunks = (count + state->chunk_size - 1) / state->chunk_size;
+
+    // Helpers that start after all chunks are claimed return without touching
+    // body, so they may safely outlive this call.
+    {
+        std::lock_guard<std::mutex> guard(mutex_);
+        for (std::size_t i = 0; i + 1 < threads; ++i) {
+            tasks_.emplace_back([state] { run_chunks(*state); });
+        }
+    }
+    cv_.notify_all();
+
+    run_chunks(*state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->completed == state->num_chunks; });
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+std::size_t ThreadPool::num_workers() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return workers_.size();
+}
+
+void ThreadPool::ensure_workers(std::size_t count) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    while (workers_.size() < count) {
+        workers_.emplace_back([this] { worker_loop(); });
+    }
+}
+
+void ThreadPool::worker_loop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this] { return !tasks_.empty(); });
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        try {
+            task();
+        } catch (...) {
+            // Tasks report their own failures; never let one kill a worker.
+        }
+    }
+}
+
+unsigned int default_num_threads() {
+    return default_threads_storage().load(std::memory_order_relaxed);
+}
+
+void set_default_num_threads(int num_threads) {
+    default_threads_storage().store(
+        num_threads > 0 ? static_cast<unsigned int>(num_threads)
+                        : hardware_threads(),
+        std::memory_order_relaxed);
+}
+
+unsigned int resolve_num_threads(int num_threads) {
+    return num_threads > 0 ? static_cast<unsigned int>(num_threads)
+                           : default_num_threads();
+}
+
+void parallel_for(std::size_t count, int num_threads,
+                  const ThreadPool::RangeFunction& body) {
+    ThreadPool::instance().parallel_for(count, resolve_num_threads(num_threads),
+                                        body);
+}
+
+} // namespace rdktools
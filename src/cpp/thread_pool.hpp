@@ -0,0 +1,94 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief Process-wide worker pool shared by every batch entry point.
+ *
+ * Workers are started lazily and reused across calls. parallel_for() lets the
+ * calling thread take part in the work, so it is safe to call from inside a
+ * pool task without deadlocking.
+ */
+class ThreadPool {
+public:
+    using RangeFunction = std::function<void(std::size_t, std::size_t)>;
+
+    /**
+     * @brief Access the shared pool instance
+     */
+    static ThreadPool& instance();
+
+    /**
+     * @brief Queue a task for execution on a worker thread
+     * @param task callable to run; exceptions escaping it are discarded
+     */
+    void enqueue(std::function<void()> task);
+
+    /**
+     * @brief Split [0, count) into chunks and run them on up to num_threads threads
+     * @param count number of items to process
+     * @param num_threads maximum number of participating threads (including the
+     *        caller), capped at four per hardware thread
+     * @param body callable invoked as body(begin, end) for each chunk
+     *
+     * The first exception thrown by body is rethrown on the calling thread once
+     * every started chunk has finished.
+     */
+    void parallel_for(std::size_t count, unsigned int num_threads,
+                      const RangeFunction& body);
+
+    /**
+     * @brief Number of worker threads currently started
+     */
+    std::size_t num_workers();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+private:
+    ThreadPool() = default;
+
+    void ensure_workers(std::size_t count);
+    void worker_loop();
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> tasks_;
+    std::vector<std::thread> workers_;
+};
+
+/**
+ * @brief Current module-level default thread count
+ *
+ * Initialised from the RDKTOOLS_NUM_THREADS environment variable when set,
+ * otherwise from std::thread::hardware_concurrency().
+ */
+unsigned int default_num_threads();
+
+/**
+ * @brief Override the module-level default thread count
+ * @param num_threads new default; values <= 0 restore the hardware default
+ */
+void set_default_num_threads(int num_threads);
+
+/**
+ * @brief Map a user-facing num_threads argument to a concrete thread count
+ * @param num_threads requested count; values <= 0 select the module default
+ */
+unsigned int resolve_num_threads(int num_threads);
+
+/**
+ * @brief Convenience wrapper around ThreadPool::instance().parallel_for()
+ */
+void parallel_for(std::size_t count, int num_threads,
+                  const ThreadPool::RangeFunction& body);
+
+} // namespace rdktools
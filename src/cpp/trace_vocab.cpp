@@ -0,0 +1,203 @@
+#include "trace_vocab.hpp"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace rdktools {
+
+namespace {
+
+constexpr const char* kCountSign = "\xC3\x97";
+constexpr const char* kArrow = "\xE2\x86\x92";
+
+bool is_environment(const std::string& token) {
+    return token.find(':') != std::string::npos;
+}
+
+} // namespace
+
+const std::vector<std::string>& fixed_trace_tokens() {
+    static const std::vector<std::string> tokens = [] {
+        std::vector<std::string> result = {"[PAD]", "[UNK]", "\n", "# per-center chains",
+                                           kCountSign, kArrow};
+        for (char digit = '0'; digit <= '9'; ++digit) {
+            result.emplace_back(1, digit);
+        }
+        for (unsigned int radius = 0; radius <= kMaxTokenRadius; ++radius) {
+            result.push_back("r" + std::to_string(radius) + ":");
+        }
+        return result;
+    }();
+    return tokens;
+}
+
+TraceVocabulary::TraceVocabulary() {
+    assign(fixed_trace_tokens(), false);
+}
+
+TraceVocabulary::TraceVocabulary(const std::vector<std::string>& tokens, bool frozen) {
+    assign(tokens, frozen);
+}
+
+std::int32_t TraceVocabulary::id(const std::string& token) {
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const auto it = ids_.find(token);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        if (frozen_) {
+            return kUnknownToken;
+        }
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (frozen_) {
+        const auto it = ids_.find(token);
+        return it == ids_.end() ? kUnknownToken : it->second;
+    }
+    const auto inserted = ids_.emplace(token, static_cast<std::int32_t>(tokens_.size()));
+    if (inserted.second) {
+        tokens_.push_back(token);
+    }
+    return inserted.first->second;
+}
+
+std::int32_t TraceVocabulary::find(const std::string& token) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const auto it = ids_.find(token);
+    if (it != ids_.end()) {
+        return it->second;
+    }
+    return frozen_ ? kUnknownToken : -1;
+}
+
+std::vector<std::string> TraceVocabulary::tokens() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return tokens_;
+}
+
+std::size_t TraceVocabulary::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return tokens_.size();
+}
+
+bool TraceVocabulary::frozen() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return frozen_;
+}
+
+void TraceVocabulary::assign(const std::vector<std::string>& tokens, bool frozen) {
+    const std::vector<std::string>& fixed = fixed_trace_tokens();
+    if (tokens.size() < fixed.size() ||
+        !std::equal(fixed.begin(), fixed.end(), tokens.begin())) {
+        throw std::invalid_argument(
+            "trace vocabulary must start with the fixed tokens of trace_vocabulary()");
+    }
+    std::unordered_map<std::string, std::int32_t> ids;
+    ids.reserve(tokens.size());
+    for (std::size_t i = 0; i < tokens.size(); ++i) {
+        if (!ids.emplace(tokens[i], static_cast<std::int32_t>(i)).second) {
+            throw std::invalid_argument("trace vocabulary repeats the token '" + tokens[i] +
+                                        "'");
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    tokens_ = tokens;
+    ids_ = std::move(ids);
+    frozen_ = frozen;
+    generation_.fetch_add(1, std::memory_order_relaxed);
+}
+
+std::uint64_t TraceVocabulary::generation() const {
+    return generation_.load(std::memory_order_relaxed);
+}
+
+std::string TraceVocabulary::decode(const std::int32_t* ids, std::size_t count) const {
+    enum class Line { Start, Radius, Chain };
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::string text;
+    Line line = Line::Start;
+    bool first_item = true;
+    for (std::size_t i = 0; i < count; ++i) {
+        const std::int32_t id = ids[i];
+        if (id < 0 || static_cast<std::size_t>(id) >= tokens_.size()) {
+            throw std::invalid_argument("token id " + std::to_string(id) +
+                                        " is outside the trace vocabulary");
+        }
+        if (id == kPadToken) {
+            continue;
+        }
+        if (id == kNewlineToken) {
+            text.push_back('\n');
+            line = Line::Start;
+            continue;
+        }
+        if (id == kChainsToken || (id >= kFirstDigitToken && id < kFirstRadiusToken)) {
+            text.append(tokens_[id]);
+            continue;
+        }
+        if (id == kCountToken) {
+            text.append(kCountSign);
+            continue;
+        }
+        if (id == kArrowToken) {
+            text.append(" ").append(kArrow).append(" ");
+            continue;
+        }
+        if (id >= kFirstRadiusToken && id < kNumFixedTokens && line == Line::Start) {
+            text.append(tokens_[id]).push_back(' ');
+            line = Line::Radius;
+            first_item = true;
+            continue;
+        }
+        // An atom symbol opens a chain line; anything else is an environment
+        // (or [UNK] standing in for one)
+        const std::string& token = tokens_[id];
+        if (line == Line::Start && !is_environment(token)) {
+            text.append(token);
+            line = Line::Chain;
+            first_item = true;
+            continue;
+        }
+        if (first_item) {
+            if (line == Line::Chain) {
+                text.append(": ");
+            }
+            first_item = false;
+        } else if (line == Line::Radius) {
+            text.append(", ");
+        }
+        text.append(token);
+    }
+    return text;
+}
+
+TraceVocabulary& trace_vocabulary() {
+    static TraceVocabulary vocabulary;
+    return vocabulary;
+}
+
+std::int32_t radius_token(unsigned int radius) {
+    if (radius > kMaxTokenRadius) {
+        throw std::invalid_argument("tokenized traces support radius up to " +
+                                    std::to_string(kMaxTokenRadius));
+    }
+    return kFirstRadiusToken + static_cast<std::int32_t>(radius);
+}
+
+void append_number_tokens(std::uint64_t value, std::vector<std::int32_t>& out) {
+    char digits[20];
+    std::size_t n = 0;
+    do {
+        digits[n++] = static_cast<char>(value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (n > 0) {
+        out.push_back(kFirstDigitToken + digits[--n]);
+    }
+}
+
+} // namespace rdktools
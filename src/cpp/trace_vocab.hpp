@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace rdktools {
+
+/**
+ * @brief Token ids every trace vocabulary starts with
+ *
+ * A tokenized trace follows the text trace line by line: radius lines are
+ * a radius marker followed by (environment, count sign, count digits)
+ * items, chain lines are the atom symbol, its index digits and the
+ * environments separated by arrows, and Newline ends every line but the
+ * last. Environments ("r<radius>:<SMARTS>") and atom symbols get ids after
+ * the fixed block in first-seen order.
+ */
+inline constexpr std::int32_t kPadToken = 0;
+inline constexpr std::int32_t kUnknownToken = 1;
+inline constexpr std::int32_t kNewlineToken = 2;
+inline constexpr std::int32_t kChainsToken = 3;  // "# per-center chains"
+inline constexpr std::int32_t kCountToken = 4;   // the multiplication sign
+inline constexpr std::int32_t kArrowToken = 5;   // chain arrow
+inline constexpr std::int32_t kFirstDigitToken = 6;    // "0" .. "9"
+inline constexpr std::int32_t kFirstRadiusToken = 16;  // "r0:" .. "r15:"
+inline constexpr unsigned int kMaxTokenRadius = 15;
+inline constexpr std::int32_t kNumFixedTokens =
+    kFirstRadiusToken + static_cast<std::int32_t>(kMaxTokenRadius) + 1;
+
+/**
+ * @brief Text of the fixed tokens, indexed by id
+ */
+const std::vector<std::string>& fixed_trace_tokens();
+
+/**
+ * @brief Thread-safe mapping between trace pieces and int32 token ids
+ *
+ * Ids are append-only while the vocabulary grows, so ids handed out earlier
+ * stay valid. New ids follow the order id() is called, so they depend on
+ * what a process has seen; export tokens() and load it frozen where ids must
+ * agree across processes. A frozen vocabulary maps unseen pieces to
+ * kUnknownToken.
+ */
+class TraceVocabulary {
+public:
+    /**
+     * @brief Growing vocabulary holding only the fixed tokens
+     */
+    TraceVocabulary();
+
+    /**
+     * @brief Vocabulary with the given id order, e.g. one exported by tokens()
+     * @throws std::invalid_argument if tokens does not start with
+     *         fixed_trace_tokens() or repeats an entry
+     */
+    TraceVocabulary(const std::vector<std::string>& tokens, bool frozen);
+
+    TraceVocabulary(const TraceVocabulary&) = delete;
+    TraceVocabulary& operator=(const TraceVocabulary&) = delete;
+
+    /**
+     * @brief Id of an environment or atom symbol, adding it unless frozen
+     */
+    std::int32_t id(const std::string& token);
+
+    /**
+     * @brief Id of a token without adding it
+     * @return the id, kUnknownToken for a piece a frozen vocabulary lacks,
+     *         or -1 for a piece a growing vocabulary has not seen yet
+     */
+    std::int32_t find(const std::string& token) const;
+
+    /**
+     * @brief Every token in id order
+     */
+    std::vector<std::string> tokens() const;
+
+    std::size_t size() const;
+
+    bool frozen() const;
+
+    /**
+     * @brief Replace the contents, as the (tokens, frozen) constructor does
+     *
+     * Bumps generation(), so results cached under the old ids are not reused.
+     */
+    void assign(const std::vector<std::string>& tokens, bool frozen);
+
+    /**
+     * @brief Counter bumped by assign(); part of the result-cache tag of
+     *        tokenized traces
+     */
+    std::uint64_t generation() const;
+
+    /**
+     * @brief Rebuild the text trace a token sequence was encoded from
+     * @throws std::invalid_argument for ids outside the vocabulary
+     */
+    std::string decode(const std::int32_t* ids, std::size_t count) const;
+
+private:
+    mutable std::shared_mutex mutex_;
+    std::vector<std::string> tokens_;
+    std::unordered_map<std::string, std::int32_t> ids_;
+    bool frozen_ = false;
+    std::atomic<std::uint64_t> generation_{0};
+};
+
+/**
+ * @brief Vocabulary shared by every tokenized trace of this process
+ */
+TraceVocabulary& trace_vocabulary();
+
+/**
+ * @brief Marker token starting the radius line of layer radius
+ * @throws std::invalid_argument if radius exceeds kMaxTokenRadius
+ */
+std::int32_t radius_token(unsigned int radius);
+
+/**
+ * @brief Append the decimal digits of value as digit tokens
+ */
+void append_number_tokens(std::uint64_t value, std::vector<std::int32_t>& out);
+
+} // namespace rdktools
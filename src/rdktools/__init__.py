@@ -5,13 +5,19 @@ This module provides fast molecular descriptor calculations, SMILES validation,
 generation by exposing RDKit's optimized C++ implementation with native numpy array support.
 """
 
-from typing import Dict, Tuple
+import asyncio
+import atexit
+import concurrent.futures
+import os
+import threading
+from typing import Any, Dict, List, Optional, Sequence, Tuple
 
 import numpy as np
 
 # Import the compiled C++ extension
 try:
     from . import _rdktools_core
+    from ._rdktools_core import FingerprintDB, MolBatch, SmilesFileReader
 
     _EXTENSION_AVAILABLE = True
 except ImportError as e:
@@ -28,115 +34,569 @@ def _check_extension():
         )
 
 
-def _validate_smiles_input(smiles) -> np.ndarray:
-    """Convert and validate SMILES input to numpy string array."""
+def _is_mol_batch(value) -> bool:
+    """Return True if value is a pre-parsed MolBatch."""
+    return _EXTENSION_AVAILABLE and isinstance(value, MolBatch)
+
+
+def _float_dtype_name(dtype) -> str:
+    """Return 'float32' or 'float64' for a numpy float dtype."""
+    dtype_name = np.dtype(dtype).name
+    if dtype_name not in ("float32", "float64"):
+        raise ValueError("dtype must be float32 or float64")
+    return dtype_name
+
+
+def _prepare_input(smiles):
+    """Pass MolBatch objects through; validate anything else as SMILES."""
+    if _is_mol_batch(smiles):
+        return smiles
+    return _validate_smiles_input(smiles)
+
+
+_ARROW_STRING_TYPES = ("string", "large_string", "utf8", "large_utf8")
+
+
+def _is_arrow_array(value) -> bool:
+    """Return True for Arrow arrays exporting the C data interface."""
+    return hasattr(value, "__arrow_c_array__") or hasattr(value, "combine_chunks")
+
+
+def _prepare_arrow_input(smiles):
+    """Normalise an Arrow (chunked) array to a single string array."""
+    if hasattr(smiles, "combine_chunks"):
+        smiles = smiles.chunk(0) if smiles.num_chunks == 1 else smiles.combine_chunks()
+    arrow_type = getattr(smiles, "type", None)
+    if arrow_type is not None and str(arrow_type) not in _ARROW_STRING_TYPES:
+        smiles = smiles.cast("large_string")
+    return smiles
+
+
+def _validate_smiles_input(smiles):
+    """
+    Convert and validate SMILES input.
+
+    numpy ``U``/``S`` arrays and Arrow string arrays are passed through as-is
+    and read by the extension without copying; other inputs become a numpy
+    string array.
+    """
     if isinstance(smiles, (list, tuple)):
         smiles = np.array(smiles, dtype=str)
     elif isinstance(smiles, str):
         smiles = np.array([smiles], dtype=str)
     elif isinstance(smiles, np.ndarray):
-        smiles = smiles.astype(str)
+        if smiles.dtype.kind not in "US":
+            smiles = smiles.astype(str)
+    elif _is_arrow_array(smiles):
+        smiles = _prepare_arrow_input(smiles)
     else:
-        raise TypeError("SMILES input must be string, list, or numpy array")
+        raise TypeError("SMILES input must be string, list, numpy or Arrow array")
 
     return smiles
 
 
+def _as_numpy_smiles(smiles) -> np.ndarray:
+    """Materialise validated SMILES input as a numpy array for slicing."""
+    if isinstance(smiles, np.ndarray):
+        return smiles
+    return np.array(
+        ["" if value is None else value for value in smiles.to_pylist()], dtype=str
+    )
+
+
+def _resolve_num_threads(num_threads: Optional[int]) -> int:
+    """Map the public num_threads argument onto the extension convention."""
+    if num_threads is None:
+        return 0
+    if not isinstance(num_threads, int):
+        raise TypeError("num_threads must be an int or None")
+    return num_threads
+
+
+# Thread pool configuration
+def set_num_threads(num_threads: int) -> None:
+    """
+    Set the default number of worker threads used by batch functions.
+
+    Args:
+        num_threads: Thread count. Non-positive values restore the default of
+            one thread per hardware core (or ``RDKTOOLS_NUM_THREADS`` if set).
+    """
+    _check_extension()
+    _rdktools_core.set_num_threads(_resolve_num_threads(num_threads))
+
+
+def get_num_threads() -> int:
+    """Return the default number of worker threads used by batch functions."""
+    _check_extension()
+    return _rdktools_core.get_num_threads()
+
+
+def set_trace_cache_capacity(capacity: int) -> None:
+    """
+    Bound the caches behind reasoning traces.
+
+    Environment SMARTS and the fragment metrics used to order tokens are
+    cached across molecules and threads. Each cache evicts its oldest entries
+    once full, so long-running jobs keep a flat memory footprint; traces are
+    identical whatever the capacity. The initial
+    capacity is ``RDKTOOLS_TRACE_CACHE_SIZE`` when set, otherwise 65536.
+
+    Args:
+        capacity: Maximum number of entries per cache (rounded up to a
+            multiple of 16); 0 disables caching.
+    """
+    _check_extension()
+    if capacity < 0:
+        raise ValueError("capacity must be non-negative")
+    _rdktools_core.set_trace_cache_capacity(capacity)
+
+
+def get_trace_cache_capacity() -> int:
+    """Return the capacity of each reasoning trace cache."""
+    _check_extension()
+    return _rdktools_core.get_trace_cache_capacity()
+
+
+def set_result_cache_capacity(capacity_bytes: int) -> None:
+    """
+    Bound the cross-call result cache.
+
+    Descriptors, fingerprints and reasoning traces computed from SMILES input
+    are cached per (function, parameters, SMILES), so repeated molecules skip
+    parsing and featurization on later calls. Once full, rarely hit entries
+    are evicted first. ``MolBatch`` input bypasses the cache. The initial
+    capacity is ``RDKTOOLS_RESULT_CACHE_BYTES`` when set, otherwise 0.
+
+    Args:
+        capacity_bytes: Approximate memory budget in bytes; 0 disables the
+            cache and drops its entries.
+    """
+    _check_extension()
+    if capacity_bytes < 0:
+        raise ValueError("capacity_bytes must be non-negative")
+    _rdktools_core.set_result_cache_capacity(capacity_bytes)
+
+
+def get_result_cache_capacity() -> int:
+    """Return the capacity of the result cache in bytes."""
+    _check_extension()
+    return _rdktools_core.get_result_cache_capacity()
+
+
+def result_cache_stats() -> Dict[str, int]:
+    """
+    Return result cache counters.
+
+    Returns:
+        Dict with ``hits``, ``misses``, ``evictions``, ``entries``, ``bytes``
+        and ``capacity``.
+    """
+    _check_extension()
+    return dict(_rdktools_core.result_cache_stats())
+
+
+def clear_result_cache() -> None:
+    """Drop every cached result and reset the counters."""
+    _check_extension()
+    _rdktools_core.clear_result_cache()
+
+
+def get_stats() -> Dict[str, Any]:
+    """
+    Return hot-path counters and per-stage timings.
+
+    Totals cover every batch function called since the last
+    :func:`reset_stats`, across all worker threads, including the TensorFlow
+    ops, which also report the stages as profiler (TraceMe) activities.
+
+    Returns:
+        Dict with ``enabled`` (False when the extension was built with
+        ``RDKTOOLS_ENABLE_STATS=OFF``, in which case everything is zero),
+        ``counters`` (``molecules_parsed``, ``invalid_smiles``,
+        ``exceptions``, hit/miss counts of the result, SMARTS and metrics
+        caches, and ``substructure_prescreen_rejects`` /
+        ``substructure_match_calls``) and ``stages``, mapping ``parse``,
+        ``morgan``, ``environment_smarts``, ``token_metrics``, ``format``,
+        ``descriptors``, ``formula`` and ``substructure`` to
+        ``{"calls": int, "seconds": float}``.
+        ``token_metrics`` time is also included in ``format``.
+    """
+    _check_extension()
+    stats = _rdktools_core.get_stats()
+    return {
+        "enabled": bool(stats["enabled"]),
+        "counters": dict(stats["counters"]),
+        "stages": {name: dict(stage) for name, stage in stats["stages"].items()},
+    }
+
+
+def reset_stats() -> None:
+    """Zero the counters and stage timers reported by :func:`get_stats`."""
+    _check_extension()
+    _rdktools_core.reset_stats()
+
+
+# Parse-once input
+def parse_smiles(smiles, num_threads: Optional[int] = None) -> "MolBatch":
+    """
+    Parse and sanitize SMILES strings once for reuse across batch functions.
+
+    Every descriptor, fingerprint and trace function accepts the returned
+    ``MolBatch`` in place of a SMILES array, skipping repeated parsing.
+
+    Args:
+        smiles: Array-like of SMILES strings or a MolBatch
+        num_threads: Worker threads to use. ``None`` uses the module default.
+
+    Returns:
+        MolBatch holding one molecule per input row. Use ``batch.valid`` for
+        the boolean validity mask; invalid rows produce NaN or zero results.
+    """
+    _check_extension()
+    smiles = _validate_smiles_input(smiles)
+    return MolBatch(smiles, _resolve_num_threads(num_threads))
+
+
+def smiles_to_pickles(
+    smiles, num_threads: Optional[int] = None, *, as_buffer: bool = False
+):
+    """
+    Parse SMILES once and serialize the molecules as RDKit binary pickles.
+
+    Pickles rebuild a molecule without re-running SMILES parsing and
+    sanitization; store them next to a dataset and load them with
+    :func:`parse_pickles` or the TF ops' ``input_format="pickle"``.
+
+    Args:
+        smiles: Array-like of SMILES strings or a MolBatch
+        num_threads: Worker threads to use. ``None`` uses the module default.
+        as_buffer: Return one concatenated buffer with offsets instead of a
+            list of ``bytes``.
+
+    Returns:
+        List of ``bytes`` with one pickle per row (empty for invalid SMILES),
+        or with ``as_buffer`` a ``(buffer, offsets)`` tuple of a uint8 array
+        and an int64 array of length N + 1; row ``i`` is
+        ``buffer[offsets[i]:offsets[i + 1]]``.
+    """
+    _check_extension()
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.smiles_to_pickles(
+        smiles, _resolve_num_threads(num_threads), bool(as_buffer)
+    )
+
+
+def parse_pickles(
+    pickles, offsets=None, num_threads: Optional[int] = None
+) -> "MolBatch":
+    """
+    Rebuild molecules from RDKit pickles for reuse across batch functions.
+
+    Args:
+        pickles: Sequence of ``bytes`` (``None`` or empty bytes mark invalid
+            rows), a pyarrow binary array, or together with ``offsets`` one
+            contiguous buffer (``bytes`` or a uint8 array).
+        offsets: Optional int64 array of length N + 1 slicing ``pickles``
+            into rows, as returned by ``smiles_to_pickles(as_buffer=True)``.
+        num_threads: Worker threads to use. ``None`` uses the module default.
+
+    Returns:
+        MolBatch accepted by every function that takes a SMILES array. Rows
+        whose pickle is empty or unreadable are invalid.
+    """
+    _check_extension()
+    if offsets is not None:
+        if isinstance(pickles, (bytes, bytearray, memoryview)):
+            pickles = np.frombuffer(pickles, dtype=np.uint8)
+        pickles = np.ascontiguousarray(pickles, dtype=np.uint8)
+        offsets = np.ascontiguousarray(offsets, dtype=np.int64)
+        if pickles.ndim != 1 or offsets.ndim != 1:
+            raise ValueError("pickle buffer and offsets must be 1D")
+    elif isinstance(pickles, np.ndarray):
+        pickles = pickles.tolist()
+    return MolBatch.from_pickles(pickles, offsets, _resolve_num_threads(num_threads))
+
+
 # Core descriptor functions
-def molecular_weights(smiles) -> np.ndarray:
+def molecular_weights(
+    smiles,
+    num_threads: Optional[int] = None,
+    *,
+    dedup: bool = False,
+    dtype=np.float64,
+    out: Optional[np.ndarray] = None,
+) -> np.ndarray:
     """
     Calculate molecular weights for an array of SMILES strings.
 
     Args:
-        smiles: Array-like of SMILES strings
+        smiles: Array-like of SMILES strings or a MolBatch
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        dedup: Compute each distinct SMILES once and copy its result to the
+            repeated rows. Ignored for MolBatch input.
+        dtype: ``np.float64`` (default) or ``np.float32``.
+        out: Optional preallocated C-contiguous array with the exact result
+            shape and dtype. Results are written into it in place and it is
+            returned, so no per-call buffer is allocated.
 
     Returns:
-        numpy array of molecular weights (float64). Invalid SMILES return NaN.
+        numpy array of molecular weights (``dtype``, float64 by default).
+        Invalid SMILES return NaN.
     """
     _check_extension()
-    smiles = _validate_smiles_input(smiles)
-    return _rdktools_core.calculate_molecular_weights(smiles)
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.calculate_molecular_weights(
+        smiles,
+        _resolve_num_threads(num_threads),
+        bool(dedup),
+        _float_dtype_name(dtype),
+        out,
+    )
 
 
-def logp(smiles) -> np.ndarray:
+def logp(
+    smiles,
+    num_threads: Optional[int] = None,
+    *,
+    dedup: bool = False,
+    dtype=np.float64,
+    out: Optional[np.ndarray] = None,
+) -> np.ndarray:
     """
     Calculate LogP values for an array of SMILES strings.
 
     Args:
-        smiles: Array-like of SMILES strings
+        smiles: Array-like of SMILES strings or a MolBatch
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        dedup: Compute each distinct SMILES once and copy its result to the
+            repeated rows. Ignored for MolBatch input.
+        dtype: ``np.float64`` (default) or ``np.float32``.
+        out: Optional preallocated C-contiguous array with the exact result
+            shape and dtype. Results are written into it in place and it is
+            returned, so no per-call buffer is allocated.
 
     Returns:
-        numpy array of LogP values (float64). Invalid SMILES return NaN.
+        numpy array of LogP values (``dtype``, float64 by default).
+        Invalid SMILES return NaN.
     """
     _check_extension()
-    smiles = _validate_smiles_input(smiles)
-    return _rdktools_core.calculate_logp(smiles)
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.calculate_logp(
+        smiles,
+        _resolve_num_threads(num_threads),
+        bool(dedup),
+        _float_dtype_name(dtype),
+        out,
+    )
 
 
-def tpsa(smiles) -> np.ndarray:
+def tpsa(
+    smiles,
+    num_threads: Optional[int] = None,
+    *,
+    dedup: bool = False,
+    dtype=np.float64,
+    out: Optional[np.ndarray] = None,
+) -> np.ndarray:
     """
     Calculate TPSA (Topological Polar Surface Area) for an array of SMILES strings.
 
     Args:
-        smiles: Array-like of SMILES strings
+        smiles: Array-like of SMILES strings or a MolBatch
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        dedup: Compute each distinct SMILES once and copy its result to the
+            repeated rows. Ignored for MolBatch input.
+        dtype: ``np.float64`` (default) or ``np.float32``.
+        out: Optional preallocated C-contiguous array with the exact result
+            shape and dtype. Results are written into it in place and it is
+            returned, so no per-call buffer is allocated.
 
     Returns:
-        numpy array of TPSA values (float64). Invalid SMILES return NaN.
+        numpy array of TPSA values (``dtype``, float64 by default).
+        Invalid SMILES return NaN.
     """
     _check_extension()
-    smiles = _validate_smiles_input(smiles)
-    return _rdktools_core.calculate_tpsa(smiles)
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.calculate_tpsa(
+        smiles,
+        _resolve_num_threads(num_threads),
+        bool(dedup),
+        _float_dtype_name(dtype),
+        out,
+    )
 
 
 # Validation functions
-def is_valid(smiles) -> np.ndarray:
+VALIDATION_LEVELS = ("syntax", "valence", "full")
+
+
+def is_valid(
+    smiles,
+    num_threads: Optional[int] = None,
+    *,
+    level: str = "full",
+    out: Optional[np.ndarray] = None,
+) -> np.ndarray:
     """
     Check if SMILES strings are valid.
 
     Args:
-        smiles: Array-like of SMILES strings
+        smiles: Array-like of SMILES strings or a MolBatch
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        level: How much to check. ``"syntax"`` only parses the string,
+            ``"valence"`` also rejects impossible valences and aromatic
+            systems that cannot be kekulized, and ``"full"`` (default) runs
+            complete sanitization. Lower levels are cheaper pre-filters and
+            accept a superset of the strings accepted by higher ones. A
+            MolBatch reports its full-sanitization mask at every level.
+        out: Optional preallocated C-contiguous bool array with the exact
+            result shape. Results are written into it in place and it is
+            returned, so no per-call buffer is allocated.
 
     Returns:
         numpy array of boolean values indicating validity.
+
+    Raises:
+        ValueError: For unknown levels.
     """
     _check_extension()
-    smiles = _validate_smiles_input(smiles)
-    return _rdktools_core.validate_smiles(smiles)
+    if level not in VALIDATION_LEVELS:
+        raise ValueError("level must be 'syntax', 'valence' or 'full'")
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.validate_smiles(
+        smiles, _resolve_num_threads(num_threads), level, out
+    )
 
 
-def canonical_smiles(smiles) -> np.ndarray:
+def canonical_smiles(
+    smiles, num_threads: Optional[int] = None, *, dedup: bool = False
+) -> np.ndarray:
     """
     Convert SMILES to canonical form.
 
     Args:
-        smiles: Array-like of SMILES strings
+        smiles: Array-like of SMILES strings or a MolBatch
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        dedup: Compute each distinct SMILES once and copy its result to the
+            repeated rows. Ignored for MolBatch input.
 
     Returns:
         numpy array of canonical SMILES strings. Invalid SMILES return empty strings.
     """
     _check_extension()
-    smiles = _validate_smiles_input(smiles)
-    return _rdktools_core.canonicalize_smiles(smiles)
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.canonicalize_smiles(
+        smiles, _resolve_num_threads(num_threads), bool(dedup)
+    )
 
 
 # Batch processing functions
-def descriptors(smiles) -> Dict[str, np.ndarray]:
+def descriptors(
+    smiles,
+    num_threads: Optional[int] = None,
+    *,
+    dedup: bool = False,
+    out: Optional[Tuple[np.ndarray, np.ndarray, np.ndarray]] = None,
+) -> Dict[str, np.ndarray]:
     """
     Calculate multiple descriptors efficiently in one pass.
 
     Args:
-        smiles: Array-like of SMILES strings
+        smiles: Array-like of SMILES strings or a MolBatch
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        dedup: Compute each distinct SMILES once and copy its result to the
+            repeated rows. Ignored for MolBatch input.
+        out: Optional ``(molecular_weight, logp, tpsa)`` tuple of
+            preallocated C-contiguous float64 arrays of length
+            ``len(smiles)``. Results are written into them in place and they
+            are the returned values.
 
     Returns:
         Dictionary with keys: 'molecular_weight', 'logp', 'tpsa'
         Each value is a numpy array. Invalid SMILES have NaN values.
     """
     _check_extension()
-    smiles = _validate_smiles_input(smiles)
-    return _rdktools_core.calculate_multiple_descriptors(smiles)
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.calculate_multiple_descriptors(
+        smiles,
+        _resolve_num_threads(num_threads),
+        bool(dedup),
+        tuple(out) if out is not None else None,
+    )
+
+
+def calculate_descriptors(
+    smiles,
+    names: Optional[Sequence[str]] = None,
+    dtype=np.float32,
+    num_threads: Optional[int] = None,
+    *,
+    dedup: bool = False,
+    out: Optional[np.ndarray] = None,
+) -> np.ndarray:
+    """
+    Calculate named descriptors into one contiguous ``N x D`` matrix.
+
+    Names are resolved once against the native registry (see
+    :func:`descriptor_names`), each molecule is parsed once, and descriptors
+    sharing intermediates (Crippen LogP/MR, ring counts) compute them once per
+    molecule.
+
+    Args:
+        smiles: Array-like of SMILES strings or a MolBatch
+        names: Descriptor names in column order. ``None`` selects every
+            registered descriptor.
+        dtype: ``np.float32`` (default) or ``np.float64``.
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        dedup: Compute each distinct SMILES once and copy its result to the
+            repeated rows. Ignored for MolBatch input.
+        out: Optional preallocated C-contiguous array with the exact result
+            shape and dtype. Results are written into it in place and it is
+            returned, so no per-call buffer is allocated.
+
+    Returns:
+        Row-major array of shape ``(len(smiles), len(names))``. Invalid SMILES
+        have NaN rows.
 
+    Raises:
+        ValueError: For unknown descriptor names, unsupported dtypes or an
+            ``out`` array that does not match the result.
+    """
+    _check_extension()
+    if isinstance(names, str):
+        names = [names]
+    names = [] if names is None else [str(name) for name in names]
+    dtype_name = _float_dtype_name(dtype)
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.calculate_descriptors(
+        smiles, names, dtype_name, _resolve_num_threads(num_threads), bool(dedup), out
+    )
+
+
+def descriptor_names() -> List[str]:
+    """Names accepted by :func:`calculate_descriptors`, in registry order."""
+    _check_extension()
+    return list(_rdktools_core.descriptor_names())
 
-def morgan_fingerprints(smiles, radius: int = 2, nbits: int = 2048) -> np.ndarray:
+
+def morgan_fingerprints(
+    smiles,
+    radius: int = 2,
+    nbits: int = 2048,
+    num_threads: Optional[int] = None,
+    *,
+    packed: Optional[str] = None,
+    dedup: bool = False,
+    out: Optional[np.ndarray] = None,
+) -> np.ndarray:
     """
     Calculate Morgan fingerprints for an array of SMILES strings.
 
@@ -144,39 +604,171 @@ def morgan_fingerprints(smiles, radius: int = 2, nbits: int = 2048) -> np.ndarra
         smiles: Array-like of SMILES strings
         radius: Fingerprint radius (default: 2)
         nbits: Number of bits in fingerprint (default: 2048)
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+
+        packed: Optional packed layout. ``"bytes"`` returns
+            ``ceil(nbits / 8)`` uint8 columns in ``np.packbits`` order, so
+            ``np.unpackbits(fps, axis=1, count=nbits)`` recovers the dense
+            matrix. ``"uint64"`` returns ``ceil(nbits / 64)`` uint64 columns
+            with bit ``i`` at position ``i % 64`` of word ``i // 64``.
+        dedup: Compute each distinct SMILES once and copy its result to the
+            repeated rows. Ignored for MolBatch input.
+        out: Optional preallocated C-contiguous array with the exact result
+            shape and dtype. Results are written into it in place and it is
+            returned, so no per-call buffer is allocated.
 
     Returns:
-        2D numpy array of shape (n_molecules, nbits) with uint8 values (0 or 1).
-        Invalid SMILES have all-zero fingerprints.
+        2D numpy array of shape (n_molecules, nbits) with uint8 values (0 or 1),
+        or the packed matrix described above. Invalid SMILES have all-zero
+        fingerprints.
     """
     _check_extension()
-    smiles = _validate_smiles_input(smiles)
-    return _rdktools_core.calculate_morgan_fingerprints(smiles, radius, nbits)
+    smiles = _prepare_input(smiles)
+    if packed is not None and packed not in ("bytes", "uint64"):
+        raise ValueError("packed must be None, 'bytes' or 'uint64'")
+    return _rdktools_core.calculate_morgan_fingerprints(
+        smiles,
+        radius,
+        nbits,
+        _resolve_num_threads(num_threads),
+        packed or "dense",
+        bool(dedup),
+        out,
+    )
+
+
+def morgan_fingerprints_sparse(
+    smiles,
+    radius: int = 2,
+    nbits: int = 2048,
+    num_threads: Optional[int] = None,
+    *,
+    unfolded: bool = False,
+    hash_bits: int = 32,
+    counts: bool = False,
+) -> Dict[str, np.ndarray]:
+    """
+    Calculate Morgan fingerprints as CSR sparse rows.
+
+    Args:
+        smiles: Array-like of SMILES strings or a MolBatch
+        radius: Fingerprint radius (default: 2)
+        nbits: Fold size. Folded indices are exactly the set bits of
+            :func:`morgan_fingerprints` with the same ``nbits``.
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        unfolded: Return the raw Morgan hash ids instead of folding them, so
+            distinct environments never collide. ``nbits`` is ignored.
+        hash_bits: Width of unfolded ids, 32 or 64.
+        counts: Also return how often each id occurs in the molecule.
+
+    Returns:
+        Dictionary with ``indptr`` (int64, length n_molecules + 1), ``indices``
+        (uint32, or uint64 when ``unfolded`` and ``hash_bits=64``) and, when
+        ``counts`` is true, ``counts`` (uint32). Row ``i`` spans
+        ``indices[indptr[i]:indptr[i + 1]]`` in ascending order, which is the
+        layout ``scipy.sparse.csr_matrix`` expects. Invalid SMILES yield empty
+        rows.
+    """
+    _check_extension()
+    smiles = _prepare_input(smiles)
+    if unfolded and hash_bits not in (32, 64):
+        raise ValueError("hash_bits must be 32 or 64")
+    return _rdktools_core.calculate_morgan_sparse(
+        smiles,
+        radius,
+        nbits,
+        _resolve_num_threads(num_threads),
+        bool(unfolded),
+        hash_bits,
+        bool(counts),
+    )
+
+
+def morgan_fingerprint_sweep(
+    smiles,
+    radii=(1, 2, 3),
+    nbits=(1024, 2048, 4096),
+    num_threads: Optional[int] = None,
+    *,
+    packed: Optional[str] = None,
+    dedup: bool = False,
+    out: Optional[Dict[Tuple[int, int], np.ndarray]] = None,
+) -> Dict[Tuple[int, int], np.ndarray]:
+    """
+    Calculate Morgan fingerprints for every combination of radii and sizes.
+
+    Environments are enumerated once per molecule up to the largest radius and
+    their raw ids are folded into every ``(radius, nbits)`` pair, instead of
+    recomputing the fingerprint for each combination. The defaults give
+    ECFP2/4/6 at 1024, 2048 and 4096 bits.
+
+    Args:
+        smiles: Array-like of SMILES strings or a MolBatch
+        radii: Fingerprint radii (an int selects one)
+        nbits: Fold sizes (an int selects one); every radius is folded into
+            every size
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        packed: Optional packed layout, ``"bytes"`` or ``"uint64"``, as for
+            :func:`morgan_fingerprints`
+        dedup: Compute each distinct SMILES once and copy its result to the
+            repeated rows. Ignored for MolBatch input.
+        out: Optional dictionary mapping ``(radius, nbits)`` to a
+            preallocated C-contiguous matrix with that fold's exact shape and
+            dtype. Those folds are written in place and returned; the others
+            are allocated.
+
+    Returns:
+        Dictionary mapping ``(radius, nbits)`` to the matrix
+        ``morgan_fingerprints(smiles, radius, nbits, packed=packed)`` would
+        return. Invalid SMILES have all-zero rows.
+    """
+    _check_extension()
+    smiles = _prepare_input(smiles)
+    if packed is not None and packed not in ("bytes", "uint64"):
+        raise ValueError("packed must be None, 'bytes' or 'uint64'")
+    radii = [int(radii)] if np.isscalar(radii) else [int(r) for r in radii]
+    nbits = [int(nbits)] if np.isscalar(nbits) else [int(n) for n in nbits]
+    if out is not None:
+        out = {(int(radius), int(size)): array for (radius, size), array in out.items()}
+    return _rdktools_core.calculate_morgan_sweep(
+        smiles,
+        radii,
+        nbits,
+        _resolve_num_threads(num_threads),
+        packed or "dense",
+        bool(dedup),
+        out,
+    )
 
 
 ECFP_REASONING_FINGERPRINT_SIZE = 2048
 
 
 def ecfp_reasoning_trace(
-    smiles: str,
+    smiles,
     radius: int = 2,
     *,
     isomeric: bool = True,
     kekulize: bool = False,
     include_per_center: bool = True,
     fingerprint_size: int = ECFP_REASONING_FINGERPRINT_SIZE,
+    index: Optional[int] = None,
 ) -> Tuple[str, np.ndarray]:
     """
     Generate an ECFP reasoning trace for a single SMILES string.
 
     Args:
-        smiles: SMILES string to analyse
+        smiles: SMILES string to analyse, or a MolBatch together with ``index``
         radius: Morgan fingerprint radius (default: 2)
         isomeric: Whether to encode stereochemistry in SMARTS fragments
         kekulize: If true, kekulize the molecule before generating fragments
         include_per_center: Whether to append per-atom environment chains
         fingerprint_size: Desired fingerprint length in bits (default: 2048).
             Non-positive values fall back to the default length.
+        index: Row of the molecule to analyse when ``smiles`` is a MolBatch.
 
     Returns:
         Tuple where the first element is the multi-line reasoning trace text
@@ -185,8 +777,13 @@ def ecfp_reasoning_trace(
         fingerprint.
     """
     _check_extension()
-    if not isinstance(smiles, str):
-        raise TypeError("SMILES input must be a string")
+    if _is_mol_batch(smiles):
+        if not isinstance(index, int):
+            raise TypeError("index must be an int when passing a MolBatch")
+        if index < 0:
+            index += len(smiles)
+    elif not isinstance(smiles, str):
+        raise TypeError("SMILES input must be a string or a MolBatch")
     if not isinstance(fingerprint_size, int):
         raise TypeError("fingerprint_size must be an int")
     target_size = (
@@ -194,8 +791,9 @@ def ecfp_reasoning_trace(
         if fingerprint_size > 0
         else ECFP_REASONING_FINGERPRINT_SIZE
     )
+    source = (smiles, index) if _is_mol_batch(smiles) else (smiles,)
     trace, fingerprint = _rdktools_core.ecfp_reasoning_trace(
-        smiles,
+        *source,
         radius,
         isomeric,
         kekulize,
@@ -211,7 +809,537 @@ def ecfp_reasoning_trace(
     return trace, fingerprint
 
 
+def ecfp_reasoning_traces(
+    smiles,
+    radius: int = 2,
+    *,
+    isomeric: bool = True,
+    kekulize: bool = False,
+    include_per_center: bool = True,
+    fingerprint_size: int = ECFP_REASONING_FINGERPRINT_SIZE,
+    packed: Optional[str] = None,
+    num_threads: Optional[int] = None,
+    dedup: bool = False,
+    out: Optional[np.ndarray] = None,
+) -> Tuple[list, np.ndarray]:
+    """
+    Generate ECFP reasoning traces for many SMILES strings in one call.
+
+    The batch is processed on the worker pool with the GIL released, and the
+    fingerprints are written into a single contiguous matrix instead of one
+    array per molecule.
+
+    Args:
+        smiles: Array-like of SMILES strings or a MolBatch
+        radius: Morgan fingerprint radius (default: 2)
+        isomeric, kekulize, include_per_center, fingerprint_size: As for
+            :func:`ecfp_reasoning_trace`
+        packed: Optional packed fingerprint layout (``"bytes"`` or
+            ``"uint64"``, see :func:`morgan_fingerprints`)
+        num_threads: Worker threads to use. ``None`` uses the module default.
+        dedup: Compute each distinct SMILES once and copy its result to the
+            repeated rows. Ignored for MolBatch input.
+        out: Optional preallocated fingerprint matrix (see
+            :func:`morgan_fingerprints`), written in place and returned.
+
+    Returns:
+        Tuple of a list with one trace string per input and a fingerprint
+        matrix with one row per input. Invalid SMILES yield an empty trace and
+        an all-zero row.
+    """
+    _check_extension()
+    if packed is not None and packed not in ("bytes", "uint64"):
+        raise ValueError("packed must be None, 'bytes' or 'uint64'")
+    if not isinstance(fingerprint_size, int):
+        raise TypeError("fingerprint_size must be an int")
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.ecfp_reasoning_traces(
+        smiles,
+        radius,
+        isomeric,
+        kekulize,
+        include_per_center,
+        fingerprint_size,
+        packed or "dense",
+        _resolve_num_threads(num_threads),
+        bool(dedup),
+        out,
+    )
+
+
+def ecfp_reasoning_trace_tokens(
+    smiles,
+    radius: int = 2,
+    *,
+    isomeric: bool = True,
+    kekulize: bool = False,
+    include_per_center: bool = True,
+    fingerprint_size: int = ECFP_REASONING_FINGERPRINT_SIZE,
+    packed: Optional[str] = None,
+    num_threads: Optional[int] = None,
+    dedup: bool = False,
+) -> Tuple[np.ndarray, np.ndarray, np.ndarray]:
+    """
+    Generate reasoning traces as integer token ids instead of text.
+
+    Each trace is encoded directly from its environments into ids of the
+    process trace vocabulary (see :func:`get_trace_vocabulary`): radius
+    markers, environment SMARTS with count digits, atom symbols and
+    separators. No trace text is built, and
+    ``decode_trace_tokens(values[splits[i]:splits[i + 1]])`` reproduces the
+    text row ``i`` of :func:`ecfp_reasoning_traces` exactly.
+
+    Args:
+        smiles: Array-like of SMILES strings or a MolBatch
+        radius: Morgan fingerprint radius, at most 15
+        isomeric, kekulize, include_per_center, fingerprint_size, packed,
+            num_threads, dedup: As for :func:`ecfp_reasoning_traces`
+
+    Returns:
+        Ragged ``(values, row_splits, fingerprints)``: int32 token ids of all
+        rows concatenated, int64 row splits of length N + 1 (as
+        ``tf.RaggedTensor.from_row_splits`` expects) and the fingerprint
+        matrix. Invalid SMILES yield an empty row and an all-zero fingerprint.
+    """
+    _check_extension()
+    if packed is not None and packed not in ("bytes", "uint64"):
+        raise ValueError("packed must be None, 'bytes' or 'uint64'")
+    if not isinstance(fingerprint_size, int):
+        raise TypeError("fingerprint_size must be an int")
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.ecfp_reasoning_trace_tokens(
+        smiles,
+        radius,
+        isomeric,
+        kekulize,
+        include_per_center,
+        fingerprint_size,
+        packed or "dense",
+        _resolve_num_threads(num_threads),
+        bool(dedup),
+    )
+
+
+def decode_trace_tokens(ids) -> str:
+    """Rebuild the text trace encoded by one row of token ids."""
+    _check_extension()
+    return _rdktools_core.decode_trace_tokens(np.ascontiguousarray(ids, dtype=np.int32))
+
+
+def get_trace_vocabulary() -> List[str]:
+    """
+    Return every trace token in id order.
+
+    The first entries are fixed in every process (``[PAD]`` = 0, ``[UNK]``,
+    newline, the per-center header, count sign, chain arrow, the digits and
+    the radius markers ``r0:`` to ``r15:``); environments and atom symbols
+    follow in the order they were first seen, by row within a batch, so the
+    ids do not depend on ``num_threads`` but do depend on what the process
+    has tokenized before. Save the list next to a tokenized dataset and
+    restore it frozen with :func:`set_trace_vocabulary`.
+    """
+    _check_extension()
+    return _rdktools_core.get_trace_vocabulary()
+
+
+def set_trace_vocabulary(tokens: Sequence[str], *, frozen: bool = False) -> None:
+    """
+    Replace the trace vocabulary with ``tokens``, in id order.
+
+    Args:
+        tokens: A list returned by :func:`get_trace_vocabulary`.
+        frozen: Map environments missing from ``tokens`` to ``[UNK]`` instead
+            of appending new ids, so ids never exceed the saved vocabulary.
+
+    Raises:
+        ValueError: If ``tokens`` does not start with the fixed tokens or
+            repeats an entry.
+    """
+    _check_extension()
+    _rdktools_core.set_trace_vocabulary([str(token) for token in tokens], bool(frozen))
+
+
+# Substructure search
+def substructure_match(
+    smiles,
+    patterns,
+    num_threads: Optional[int] = None,
+    *,
+    use_chirality: bool = False,
+    out: Optional[np.ndarray] = None,
+) -> np.ndarray:
+    """
+    Match SMARTS queries, e.g. structural alerts, against a list of molecules.
+
+    Each query is compiled once per call. Molecules are prescreened with
+    RDKit pattern fingerprints, so a (molecule, query) pair only reaches
+    ``SubstructMatch`` when every fingerprint bit of the query is also set
+    in the molecule; most non-matches are rejected by a few packed AND
+    tests. Pass a MolBatch to reuse molecules parsed once.
+
+    Args:
+        smiles: Array-like of SMILES strings or a MolBatch
+        patterns: SMARTS string or sequence of SMARTS strings
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        use_chirality: Require stereochemistry in the queries to match.
+        out: Optional preallocated C-contiguous bool array of the result
+            shape, written in place and returned.
+
+    Returns:
+        bool array of shape ``(len(smiles), len(patterns))``. Invalid SMILES
+        match nothing.
+
+    Raises:
+        ValueError: For a SMARTS string that cannot be parsed.
+    """
+    _check_extension()
+    if isinstance(patterns, str):
+        patterns = [patterns]
+    patterns = list(patterns)
+    if not all(isinstance(pattern, str) for pattern in patterns):
+        raise TypeError("patterns must be a SMARTS string or a sequence of them")
+    smiles = _prepare_input(smiles)
+    return _rdktools_core.substructure_match(
+        smiles, patterns, bool(use_chirality), _resolve_num_threads(num_threads), out
+    )
+
+
 # Convenience functions
+def _is_fingerprint_db(value) -> bool:
+    """Return True if value is a memory-mapped FingerprintDB."""
+    return _EXTENSION_AVAILABLE and isinstance(value, FingerprintDB)
+
+
+def _prepare_fingerprints(fps, name: str) -> np.ndarray:
+    """Return a C-contiguous 2D packed fingerprint matrix (no copy if possible)."""
+    fps = np.asarray(fps)
+    if fps.dtype not in (np.uint8, np.uint64):
+        raise TypeError(
+            f"{name} must be packed uint8 or uint64 fingerprints "
+            "(see morgan_fingerprints(..., packed=...))"
+        )
+    if fps.ndim == 1:
+        fps = fps.reshape(1, -1)
+    elif fps.ndim != 2:
+        raise ValueError(f"{name} must be a 1D or 2D fingerprint array")
+    return np.ascontiguousarray(fps)
+
+
+def tanimoto_matrix(
+    a: np.ndarray,
+    b: Optional[np.ndarray] = None,
+    num_threads: Optional[int] = None,
+    *,
+    out: Optional[np.ndarray] = None,
+) -> np.ndarray:
+    """
+    All-pairs Tanimoto similarity between packed fingerprints.
+
+    Args:
+        a: Packed fingerprints of shape (m, width), as returned by
+            ``morgan_fingerprints(..., packed="bytes")`` or ``packed="uint64"``
+        b: Packed fingerprints of shape (n, width) in the same layout as
+            ``a``, or a :class:`FingerprintDB`. Defaults to ``a``.
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        out: Optional preallocated C-contiguous float32 array of shape
+            (m, n), written in place and returned.
+
+    Returns:
+        float32 array of shape (m, n). Two all-zero fingerprints score 0.
+    """
+    _check_extension()
+    a = _prepare_fingerprints(a, "a")
+    if b is None:
+        b = a
+    elif not _is_fingerprint_db(b):
+        b = _prepare_fingerprints(b, "b")
+    return _rdktools_core.calculate_tanimoto_matrix(
+        a, b, _resolve_num_threads(num_threads), out
+    )
+
+
+def tanimoto_topk(
+    queries: np.ndarray,
+    library: np.ndarray,
+    k: int = 10,
+    threshold: float = 0.0,
+    num_threads: Optional[int] = None,
+    *,
+    out: Optional[Tuple[np.ndarray, np.ndarray]] = None,
+) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Find the k most similar library fingerprints for every query.
+
+    Args:
+        queries: Packed query fingerprints of shape (m, width)
+        library: Packed library fingerprints of shape (n, width) in the same
+            layout as ``queries``, or a :class:`FingerprintDB` whose mapped rows
+            and stored popcounts are scanned in place
+        k: Number of hits per query, capped at the library size
+        threshold: Minimum Tanimoto similarity for a hit
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        out: Optional ``(indices, scores)`` tuple of preallocated
+            C-contiguous int64 and float32 arrays of the result shape,
+            written in place and returned.
+
+    Returns:
+        Tuple ``(indices, scores)`` of shape (m, min(k, n)): int64 library
+        row indices and float32 similarities ordered best first (ties by
+        lower index). Queries with fewer hits above ``threshold`` are padded
+        with index -1 and score 0.
+    """
+    _check_extension()
+    if k < 0:
+        raise ValueError("k must be non-negative")
+    queries = _prepare_fingerprints(queries, "queries")
+    if not _is_fingerprint_db(library):
+        library = _prepare_fingerprints(library, "library")
+    return _rdktools_core.calculate_tanimoto_topk(
+        queries,
+        library,
+        k,
+        float(threshold),
+        _resolve_num_threads(num_threads),
+        tuple(out) if out is not None else None,
+    )
+
+
+def butina_cluster(
+    fps: np.ndarray,
+    threshold: float = 0.65,
+    num_threads: Optional[int] = None,
+    *,
+    reordering: bool = False,
+) -> Tuple[np.ndarray, np.ndarray]:
+    """
+    Cluster packed fingerprints with the Taylor-Butina algorithm.
+
+    Neighbor lists are built in parallel by streaming row pairs through the
+    popcount kernels, skipping pairs whose bit counts alone rule out the
+    threshold; the full similarity matrix is never materialized, so memory
+    grows with the number of neighbor pairs rather than with n².
+
+    Args:
+        fps: Packed fingerprints of shape (n, width), or a
+            :class:`FingerprintDB` whose mapped rows and stored popcounts are
+            used in place
+        threshold: Minimum Tanimoto similarity between a centroid and its
+            members, in (0, 1]. RDKit's ``Butina.ClusterData`` takes a
+            distance cutoff instead; ``threshold = 1 - cutoff``.
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        reordering: Update the neighbor counts of the remaining rows after
+            every cluster is formed, as in RDKit's ``reordering=True``
+
+    Returns:
+        Tuple ``(labels, centroids)``: int64 cluster index of every row, and
+        int64 row index of every cluster's centroid. Clusters are numbered in
+        the order they are formed, starting from the row with most neighbors.
+    """
+    _check_extension()
+    if not _is_fingerprint_db(fps):
+        fps = _prepare_fingerprints(fps, "fps")
+    return _rdktools_core.calculate_butina_clusters(
+        fps, float(threshold), bool(reordering), _resolve_num_threads(num_threads)
+    )
+
+
+def maxmin_pick(
+    fps: np.ndarray,
+    k: int,
+    num_threads: Optional[int] = None,
+    *,
+    first_picks=None,
+    seed: int = 0,
+) -> np.ndarray:
+    """
+    Pick a diverse subset of packed fingerprints with the MaxMin algorithm.
+
+    Every step picks the row least similar to everything picked so far. Each
+    row's highest similarity to the picks is kept and updated against the
+    newest pick in one parallel pass, so memory stays O(n).
+
+    Args:
+        fps: Packed fingerprints of shape (n, width), or a
+            :class:`FingerprintDB`
+        k: Number of rows to pick, including ``first_picks``
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+        first_picks: Optional row indices to start from, e.g. an existing
+            selection to extend
+        seed: Random seed for the first pick when ``first_picks`` is empty
+
+    Returns:
+        int64 array of k row indices in pick order, starting with
+        ``first_picks``; ties go to the lower row index.
+    """
+    _check_extension()
+    if k < 0:
+        raise ValueError("k must be non-negative")
+    if seed < 0:
+        raise ValueError("seed must be non-negative")
+    if not _is_fingerprint_db(fps):
+        fps = _prepare_fingerprints(fps, "fps")
+    picks = [] if first_picks is None else [int(pick) for pick in first_picks]
+    return _rdktools_core.calculate_maxmin_picks(
+        fps, k, picks, seed, _resolve_num_threads(num_threads)
+    )
+
+
+def write_fingerprint_db(
+    path,
+    fingerprints: np.ndarray,
+    ids=None,
+    num_bits: Optional[int] = None,
+    num_threads: Optional[int] = None,
+) -> None:
+    """
+    Write packed fingerprints to a memory-mappable database file.
+
+    The file holds a versioned header, the packed rows, one precomputed
+    popcount per row and an optional ID table. It is written to a temporary
+    file and renamed into place.
+
+    Args:
+        path: Destination file path
+        fingerprints: Packed uint8 (``packed="bytes"``) or uint64
+            (``packed="uint64"``) fingerprint matrix
+        ids: Optional sequence of string identifiers, one per row
+        num_bits: Fingerprint length in bits. Defaults to the row width.
+        num_threads: Worker threads to use. ``None`` uses the module default
+            (see :func:`set_num_threads`).
+    """
+    _check_extension()
+    fingerprints = _prepare_fingerprints(fingerprints, "fingerprints")
+    if ids is not None:
+        ids = [str(value) for value in ids]
+    _rdktools_core.write_fingerprint_db(
+        os.fspath(path),
+        fingerprints,
+        ids,
+        0 if num_bits is None else num_bits,
+        _resolve_num_threads(num_threads),
+    )
+
+
+def open_fingerprint_db(path) -> "FingerprintDB":
+    """
+    Memory-map a database written by :func:`write_fingerprint_db`.
+
+    Opening only validates the header; rows are paged in on demand and shared
+    between every process that maps the same file. ``db.fingerprints`` and
+    ``db.popcounts`` are read-only numpy views of the mapping, and ``db`` can
+    be passed as the library of :func:`tanimoto_matrix` and
+    :func:`tanimoto_topk`.
+
+    Args:
+        path: Database file path
+
+    Returns:
+        FingerprintDB
+    """
+    _check_extension()
+    return FingerprintDB(os.fspath(path))
+
+
+def _smiles_file_format(path: str):
+    """Default (delimiter, header) for a SMILES file based on its extension."""
+    name = path.lower()
+    if name.endswith(".gz"):
+        name = name[:-3]
+    if name.endswith(".csv"):
+        return ",", True
+    if name.endswith(".tsv"):
+        return "\t", True
+    return "", False
+
+
+def read_smiles_file(
+    path,
+    batch_size: int = 10000,
+    *,
+    smiles_column=0,
+    id_column=None,
+    delimiter: Optional[str] = None,
+    header: Optional[bool] = None,
+    descriptors: bool = True,
+    fingerprints: bool = False,
+    radius: int = 2,
+    nbits: int = 2048,
+    packed: Optional[str] = None,
+    traces: bool = False,
+    num_threads: Optional[int] = None,
+    queue_depth: int = 2,
+) -> "SmilesFileReader":
+    """
+    Stream a large SMILES file as an iterator of featurized batches.
+
+    The file is read in fixed-size chunks (gzip-compressed files are
+    decompressed on the fly), split into records and featurized on the worker
+    pool, with each stage on its own thread and at most ``queue_depth`` items
+    buffered between stages. I/O, decompression and RDKit work therefore
+    overlap while memory stays flat regardless of the file size.
+
+    Args:
+        path: ``.smi``/``.csv``/``.tsv`` file, optionally ending in ``.gz``
+        batch_size: Records per batch (default: 10000)
+        smiles_column: Index or header name of the SMILES column
+        id_column: Index or header name of an identifier column, or None
+        delimiter: Field separator. ``None`` picks ``","`` for ``.csv`` and
+            ``"\t"`` for ``.tsv``; otherwise fields are separated by runs of
+            spaces/tabs as in ``.smi`` files. Non-blank delimiters honour
+            double-quoted fields, which may span lines.
+        header: Whether the first record is a header row. ``None`` assumes
+            one for ``.csv``/``.tsv`` files.
+        descriptors: Include ``molecular_weight``, ``logp`` and ``tpsa``
+        fingerprints: Include Morgan ``fingerprints`` (see
+            :func:`morgan_fingerprints` for ``radius``/``nbits``/``packed``)
+        traces: Include ECFP reasoning ``traces`` (list of str)
+        num_threads: Featurization threads. ``None`` uses the module default.
+        queue_depth: Items buffered between pipeline stages (default: 2)
+
+    Returns:
+        Iterator yielding one dict per batch with ``offset`` (row of the
+        first record), ``smiles``, ``ids`` (list or None), ``valid`` and the
+        requested feature arrays, all aligned with the file's records. Blank
+        lines and lines starting with ``#`` are skipped; invalid SMILES get
+        NaN descriptors, zero fingerprints and empty traces.
+    """
+    _check_extension()
+    path = os.fspath(path)
+    if packed is not None and packed not in ("bytes", "uint64"):
+        raise ValueError("packed must be None, 'bytes' or 'uint64'")
+    default_delimiter, default_header = _smiles_file_format(path)
+    if delimiter is None:
+        delimiter = default_delimiter
+    if header is None:
+        header = default_header
+    if isinstance(id_column, str) or isinstance(smiles_column, str):
+        header = True
+
+    return SmilesFileReader(
+        path,
+        batch_size=batch_size,
+        delimiter=delimiter,
+        header=header,
+        smiles_column=smiles_column if isinstance(smiles_column, int) else 0,
+        smiles_column_name=smiles_column if isinstance(smiles_column, str) else "",
+        id_column=id_column if isinstance(id_column, int) else -1,
+        id_column_name=id_column if isinstance(id_column, str) else "",
+        descriptors=descriptors,
+        fingerprints=fingerprints,
+        radius=radius,
+        nbits=nbits,
+        layout=packed or "dense",
+        traces=traces,
+        num_threads=_resolve_num_threads(num_threads),
+        queue_depth=queue_depth,
+    )
+
+
 def filter_valid(smiles) -> np.ndarray:
     """
     Filter array to only valid SMILES strings.
@@ -222,7 +1350,7 @@ def filter_valid(smiles) -> np.ndarray:
     Returns:
         numpy array containing only valid SMILES strings.
     """
-    smiles = _validate_smiles_input(smiles)
+    smiles = _as_numpy_smiles(_validate_smiles_input(smiles))
     valid_mask = is_valid(smiles)
     return smiles[valid_mask]
 
@@ -234,6 +1362,7 @@ def batch_process(
     include_fingerprints: bool = False,
     radius: int = 2,
     nbits: int = 2048,
+    num_threads: Optional[int] = None,
 ) -> Dict[str, np.ndarray]:
     """
     Process large datasets in batches for memory efficiency.
@@ -245,12 +1374,14 @@ def batch_process(
         include_fingerprints: Whether to calculate fingerprints
         radius: Fingerprint radius (if calculating fingerprints)
         nbits: Fingerprint size (if calculating fingerprints)
+        num_threads: Worker threads used for each batch call
 
     Returns:
         Dictionary with results. Always includes 'valid' boolean array.
         If include_descriptors: adds 'molecular_weight', 'logp', 'tpsa'
         If include_fingerprints: adds 'fingerprints' 2D array
     """
+    # numpy and Arrow arrays both slice without copying
     smiles = _validate_smiles_input(smiles)
     n_molecules = len(smiles)
 
@@ -275,22 +1406,125 @@ def batch_process(
         batch_smiles = smiles[i:end_idx]
 
         # Validation
-        batch_valid = is_valid(batch_smiles)
+        batch_valid = is_valid(batch_smiles, num_threads)
         results["valid"][i:end_idx] = batch_valid
 
         if include_descriptors:
-            batch_desc = descriptors(batch_smiles)
+            batch_desc = descriptors(batch_smiles, num_threads)
             results["molecular_weight"][i:end_idx] = batch_desc["molecular_weight"]
             results["logp"][i:end_idx] = batch_desc["logp"]
             results["tpsa"][i:end_idx] = batch_desc["tpsa"]
 
         if include_fingerprints:
-            batch_fps = morgan_fingerprints(batch_smiles, radius, nbits)
+            batch_fps = morgan_fingerprints(batch_smiles, radius, nbits, num_threads)
             results["fingerprints"][i:end_idx] = batch_fps
 
     return results
 
 
+# Asynchronous submission
+_pending_lock = threading.Lock()
+_pending: "set[concurrent.futures.Future]" = set()
+
+
+def _forget_pending(future: concurrent.futures.Future) -> None:
+    with _pending_lock:
+        _pending.discard(future)
+
+
+def _submit(fn, args, kwargs, block: bool) -> Optional[concurrent.futures.Future]:
+    if not callable(fn):
+        raise TypeError("fn must be callable")
+    future = concurrent.futures.Future()
+    with _pending_lock:
+        _pending.add(future)
+    try:
+        queued = _rdktools_core.submit_call(future, fn, tuple(args), dict(kwargs), block)
+    except BaseException:
+        _forget_pending(future)
+        raise
+    if not queued:
+        _forget_pending(future)
+        return None
+    future.add_done_callback(_forget_pending)
+    return future
+
+
+def submit(fn, *args, **kwargs) -> concurrent.futures.Future:
+    """
+    Run ``fn(*args, **kwargs)`` on the native worker pool.
+
+    Meant for rdktools batch functions, which release the GIL while they
+    featurize: the caller keeps reading and preparing the next batch while
+    the current one is processed. At most :func:`get_max_in_flight` jobs are
+    queued or running at once; ``submit`` waits for a free slot, with the GIL
+    released, when that many are pending, so producers cannot run ahead of
+    the pool.
+
+    Example::
+
+        future = rdktools.submit(rdktools.morgan_fingerprints, batch, nbits=1024)
+        next_batch = read_next()
+        fps = future.result()
+
+    Args:
+        fn: Callable, typically an rdktools batch function
+        *args, **kwargs: Arguments for ``fn``
+
+    Returns:
+        ``concurrent.futures.Future`` holding the result or exception of
+        ``fn``. ``result()`` waits without holding the GIL; use
+        :func:`submit_async` or ``asyncio.wrap_future`` from asyncio code.
+    """
+    _check_extension()
+    return _submit(fn, args, kwargs, True)
+
+
+async def submit_async(fn, *args, **kwargs):
+    """
+    Awaitable counterpart of :func:`submit`.
+
+    Waits for a free slot without blocking the event loop, then awaits the
+    result of ``fn(*args, **kwargs)``.
+    """
+    _check_extension()
+    while True:
+        future = _submit(fn, args, kwargs, False)
+        if future is not None:
+            return await asyncio.wrap_future(future)
+        with _pending_lock:
+            pending = [asyncio.wrap_future(f) for f in _pending]
+        if pending:
+            await asyncio.wait(pending, return_when=asyncio.FIRST_COMPLETED)
+        else:
+            await asyncio.sleep(0)
+
+
+def set_max_in_flight(limit: int) -> None:
+    """
+    Bound the number of submitted jobs queued or running at once.
+
+    Args:
+        limit: Positive job count (default: 2, i.e. double buffering)
+    """
+    _check_extension()
+    if limit < 1:
+        raise ValueError("limit must be positive")
+    _rdktools_core.set_max_in_flight(limit)
+
+
+def get_max_in_flight() -> int:
+    """Return the bound on submitted jobs queued or running at once."""
+    _check_extension()
+    return _rdktools_core.get_max_in_flight()
+
+
+if _EXTENSION_AVAILABLE:
+    # Jobs take the GIL to publish results, so let them finish before the
+    # interpreter shuts down
+    atexit.register(_rdktools_core.wait_for_submitted)
+
+
 # TensorFlow ops (optional)
 try:
     from . import tf_ops  # noqa: F401
@@ -317,11 +1551,49 @@ __all__ = [
     "is_valid",
     "canonical_smiles",
     "descriptors",
+    "calculate_descriptors",
+    "descriptor_names",
     "morgan_fingerprints",
+    "morgan_fingerprints_sparse",
+    "morgan_fingerprint_sweep",
     "ecfp_reasoning_trace",
+    "ecfp_reasoning_traces",
+    "ecfp_reasoning_trace_tokens",
+    "decode_trace_tokens",
+    "get_trace_vocabulary",
+    "set_trace_vocabulary",
+    "substructure_match",
+    "tanimoto_matrix",
+    "tanimoto_topk",
+    "butina_cluster",
+    "maxmin_pick",
+    "write_fingerprint_db",
+    "open_fingerprint_db",
+    "FingerprintDB",
+    "read_smiles_file",
+    "SmilesFileReader",
     "ECFP_REASONING_FINGERPRINT_SIZE",
+    "VALIDATION_LEVELS",
     "filter_valid",
     "batch_process",
+    "MolBatch",
+    "parse_smiles",
+    "smiles_to_pickles",
+    "parse_pickles",
+    "set_num_threads",
+    "get_num_threads",
+    "set_trace_cache_capacity",
+    "get_trace_cache_capacity",
+    "set_result_cache_capacity",
+    "get_result_cache_capacity",
+    "result_cache_stats",
+    "clear_result_cache",
+    "get_stats",
+    "reset_stats",
+    "submit",
+    "submit_async",
+    "set_max_in_flight",
+    "get_max_in_flight",
 ]
 
 # Add TensorFlow ops to exports if available
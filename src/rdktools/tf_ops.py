@@ -7,10 +7,13 @@ TensorFlow graphs and tf.data pipelines.
 """
 
 import os
-from typing import Optional, Tuple
+from typing import Optional, Sequence, Tuple, Union
 
 import numpy as np
 import tensorflow as tf
+from tensorflow.python.data.ops import dataset_ops
+
+from . import _smiles_file_format
 
 
 def _load_tf_ops():
@@ -52,10 +55,28 @@ def _check_tf_ops():
         )
 
 
+_INPUT_FORMATS = ("smiles", "pickle")
+
+
+def _check_input_format(input_format: str) -> str:
+    if input_format not in _INPUT_FORMATS:
+        raise ValueError(
+            f"input_format must be one of {_INPUT_FORMATS}, got {input_format!r}"
+        )
+    return input_format
+
+
 def string_process(
     input_strings: tf.Tensor,
     name: Optional[str] = None,
     fingerprint_size: int = 2048,
+    packed: bool = False,
+    radius: int = 2,
+    isomeric: bool = True,
+    kekulize: bool = False,
+    include_per_center: bool = True,
+    dedup: bool = False,
+    input_format: str = "smiles",
 ) -> Tuple[tf.Tensor, tf.Tensor]:
     """
     Generate reasoning traces and Morgan fingerprints for SMILES tensors.
@@ -65,12 +86,24 @@ def string_process(
         name: Optional name for the operation.
         fingerprint_size: Desired fingerprint length in bits. Non-positive
             values fall back to the default of 2048.
+        packed: If True, emit bit-packed fingerprints of
+            ``ceil(fingerprint_size / 8)`` bytes per row in ``np.packbits``
+            order instead of one byte per bit.
+        radius: Maximum Morgan radius for environments and fingerprints.
+        isomeric: Include chirality in environments and fingerprints.
+        kekulize: Write environments from a kekulized copy of the molecule.
+        include_per_center: Append the per-atom chain summary to each trace.
+        dedup: Featurize each distinct SMILES of the batch once and copy its
+            outputs to repeated rows.
+        input_format: ``"smiles"``, or ``"pickle"`` when the tensor holds
+            RDKit pickles from :func:`rdktools.smiles_to_pickles`.
         
     Returns:
         Tuple `(traces, fingerprints)` where `traces` matches the input shape
         with string tensors containing the reasoning trace, and `fingerprints`
         appends a trailing dimension of size `fingerprint_size` (default 2048)
-        with the uint8 fingerprint.
+        with the uint8 fingerprint, or ``ceil(fingerprint_size / 8)`` when
+        ``packed`` is set.
         
     Raises:
         ImportError: If TensorFlow custom ops are not available.
@@ -96,15 +129,157 @@ def string_process(
     if not isinstance(fingerprint_size, int):
         raise TypeError("fingerprint_size must be an int")
     size = fingerprint_size if fingerprint_size > 0 else 2048
+    if int(radius) < 0:
+        raise ValueError("radius must be non-negative")
 
     return _tf_ops_module.string_process(
-        input_strings, fingerprint_size=size, name=name
+        input_strings,
+        fingerprint_size=size,
+        packed=bool(packed),
+        radius=int(radius),
+        isomeric=bool(isomeric),
+        kekulize=bool(kekulize),
+        include_per_center=bool(include_per_center),
+        dedup=bool(dedup),
+        input_format=_check_input_format(input_format),
+        name=name,
+    )
+
+
+def trace_tokens(
+    input_strings: tf.Tensor,
+    name: Optional[str] = None,
+    fingerprint_size: int = 2048,
+    packed: bool = False,
+    radius: int = 2,
+    isomeric: bool = True,
+    kekulize: bool = False,
+    include_per_center: bool = True,
+    vocabulary: Optional[Sequence[str]] = None,
+    input_format: str = "smiles",
+) -> Tuple[tf.RaggedTensor, tf.Tensor]:
+    """
+    Generate reasoning traces as ragged int32 token ids for a SMILES vector.
+
+    Token ids are encoded straight from the trace environments with no text
+    built in between (see :func:`rdktools.ecfp_reasoning_trace_tokens`).
+
+    Args:
+        input_strings: A rank-1 string tensor to process.
+        name: Optional name for the operation.
+        fingerprint_size, packed, radius, isomeric, kekulize,
+            include_per_center: As for :func:`string_process`; ``radius``
+            is at most 15.
+        vocabulary: Tokens in id order, e.g. ``rdktools.get_trace_vocabulary()``
+            saved with a dataset. The op uses it frozen, mapping unseen
+            environments to ``[UNK]``. ``None`` uses the shared vocabulary
+            (see :func:`trace_vocabulary`), which must first be frozen with
+            ``rdktools.set_trace_vocabulary(tokens, frozen=True)``; the op
+            fails otherwise. Ids from a growing vocabulary depend on the order
+            environments are first met, so they differ between runs and
+            between worker processes.
+        input_format: ``"smiles"``, or ``"pickle"`` when the tensor holds
+            RDKit pickles from :func:`rdktools.smiles_to_pickles`.
+
+    Returns:
+        Tuple ``(tokens, fingerprints)`` of a ``tf.RaggedTensor`` of shape
+        ``[N, None]`` and a uint8 fingerprint matrix. Invalid SMILES yield
+        empty rows and all-zero fingerprints.
+    """
+    _check_tf_ops()
+
+    if not isinstance(fingerprint_size, int):
+        raise TypeError("fingerprint_size must be an int")
+    if fingerprint_size <= 0:
+        raise ValueError("fingerprint_size must be positive")
+    if not 0 <= int(radius) <= 15:
+        raise ValueError("radius must be between 0 and 15")
+
+    values, row_splits, fingerprints = _tf_ops_module.trace_tokens(
+        input_strings,
+        fingerprint_size=fingerprint_size,
+        packed=bool(packed),
+        radius=int(radius),
+        isomeric=bool(isomeric),
+        kekulize=bool(kekulize),
+        include_per_center=bool(include_per_center),
+        vocabulary=[str(token) for token in vocabulary] if vocabulary else [],
+        input_format=_check_input_format(input_format),
+        name=name,
+    )
+    tokens = tf.RaggedTensor.from_row_splits(values, row_splits, validate=False)
+    return tokens, fingerprints
+
+
+def trace_vocabulary(name: Optional[str] = None) -> tf.Tensor:
+    """
+    Return the process-wide trace vocabulary as a string vector.
+
+    These are the ids :func:`trace_tokens` uses when no ``vocabulary`` is
+    given. The TF ops and the ``rdktools`` functions share one runtime, so
+    this matches :func:`rdktools.get_trace_vocabulary`.
+    """
+    _check_tf_ops()
+    return _tf_ops_module.trace_vocabulary(name=name)
+
+
+def morgan_fingerprint(
+    input_strings: tf.Tensor,
+    radius: int = 2,
+    use_chirality: bool = False,
+    fingerprint_size: int = 2048,
+    packed: bool = False,
+    counts: bool = False,
+    name: Optional[str] = None,
+    input_format: str = "smiles",
+) -> tf.Tensor:
+    """
+    Generate Morgan fingerprints for SMILES tensors without building traces.
+
+    Args:
+        input_strings: A string tensor to process.
+        radius: Maximum Morgan radius.
+        use_chirality: Include chirality in the atom invariants.
+        fingerprint_size: Fingerprint length in bits.
+        packed: If True, emit bit-packed rows of ``ceil(fingerprint_size / 8)``
+            bytes in ``np.packbits`` order.
+        counts: If True, each byte holds the number of environments hashed to
+            that bit (saturating at 255). Cannot be combined with ``packed``.
+        name: Optional name for the operation.
+        input_format: ``"smiles"``, or ``"pickle"`` when the tensor holds
+            RDKit pickles from :func:`rdktools.smiles_to_pickles`.
+
+    Returns:
+        A uint8 tensor of shape ``input_shape + [width]``. Invalid or empty
+        SMILES yield all-zero rows.
+    """
+    _check_tf_ops()
+
+    if not isinstance(fingerprint_size, int):
+        raise TypeError("fingerprint_size must be an int")
+    if fingerprint_size <= 0:
+        raise ValueError("fingerprint_size must be positive")
+    if int(radius) < 0:
+        raise ValueError("radius must be non-negative")
+    if packed and counts:
+        raise ValueError("packed and counts cannot both be set")
+
+    return _tf_ops_module.morgan_fingerprint(
+        input_strings,
+        radius=int(radius),
+        use_chirality=bool(use_chirality),
+        fingerprint_size=fingerprint_size,
+        packed=bool(packed),
+        counts=bool(counts),
+        input_format=_check_input_format(input_format),
+        name=name,
     )
 
 
 def formula_process(
     input_strings: tf.Tensor,
     name: Optional[str] = None,
+    input_format: str = "smiles",
 ) -> tf.Tensor:
     """
     Generate `<formula>[SEP]<smiles>` strings for SMILES tensors.
@@ -112,13 +287,157 @@ def formula_process(
     Args:
         input_strings: A string tensor to process.
         name: Optional name for the operation.
+        input_format: ``"smiles"``, or ``"pickle"`` when the tensor holds
+            RDKit pickles from :func:`rdktools.smiles_to_pickles`.
 
     Returns:
         A string tensor matching the input shape containing the formatted
-        formula/SMILES strings. Invalid SMILES yield "[invalid]".
+        formula/SMILES strings. Invalid SMILES yield "[invalid]"; pickled
+        input is written back as canonical SMILES.
     """
     _check_tf_ops()
-    return _tf_ops_module.formula_process(input_strings, name=name)
+    return _tf_ops_module.formula_process(
+        input_strings, input_format=_check_input_format(input_format), name=name
+    )
+
+
+def descriptor_process(
+    input_strings: tf.Tensor,
+    descriptors: Sequence[str] = ("molecular_weight", "logp", "tpsa"),
+    emit_formula: bool = False,
+    name: Optional[str] = None,
+    input_format: str = "smiles",
+) -> Union[tf.Tensor, Tuple[tf.Tensor, tf.Tensor]]:
+    """
+    Compute several descriptors for SMILES tensors from a single parse.
+
+    Args:
+        input_strings: A string tensor to process.
+        descriptors: Descriptor names such as ``"molecular_weight"``,
+            ``"logp"``, ``"tpsa"``, ``"num_hbd"`` or ``"fraction_csp3"``.
+        emit_formula: Also return ``<formula>[SEP]<smiles>`` strings computed
+            from the same parsed molecule.
+        name: Optional name for the operation.
+        input_format: ``"smiles"``, or ``"pickle"`` when the tensor holds
+            RDKit pickles from :func:`rdktools.smiles_to_pickles`.
+
+    Returns:
+        A float32 tensor of shape ``input_shape + [len(descriptors)]`` with NaN
+        rows for invalid SMILES, or ``(values, formulas)`` when
+        ``emit_formula`` is set.
+    """
+    _check_tf_ops()
+
+    if isinstance(descriptors, str):
+        descriptors = [descriptors]
+    descriptors = [str(descriptor) for descriptor in descriptors]
+    if not descriptors:
+        raise ValueError("descriptors must not be empty")
+
+    values, formulas = _tf_ops_module.descriptor_process(
+        input_strings,
+        descriptors=descriptors,
+        emit_formula=bool(emit_formula),
+        input_format=_check_input_format(input_format),
+        name=name,
+    )
+    if emit_formula:
+        return values, formulas
+    return values
+
+
+class SmilesFileDataset(dataset_ops.DatasetSource):
+    """
+    ``tf.data`` source that streams batched SMILES out of files in C++.
+
+    Files are read in order by a native read/split/featurize pipeline (gzip is
+    detected transparently), so no Python generator or GIL sits on the input
+    path. Each element is a batch of up to ``batch_size`` rows; batches do not
+    span files.
+
+    Args:
+        filenames: A local path, a sequence of paths, or a string tensor.
+        batch_size: Rows per batch.
+        smiles_column: Zero-based column holding the SMILES.
+        delimiter: Field delimiter character. ``None`` picks it from the first
+            file name as ``rdktools.read_smiles_file`` does (``,`` for ``.csv``,
+            tab for ``.tsv``, whitespace otherwise).
+        header: Whether every file starts with a header row. ``None`` picks it
+            from the first file name.
+        featurize: If True, elements are ``(smiles, traces, fingerprints)``
+            matching ``string_process`` on the batch, computed in the reader.
+        radius: Trace and fingerprint radius when featurizing.
+        fingerprint_size: Fingerprint length in bits when featurizing.
+        packed: Bit-pack fused fingerprints to ``ceil(fingerprint_size / 8)``
+            bytes per row.
+        num_threads: Featurize threads; ``None`` uses ``rdktools.get_num_threads()``.
+    """
+
+    def __init__(
+        self,
+        filenames: Union[str, Sequence[str], tf.Tensor],
+        batch_size: int = 1024,
+        *,
+        smiles_column: int = 0,
+        delimiter: Optional[str] = None,
+        header: Optional[bool] = None,
+        featurize: bool = False,
+        radius: int = 2,
+        fingerprint_size: int = 2048,
+        packed: bool = False,
+        num_threads: Optional[int] = None,
+    ):
+        _check_tf_ops()
+
+        if isinstance(filenames, (str, os.PathLike)):
+            filenames = [os.fspath(filenames)]
+        if not isinstance(filenames, tf.Tensor):
+            filenames = [os.fspath(name) for name in filenames]
+            if not filenames:
+                raise ValueError("filenames must not be empty")
+            default_delimiter, default_header = _smiles_file_format(filenames[0])
+        else:
+            default_delimiter, default_header = "", False
+        if delimiter is None:
+            delimiter = default_delimiter
+        if header is None:
+            header = default_header
+        if batch_size <= 0:
+            raise ValueError("batch_size must be positive")
+        if fingerprint_size <= 0:
+            raise ValueError("fingerprint_size must be positive")
+
+        self._filenames = tf.convert_to_tensor(
+            filenames, dtype=tf.string, name="filenames"
+        )
+        smiles_spec = tf.TensorSpec(shape=(None,), dtype=tf.string)
+        if featurize:
+            width = (fingerprint_size + 7) // 8 if packed else fingerprint_size
+            self._element_spec = (
+                smiles_spec,
+                tf.TensorSpec(shape=(None,), dtype=tf.string),
+                tf.TensorSpec(shape=(None, width), dtype=tf.uint8),
+            )
+        else:
+            self._element_spec = smiles_spec
+
+        variant_tensor = _tf_ops_module.smiles_file_dataset(
+            self._filenames,
+            batch_size=int(batch_size),
+            smiles_column=int(smiles_column),
+            delimiter=delimiter,
+            header=bool(header),
+            featurize=bool(featurize),
+            radius=int(radius),
+            fingerprint_size=int(fingerprint_size),
+            packed=bool(packed),
+            num_threads=0 if num_threads is None else int(num_threads),
+        )
+        super().__init__(variant_tensor)
+
+    @property
+    def element_spec(self):
+        return self._element_spec
 
 
 def create_tf_dataset_op(
@@ -129,10 +448,15 @@ def create_tf_dataset_op(
     shuffle_buffer_size: Optional[int] = None,
     prefetch: bool = True,
     fingerprint_size: int = 2048,
+    dedup: bool = False,
 ) -> tf.data.Dataset:
     """
     Convenience helper that builds a tf.data pipeline backed by the custom op.
 
+    Elements are batched first and ``string_process`` runs once per batch, so
+    the op shards each batch over the intra-op pool instead of being invoked
+    per scalar.
+
     Args:
         smiles: Iterable or tensor of SMILES strings.
         batch_size: Number of elements per batch.
@@ -141,6 +465,8 @@ def create_tf_dataset_op(
         prefetch: Whether to add a `prefetch(tf.data.AUTOTUNE)` stage.
         fingerprint_size: Desired fingerprint length for the op. Non-positive
             values fall back to 2048.
+        dedup: Featurize each distinct SMILES of a batch once (see
+            :func:`string_process`).
 
     Returns:
         Configured tf.data.Dataset yielding batches of `(traces, fingerprints)`
@@ -161,13 +487,6 @@ def create_tf_dataset_op(
             output_signature=tf.TensorSpec(shape=(), dtype=tf.string),
         )
 
-    dataset = dataset.map(
-        lambda value: string_process(
-            value, fingerprint_size=fingerprint_size
-        ),
-        num_parallel_calls=tf.data.AUTOTUNE,
-    )
-
     if shuffle:
         if shuffle_buffer_size is None:
             try:
@@ -179,6 +498,12 @@ def create_tf_dataset_op(
         dataset = dataset.shuffle(shuffle_buffer_size)
 
     dataset = dataset.batch(batch_size)
+    dataset = dataset.map(
+        lambda values: string_process(
+            values, fingerprint_size=fingerprint_size, dedup=dedup
+        ),
+        num_parallel_calls=tf.data.AUTOTUNE,
+    )
 
     if prefetch:
         dataset = dataset.prefetch(tf.data.AUTOTUNE)
@@ -188,7 +513,10 @@ def create_tf_dataset_op(
 # Export public API
 __all__ = [
     "string_process",
+    "morgan_fingerprint",
     "formula_process",
+    "descriptor_process",
+    "SmilesFileDataset",
     "create_tf_dataset_op",
 ]
 
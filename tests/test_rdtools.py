@@ -6,6 +6,10 @@ Note: These tests require the C++ extension to be built.
 Run: uv run python setup.py build_ext --inplace
 """
 
+import gzip
+import os
+import stat
+
 import pytest
 import numpy as np
 import numpy.testing as npt
@@ -78,6 +82,28 @@ class TestBasicFunctions:
         assert valid[1] == False  # invalid
         assert valid[2] == True   # benzene
         assert valid[3] == False  # bad_smiles
+
+    def test_validation_levels(self):
+        """Lower levels accept a superset of what higher levels accept."""
+        smiles = np.array([
+            'CCO',             # valid at every level
+            'C1CC',            # unclosed ring: syntax error
+            'C(C)(C)(C)(C)C',  # pentavalent carbon
+            'c1cccc1',         # aromatic ring that cannot be kekulized
+            'CN(=O)=O',        # nitro group fixed up by cleanup
+        ])
+        syntax = rdktools.is_valid(smiles, level='syntax')
+        valence = rdktools.is_valid(smiles, level='valence')
+        full = rdktools.is_valid(smiles, level='full')
+
+        npt.assert_array_equal(syntax, [True, False, True, True, True])
+        npt.assert_array_equal(valence, [True, False, False, False, True])
+        npt.assert_array_equal(full, rdktools.is_valid(smiles))
+        assert not np.any(full & ~valence)
+        assert not np.any(valence & ~syntax)
+
+        with pytest.raises(ValueError):
+            rdktools.is_valid(smiles, level='strict')
     
     def test_canonical_smiles(self):
         """Test SMILES canonicalization."""
@@ -152,6 +178,47 @@ class TestBatchOperations:
         assert results['valid'][3] == True   # acetic acid
 
 
+class TestDescriptorMatrix:
+    """Test the registry-backed N x D descriptor matrix."""
+
+    def test_matches_single_descriptors(self):
+        smiles = np.array(['CCO', 'c1ccccc1', 'invalid', 'CC(=O)O'])
+        names = ['molecular_weight', 'logp', 'tpsa']
+
+        matrix = rdktools.calculate_descriptors(smiles, names, dtype=np.float64)
+        expected = rdktools.descriptors(smiles)
+
+        assert matrix.shape == (4, 3)
+        assert matrix.dtype == np.float64
+        assert matrix.flags['C_CONTIGUOUS']
+        for column, name in enumerate(names):
+            np.testing.assert_allclose(matrix[:, column], expected[name])
+        assert np.isnan(matrix[2]).all()
+
+    def test_float32_and_mol_batch(self):
+        smiles = ['c1ccncc1', 'C1CCCCC1', 'CC(=O)Nc1ccccc1']
+        names = ['num_rings', 'num_aromatic_rings', 'num_aliphatic_rings',
+                 'num_heterocycles', 'molar_refractivity']
+
+        from_smiles = rdktools.calculate_descriptors(smiles, names)
+        from_batch = rdktools.calculate_descriptors(rdktools.parse_smiles(smiles), names)
+
+        assert from_smiles.dtype == np.float32
+        np.testing.assert_array_equal(from_smiles, from_batch)
+        np.testing.assert_array_equal(from_smiles[:, :4], [[1, 1, 0, 1], [1, 0, 1, 0], [1, 1, 0, 0]])
+
+    def test_all_names_and_errors(self):
+        names = rdktools.descriptor_names()
+        matrix = rdktools.calculate_descriptors(['CCO'])
+
+        assert matrix.shape == (1, len(names))
+        assert not np.isnan(matrix).any()
+        with pytest.raises(ValueError):
+            rdktools.calculate_descriptors(['CCO'], ['not_a_descriptor'])
+        with pytest.raises(ValueError):
+            rdktools.calculate_descriptors(['CCO'], ['logp'], dtype=np.int32)
+
+
 class TestFingerprints:
     """Test fingerprint calculations."""
     
@@ -205,6 +272,404 @@ class TestFingerprints:
         # Should have some similarity but not be identical
         assert 0.0 < tanimoto < 1.0
 
+    def test_packed_byte_fingerprints(self):
+        """Packed byte rows match np.packbits of the dense rows."""
+        smiles = np.array(['CCO', 'c1ccccc1', 'invalid_smiles', 'CC(=O)O'])
+        dense = rdktools.morgan_fingerprints(smiles, radius=2, nbits=1000)
+        packed = rdktools.morgan_fingerprints(smiles, radius=2, nbits=1000, packed="bytes")
+
+        assert packed.shape == (4, 125)
+        assert packed.dtype == np.uint8
+        npt.assert_array_equal(packed, np.packbits(dense, axis=1))
+
+    def test_packed_word_fingerprints(self):
+        """uint64 rows hold bit i at position i % 64 of word i // 64."""
+        smiles = np.array(['CCO', 'c1ccccc1'])
+        dense = rdktools.morgan_fingerprints(smiles, radius=2, nbits=100)
+        words = rdktools.morgan_fingerprints(smiles, radius=2, nbits=100, packed="uint64")
+
+        assert words.shape == (2, 2)
+        assert words.dtype == np.uint64
+        unpacked = np.unpackbits(words.view(np.uint8), axis=1, bitorder='little')
+        npt.assert_array_equal(unpacked[:, :100], dense)
+        assert not unpacked[:, 100:].any()
+
+    def test_packed_layout_rejects_unknown(self):
+        """Unknown layouts raise ValueError."""
+        with pytest.raises(ValueError):
+            rdktools.morgan_fingerprints(np.array(['CCO']), packed="bits")
+
+
+class TestSparseFingerprints:
+    """Test CSR sparse Morgan fingerprints."""
+
+    SMILES = np.array(['CCO', 'c1ccccc1', 'invalid_smiles', 'CC(=O)Oc1ccccc1C(=O)O'])
+
+    def test_folded_matches_dense(self):
+        """Folded indices are the set bits of the dense fingerprint."""
+        dense = rdktools.morgan_fingerprints(self.SMILES, radius=2, nbits=1024)
+        sparse = rdktools.morgan_fingerprints_sparse(self.SMILES, radius=2, nbits=1024)
+
+        indptr, indices = sparse['indptr'], sparse['indices']
+        assert indptr.dtype == np.int64
+        assert indices.dtype == np.uint32
+        assert len(indptr) == len(self.SMILES) + 1
+        assert 'counts' not in sparse
+        for i, row in enumerate(dense):
+            npt.assert_array_equal(indices[indptr[i]:indptr[i + 1]], np.flatnonzero(row))
+
+        # Invalid SMILES yield an empty row
+        assert indptr[3] == indptr[2]
+
+    def test_counts(self):
+        """Counts are positive and sum the environments in each row."""
+        sparse = rdktools.morgan_fingerprints_sparse(['CCCCCC'], nbits=2048, counts=True)
+
+        counts = sparse['counts']
+        assert counts.dtype == np.uint32
+        assert len(counts) == len(sparse['indices'])
+        assert np.all(counts > 0)
+        # Hexane has 6 atoms, so radius 0 alone contributes 6 environments
+        assert counts.sum() > 6
+
+    def test_unfolded_ids(self):
+        """Unfolded ids are raw hashes: sorted, unique and width-selectable."""
+        sparse32 = rdktools.morgan_fingerprints_sparse(self.SMILES, unfolded=True)
+        sparse64 = rdktools.morgan_fingerprints_sparse(
+            self.SMILES, unfolded=True, hash_bits=64, counts=True
+        )
+
+        assert sparse32['indices'].dtype == np.uint32
+        assert sparse64['indices'].dtype == np.uint64
+        for sparse in (sparse32, sparse64):
+            indptr, indices = sparse['indptr'], sparse['indices']
+            for i in range(len(self.SMILES)):
+                row = indices[indptr[i]:indptr[i + 1]]
+                assert np.all(row[1:] > row[:-1])
+        # Folding the 32-bit ids reproduces the folded rows
+        folded = rdktools.morgan_fingerprints_sparse(self.SMILES, nbits=2048)
+        indptr, indices = sparse32['indptr'], sparse32['indices']
+        for i in range(len(self.SMILES)):
+            refolded = np.unique(indices[indptr[i]:indptr[i + 1]] % 2048)
+            npt.assert_array_equal(
+                refolded, folded['indices'][folded['indptr'][i]:folded['indptr'][i + 1]]
+            )
+
+    def test_invalid_hash_bits(self):
+        """Only 32 and 64 bit unfolded ids are supported."""
+        with pytest.raises(ValueError):
+            rdktools.morgan_fingerprints_sparse(['CCO'], unfolded=True, hash_bits=16)
+
+
+class TestMorganSweep:
+    """Test multi-radius, multi-size Morgan fingerprints from one enumeration."""
+
+    SMILES = np.array(['CCO', 'c1ccccc1', 'invalid_smiles', 'CC(=O)Oc1ccccc1C(=O)O',
+                       'CN1CCC[C@H]1c1cccnc1'])
+
+    def test_matches_single_calls(self):
+        """Every combination equals morgan_fingerprints for that radius and size."""
+        for packed in (None, "bytes", "uint64"):
+            sweep = rdktools.morgan_fingerprint_sweep(
+                self.SMILES, radii=(0, 1, 3), nbits=(100, 1024), packed=packed
+            )
+            assert sorted(sweep) == [(0, 100), (0, 1024), (1, 100), (1, 1024),
+                                     (3, 100), (3, 1024)]
+            for (radius, nbits), fps in sweep.items():
+                npt.assert_array_equal(
+                    fps, rdktools.morgan_fingerprints(self.SMILES, radius, nbits, packed=packed)
+                )
+            assert not sweep[(3, 1024)][2].any()
+
+    def test_molbatch_scalars_and_errors(self):
+        """MolBatch input and scalar arguments work; bad sizes are rejected."""
+        batch = rdktools.parse_smiles(self.SMILES)
+        sweep = rdktools.morgan_fingerprint_sweep(batch, radii=2, nbits=2048)
+        assert list(sweep) == [(2, 2048)]
+        npt.assert_array_equal(sweep[(2, 2048)], rdktools.morgan_fingerprints(self.SMILES))
+        with pytest.raises(ValueError):
+            rdktools.morgan_fingerprint_sweep(self.SMILES, nbits=(0,))
+        with pytest.raises(ValueError):
+            rdktools.morgan_fingerprint_sweep(self.SMILES, radii=())
+
+    def test_dedup_and_out(self):
+        """Repeated rows and caller buffers give the same matrices."""
+        smiles = np.concatenate([self.SMILES, self.SMILES])
+        expected = rdktools.morgan_fingerprint_sweep(smiles, radii=(1, 2), nbits=256)
+        staging = np.full((len(smiles), 256), 9, dtype=np.uint8)
+        sweep = rdktools.morgan_fingerprint_sweep(
+            smiles, radii=(1, 2), nbits=256, dedup=True, out={(2, 256): staging}
+        )
+        assert sweep[(2, 256)] is staging
+        for key, fps in expected.items():
+            npt.assert_array_equal(sweep[key], fps)
+        with pytest.raises(ValueError):
+            rdktools.morgan_fingerprint_sweep(
+                smiles, radii=2, nbits=256, out={(2, 256): staging[:1]}
+            )
+
+
+class TestSimilarity:
+    """Test native Tanimoto similarity on packed fingerprints."""
+
+    SMILES = np.array(['CCO', 'CCC', 'c1ccccc1', 'Cc1ccccc1', 'CC(=O)O', 'invalid_smiles'])
+
+    @staticmethod
+    def reference_tanimoto(dense_a, dense_b):
+        a = dense_a.astype(np.int64)
+        b = dense_b.astype(np.int64)
+        common = a @ b.T
+        union = a.sum(axis=1)[:, None] + b.sum(axis=1)[None, :] - common
+        with np.errstate(invalid='ignore', divide='ignore'):
+            return np.where(union > 0, common / np.maximum(union, 1), 0.0)
+
+    def test_tanimoto_matrix_matches_reference(self):
+        """Both packed layouts give the numpy reference similarities."""
+        dense = rdktools.morgan_fingerprints(self.SMILES, nbits=1000)
+        expected = self.reference_tanimoto(dense, dense)
+        for layout in ("bytes", "uint64"):
+            packed = rdktools.morgan_fingerprints(self.SMILES, nbits=1000, packed=layout)
+            sims = rdktools.tanimoto_matrix(packed)
+
+            assert sims.shape == (len(self.SMILES), len(self.SMILES))
+            assert sims.dtype == np.float32
+            npt.assert_allclose(sims, expected, rtol=1e-6)
+
+    def test_tanimoto_topk(self):
+        """Top-k hits are the best library rows, best first."""
+        packed = rdktools.morgan_fingerprints(self.SMILES, nbits=2048, packed="uint64")
+        sims = rdktools.tanimoto_matrix(packed[:2], packed)
+        indices, scores = rdktools.tanimoto_topk(packed[:2], packed, k=3)
+
+        assert indices.shape == scores.shape == (2, 3)
+        assert indices.dtype == np.int64
+        # Each query matches itself first
+        npt.assert_array_equal(indices[:, 0], [0, 1])
+        npt.assert_allclose(scores[:, 0], 1.0)
+        for q in range(2):
+            npt.assert_allclose(scores[q], sims[q, indices[q]])
+            assert np.all(np.diff(scores[q]) <= 0)
+
+    def test_tanimoto_topk_threshold_padding(self):
+        """Rows with fewer than k hits above the threshold are padded."""
+        packed = rdktools.morgan_fingerprints(self.SMILES, nbits=2048, packed="bytes")
+        indices, scores = rdktools.tanimoto_topk(packed[2], packed, k=4, threshold=0.99)
+
+        assert indices[0, 0] == 2
+        npt.assert_array_equal(indices[0, 1:], [-1, -1, -1])
+        npt.assert_array_equal(scores[0, 1:], [0.0, 0.0, 0.0])
+
+    def test_tanimoto_topk_caps_k(self):
+        """k beyond the library size is capped instead of allocating padding."""
+        packed = rdktools.morgan_fingerprints(self.SMILES, nbits=2048, packed="bytes")
+        indices, scores = rdktools.tanimoto_topk(packed[:2], packed, k=10**9)
+
+        assert indices.shape == scores.shape == (2, len(self.SMILES))
+        npt.assert_array_equal(np.sort(indices, axis=1), [range(len(self.SMILES))] * 2)
+
+    def test_layout_mismatch_rejected(self):
+        """Mixed layouts and dense fingerprints are rejected."""
+        as_bytes = rdktools.morgan_fingerprints(self.SMILES, nbits=1024, packed="bytes")
+        as_words = rdktools.morgan_fingerprints(self.SMILES, nbits=1024, packed="uint64")
+        with pytest.raises(ValueError):
+            rdktools.tanimoto_matrix(as_bytes, as_words)
+        with pytest.raises(TypeError):
+            rdktools.tanimoto_matrix(as_bytes.astype(np.float32))
+
+
+class TestFingerprintDB:
+    """Test the memory-mapped fingerprint database."""
+
+    SMILES = ['CCO', 'CCC', 'c1ccccc1', 'Cc1ccccc1', 'CC(=O)O']
+
+    def test_round_trip(self, tmp_path):
+        """Mapped rows, popcounts and ids match what was written."""
+        fps = rdktools.morgan_fingerprints(self.SMILES, nbits=1000, packed="uint64")
+        path = tmp_path / "library.fpdb"
+        rdktools.write_fingerprint_db(path, fps, ids=[f"mol{i}" for i in range(5)], num_bits=1000)
+
+        db = rdktools.open_fingerprint_db(path)
+        assert len(db) == 5
+        assert db.num_bits == 1000
+        assert db.layout == "uint64"
+        assert db.has_ids
+        npt.assert_array_equal(db.fingerprints, fps)
+        assert not db.fingerprints.flags.writeable
+        dense = rdktools.morgan_fingerprints(self.SMILES, nbits=1000)
+        npt.assert_array_equal(db.popcounts, dense.sum(axis=1))
+        assert db.ids([4, -1, 0]) == ["mol4", "", "mol0"]
+
+    def test_search_on_mapped_rows(self, tmp_path):
+        """Similarity search against the database matches in-memory search."""
+        fps = rdktools.morgan_fingerprints(self.SMILES, nbits=2048, packed="bytes")
+        path = tmp_path / "library.fpdb"
+        rdktools.write_fingerprint_db(path, fps)
+        db = rdktools.open_fingerprint_db(path)
+
+        assert not db.has_ids
+        npt.assert_array_equal(
+            rdktools.tanimoto_matrix(fps[:2], db), rdktools.tanimoto_matrix(fps[:2], fps)
+        )
+        for got, expected in zip(
+            rdktools.tanimoto_topk(fps, db, k=3), rdktools.tanimoto_topk(fps, fps, k=3)
+        ):
+            npt.assert_array_equal(got, expected)
+
+        words = rdktools.morgan_fingerprints(self.SMILES, nbits=2048, packed="uint64")
+        with pytest.raises(ValueError):
+            rdktools.tanimoto_topk(words, db)
+
+    def test_file_mode_follows_umask(self, tmp_path):
+        """The database gets the permissions a plain open() would give it."""
+        path = tmp_path / "library.fpdb"
+        fps = rdktools.morgan_fingerprints(self.SMILES, packed="bytes")
+        rdktools.write_fingerprint_db(path, fps)
+        mask = os.umask(0)
+        os.umask(mask)
+        assert stat.S_IMODE(path.stat().st_mode) == 0o666 & ~mask
+
+    def test_rejects_bad_files(self, tmp_path):
+        """Non-database and truncated files fail to open."""
+        path = tmp_path / "bogus.fpdb"
+        path.write_bytes(b"not a fingerprint database" * 10)
+        with pytest.raises(RuntimeError):
+            rdktools.open_fingerprint_db(path)
+
+        fps = rdktools.morgan_fingerprints(self.SMILES, nbits=2048, packed="bytes")
+        good = tmp_path / "good.fpdb"
+        rdktools.write_fingerprint_db(good, fps)
+        truncated = tmp_path / "truncated.fpdb"
+        truncated.write_bytes(good.read_bytes()[:512])
+        with pytest.raises(RuntimeError):
+            rdktools.open_fingerprint_db(truncated)
+
+
+class TestClustering:
+    """Test Butina clustering and MaxMin picking on packed fingerprints."""
+
+    SMILES = ['CCO', 'CCCO', 'CCCCO', 'c1ccccc1', 'Cc1ccccc1', 'CCc1ccccc1',
+              'CC(=O)O', 'CCC(=O)O', 'C1CCCCC1', 'C1CCCCC1C']
+
+    def test_butina_members_near_centroid(self):
+        """Every row is labelled and each member is within threshold of its centroid."""
+        fps = rdktools.morgan_fingerprints(self.SMILES * 3, nbits=2048, packed="uint64")
+        sims = rdktools.tanimoto_matrix(fps)
+        for reordering in (False, True):
+            labels, centroids = rdktools.butina_cluster(fps, 0.5, reordering=reordering)
+            assert labels.shape == (len(fps),)
+            assert labels.dtype == centroids.dtype == np.int64
+            npt.assert_array_equal(labels[centroids], np.arange(len(centroids)))
+            assert np.all(sims[np.arange(len(fps)), centroids[labels]] >= 0.5)
+
+    def test_butina_threads_and_db_agree(self, tmp_path):
+        """Thread count and FingerprintDB input do not change the clusters."""
+        fps = rdktools.morgan_fingerprints(self.SMILES * 50, nbits=1024, packed="bytes")
+        path = tmp_path / "library.fpdb"
+        rdktools.write_fingerprint_db(path, fps)
+        serial = rdktools.butina_cluster(fps, 0.4, num_threads=1)
+        for got in (rdktools.butina_cluster(fps, 0.4, num_threads=4),
+                    rdktools.butina_cluster(rdktools.open_fingerprint_db(path), 0.4)):
+            for a, b in zip(got, serial):
+                npt.assert_array_equal(a, b)
+
+    def test_maxmin_picks(self):
+        """Picks are distinct, start from first_picks and repeat for a seed."""
+        fps = rdktools.morgan_fingerprints(self.SMILES, nbits=2048, packed="uint64")
+        picks = rdktools.maxmin_pick(fps, 5, seed=7)
+        assert picks.dtype == np.int64
+        assert len(set(picks.tolist())) == 5
+        npt.assert_array_equal(rdktools.maxmin_pick(fps, 5, seed=7, num_threads=1), picks)
+
+        extended = rdktools.maxmin_pick(fps, 4, first_picks=[3, 0])
+        npt.assert_array_equal(extended[:2], [3, 0])
+        # The third pick is the first row least similar to both first picks
+        nearest = rdktools.tanimoto_matrix(fps, fps[[3, 0]]).max(axis=1)
+        nearest[[3, 0]] = np.inf
+        assert extended[2] == np.argmin(nearest)
+
+    def test_invalid_arguments(self):
+        """Out-of-range thresholds, counts and first picks raise ValueError."""
+        fps = rdktools.morgan_fingerprints(self.SMILES, nbits=1024, packed="bytes")
+        with pytest.raises(ValueError):
+            rdktools.butina_cluster(fps, 0.0)
+        with pytest.raises(ValueError):
+            rdktools.butina_cluster(fps, 1.5)
+        with pytest.raises(ValueError):
+            rdktools.maxmin_pick(fps, len(fps) + 1)
+        with pytest.raises(ValueError):
+            rdktools.maxmin_pick(fps, 3, first_picks=[1, 1])
+        with pytest.raises(ValueError):
+            rdktools.maxmin_pick(fps, 3, first_picks=[len(fps)])
+
+
+class TestStreamingReader:
+    """Test the streaming SMILES file reader."""
+
+    SMILES = ['CCO', 'invalid_smiles', 'c1ccccc1', 'CC(=O)O', 'CCN']
+
+    def test_smi_batches(self, tmp_path):
+        """Batches cover every record in order and match the in-memory path."""
+        path = tmp_path / "library.smi"
+        lines = ["# comment", ""] + [f"{smi}\tmol{i}" for i, smi in enumerate(self.SMILES)]
+        path.write_text("\n".join(lines) + "\n")
+
+        batches = list(
+            rdktools.read_smiles_file(path, batch_size=2, id_column=1, fingerprints=True, nbits=512)
+        )
+        assert [b["offset"] for b in batches] == [0, 2, 4]
+        assert sum((b["smiles"] for b in batches), []) == self.SMILES
+        assert sum((b["ids"] for b in batches), []) == [f"mol{i}" for i in range(5)]
+
+        valid = np.concatenate([b["valid"] for b in batches])
+        npt.assert_array_equal(valid, rdktools.is_valid(self.SMILES))
+        expected = rdktools.descriptors(self.SMILES)
+        for name in ("molecular_weight", "logp", "tpsa"):
+            npt.assert_array_equal(np.concatenate([b[name] for b in batches]), expected[name])
+        npt.assert_array_equal(
+            np.concatenate([b["fingerprints"] for b in batches]),
+            rdktools.morgan_fingerprints(self.SMILES, nbits=512),
+        )
+
+    def test_gzip_csv_with_header(self, tmp_path):
+        """Compressed CSV files are decompressed and columns resolved by name."""
+        path = tmp_path / "library.csv.gz"
+        rows = ["id,smiles"] + [f'"mol,{i}",{smi}' for i, smi in enumerate(self.SMILES)]
+        with gzip.open(path, "wt") as handle:
+            handle.write("\n".join(rows))
+
+        reader = rdktools.read_smiles_file(
+            path, smiles_column="smiles", id_column="id", descriptors=False,
+            fingerprints=True, packed="uint64", traces=True,
+        )
+        (batch,) = list(reader)
+        assert batch["smiles"] == self.SMILES
+        assert batch["ids"][0] == "mol,0"
+        assert "molecular_weight" not in batch
+        assert batch["fingerprints"].dtype == np.uint64
+        assert batch["traces"][0] == rdktools.ecfp_reasoning_trace("CCO")[0]
+        assert batch["traces"][1] == ""
+        assert reader.rows_read == 5
+
+    def test_quoted_newlines(self, tmp_path):
+        """Quoted CSV fields may span lines without splitting the record."""
+        path = tmp_path / "library.csv"
+        path.write_text('id,smiles\n"first\nline",CCO\n"say ""hi""",c1ccccc1\nlast,CC\n')
+
+        (batch,) = list(rdktools.read_smiles_file(
+            path, smiles_column="smiles", id_column="id", descriptors=False,
+        ))
+        assert batch["smiles"] == ["CCO", "c1ccccc1", "CC"]
+        assert batch["ids"] == ["first\nline", 'say "hi"', "last"]
+
+    def test_errors(self, tmp_path):
+        """Missing files and unknown columns raise."""
+        with pytest.raises(RuntimeError):
+            rdktools.read_smiles_file(tmp_path / "missing.smi")
+        path = tmp_path / "library.csv"
+        path.write_text("smiles\nCCO\n")
+        with pytest.raises(ValueError):
+            list(rdktools.read_smiles_file(path, smiles_column="nope"))
+
 
 class TestReasoningTrace:
     """Test ECFP reasoning trace generation."""
@@ -281,6 +746,647 @@ class TestReasoningTrace:
         assert fingerprint.shape == (512,)
         assert fingerprint.sum() > 0
 
+    def test_ecfp_reasoning_trace_fingerprint_matches_morgan(self):
+        """The single-pass trace fingerprint equals the batch Morgan fingerprint."""
+        smiles = ['CCO', 'c1ccccc1O', 'CC(=O)Nc1ccc(O)cc1']
+        expected = rdktools.morgan_fingerprints(smiles, radius=2, nbits=1024)
+        for row, smi in enumerate(smiles):
+            for kekulize in (False, True):
+                _, fingerprint = rdktools.ecfp_reasoning_trace(
+                    smi, kekulize=kekulize, fingerprint_size=1024
+                )
+                npt.assert_array_equal(fingerprint, expected[row])
+
+    def test_ecfp_reasoning_traces_batch(self):
+        """The batched API matches per-molecule traces row for row."""
+        smiles = ['CCO', 'not_a_smiles', 'CC(=O)Oc1ccccc1C(=O)O']
+        traces, fingerprints = rdktools.ecfp_reasoning_traces(
+            smiles, fingerprint_size=1024, num_threads=2
+        )
+
+        assert isinstance(traces, list)
+        assert fingerprints.shape == (3, 1024)
+        assert fingerprints.dtype == np.uint8
+        for row, smi in enumerate(smiles):
+            trace, fingerprint = rdktools.ecfp_reasoning_trace(smi, fingerprint_size=1024)
+            assert traces[row] == trace
+            npt.assert_array_equal(fingerprints[row], fingerprint)
+        assert traces[1] == ""
+
+        _, packed = rdktools.ecfp_reasoning_traces(smiles, fingerprint_size=1024, packed="bytes")
+        npt.assert_array_equal(np.unpackbits(packed, axis=1, count=1024), fingerprints)
+        batch_traces, _ = rdktools.ecfp_reasoning_traces(rdktools.parse_smiles(smiles))
+        assert batch_traces == rdktools.ecfp_reasoning_traces(smiles)[0]
+
+    def test_ecfp_reasoning_trace_cache_capacity(self):
+        """Traces do not depend on the size or contents of the trace caches."""
+        smiles = 'CC(=O)Nc1ccc(O)cc1'
+        related = ['CC(=O)Nc1ccccc1', 'Oc1ccc(N)cc1', 'C[C@H](N)C(=O)O', 'OCC(=O)N']
+        original = rdktools.get_trace_cache_capacity()
+        try:
+            rdktools.set_trace_cache_capacity(0)
+            assert rdktools.get_trace_cache_capacity() == 0
+            expected = rdktools.ecfp_reasoning_trace(smiles)[0]
+            cold = [rdktools.ecfp_reasoning_trace(smi)[0] for smi in related]
+
+            # Environment SMARTS shared with earlier molecules come from the cache
+            rdktools.set_trace_cache_capacity(original)
+            for smi in related:
+                rdktools.ecfp_reasoning_trace(smi)
+            assert rdktools.ecfp_reasoning_trace(smiles)[0] == expected
+            assert [rdktools.ecfp_reasoning_trace(smi)[0] for smi in related] == cold
+
+            rdktools.set_trace_cache_capacity(32)
+            assert rdktools.get_trace_cache_capacity() == 32
+            assert rdktools.ecfp_reasoning_trace(smiles)[0] == expected
+        finally:
+            rdktools.set_trace_cache_capacity(original)
+
+
+class TestResultCache:
+    """Test the cross-call result cache."""
+
+    SMILES = np.array(['CCO', 'invalid', 'c1ccccc1', 'CC(=O)O', 'CCO'])
+
+    def setup_method(self):
+        rdktools.clear_result_cache()
+        rdktools.set_result_cache_capacity(1 << 20)
+
+    def teardown_method(self):
+        rdktools.set_result_cache_capacity(0)
+        rdktools.clear_result_cache()
+
+    def test_cached_results_match(self):
+        """Second calls are served from the cache and return identical results."""
+        descriptors = rdktools.calculate_descriptors(self.SMILES)
+        fps = rdktools.morgan_fingerprints(self.SMILES)
+        traces, trace_fps = rdktools.ecfp_reasoning_traces(self.SMILES)
+        first = rdktools.result_cache_stats()
+        assert first['entries'] > 0
+
+        npt.assert_array_equal(rdktools.calculate_descriptors(self.SMILES), descriptors)
+        npt.assert_array_equal(rdktools.morgan_fingerprints(self.SMILES), fps)
+        cached_traces, cached_fps = rdktools.ecfp_reasoning_traces(self.SMILES)
+        assert cached_traces == traces
+        npt.assert_array_equal(cached_fps, trace_fps)
+
+        second = rdktools.result_cache_stats()
+        assert second['hits'] >= first['hits'] + 3 * len(self.SMILES)
+        assert second['entries'] == first['entries']
+
+    def test_parameters_are_part_of_the_key(self):
+        """Different parameters never share cached rows."""
+        small = rdktools.morgan_fingerprints(self.SMILES, nbits=512)
+        large = rdktools.morgan_fingerprints(self.SMILES, nbits=1024)
+        assert small.shape[1] == 512 and large.shape[1] == 1024
+
+        logp = rdktools.calculate_descriptors(self.SMILES, ['logp'])
+        npt.assert_array_equal(logp[:, 0], rdktools.descriptors(self.SMILES)['logp'])
+
+    def test_capacity_and_clear(self):
+        """Capacity bounds the footprint; clear drops entries and counters."""
+        rdktools.set_result_cache_capacity(16384)
+        assert rdktools.get_result_cache_capacity() >= 16384
+        chains = np.array(['C' * n for n in range(1, 200)])
+        rdktools.morgan_fingerprints(chains, nbits=64)
+        stats = rdktools.result_cache_stats()
+        assert stats['bytes'] <= stats['capacity']
+        assert stats['evictions'] > 0
+
+        rdktools.clear_result_cache()
+        stats = rdktools.result_cache_stats()
+        assert stats['entries'] == 0 and stats['hits'] == 0
+
+        with pytest.raises(ValueError):
+            rdktools.set_result_cache_capacity(-1)
+
+
+class TestDedup:
+    """Test in-batch deduplication of repeated SMILES."""
+
+    SMILES = np.array(['CCO', 'c1ccccc1', 'CCO', 'invalid', 'CC(=O)O', 'c1ccccc1', 'CCO'])
+
+    def test_descriptors_match(self):
+        """Deduplicated descriptors equal the row-by-row results."""
+        npt.assert_array_equal(
+            rdktools.molecular_weights(self.SMILES, dedup=True),
+            rdktools.molecular_weights(self.SMILES),
+        )
+        npt.assert_array_equal(
+            rdktools.calculate_descriptors(self.SMILES, dedup=True),
+            rdktools.calculate_descriptors(self.SMILES),
+        )
+        deduped = rdktools.descriptors(self.SMILES, dedup=True)
+        expected = rdktools.descriptors(self.SMILES)
+        for key in ['molecular_weight', 'logp', 'tpsa']:
+            npt.assert_array_equal(deduped[key], expected[key])
+
+    def test_fingerprints_traces_and_canonical_match(self):
+        """Repeated rows are copies of their first occurrence."""
+        npt.assert_array_equal(
+            rdktools.morgan_fingerprints(self.SMILES, packed='bytes', dedup=True),
+            rdktools.morgan_fingerprints(self.SMILES, packed='bytes'),
+        )
+        traces, fps = rdktools.ecfp_reasoning_traces(self.SMILES, dedup=True)
+        expected_traces, expected_fps = rdktools.ecfp_reasoning_traces(self.SMILES)
+        assert traces == expected_traces
+        npt.assert_array_equal(fps, expected_fps)
+        assert list(rdktools.canonical_smiles(self.SMILES, dedup=True)) == list(
+            rdktools.canonical_smiles(self.SMILES)
+        )
+
+    def test_mol_batch_ignores_dedup(self):
+        """MolBatch rows are already parsed, so dedup leaves results unchanged."""
+        batch = rdktools.parse_smiles(self.SMILES)
+        npt.assert_array_equal(
+            rdktools.tpsa(batch, dedup=True), rdktools.tpsa(self.SMILES)
+        )
+
+
+class TestStats:
+    """Test the hot-path counters and stage timers."""
+
+    SMILES = np.array(['CCO', 'invalid', 'c1ccccc1', 'CC(=O)O'])
+
+    def setup_method(self):
+        rdktools.reset_stats()
+
+    def test_counters_and_stages(self):
+        """Featurization bumps the parse counters and times each stage."""
+        stats = rdktools.get_stats()
+        if not stats['enabled']:
+            pytest.skip("built with RDKTOOLS_ENABLE_STATS=OFF")
+
+        rdktools.ecfp_reasoning_traces(self.SMILES)
+        rdktools.calculate_descriptors(self.SMILES)
+        stats = rdktools.get_stats()
+        counters, stages = stats['counters'], stats['stages']
+        assert counters['molecules_parsed'] == 6
+        assert counters['invalid_smiles'] == 2
+        assert stages['parse']['calls'] == 8
+        for name in ['morgan', 'environment_smarts', 'format']:
+            assert stages[name]['calls'] == 3
+            assert stages[name]['seconds'] > 0
+        assert stages['descriptors']['calls'] == 3
+
+    def test_reset(self):
+        """reset_stats zeroes every counter and stage."""
+        rdktools.molecular_weights(self.SMILES)
+        rdktools.reset_stats()
+        stats = rdktools.get_stats()
+        assert all(value == 0 for value in stats['counters'].values())
+        assert all(stage['calls'] == 0 for stage in stats['stages'].values())
+
+
+class TestOutputBuffers:
+    """Test caller-provided out= buffers and float32 descriptors."""
+
+    SMILES = np.array(['CCO', 'invalid', 'c1ccccc1', 'CC(=O)O'])
+
+    def test_descriptor_out_and_dtype(self):
+        """Results land in the caller's array, which is returned."""
+        expected = rdktools.molecular_weights(self.SMILES)
+        out = np.full(len(self.SMILES), -1.0)
+        result = rdktools.molecular_weights(self.SMILES, out=out)
+        assert result is out
+        npt.assert_array_equal(out, expected)
+
+        as_float32 = rdktools.logp(self.SMILES, dtype=np.float32)
+        assert as_float32.dtype == np.float32
+        npt.assert_allclose(as_float32, rdktools.logp(self.SMILES), rtol=1e-6)
+
+        matrix = np.empty((len(self.SMILES), 2), dtype=np.float32)
+        result = rdktools.calculate_descriptors(self.SMILES, ['logp', 'tpsa'], out=matrix)
+        assert result is matrix
+        npt.assert_array_equal(
+            matrix, rdktools.calculate_descriptors(self.SMILES, ['logp', 'tpsa'])
+        )
+
+    def test_validity_mask_out(self):
+        """Both validation paths write the bool mask into out."""
+        for level in ('full', 'syntax'):
+            mask = np.ones(len(self.SMILES), dtype=bool)
+            result = rdktools.is_valid(self.SMILES, level=level, out=mask)
+            assert result is mask
+            npt.assert_array_equal(mask, [True, False, True, True])
+        with pytest.raises(ValueError):
+            rdktools.is_valid(self.SMILES, out=np.empty(len(self.SMILES), dtype=np.uint8))
+
+    def test_tuple_outputs(self):
+        """Multi-array results fill one caller array each."""
+        expected = rdktools.descriptors(self.SMILES)
+        outs = tuple(np.empty(len(self.SMILES)) for _ in range(3))
+        result = rdktools.descriptors(self.SMILES, out=outs)
+        for name, array in zip(('molecular_weight', 'logp', 'tpsa'), outs):
+            assert result[name] is array
+            npt.assert_array_equal(array, expected[name])
+        with pytest.raises(TypeError):
+            rdktools.descriptors(self.SMILES, out=outs[:2])
+
+        packed = rdktools.morgan_fingerprints(self.SMILES, nbits=256, packed='uint64')
+        sims = np.empty((len(self.SMILES), len(self.SMILES)), dtype=np.float32)
+        assert rdktools.tanimoto_matrix(packed, out=sims) is sims
+        npt.assert_array_equal(sims, rdktools.tanimoto_matrix(packed))
+
+        hits = (np.empty((2, 3), dtype=np.int64), np.empty((2, 3), dtype=np.float32))
+        indices, scores = rdktools.tanimoto_topk(packed[:2], packed, k=3, out=hits)
+        assert indices is hits[0] and scores is hits[1]
+        for got, want in zip(hits, rdktools.tanimoto_topk(packed[:2], packed, k=3)):
+            npt.assert_array_equal(got, want)
+
+    def test_fingerprint_out_overwrites_every_row(self):
+        """Invalid rows are zeroed even when the buffer held other data."""
+        expected = rdktools.morgan_fingerprints(self.SMILES, nbits=256, packed='uint64')
+        out = np.full(expected.shape, np.iinfo(np.uint64).max, dtype=np.uint64)
+        result = rdktools.morgan_fingerprints(self.SMILES, nbits=256, packed='uint64', out=out)
+        assert result is out
+        npt.assert_array_equal(out, expected)
+
+        _, trace_fps = rdktools.ecfp_reasoning_traces(self.SMILES, fingerprint_size=256)
+        staging = np.full(trace_fps.shape, 7, dtype=np.uint8)
+        _, fps = rdktools.ecfp_reasoning_traces(self.SMILES, fingerprint_size=256, out=staging)
+        assert fps is staging
+        npt.assert_array_equal(staging, trace_fps)
+
+    def test_out_is_checked(self):
+        """Mismatched dtype, shape, contiguity or writability is rejected."""
+        n = len(self.SMILES)
+        with pytest.raises(ValueError):
+            rdktools.tpsa(self.SMILES, out=np.empty(n, dtype=np.float32))
+        with pytest.raises(ValueError):
+            rdktools.tpsa(self.SMILES, out=np.empty(n + 1))
+        with pytest.raises(ValueError):
+            rdktools.tpsa(self.SMILES, out=np.empty(2 * n)[::2])
+        with pytest.raises(ValueError):
+            transposed = np.empty((64, n), dtype=np.uint8).T
+            rdktools.morgan_fingerprints(self.SMILES, nbits=64, out=transposed)
+        read_only = np.empty(n)
+        read_only.flags.writeable = False
+        with pytest.raises((TypeError, ValueError)):
+            rdktools.tpsa(self.SMILES, out=read_only)
+        with pytest.raises(ValueError):
+            rdktools.tpsa(self.SMILES, dtype=np.int32)
+
+
+class TestMolBatch:
+    """Test the parse-once MolBatch container."""
+
+    SMILES = np.array(['CCO', 'invalid', 'c1ccccc1', 'CC(=O)O'])
+
+    def test_validity_mask(self):
+        """The batch keeps every row and flags invalid SMILES."""
+        batch = rdktools.parse_smiles(self.SMILES)
+
+        assert len(batch) == 4
+        assert batch.num_valid == 3
+        npt.assert_array_equal(batch.valid, rdktools.is_valid(self.SMILES))
+
+    def test_batch_matches_smiles_input(self):
+        """Descriptors, fingerprints and canonical SMILES match SMILES input."""
+        batch = rdktools.parse_smiles(self.SMILES)
+
+        from_smiles = rdktools.descriptors(self.SMILES)
+        from_batch = rdktools.descriptors(batch)
+        for key in ['molecular_weight', 'logp', 'tpsa']:
+            npt.assert_array_equal(from_smiles[key], from_batch[key])
+
+        npt.assert_array_equal(
+            rdktools.molecular_weights(self.SMILES), rdktools.molecular_weights(batch)
+        )
+        npt.assert_array_equal(
+            rdktools.morgan_fingerprints(self.SMILES, nbits=1024),
+            rdktools.morgan_fingerprints(batch, nbits=1024),
+        )
+        assert list(rdktools.canonical_smiles(batch)) == list(
+            rdktools.canonical_smiles(self.SMILES)
+        )
+
+    def test_batch_reasoning_trace(self):
+        """Traces from a batch row match traces from the SMILES string."""
+        batch = rdktools.parse_smiles(self.SMILES)
+
+        trace, fingerprint = rdktools.ecfp_reasoning_trace(batch, index=0)
+        expected_trace, expected_fp = rdktools.ecfp_reasoning_trace('CCO')
+        assert trace == expected_trace
+        npt.assert_array_equal(fingerprint, expected_fp)
+
+        invalid_trace, invalid_fp = rdktools.ecfp_reasoning_trace(batch, index=1)
+        assert invalid_trace == ""
+        assert np.count_nonzero(invalid_fp) == 0
+
+        with pytest.raises(IndexError):
+            rdktools.ecfp_reasoning_trace(batch, index=10)
+
+
+class TestTraceTokens:
+    """Test tokenized reasoning traces and the trace vocabulary."""
+
+    SMILES = ['CCO', 'invalid', 'c1ccccc1', 'CC(=O)Oc1ccccc1C(=O)O', '']
+
+    def test_tokens_decode_to_text_traces(self):
+        """Every token row decodes to the matching text trace."""
+        values, splits, fps = rdktools.ecfp_reasoning_trace_tokens(self.SMILES)
+        traces, expected_fps = rdktools.ecfp_reasoning_traces(self.SMILES)
+
+        assert values.dtype == np.int32
+        assert splits.dtype == np.int64
+        assert len(splits) == len(self.SMILES) + 1
+        assert splits[0] == 0 and splits[-1] == len(values)
+        npt.assert_array_equal(fps, expected_fps)
+        for i, trace in enumerate(traces):
+            row = values[splits[i]:splits[i + 1]]
+            assert rdktools.decode_trace_tokens(row) == trace
+        assert splits[1] == splits[2]
+        assert splits[4] == splits[5]
+
+    def test_batch_matches_smiles_input(self):
+        """MolBatch input gives the same ids as SMILES input."""
+        batch = rdktools.parse_smiles(self.SMILES)
+        expected = rdktools.ecfp_reasoning_trace_tokens(self.SMILES, include_per_center=False)
+        result = rdktools.ecfp_reasoning_trace_tokens(batch, include_per_center=False)
+        for a, b in zip(expected, result):
+            npt.assert_array_equal(a, b)
+
+    def test_vocabulary_round_trip(self):
+        """A frozen vocabulary keeps ids and maps unseen environments to [UNK]."""
+        rdktools.ecfp_reasoning_trace_tokens(self.SMILES)
+        saved = rdktools.get_trace_vocabulary()
+        assert saved[0] == "[PAD]" and saved[1] == "[UNK]"
+        assert "r0:" in saved
+        fixed = saved[:saved.index("r15:") + 1]
+        try:
+            rdktools.set_trace_vocabulary(saved, frozen=True)
+            values, _, _ = rdktools.ecfp_reasoning_trace_tokens(['CCCN'])
+            assert values.max() < len(saved)
+            assert len(rdktools.get_trace_vocabulary()) == len(saved)
+
+            rdktools.set_trace_vocabulary(fixed, frozen=True)
+            values, _, _ = rdktools.ecfp_reasoning_trace_tokens(['CCO'])
+            assert 1 in values
+            assert values.max() < len(fixed)
+        finally:
+            rdktools.set_trace_vocabulary(saved)
+
+        with pytest.raises(ValueError):
+            rdktools.set_trace_vocabulary(["CCO"] + saved)
+        with pytest.raises(ValueError):
+            rdktools.set_trace_vocabulary(saved + [saved[-1]])
+
+    def test_new_ids_ignore_thread_count(self):
+        """Unseen environments get the same ids however the rows are scheduled."""
+        saved = rdktools.get_trace_vocabulary()
+        fixed = saved[:saved.index("r15:") + 1]
+        smiles = list(self.SMILES) * 20
+        runs = []
+        try:
+            for num_threads in (1, 4):
+                rdktools.set_trace_vocabulary(fixed)
+                values, _, _ = rdktools.ecfp_reasoning_trace_tokens(
+                    smiles, num_threads=num_threads
+                )
+                runs.append((values, rdktools.get_trace_vocabulary()))
+        finally:
+            rdktools.set_trace_vocabulary(saved)
+        npt.assert_array_equal(runs[0][0], runs[1][0])
+        assert runs[0][1] == runs[1][1]
+
+    def test_invalid_arguments(self):
+        """Radii beyond the radius markers and unknown ids are rejected."""
+        with pytest.raises(ValueError):
+            rdktools.ecfp_reasoning_trace_tokens(['CCO'], radius=16)
+        with pytest.raises(ValueError):
+            rdktools.decode_trace_tokens([len(rdktools.get_trace_vocabulary())])
+
+
+class TestPickles:
+    """Test binary pickle output and MolBatch.from_pickles input."""
+
+    SMILES = np.array(['CCO', 'invalid', 'c1ccccc1', 'CC(=O)O'])
+
+    def test_list_round_trip(self):
+        """Pickled molecules give the same results as the SMILES they came from."""
+        pickles = rdktools.smiles_to_pickles(self.SMILES)
+
+        assert len(pickles) == 4
+        assert all(isinstance(p, bytes) for p in pickles)
+        assert pickles[1] == b""
+
+        batch = rdktools.parse_pickles(pickles)
+        npt.assert_array_equal(batch.valid, rdktools.is_valid(self.SMILES))
+        npt.assert_array_equal(
+            rdktools.molecular_weights(batch), rdktools.molecular_weights(self.SMILES)
+        )
+        npt.assert_array_equal(
+            rdktools.morgan_fingerprints(batch, nbits=1024),
+            rdktools.morgan_fingerprints(self.SMILES, nbits=1024),
+        )
+        assert list(rdktools.canonical_smiles(batch)) == list(
+            rdktools.canonical_smiles(self.SMILES)
+        )
+
+    def test_buffer_round_trip(self):
+        """The concatenated buffer and offsets load like the list form."""
+        buffer, offsets = rdktools.smiles_to_pickles(self.SMILES, as_buffer=True)
+
+        assert buffer.dtype == np.uint8
+        assert offsets.dtype == np.int64
+        assert len(offsets) == 5
+        assert offsets[1] == offsets[2]
+
+        batch = rdktools.parse_pickles(buffer, offsets)
+        trace, fingerprint = rdktools.ecfp_reasoning_trace(batch, index=2)
+        expected_trace, expected_fp = rdktools.ecfp_reasoning_trace('c1ccccc1')
+        assert trace == expected_trace
+        npt.assert_array_equal(fingerprint, expected_fp)
+
+        from_bytes = rdktools.parse_pickles(buffer.tobytes(), offsets)
+        npt.assert_array_equal(from_bytes.valid, batch.valid)
+
+    def test_invalid_pickles(self):
+        """None, empty and corrupt pickles become invalid rows."""
+        pickles = rdktools.smiles_to_pickles(['CCO'])
+        batch = rdktools.parse_pickles([pickles[0], None, b"", b"not a pickle"])
+
+        npt.assert_array_equal(batch.valid, [True, False, False, False])
+        assert np.isnan(rdktools.molecular_weights(batch)[1:]).all()
+
+    def test_bad_inputs(self):
+        """Non-bytes rows and inconsistent offsets are rejected."""
+        with pytest.raises(TypeError):
+            rdktools.parse_pickles(['CCO'])
+        buffer, _ = rdktools.smiles_to_pickles(['CCO'], as_buffer=True)
+        with pytest.raises(ValueError):
+            rdktools.parse_pickles(buffer, [0, len(buffer) + 1])
+        with pytest.raises(ValueError):
+            rdktools.parse_pickles(buffer, [0, 4, 2])
+
+
+class TestSubstructure:
+    """Test SMARTS matching with the pattern fingerprint prescreen."""
+
+    SMILES = ['CCO', 'c1ccccc1O', 'CC(=O)Cl', 'invalid', 'O=[N+]([O-])c1ccccc1', 'C1CCCCC1']
+    PATTERNS = ['[OX2H]', 'c1ccccc1', 'C(=O)Cl', '[N+](=O)[O-]', '[R]', '[$(C=O)]']
+
+    def test_match_matrix(self):
+        """Rows follow the molecules and columns the patterns."""
+        hits = rdktools.substructure_match(self.SMILES, self.PATTERNS)
+        assert hits.shape == (6, 6)
+        assert hits.dtype == bool
+        npt.assert_array_equal(hits[0], [True, False, False, False, False, False])
+        npt.assert_array_equal(hits[1], [True, True, False, False, True, False])
+        npt.assert_array_equal(hits[2], [False, False, True, False, False, True])
+        assert not hits[3].any()
+        npt.assert_array_equal(hits[5], [False, False, False, False, True, False])
+
+        out = np.ones((6, 6), dtype=bool)
+        assert rdktools.substructure_match(self.SMILES, self.PATTERNS, out=out) is out
+        npt.assert_array_equal(out, hits)
+
+    def test_molbatch_and_threads_agree(self):
+        """MolBatch input and thread count do not change the result."""
+        serial = rdktools.substructure_match(self.SMILES * 20, self.PATTERNS, num_threads=1)
+        batch = rdktools.parse_smiles(self.SMILES * 20)
+        npt.assert_array_equal(
+            rdktools.substructure_match(batch, self.PATTERNS, num_threads=4), serial
+        )
+
+    def test_matches_rdkit(self):
+        """The prescreen never drops a match RDKit reports."""
+        Chem = pytest.importorskip("rdkit.Chem")
+        smiles = [s for s in self.SMILES if s != 'invalid']
+        hits = rdktools.substructure_match(smiles, self.PATTERNS)
+        for i, s in enumerate(smiles):
+            mol = Chem.MolFromSmiles(s)
+            for j, pattern in enumerate(self.PATTERNS):
+                assert hits[i, j] == mol.HasSubstructMatch(Chem.MolFromSmarts(pattern))
+
+    def test_single_pattern_and_errors(self):
+        """A bare SMARTS string is one pattern; bad SMARTS raise ValueError."""
+        hits = rdktools.substructure_match(['CCO', 'CC'], 'O')
+        npt.assert_array_equal(hits, [[True], [False]])
+        assert rdktools.substructure_match(['CCO'], []).shape == (1, 0)
+        with pytest.raises(ValueError):
+            rdktools.substructure_match(['CCO'], ['C(('])
+
+    def test_prescreen_counters(self):
+        """Rejected and matched pairs are counted separately."""
+        rdktools.reset_stats()
+        rdktools.substructure_match(['CCO', 'CCCC'], ['c1ccccc1', 'CC'])
+        stats = rdktools.get_stats()
+        if not stats['enabled']:
+            pytest.skip("stats compiled out")
+        counters = stats['counters']
+        assert counters['substructure_prescreen_rejects'] >= 2
+        assert (counters['substructure_prescreen_rejects']
+                + counters['substructure_match_calls']) == 4
+        assert stats['stages']['substructure']['calls'] == 2
+
+
+class TestThreading:
+    """Test multi-threaded batch execution."""
+
+    SMILES = np.array(
+        ['CCO', 'invalid', 'c1ccccc1', 'CC(=O)Oc1ccccc1C(=O)O', '', 'CCN'] * 50
+    )
+
+    def test_threaded_descriptors_match_serial(self):
+        """Thread count must not change descriptor results."""
+        serial = rdktools.descriptors(self.SMILES, num_threads=1)
+        threaded = rdktools.descriptors(self.SMILES, num_threads=4)
+
+        for key in ['molecular_weight', 'logp', 'tpsa']:
+            npt.assert_array_equal(serial[key], threaded[key])
+        assert np.isnan(threaded['molecular_weight'][1])
+
+    def test_threaded_fingerprints_match_serial(self):
+        """Thread count must not change fingerprints, including zero rows."""
+        serial = rdktools.morgan_fingerprints(self.SMILES, nbits=512, num_threads=1)
+        threaded = rdktools.morgan_fingerprints(self.SMILES, nbits=512, num_threads=8)
+
+        npt.assert_array_equal(serial, threaded)
+        assert threaded[1].sum() == 0
+
+    def test_threaded_validation_and_canonical(self):
+        """Validation and canonicalization keep input order under threading."""
+        valid = rdktools.is_valid(self.SMILES, num_threads=3)
+        canonical = rdktools.canonical_smiles(self.SMILES, num_threads=3)
+
+        npt.assert_array_equal(valid, rdktools.is_valid(self.SMILES, num_threads=1))
+        assert list(canonical) == list(
+            rdktools.canonical_smiles(self.SMILES, num_threads=1)
+        )
+
+    def test_default_num_threads(self):
+        """The module-level default can be changed and restored."""
+        original = rdktools.get_num_threads()
+        try:
+            rdktools.set_num_threads(2)
+            assert rdktools.get_num_threads() == 2
+        finally:
+            rdktools.set_num_threads(original)
+        assert rdktools.get_num_threads() == original
+
+
+class TestSubmit:
+    """Test asynchronous submission to the worker pool."""
+
+    SMILES = np.array(['CCO', 'invalid', 'c1ccccc1', 'CCN'] * 25)
+
+    def test_submit_matches_direct_call(self):
+        """A submitted call resolves to the same result as a direct one."""
+        future = rdktools.submit(rdktools.morgan_fingerprints, self.SMILES, nbits=256)
+        npt.assert_array_equal(
+            future.result(timeout=30), rdktools.morgan_fingerprints(self.SMILES, nbits=256)
+        )
+
+    def test_submit_propagates_exceptions(self):
+        """Exceptions raised by fn surface from result()."""
+        future = rdktools.submit(rdktools.morgan_fingerprints, self.SMILES, nbits=0)
+        with pytest.raises(ValueError):
+            future.result(timeout=30)
+        with pytest.raises(TypeError):
+            rdktools.submit("not callable")
+
+    def test_in_flight_is_bounded(self):
+        """No more than max_in_flight jobs run at once."""
+        import threading
+        import time
+
+        lock = threading.Lock()
+        state = {"running": 0, "peak": 0}
+
+        def job(i):
+            with lock:
+                state["running"] += 1
+                state["peak"] = max(state["peak"], state["running"])
+            time.sleep(0.01)
+            with lock:
+                state["running"] -= 1
+            return i
+
+        original = rdktools.get_max_in_flight()
+        try:
+            rdktools.set_max_in_flight(2)
+            futures = [rdktools.submit(job, i) for i in range(8)]
+            assert [f.result(timeout=30) for f in futures] == list(range(8))
+        finally:
+            rdktools.set_max_in_flight(original)
+        assert state["peak"] <= 2
+        with pytest.raises(ValueError):
+            rdktools.set_max_in_flight(0)
+
+    def test_submit_async(self):
+        """submit_async can be awaited from an event loop."""
+        import asyncio
+
+        async def run():
+            return await asyncio.gather(*(
+                rdktools.submit_async(rdktools.is_valid, self.SMILES) for _ in range(4)
+            ))
+
+        for valid in asyncio.run(run()):
+            npt.assert_array_equal(valid, rdktools.is_valid(self.SMILES))
+
 
 class TestInputValidation:
     """Test input validation and error handling."""
@@ -322,6 +1428,46 @@ class TestInputValidation:
         npt.assert_array_equal(weights_obj, weights_uni)
 
 
+class TestZeroCopyInput:
+    """Test numpy fixed-width and Arrow string inputs."""
+
+    SMILES = ['CCO', 'c1ccccc1', 'invalid_smiles', 'CC(=O)O']
+
+    def test_bytes_and_strided_arrays(self):
+        """numpy S arrays and strided views match list input."""
+        expected = rdktools.molecular_weights(self.SMILES)
+
+        npt.assert_array_equal(
+            rdktools.molecular_weights(np.array(self.SMILES, dtype='S')), expected
+        )
+        doubled = np.array([s for s in self.SMILES for _ in range(2)], dtype='U20')
+        npt.assert_array_equal(rdktools.molecular_weights(doubled[::2]), expected)
+
+    def test_arrow_string_arrays(self):
+        """Arrow string and large_string arrays are read in place."""
+        pa = pytest.importorskip("pyarrow")
+        expected = rdktools.descriptors(self.SMILES)
+        for arrow_type in (pa.string(), pa.large_string()):
+            column = pa.array(self.SMILES, type=arrow_type)
+            result = rdktools.descriptors(column)
+            for key in expected:
+                npt.assert_array_equal(result[key], expected[key])
+
+        # Sliced arrays honour the Arrow offset
+        sliced = pa.array(self.SMILES, type=pa.large_string()).slice(1, 2)
+        npt.assert_array_equal(rdktools.is_valid(sliced), [True, False])
+
+    def test_arrow_nulls_are_invalid(self):
+        """Arrow null entries behave like invalid SMILES."""
+        pa = pytest.importorskip("pyarrow")
+        column = pa.array(['CCO', None, 'c1ccccc1'], type=pa.large_string())
+
+        npt.assert_array_equal(rdktools.is_valid(column), [True, False, True])
+        weights = rdktools.molecular_weights(column)
+        assert np.isnan(weights[1])
+        assert rdktools.parse_smiles(column).num_valid == 2
+
+
 class TestConsistency:
     """Test consistency between different calculation methods."""
     
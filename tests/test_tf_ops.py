@@ -3,6 +3,8 @@
 Pytest suite for TensorFlow custom ops integration.
 """
 
+import gzip
+
 import numpy as np
 import pytest
 
@@ -51,6 +53,163 @@ def test_string_process_custom_fingerprint_size():
     assert int(tf.reduce_sum(fingerprints[0]).numpy()) >= 0
 
 
+def test_string_process_packed_fingerprints():
+    inputs = tf.constant(["CCO", "c1ccccc1"])
+
+    _, dense = tf_ops.string_process(inputs, fingerprint_size=512)
+    _, packed = tf_ops.string_process(inputs, fingerprint_size=512, packed=True)
+
+    assert packed.shape == inputs.shape + (64,)
+    assert packed.dtype == tf.uint8
+    np.testing.assert_array_equal(
+        packed.numpy(), np.packbits(dense.numpy(), axis=-1)
+    )
+
+
+def test_string_process_sharded_batch_matches_elementwise():
+    smiles = ["CCO", "c1ccccc1", "", "not_a_smiles", "CC(=O)Oc1ccccc1C(=O)O"] * 40
+    traces, fingerprints = tf_ops.string_process(tf.constant(smiles), fingerprint_size=256)
+
+    for index in (0, 1, 2, 3, 4, len(smiles) - 1):
+        trace, fingerprint = tf_ops.string_process(
+            tf.constant([smiles[index]]), fingerprint_size=256
+        )
+        assert traces.numpy()[index] == trace.numpy()[0]
+        np.testing.assert_array_equal(fingerprints.numpy()[index], fingerprint.numpy()[0])
+
+
+def test_string_process_trace_attrs():
+    inputs = tf.constant(["CC(=O)Oc1ccccc1C(=O)O"])
+
+    traces, fingerprints = tf_ops.string_process(
+        inputs, fingerprint_size=512, radius=1, include_per_center=False
+    )
+
+    text = traces.numpy()[0].decode()
+    assert "r1:" in text
+    assert "r2:" not in text
+    assert "# per-center chains" not in text
+    _, expected = tf_ops.string_process(inputs, fingerprint_size=512, radius=1)
+    np.testing.assert_array_equal(fingerprints.numpy(), expected.numpy())
+
+
+def test_string_process_dedup_matches():
+    smiles = ["CCO", "c1ccccc1", "CCO", "", "not_a_smiles", "CCO", "not_a_smiles"]
+    inputs = tf.constant(smiles)
+
+    traces, fingerprints = tf_ops.string_process(inputs, fingerprint_size=256, dedup=True)
+    expected_traces, expected = tf_ops.string_process(inputs, fingerprint_size=256)
+
+    assert traces.numpy().tolist() == expected_traces.numpy().tolist()
+    np.testing.assert_array_equal(fingerprints.numpy(), expected.numpy())
+
+
+def test_trace_tokens_match_core_tokens():
+    smiles = ["CCO", "c1ccccc1", "", "not_a_smiles", "CC(=O)Oc1ccccc1C(=O)O"]
+    values, splits, fps = rdktools.ecfp_reasoning_trace_tokens(smiles, fingerprint_size=256)
+
+    tokens, fingerprints = tf_ops.trace_tokens(
+        tf.constant(smiles),
+        fingerprint_size=256,
+        vocabulary=rdktools.get_trace_vocabulary(),
+    )
+
+    assert isinstance(tokens, tf.RaggedTensor)
+    np.testing.assert_array_equal(tokens.values.numpy(), values)
+    np.testing.assert_array_equal(tokens.row_splits.numpy(), splits)
+    np.testing.assert_array_equal(fingerprints.numpy(), fps)
+
+    traces, _ = tf_ops.string_process(tf.constant(smiles[:2]), fingerprint_size=256)
+    assert rdktools.decode_trace_tokens(tokens[0].numpy()) == traces.numpy()[0].decode()
+
+    # The shared vocabulary is still growing, so the op refuses to use it
+    with pytest.raises(tf.errors.FailedPreconditionError):
+        tf_ops.trace_tokens(tf.constant(smiles[:1]))
+
+
+def test_ops_share_runtime_with_core():
+    smiles = ["CCO", "c1ccccc1", "CCN"]
+    # A vocabulary frozen from Python is the one TF uses, and ops count into
+    # the same stats
+    rdktools.ecfp_reasoning_trace_tokens(smiles)
+    saved = rdktools.get_trace_vocabulary()
+    rdktools.set_trace_vocabulary(saved, frozen=True)
+    try:
+        rdktools.reset_stats()
+        tokens, _ = tf_ops.trace_tokens(tf.constant(smiles))
+        assert [token.decode() for token in tf_ops.trace_vocabulary().numpy()] == saved
+        assert tokens.values.numpy().max() < len(saved)
+    finally:
+        rdktools.set_trace_vocabulary(saved)
+    stats = rdktools.get_stats()
+    if stats["enabled"]:
+        assert stats["counters"]["molecules_parsed"] >= len(smiles)
+
+
+def test_pickle_input_matches_smiles_input():
+    smiles = ["CCO", "c1ccccc1", "CC(=O)Oc1ccccc1C(=O)O"]
+    pickles = tf.constant(rdktools.smiles_to_pickles(smiles))
+
+    traces, fingerprints = tf_ops.string_process(
+        pickles, fingerprint_size=256, input_format="pickle"
+    )
+    expected_traces, expected = tf_ops.string_process(
+        tf.constant(smiles), fingerprint_size=256
+    )
+    assert traces.numpy().tolist() == expected_traces.numpy().tolist()
+    np.testing.assert_array_equal(fingerprints.numpy(), expected.numpy())
+
+    np.testing.assert_array_equal(
+        tf_ops.morgan_fingerprint(pickles, input_format="pickle").numpy(),
+        tf_ops.morgan_fingerprint(tf.constant(smiles)).numpy(),
+    )
+    np.testing.assert_array_equal(
+        tf_ops.descriptor_process(pickles, input_format="pickle").numpy(),
+        tf_ops.descriptor_process(tf.constant(smiles)).numpy(),
+    )
+    formulas = tf_ops.formula_process(pickles, input_format="pickle").numpy()
+    assert formulas[0] == b"C2H6O[SEP]CCO"
+
+    with pytest.raises(ValueError):
+        tf_ops.string_process(pickles, input_format="sdf")
+
+
+def test_morgan_fingerprint_matches_string_process():
+    smiles = ["CCO", "c1ccccc1", "", "not_a_smiles", "CC(=O)Oc1ccccc1C(=O)O"] * 8
+    inputs = tf.constant(smiles)
+
+    _, expected = tf_ops.string_process(inputs, fingerprint_size=512)
+    fingerprints = tf_ops.morgan_fingerprint(
+        inputs, use_chirality=True, fingerprint_size=512
+    )
+    packed = tf_ops.morgan_fingerprint(
+        inputs, use_chirality=True, fingerprint_size=512, packed=True
+    )
+
+    assert fingerprints.shape == inputs.shape + (512,)
+    assert fingerprints.dtype == tf.uint8
+    np.testing.assert_array_equal(fingerprints.numpy(), expected.numpy())
+    np.testing.assert_array_equal(
+        packed.numpy(), np.packbits(expected.numpy(), axis=-1)
+    )
+    assert fingerprints.numpy()[2].sum() == 0
+    assert fingerprints.numpy()[3].sum() == 0
+
+
+def test_morgan_fingerprint_counts():
+    inputs = tf.constant(["CCCCCC", "c1ccccc1"])
+
+    bits = tf_ops.morgan_fingerprint(inputs, radius=1, fingerprint_size=256)
+    counts = tf_ops.morgan_fingerprint(
+        inputs, radius=1, fingerprint_size=256, counts=True
+    )
+
+    np.testing.assert_array_equal(counts.numpy() > 0, bits.numpy() > 0)
+    assert counts.numpy().max() > 1
+    with pytest.raises(ValueError):
+        tf_ops.morgan_fingerprint(inputs, packed=True, counts=True)
+
+
 def test_create_tf_dataset_batches():
     smiles = ["CCO", "c1ccccc1", "CC(=O)O", "CCC"]
     dataset = tf_ops.create_tf_dataset_op(smiles, batch_size=2, prefetch=False)
@@ -87,3 +246,63 @@ def test_create_tf_dataset_batches_custom_size():
         assert trace_batch.shape == (1,)
         assert fp_batch.shape == (1, 512)
         assert fp_batch.dtype == tf.uint8
+
+
+def test_smiles_file_dataset_batches(tmp_path):
+    first = tmp_path / "a.smi"
+    first.write_text("CCO ethanol\n# comment\nc1ccccc1 benzene\nCC(=O)O acid\n")
+    second = tmp_path / "b.smi"
+    second.write_text("CCC\nnot_a_smiles\n")
+
+    dataset = tf_ops.SmilesFileDataset([str(first), str(second)], batch_size=2)
+    batches = [batch.numpy().tolist() for batch in dataset]
+
+    assert batches == [[b"CCO", b"c1ccccc1"], [b"CC(=O)O"], [b"CCC", b"not_a_smiles"]]
+
+
+def test_smiles_file_dataset_featurize_matches_string_process(tmp_path):
+    path = tmp_path / "mols.csv.gz"
+    with gzip.open(path, "wt") as handle:
+        handle.write("id,smiles\n1,CCO\n2,c1ccccc1\n3,not_a_smiles\n4,CC(=O)O\n")
+
+    dataset = tf_ops.SmilesFileDataset(
+        str(path), batch_size=3, smiles_column=1, featurize=True, fingerprint_size=256
+    )
+    batches = list(dataset)
+    assert [int(batch[0].shape[0]) for batch in batches] == [3, 1]
+
+    for smiles, traces, fingerprints in batches:
+        expected_traces, expected_fps = tf_ops.string_process(smiles, fingerprint_size=256)
+        np.testing.assert_array_equal(traces.numpy(), expected_traces.numpy())
+        np.testing.assert_array_equal(fingerprints.numpy(), expected_fps.numpy())
+
+
+def test_smiles_file_dataset_missing_file(tmp_path):
+    dataset = tf_ops.SmilesFileDataset(str(tmp_path / "missing.smi"))
+    with pytest.raises(tf.errors.NotFoundError):
+        list(dataset)
+
+
+def test_descriptor_process_matches_core_descriptors():
+    smiles = ["CCO", "c1ccccc1", "", "not_a_smiles", "CC(=O)O"]
+
+    values, formulas = tf_ops.descriptor_process(
+        tf.constant(smiles), ["molecular_weight", "logp", "tpsa"], emit_formula=True
+    )
+
+    assert values.shape == (len(smiles), 3)
+    assert values.dtype == tf.float32
+    expected = rdktools.descriptors(smiles)
+    for column, key in enumerate(["molecular_weight", "logp", "tpsa"]):
+        np.testing.assert_allclose(
+            values.numpy()[:, column], expected[key].astype(np.float32), rtol=1e-6
+        )
+    assert np.isnan(values.numpy()[2:4]).all()
+    np.testing.assert_array_equal(
+        formulas.numpy(), tf_ops.formula_process(tf.constant(smiles)).numpy()
+    )
+
+
+def test_descriptor_process_rejects_unknown_name():
+    with pytest.raises((tf.errors.InvalidArgumentError, ValueError)):
+        tf_ops.descriptor_process(tf.constant(["CCO"]), ["not_a_descriptor"])